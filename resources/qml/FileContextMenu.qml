@@ -31,6 +31,7 @@ Menu {
     signal createNoteRequested(string parentPath)
     signal renameRequested(string path, string name)
     signal deleteRequested(string path)
+    signal aiBatchRequested(string path, string operation)
     
     // 动画
     enter: Transition {
@@ -125,6 +126,52 @@ Menu {
         }
     }
     
+    // AI批量总结按钮，处理文件夹及其子文件夹中的所有笔记
+    Action {
+        id: aiSummarizeAction
+        text: qsTr("AI批量总结")
+        icon.source: "qrc:/icons/editor/simplify-content.svg"
+        enabled: isFolder
+        onTriggered: {
+            console.log("[ContextMenu] AI Batch Summarize Requested for:", itemPath)
+            contextMenu.aiBatchRequested(itemPath, "summarize")
+        }
+    }
+    
+    // AI生成标签按钮
+    Action {
+        id: aiTagAction
+        text: qsTr("AI生成标签")
+        icon.source: "qrc:/icons/editor/ai.svg"
+        enabled: isFolder
+        onTriggered: {
+            console.log("[ContextMenu] AI Batch Tag Requested for:", itemPath)
+            contextMenu.aiBatchRequested(itemPath, "tag")
+        }
+    }
+    
+    // AI语法纠错按钮
+    Action {
+        id: aiFixAction
+        text: qsTr("AI语法纠错")
+        icon.source: "qrc:/icons/editor/grammar-check.svg"
+        enabled: isFolder
+        onTriggered: {
+            console.log("[ContextMenu] AI Batch Fix Requested for:", itemPath)
+            contextMenu.aiBatchRequested(itemPath, "fix")
+        }
+    }
+    
+    // 分隔线
+    MenuSeparator {
+        visible: isFolder
+        contentItem: Rectangle {
+            implicitWidth: 180
+            implicitHeight: 1
+            color: dividerColor
+        }
+    }
+    
     // 重命名按钮
     Action {
         id: renameAction
@@ -16,7 +16,7 @@ Item {
     property string selectedNoteType: "" // folder 或 note
     property string selectedNoteName: "" // 当前选中的笔记或文件夹名称
     property int maxFolderLevel: 4
-    property alias folderListModel: folderListModel // 导出列表模型以便外部访问
+    property var folderListModel: noteTreeModel // 导出文件树模型以便外部访问
     
     // 主题相关颜色（扩展更多颜色定义）
     property color bgColor: sidebarManager.isDarkTheme ? "transparent" : "transparent"
@@ -74,6 +74,10 @@ Item {
         function onDeleteRequested(path) {
             noteTree.handleDeleteRequest(path)
         }
+        function onAiBatchRequested(path, operation) {
+            // 由主窗口确认并在后台执行
+            sidebarManager.requestAiBatch(path, operation)
+        }
     }
     
     // 自定义对话框实例
@@ -95,17 +99,12 @@ Item {
                 
                 // 检查是否超过最大嵌套层级
                 if (parentPath !== "/root") {
-                    for (var i = 0; i < folderListModel.count; i++) {
-                        var item = folderListModel.get(i)
-                        if (item.path === parentPath) {
-                            if (item.level >= noteTree.maxFolderLevel - 1) {
-                                // console.error("文件夹嵌套层级已达上限:", noteTree.maxFolderLevel)
-                                errorMessageDialog.message = qsTr("文件夹嵌套层级已达上限（") + noteTree.maxFolderLevel + qsTr("层）")
-                                errorMessageDialog.open()
-                                return
-                            }
-                            break
-                        }
+                    var parentIndex = noteTreeModel.indexOfPath(parentPath)
+                    if (parentIndex !== -1 && noteTreeModel.get(parentIndex).level >= noteTree.maxFolderLevel - 1) {
+                        // console.error("文件夹嵌套层级已达上限:", noteTree.maxFolderLevel)
+                        errorMessageDialog.message = qsTr("文件夹嵌套层级已达上限（") + noteTree.maxFolderLevel + qsTr("层）")
+                        errorMessageDialog.open()
+                        return
                     }
                 }
                 
@@ -125,21 +124,16 @@ Item {
                         selectRetryCount++
                         
                         var folderPath = "/folder_" + newFolderId
-                        var found = false
-                        var targetIndex = -1
-                        for (var i = 0; i < folderListModel.count; i++) {
-                            var item = folderListModel.get(i)
-                            if (item.path === folderPath) {
-                                found = true
-                                targetIndex = i
-                                // console.log("选中新创建的文件夹 (尝试 "+ selectRetryCount +"):", item.name, "路径:", folderPath)
-                                selectedNotePath = folderPath
-                                selectedNoteType = "folder"
-                                selectedNoteName = item.name
-                                listView.positionViewAtIndex(targetIndex, ListView.Center)
-                                noteSelected(folderPath, "folder")
-                                break
-                            }
+                        var targetIndex = noteTreeModel.expandToPath(folderPath)
+                        var found = targetIndex !== -1
+                        if (found) {
+                            var item = noteTreeModel.get(targetIndex)
+                            // console.log("选中新创建的文件夹 (尝试 "+ selectRetryCount +"):", item.name, "路径:", folderPath)
+                            selectedNotePath = folderPath
+                            selectedNoteType = "folder"
+                            selectedNoteName = item.name
+                            listView.positionViewAtIndex(targetIndex, ListView.Center)
+                            noteSelected(folderPath, "folder")
                         }
                         
                         if (!found) {
@@ -148,62 +142,7 @@ Item {
                         }
                     }
                     
-                    var parentIndex = -1
-                    var parentLevel = -1
-                    if (parentPath === "/root") {
-                        parentIndex = -1
-                        parentLevel = -1
-                    } else {
-                        for (var i = 0; i < folderListModel.count; i++) {
-                            if (folderListModel.get(i).path === parentPath) {
-                                parentIndex = i
-                                parentLevel = folderListModel.get(i).level
-                                break
-                            }
-                        }
-                    }
-                    
-                    if (parentPath !== "/root" && parentIndex === -1) {
-                        // console.error("未能找到父文件夹用于插入新项目")
-                        return
-                    }
-                    
-                    if (parentIndex !== -1 && !folderListModel.get(parentIndex).expanded) {
-                        // console.log("展开父文件夹以插入新项")
-                        toggleFolderExpanded(parentIndex)
-                    }
-                    
-                    var newItemLevel = parentLevel + 1;
-                    var newItemData = {
-                        "id": newFolderId,
-                        "name": inputText.trim(),
-                        "type": "folder",
-                        "level": newItemLevel,
-                        "expanded": false,
-                        "path": "/folder_" + newFolderId
-                    }
-                    // console.log("构造新文件夹数据:", JSON.stringify(newItemData));
-                    
-                    var insertIndex = -1;
-                    if (parentIndex === -1) {
-                        // 如果是根目录，将文件夹放在所有文件夹后面
-                        insertIndex = 0;
-                        // 找到所有最上层文件夹的最后一个位置
-                        while (insertIndex < folderListModel.count && 
-                               (folderListModel.get(insertIndex).type === 'folder' && 
-                                folderListModel.get(insertIndex).level === 0)) {
-                            insertIndex++;
-                        }
-                    } else { 
-                        insertIndex = parentIndex + 1;
-                        while (insertIndex < folderListModel.count && folderListModel.get(insertIndex).level > parentLevel) {
-                            insertIndex++;
-                        }
-                    }
-                    
-                    // console.log("在索引 " + insertIndex + " 处插入新文件夹")
-                    folderListModel.insert(insertIndex, newItemData)
-                    
+                    // 新文件夹所在的行由noteTreeModel在数据库的folderAdded信号中插入
                     Qt.callLater(selectNewFolder)
                     
                 } else {
@@ -232,17 +171,12 @@ Item {
                 // console.log("创建笔记:", parentPath, inputText.trim())
                 
                 if (parentPath !== "/root") {
-                    for (var i = 0; i < folderListModel.count; i++) {
-                        var item = folderListModel.get(i)
-                        if (item.path === parentPath) {
-                            if (item.level >= noteTree.maxFolderLevel - 1) {
-                                // console.error("文件夹嵌套层级已达上限:", noteTree.maxFolderLevel)
-                                errorMessageDialog.message = qsTr("文件夹嵌套层级已达上限（") + noteTree.maxFolderLevel + qsTr("层）")
-                                errorMessageDialog.open()
-                                return
-                            }
-                            break
-                        }
+                    var parentIndex = noteTreeModel.indexOfPath(parentPath)
+                    if (parentIndex !== -1 && noteTreeModel.get(parentIndex).level >= noteTree.maxFolderLevel - 1) {
+                        // console.error("文件夹嵌套层级已达上限:", noteTree.maxFolderLevel)
+                        errorMessageDialog.message = qsTr("文件夹嵌套层级已达上限（") + noteTree.maxFolderLevel + qsTr("层）")
+                        errorMessageDialog.open()
+                        return
                     }
                 }
                 
@@ -262,21 +196,16 @@ Item {
                         selectRetryCount++
                         
                         var notePath = "/note_" + newNoteId
-                        var found = false
-                        var targetIndex = -1
-                        for (var i = 0; i < folderListModel.count; i++) {
-                            var item = folderListModel.get(i)
-                            if (item.path === notePath) {
-                                found = true
-                                targetIndex = i
-                                // console.log("选中新创建的笔记 (尝试 "+ selectRetryCount +"):", item.name, "路径:", notePath)
-                                selectedNotePath = notePath
-                                selectedNoteType = "note"
-                                selectedNoteName = item.name
-                                listView.positionViewAtIndex(targetIndex, ListView.Center)
-                                noteSelected(notePath, "note")
-                                break
-                            }
+                        var targetIndex = noteTreeModel.expandToPath(notePath)
+                        var found = targetIndex !== -1
+                        if (found) {
+                            var item = noteTreeModel.get(targetIndex)
+                            // console.log("选中新创建的笔记 (尝试 "+ selectRetryCount +"):", item.name, "路径:", notePath)
+                            selectedNotePath = notePath
+                            selectedNoteType = "note"
+                            selectedNoteName = item.name
+                            listView.positionViewAtIndex(targetIndex, ListView.Center)
+                            noteSelected(notePath, "note")
                         }
                         
                         if (!found) {
@@ -285,62 +214,7 @@ Item {
                         }
                     }
                     
-                    var parentIndex = -1
-                    var parentLevel = -1
-                    if (parentPath === "/root") {
-                        parentIndex = -1
-                        parentLevel = -1
-                    } else {
-                        for (var i = 0; i < folderListModel.count; i++) {
-                            if (folderListModel.get(i).path === parentPath) {
-                                parentIndex = i
-                                parentLevel = folderListModel.get(i).level
-                                break
-                            }
-                        }
-                    }
-                    
-                    if (parentPath !== "/root" && parentIndex === -1) {
-                        // console.error("未能找到父文件夹用于插入新项目")
-                        return
-                    }
-                    
-                     if (parentIndex !== -1 && !folderListModel.get(parentIndex).expanded) {
-                        // console.log("展开父文件夹以插入新项")
-                        toggleFolderExpanded(parentIndex)
-                    }
-                    
-                    var newItemLevel = parentLevel + 1;
-                    var newItemData = {
-                        "id": newNoteId,
-                        "name": inputText.trim(),
-                        "type": "note",
-                        "level": newItemLevel,
-                        "path": "/note_" + newNoteId,
-                        "date": new Date().toISOString() // 模拟日期
-                    }
-                    // console.log("构造新笔记数据:", JSON.stringify(newItemData));
-                    
-                    var insertIndex = -1;
-                    if (parentIndex === -1) { 
-                        // 如果是根目录，将笔记放在所有文件夹后面
-                        insertIndex = 0;
-                        // 找到所有最上层文件夹的最后一个位置
-                        while (insertIndex < folderListModel.count && 
-                               (folderListModel.get(insertIndex).type === 'folder' && 
-                                folderListModel.get(insertIndex).level === 0)) {
-                            insertIndex++;
-                        }
-                    } else { 
-                        insertIndex = parentIndex + 1;
-                        while (insertIndex < folderListModel.count && folderListModel.get(insertIndex).level > parentLevel) {
-                            insertIndex++;
-                        }
-                    }
-                    
-                    // console.log("在索引 " + insertIndex + " 处插入新笔记")
-                    folderListModel.insert(insertIndex, newItemData)
-                    
+                    // 新笔记所在的行由noteTreeModel在数据库的noteAdded信号中插入
                     Qt.callLater(selectNewNote)
                     
                 } else {
@@ -367,7 +241,7 @@ Item {
                 // console.log("重命名项目:", itemPath, "为", inputText.trim());
                 if (sidebarManager.renameItem(itemPath, inputText.trim())) {
                     // console.log("项目重命名成功:", inputText.trim());
-                    // 刷新在Connections的onFolderStructureChanged中处理
+                    // 对应的行由noteTreeModel在数据库的变化信号中更新
                 } else {
                     // console.error("项目重命名失败:", inputText.trim());
                     errorMessageDialog.message = qsTr("重命名失败：") + inputText.trim()
@@ -393,7 +267,7 @@ Item {
             // console.log("删除项目:", itemPath)
             if (sidebarManager.deleteItem(itemPath)) {
                 // console.log("项目删除成功:", itemPath);
-                // 刷新在Connections的onFolderStructureChanged中处理
+                // 对应的行由noteTreeModel在数据库的删除信号中移除
             } else {
                 // console.error("项目删除失败:", itemPath);
                 errorMessageDialog.message = qsTr("删除失败：") + itemPath
@@ -574,7 +448,7 @@ Item {
                 }
             
                 // 使用C++提供的数据代替静态数据
-                model: folderListModel
+                model: noteTreeModel
             
                 // 添加空白分隔区域，用于点击取消选中
                 header: Rectangle {
@@ -601,7 +475,7 @@ Item {
                 footer: Rectangle {
                     width: parent.width
                     // 动态计算footer高度，填充剩余可见空间，避免绑定循环
-                    property int itemTotalHeight: folderListModel.count * (44 + 8) // 44是项目高度, 8是间距
+                    property int itemTotalHeight: noteTreeModel.count * (44 + 8) // 44是项目高度, 8是间距
                     height: Math.max(10, listAreaContainer.height - itemTotalHeight - 10) 
                     color: "transparent" // 恢复透明
                     // opacity: 0.3
@@ -904,9 +778,6 @@ Item {
         }
     }
     } 
-    ListModel {
-        id: folderListModel
-    }
     
     Component.onCompleted: {
         // console.log("[NoteTree] 组件初始化开始")
@@ -916,73 +787,15 @@ Item {
     function refreshNotesList() {
         // console.log("--- [NoteTree] refreshNotesList() CALLED --- "); 
         var currentSelectedPath = selectedNotePath;
-        folderListModel.clear();
-        var topLevelItems = sidebarManager.getFolderStructure();
-        // console.log("[NoteTree] Fetched top level items count: " + topLevelItems.length);
-        for (var i = 0; i < topLevelItems.length; i++) {
-            folderListModel.append(topLevelItems[i]);
-        }
-        // console.log("[NoteTree] refreshNotesList() finished. Total items: " + folderListModel.count);
+        noteTreeModel.reload();
         if (currentSelectedPath) {
             selectedNotePath = currentSelectedPath;
         }
-        listView.forceLayout();
     }
     
     function toggleFolderExpanded(index) {
-        if (index < 0 || index >= folderListModel.count) return
-        var folder = folderListModel.get(index)
-        if (folder.type !== "folder") return
-        // console.log("--- [NoteTree] toggleFolderExpanded() CALLED for:", folder.name, "Current expanded:", folder.expanded, "Target state:", !folder.expanded);
-        
-        folder.expanded = !folder.expanded
-        
-        if (folder.expanded) {
-            var hasChildren = false
-            if (index + 1 < folderListModel.count) {
-                var nextItem = folderListModel.get(index + 1)
-                if (nextItem.level > folder.level) {
-                    hasChildren = true
-                    // console.log("[NoteTree] Folder already has children in model, skipping add.")
-                }
-            }
-            if (!hasChildren) {
-                var contents = sidebarManager.getFolderContents(folder.id, folder.level)
-                // console.log("[NoteTree] Fetched children count for expand: " + contents.length)
-                var insertPosition = index + 1
-                for (var i = 0; i < contents.length; i++) {
-                    folderListModel.insert(insertPosition, contents[i])
-                    insertPosition++
-                }
-            }
-        } else {
-            // console.log("--- [NoteTree] Calling removeChildItems() for index:", index);
-            removeChildItems(index)
-        }
-        listView.forceLayout()
-    }
-    
-    function removeChildItems(parentIndex) {
-        if (parentIndex < 0 || parentIndex >= folderListModel.count) return
-        var parentItem = folderListModel.get(parentIndex)
-        if (parentItem.type !== "folder") return
-        var parentLevel = parentItem.level
-        // console.log("--- [NoteTree] removeChildItems() CALLED for:", parentItem.name);
-        var startIndex = parentIndex + 1
-        var endIndex = startIndex
-        while (endIndex < folderListModel.count && folderListModel.get(endIndex).level > parentLevel) {
-            endIndex++
-        }
-        if (endIndex > startIndex) {
-            var removeCount = endIndex - startIndex
-            // console.log("[NoteTree] Removing " + removeCount + " child items from index " + startIndex)
-            for (var i = endIndex - 1; i >= startIndex; i--) {
-                 folderListModel.remove(i)
-            }
-        } else {
-            // console.log("[NoteTree] No child items found to remove.")
-        }
-        listView.forceLayout();
+        // 子项由模型批量插入或移除
+        noteTreeModel.toggleExpanded(index)
     }
     
     Connections {
@@ -1012,13 +825,8 @@ Item {
         if (parentPath === "/root") {
             isValidPath = true
         } else {
-            for (var i = 0; i < folderListModel.count; i++) {
-                var item = folderListModel.get(i)
-                if (item.path === parentPath && item.type === "folder") {
-                    isValidPath = true
-                    break
-                }
-            }
+            var parentIndex = noteTreeModel.indexOfPath(parentPath)
+            isValidPath = parentIndex !== -1 && noteTreeModel.get(parentIndex).type === "folder"
         }
         
         // 如果路径无效（可能是笔记路径），则使用根目录
@@ -1038,15 +846,11 @@ Item {
     }
     
     function ensureFolderExpanded(folderPath) {
-        for (var i = 0; i < folderListModel.count; i++) {
-            var item = folderListModel.get(i)
-            if (item.path === folderPath && item.type === "folder") {
-                // console.log("[NoteTree] 确保文件夹展开:", item.name)
-                if (!item.expanded) {
-                    toggleFolderExpanded(i)
-                }
-                return true
-            }
+        var index = noteTreeModel.expandToPath(folderPath)
+        if (index !== -1 && noteTreeModel.get(index).type === "folder") {
+            // console.log("[NoteTree] 确保文件夹展开:", folderPath)
+            noteTreeModel.setExpanded(index, true)
+            return true
         }
         // console.log("[NoteTree] 未找到要展开的文件夹:", folderPath)
         return false
@@ -1112,108 +916,34 @@ Item {
     function selectItemByPath(path) {
         console.log("尝试选中项目，路径:", path)
         
-        // 遍历模型查找匹配项
-        for (var i = 0; i < folderListModel.count; i++) {
-            var item = folderListModel.get(i)
-            if (item.path === path) {
-                // 找到匹配项
-                console.log("找到匹配项，索引:", i, "名称:", item.name, "类型:", item.type)
-                
-                // 设置选中状态
-                selectedNotePath = path
-                selectedNoteType = item.type
-                selectedNoteName = item.name
-                
-                // 确保文件夹路径展开以显示此项
-                ensurePathExpanded(path)
-                
-                // 滚动到选中项
-                Qt.callLater(function() {
-                    listView.positionViewAtIndex(i, ListView.Center)
-                    
-                    // 触发选中信号
-                    noteSelected(path, item.type)
-                })
-                
-                return true
-            }
+        // 展开所在的文件夹路径并取得行号
+        var index = noteTreeModel.expandToPath(path)
+        if (index === -1) {
+            console.log("未找到匹配路径:", path)
+            return false
         }
         
-        console.log("未找到匹配路径:", path)
-        return false
+        var item = noteTreeModel.get(index)
+        console.log("找到匹配项，索引:", index, "名称:", item.name, "类型:", item.type)
+        
+        // 设置选中状态
+        selectedNotePath = path
+        selectedNoteType = item.type
+        selectedNoteName = item.name
+        
+        // 滚动到选中项
+        Qt.callLater(function() {
+            listView.positionViewAtIndex(index, ListView.Center)
+            
+            // 触发选中信号
+            noteSelected(path, item.type)
+        })
+        
+        return true
     }
     
     // 函数：确保路径展开（用于显示某个深层次的项目）
     function ensurePathExpanded(path) {
-        // 对于笔记，需要找到其所在的文件夹
-        var folderPath = path
-        if (path.indexOf("/note_") !== -1) {
-            // 尝试找到此笔记的父文件夹
-            for (var i = 0; i < folderListModel.count; i++) {
-                var item = folderListModel.get(i)
-                if (item.path === path) {
-                    // 找到笔记所在的级别
-                    var noteLevel = item.level
-                    
-                    // 向上查找一个级别的文件夹
-                    for (var j = i - 1; j >= 0; j--) {
-                        var potentialParent = folderListModel.get(j)
-                        if (potentialParent.level < noteLevel && potentialParent.type === "folder") {
-                            folderPath = potentialParent.path
-                            break
-                        }
-                    }
-                    break
-                }
-            }
-        }
-        
-        // 现在展开从根到所需文件夹的所有文件夹
-        if (folderPath.indexOf("/folder_") !== -1) {
-            // 获取文件夹ID
-            var folderId = parseInt(folderPath.split("_")[1])
-            
-            // 获取所有父文件夹ID的列表
-            var parentIds = []
-            var currentFolderId = folderId
-            
-            while (currentFolderId > 0) {
-                // 遍历查找当前文件夹
-                for (var i = 0; i < folderListModel.count; i++) {
-                    var folder = folderListModel.get(i)
-                    if (folder.type === "folder" && folder.id === currentFolderId) {
-                        // 确保这个文件夹是展开的
-                        if (!folder.expanded) {
-                            toggleFolderExpanded(i) // 展开文件夹
-                        }
-                        
-                        // 寻找父文件夹
-                        if (folder.level > 0) {
-                            // 向上查找一个级别的文件夹
-                            for (var j = i - 1; j >= 0; j--) {
-                                var potentialParent = folderListModel.get(j)
-                                if (potentialParent.level < folder.level && potentialParent.type === "folder") {
-                                    currentFolderId = potentialParent.id
-                                    break
-                                }
-                            }
-                            // 如果找不到父文件夹，结束循环
-                            if (j < 0) {
-                                currentFolderId = 0
-                            }
-                        } else {
-                            // 如果是顶级文件夹，结束循环
-                            currentFolderId = 0
-                        }
-                        break
-                    }
-                }
-                // 如果遍历完未找到当前文件夹，结束循环
-                if (i >= folderListModel.count) {
-                    break
-                }
-            }
-        }
+        return noteTreeModel.expandToPath(path) !== -1
     }
 }
-
@@ -35,8 +35,8 @@ Rectangle {
     signal openNote(string path, string type)
     
     // 属性
-    property var searchResults: [] // 搜索结果数组
-    property bool isLoading: true // 添加加载状态
+    // 搜索结果由C++侧的searchResultModel分页提供
+    property bool isLoading: searchResultModel.loading && searchResultModel.count === 0 // 首页加载状态
     
     // 自定义标题栏
     Rectangle {
@@ -267,6 +267,59 @@ Rectangle {
             anchors.rightMargin: 20
             spacing: 10
             
+            // AI批量处理当前搜索条件下的全部结果
+            Button {
+                id: aiBatchButton
+                text: qsTr("AI批量处理")
+                font.pixelSize: 13
+                implicitHeight: 32
+                enabled: searchResultModel.count > 0
+                
+                background: Rectangle {
+                    color: aiBatchButton.hovered ? hoverBgColor : inputBgColor
+                    radius: 16
+                    opacity: aiBatchButton.enabled ? 1.0 : 0.5
+                }
+                
+                contentItem: Text {
+                    text: aiBatchButton.text
+                    font: aiBatchButton.font
+                    color: textColor
+                    opacity: aiBatchButton.enabled ? 1.0 : 0.5
+                    verticalAlignment: Text.AlignVCenter
+                    horizontalAlignment: Text.AlignHCenter
+                    leftPadding: 10
+                    rightPadding: 10
+                }
+                
+                onClicked: aiBatchMenu.open()
+                
+                Menu {
+                    id: aiBatchMenu
+                    y: aiBatchButton.height
+                    
+                    MenuItem {
+                        text: qsTr("总结全部结果")
+                        onTriggered: searchManager.requestAiBatch("summarize")
+                    }
+                    MenuItem {
+                        text: qsTr("为全部结果生成标签")
+                        onTriggered: searchManager.requestAiBatch("tag")
+                    }
+                    MenuItem {
+                        text: qsTr("纠错全部结果")
+                        onTriggered: searchManager.requestAiBatch("fix")
+                    }
+                    
+                    background: Rectangle {
+                        implicitWidth: 180
+                        color: cardBgColor
+                        border.color: sidebarManager.isDarkTheme ? "#606060" : "#c0c0c0"
+                        radius: 5
+                    }
+                }
+            }
+            
             Text {
                 text: qsTr("排序:")
                 font.pixelSize: 13
@@ -276,7 +329,7 @@ Rectangle {
             // 排序方式 (自定义样式)
             ComboBox {
                 id: sortOrder
-                model: [qsTr("最近修改"), qsTr("创建时间"), qsTr("按名称排序")]
+                model: [qsTr("最近修改"), qsTr("创建时间"), qsTr("按名称排序"), qsTr("按相关度")]
                 currentIndex: 0
                 font.pixelSize: 13
                 implicitWidth: 130
@@ -378,7 +431,7 @@ Rectangle {
         // 加载指示器
         BusyIndicator {
             anchors.centerIn: parent
-            running: isLoading && searchResults.length === 0
+            running: isLoading
         }
         
         // 空状态提示 (区分加载中和无结果)
@@ -430,7 +483,7 @@ Rectangle {
                 anchors.fill: parent
                 cellWidth: Math.floor(parent.width / Math.max(2, Math.floor(parent.width / 300))) // 调整卡片宽度计算
                 cellHeight: 200
-                model: searchResults
+                model: searchResultModel
                 
                 delegate: Rectangle {
                     id: noteCard
@@ -484,7 +537,7 @@ Rectangle {
                             Text {
                                 Layout.fillWidth: true
                                 Layout.alignment: Qt.AlignVCenter
-                                text: modelData.title
+                                text: model.title
                                 font.pixelSize: 15
                                 font.bold: true
                                 elide: Text.ElideRight
@@ -503,7 +556,7 @@ Rectangle {
                         Text {
                             Layout.fillWidth: true
                             Layout.preferredHeight: 70
-                            text: modelData.previewText || qsTr("无内容预览")
+                            text: model.previewText || qsTr("无内容预览")
                             font.pixelSize: 13
                             color: secondaryTextColor
                             wrapMode: Text.WordWrap
@@ -517,7 +570,7 @@ Rectangle {
                             spacing: 5
                             
                             Text {
-                                text: modelData.updatedAt ? qsTr("修改: ") + modelData.updatedAt : ""
+                                text: model.updatedAt ? qsTr("修改: ") + model.updatedAt : ""
                                 font.pixelSize: 11
                                 color: sidebarManager.isDarkTheme ? "#909090" : "#909090"
                             }
@@ -528,7 +581,13 @@ Rectangle {
                             }
                             
                             Text {
-                                text: modelData.createdAt ? qsTr("创建: ") + modelData.createdAt : ""
+                                text: model.wordCount ? qsTr("字数: ") + model.wordCount : ""
+                                font.pixelSize: 11
+                                color: sidebarManager.isDarkTheme ? "#909090" : "#909090"
+                            }
+                            
+                            Text {
+                                text: model.createdAt ? qsTr("创建: ") + model.createdAt : ""
                                 font.pixelSize: 11
                                 color: sidebarManager.isDarkTheme ? "#909090" : "#909090"
                             }
@@ -543,7 +602,7 @@ Rectangle {
                         cursorShape: Qt.PointingHandCursor
                         
                         onClicked: {
-                            searchRoot.openNote(modelData.path, "note")
+                            searchRoot.openNote(model.path, "note")
                             searchRoot.closeSearch()
                         }
                     }
@@ -584,20 +643,11 @@ Rectangle {
         // searchManager.searchNotes("", 0, 0, 0) 
     }
     
-    // 处理搜索结果更新
-    function updateSearchResults(results) {
-        console.log("SearchView.qml: updateSearchResults called with results count:", results.length) // 添加日志
-        isLoading = false // 收到结果，停止加载状态
-        searchResults = results
-    }
-    
     // 重置搜索状态 (用于再次打开时)
     function resetSearch() {
         console.log("SearchView.qml: resetSearch called") // 添加日志
         searchField.text = ""
-        searchResults = []
         sortOrder.currentIndex = 0 // 重置排序
-        isLoading = true // 重置时标记为加载中，直到首次数据返回
     }
     
     // 监听主题变化
@@ -85,39 +85,9 @@ Rectangle {
                 // 如果选中的是文件夹，直接在该文件夹下创建
                 noteTree.handleCreateNoteRequest(noteTree.selectedNotePath)
             } else if (noteTree.selectedNoteType === "note") {
-                // 如果选中的是笔记，需要获取其父文件夹路径
-                // 查找笔记的父文件夹
-                for (var i = 0; i < noteTree.folderListModel.count; i++) {
-                    var item = noteTree.folderListModel.get(i)
-                    if (item.path === noteTree.selectedNotePath) {
-                        // 找到笔记所在的父文件夹级别
-                        var noteLevel = item.level
-                        var parentIndex = -1
-                        
-                        // 向上查找父文件夹
-                        for (var j = i - 1; j >= 0; j--) {
-                            var potentialParent = noteTree.folderListModel.get(j)
-                            if (potentialParent.level < noteLevel && potentialParent.type === "folder") {
-                                parentIndex = j
-                                break
-                            }
-                        }
-                        
-                        if (parentIndex >= 0) {
-                            // 找到父文件夹
-                            noteTree.handleCreateNoteRequest(noteTree.folderListModel.get(parentIndex).path)
-                        } else {
-                            // 未找到父文件夹，使用根目录
-                            noteTree.handleCreateNoteRequest("/root")
-                        }
-                        break
-                    }
-                }
-                
-                if (i >= noteTree.folderListModel.count) {
-                    // 未找到笔记，使用根目录
-                    noteTree.handleCreateNoteRequest("/root")
-                }
+                // 如果选中的是笔记，在其父文件夹下创建，找不到时使用根目录
+                var noteIndex = noteTreeModel.indexOfPath(noteTree.selectedNotePath)
+                noteTree.handleCreateNoteRequest(noteIndex !== -1 ? noteTreeModel.parentPath(noteIndex) : "/root")
             } else {
                 // 没有选中项，在根目录下创建
                 noteTree.handleCreateNoteRequest("/root")
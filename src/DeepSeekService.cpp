@@ -9,6 +9,7 @@
  * Copyright (c) 2025, All Rights Reserved. 
  */
 #include "DeepSeekService.h"
+#include "aitextchunker.h"
 #include <QNetworkRequest>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -27,13 +28,20 @@ DeepSeekService::DeepSeekService(QObject *parent)
     , m_apiKey(DEFAULT_API_KEY)
     , m_apiEndpoint(API_ENDPOINT)
     , m_modelName(MODEL_NAME)
+    , m_streamingEnabled(false)
+    , m_bypassCache(false)
+    , m_requestPriority(InteractivePriority)
 {
     qDebug() << "DeepSeekService初始化开始";
+    m_responseCache.setConfig(AiResponseCache::Config::fromSettings());
     qDebug() << "API终端:" << m_apiEndpoint;
     qDebug() << "模型名称:" << m_modelName;
     
-    // 连接网络管理器的finished信号到处理槽函数
-    connect(m_networkManager, &QNetworkAccessManager::finished,
+    // 请求经调度器发出，完成(含重试)后再交给处理槽函数
+    m_scheduler = new AiRequestScheduler(m_networkManager, this);
+    connect(m_scheduler, &AiRequestScheduler::requestStarted,
+            this, &DeepSeekService::onRequestStarted);
+    connect(m_scheduler, &AiRequestScheduler::requestFinished,
             this, &DeepSeekService::handleNetworkReply);
     
     qDebug() << "DeepSeekService初始化完成 (已移除启动时API测试)";
@@ -64,98 +72,131 @@ void DeepSeekService::setApiEndpoint(const QString& apiEndpoint)
     }
 }
 
+// 设置是否流式接收回复
+void DeepSeekService::setStreamingEnabled(bool enabled)
+{
+    m_streamingEnabled = enabled;
+    qDebug() << "DeepSeekService流式回复:" << (enabled ? "开启" : "关闭");
+}
+
+// 设置是否缓存回复
+void DeepSeekService::setResponseCacheEnabled(bool enabled)
+{
+    AiResponseCache::Config config = AiResponseCache::Config::fromSettings();
+    config.enabled = enabled;
+    m_responseCache.setConfig(config);
+}
+
 // 润色文本
-void DeepSeekService::rewriteText(const QString& textToRewrite)
+int DeepSeekService::rewriteText(const QString& textToRewrite)
 {
     if (textToRewrite.isEmpty()) {
-        emit aiError("润色", "文本内容为空，无法处理");
-        return;
+        reportError("润色", "文本内容为空，无法处理", m_requestPriority);
+        return 0;
     }
 
     QString systemPrompt = "你是一位专业的文字编辑。请对用户提供的文本进行润色，提高其表达质量和专业度，但保持原意不变。使改进后的文本更加流畅、清晰且表达更准确。";
-    sendRequest("rewrite", textToRewrite, systemPrompt);
+    return sendRequest("rewrite", textToRewrite, systemPrompt, defaultOptions());
 }
 
 // 总结文本
-void DeepSeekService::summarizeText(const QString& textToSummarize)
+int DeepSeekService::summarizeText(const QString& textToSummarize)
 {
     if (textToSummarize.isEmpty()) {
-        emit aiError("总结", "文本内容为空，无法处理");
-        return;
+        reportError("总结", "文本内容为空，无法处理", m_requestPriority);
+        return 0;
     }
 
     QString systemPrompt = "你是一位专业的文字编辑。请对用户提供的文本进行简明扼要的总结，保留文本的关键信息和核心观点。总结应该简洁明了，突出文本的主要内容。";
-    sendRequest("summarize", textToSummarize, systemPrompt);
+
+    // 长文本一次发送容易超出上下文或被截断，改为分段总结后再合并
+    if (AiTextChunker::estimateTokens(textToSummarize) > LONG_DOCUMENT_TOKEN_BUDGET) {
+        return startLongSummary(textToSummarize, systemPrompt, defaultOptions());
+    }
+    return sendRequest("summarize", textToSummarize, systemPrompt, defaultOptions());
 }
 
 // 修复文本
-void DeepSeekService::fixText(const QString& textToFix)
+int DeepSeekService::fixText(const QString& textToFix)
 {
     if (textToFix.isEmpty()) {
-        emit aiError("修复", "文本内容为空，无法处理");
-        return;
+        reportError("修复", "文本内容为空，无法处理", m_requestPriority);
+        return 0;
     }
 
     QString systemPrompt = "你是一位专业的文字编辑和语法专家。请检查并修复用户提供文本中的语法错误、拼写错误和表达不当，使文本更加准确和符合规范。";
-    sendRequest("fix", textToFix, systemPrompt);
+    return sendRequest("fix", textToFix, systemPrompt, defaultOptions());
 }
 
 // 生成通用文本
-void DeepSeekService::generateGenericText(const QString& prompt)
+int DeepSeekService::generateGenericText(const QString& prompt)
 {
     if (prompt.isEmpty()) {
-        emit aiError("通用对话", "提示词为空，无法处理");
-        return;
+        reportError("通用对话", "提示词为空，无法处理", m_requestPriority);
+        return 0;
     }
 
     QString systemPrompt = "你是一位全能的AI助手，能够提供有用、准确、翔实的回答，帮助用户解决各种问题。";
-    sendRequest("generic", prompt, systemPrompt);
+    return sendRequest("generic", prompt, systemPrompt, defaultOptions());
+}
+
+// 生成标签
+int DeepSeekService::generateTags(const QString& text)
+{
+    if (text.isEmpty()) {
+        reportError("生成标签", "文本内容为空，无法处理", m_requestPriority);
+        return 0;
+    }
+
+    QString systemPrompt = "你是一位笔记整理助手。请为用户提供的笔记生成3到5个能概括其主题的简短标签，只输出标签本身，用英文逗号分隔，不要编号或解释。";
+    return sendRequest("tag", text, systemPrompt, defaultOptions());
 }
 
 // 发送请求到DeepSeek API
-void DeepSeekService::sendRequest(const QString& operation, const QString& originalText, const QString& systemPrompt)
+int DeepSeekService::sendRequest(const QString& operation, const QString& originalText, const QString& systemPrompt,
+                                 const RequestOptions& options, const JobStep& step)
 {
     // 详细记录操作
     qDebug() << "发送" << operationToDescription(operation) << "请求，文本长度:" << originalText.length();
     
     // 参数验证
     if (operation.isEmpty()) {
-        emit aiError(operationToDescription(operation), "操作类型为空");
-        return;
+        reportError(operationToDescription(operation), "操作类型为空", options.priority);
+        return 0;
     }
     if (originalText.isEmpty()) {
-        emit aiError(operationToDescription(operation), "原始文本为空");
-        return;
+        reportError(operationToDescription(operation), "原始文本为空", options.priority);
+        return 0;
     }
     if (systemPrompt.isEmpty()) {
-        emit aiError(operationToDescription(operation), "系统提示词为空");
-        return;
+        reportError(operationToDescription(operation), "系统提示词为空", options.priority);
+        return 0;
     }
 
-    // 检查API密钥
-    if (m_apiKey.isEmpty() || m_apiKey.trimmed().isEmpty()) {
-        emit aiError(operationToDescription(operation), "API密钥未设置，请在设置中配置有效的DeepSeek API密钥");
-        return;
-    }
-    
-    // 检查是否使用了默认API密钥
-    if (m_apiKey == DEFAULT_API_KEY) {
-        emit aiError(operationToDescription(operation), "使用了默认API密钥，请在设置中配置有效的DeepSeek API密钥");
-        return;
-    }
-    
-    // 检查API密钥格式
-    if (!m_apiKey.startsWith("sk-") || m_apiKey.length() < 20) {
-        emit aiError(operationToDescription(operation), "API密钥格式不正确，有效的DeepSeek API密钥应以'sk-'开头且长度至少为20个字符");
-        return;
+    if (!checkServiceConfig(operation, options.priority)) {
+        return 0;
     }
 
-    // 检查API端点
-    if (m_apiEndpoint.isEmpty() || !m_apiEndpoint.startsWith("http")) {
-        emit aiError(operationToDescription(operation), "API端点URL无效");
-        return;
+    // 同一文本执行过同一操作时直接返回缓存的结果，信号在下一次事件循环发出，与网络请求一样是异步的
+    QString cacheKey;
+    if (m_responseCache.isEnabled()) {
+        cacheKey = AiResponseCache::makeKey(operation, m_modelName, systemPrompt, originalText);
+        QString cachedText;
+        if (!options.bypassCache && m_responseCache.lookup(cacheKey, &cachedText)) {
+            qDebug() << operationToDescription(operation) << "命中回复缓存，长度:" << cachedText.length();
+            if (step.jobId != 0) {
+                QTimer::singleShot(0, this, [this, cachedText, step]() {
+                    onSummaryStepFinished(step, cachedText);
+                });
+                return step.jobId; // 结果按任务ID报告，返回非0表示已处理
+            }
+            return finishFromCache(operation, cachedText, options.priority);
+        }
     }
 
+    // 分段总结的中间结果不展示给用户，只有最终合并的结果按流式返回；后台请求没有界面显示，不需要流式接收
+    bool stream = m_streamingEnabled && operation != "summarize_chunk" && options.priority == InteractivePriority;
+
     // 创建请求URL
     QUrl url(m_apiEndpoint);
     QNetworkRequest request(url);
@@ -183,6 +224,12 @@ void DeepSeekService::sendRequest(const QString& operation, const QString& origi
 
     payload["messages"] = messages;
     
+    // 流式回复：服务器以server-sent events逐段返回生成的内容
+    if (stream) {
+        payload["stream"] = true;
+        request.setRawHeader("Accept", "text/event-stream");
+    }
+    
     // 根据需要设置其他参数 (例如 max_tokens, temperature)
     // payload["max_tokens"] = 4096; // 示例：可以根据需要调整最大令牌数
     // payload["temperature"] = 0.7; // 示例：可以调整创造性
@@ -193,36 +240,143 @@ void DeepSeekService::sendRequest(const QString& operation, const QString& origi
     qDebug() << "请求URL:" << url.toString();
     qDebug() << "请求负载:" << QString::fromUtf8(data).left(200) << "..."; // 打印部分负载用于调试
 
-    // 发送POST请求
-    QNetworkReply *reply = m_networkManager->post(request, data);
+    // 交给调度器排队发送，超过并发上限时等待，限流或服务器错误时自动重试
+    AiRequestScheduler::Priority priority = options.priority == BackgroundPriority
+        ? AiRequestScheduler::BackgroundPriority : AiRequestScheduler::InteractivePriority;
+    int requestId = m_scheduler->submit(request, data, priority);
+
+    // 存储操作类型，用于后续处理响应
+    m_activeReplies.insert(requestId, operation);
+    if (!cacheKey.isEmpty()) {
+        m_replyCacheKeys.insert(requestId, cacheKey);
+    }
+    if (step.jobId != 0) {
+        m_jobRequests.insert(requestId, step);
+    } else if (options.priority == BackgroundPriority) {
+        m_backgroundRequests.insert(requestId);
+    }
+    
+    if (stream) {
+        StreamState state;
+        state.elapsed.start();
+        m_streamStates.insert(requestId, state);
+    }
+    qDebug() << "请求已提交，ID:" << requestId;
+    return requestId;
+}
+
+// 通过公开接口发起的请求使用的选项
+DeepSeekService::RequestOptions DeepSeekService::defaultOptions() const
+{
+    RequestOptions options;
+    options.priority = m_requestPriority;
+    options.bypassCache = m_bypassCache;
+    return options;
+}
+
+// 检查API密钥和端点配置
+bool DeepSeekService::checkServiceConfig(const QString& operation, RequestPriority priority)
+{
+    // 检查API密钥
+    if (m_apiKey.isEmpty() || m_apiKey.trimmed().isEmpty()) {
+        reportError(operationToDescription(operation), "API密钥未设置，请在设置中配置有效的DeepSeek API密钥", priority);
+        return false;
+    }
+    
+    // 检查是否使用了默认API密钥
+    if (m_apiKey == DEFAULT_API_KEY) {
+        reportError(operationToDescription(operation), "使用了默认API密钥，请在设置中配置有效的DeepSeek API密钥", priority);
+        return false;
+    }
+    
+    // 检查API密钥格式
+    if (!m_apiKey.startsWith("sk-") || m_apiKey.length() < 20) {
+        reportError(operationToDescription(operation), "API密钥格式不正确，有效的DeepSeek API密钥应以'sk-'开头且长度至少为20个字符", priority);
+        return false;
+    }
+
+    // 检查API端点
+    if (m_apiEndpoint.isEmpty() || !m_apiEndpoint.startsWith("http")) {
+        reportError(operationToDescription(operation), "API端点URL无效", priority);
+        return false;
+    }
+
+    return true;
+}
+
+// 请求(或其一次重试)已发出
+void DeepSeekService::onRequestStarted(int requestId, QNetworkReply *reply)
+{
+    QString operation = m_activeReplies.value(requestId);
     
     // **增加超时设置**
-    // 设置一个较长的超时时间，例如 120 秒 (120000 毫秒)
-    QTimer::singleShot(120000, reply, [this, reply, operation]() { 
-        if (reply && reply->isRunning()) {
+    // 设置一个较长的超时时间，例如 120 秒 (120000 毫秒)；流式请求每收到数据重新计时
+    QTimer *timeoutTimer = new QTimer(reply);
+    timeoutTimer->setObjectName("timeoutTimer");
+    timeoutTimer->setSingleShot(true);
+    connect(timeoutTimer, &QTimer::timeout, reply, [this, reply, operation]() { 
+        if (reply->isRunning()) {
              qWarning() << operationToDescription(operation) << "请求超时 (120s)，中止请求";
+             reply->setProperty(AiRequestScheduler::TIMED_OUT_PROPERTY, true);
              reply->abort(); // 中止请求
         }
     });
+    timeoutTimer->start(REQUEST_TIMEOUT_MS);
+    
+    if (m_streamStates.contains(requestId)) {
+        // 重试时从头接收。调度器不会重试已输出过片段的请求，这里只保留计时
+        StreamState &state = m_streamStates[requestId];
+        QElapsedTimer elapsed = state.elapsed;
+        state = StreamState();
+        state.elapsed = elapsed;
+        connect(reply, &QNetworkReply::readyRead, this, [this, requestId, reply]() {
+            handleStreamData(requestId, reply);
+        });
+    }
+    qDebug() << "请求已发送到DeepSeek API，ID:" << requestId;
+}
 
-    // 存储操作类型，用于后续处理响应
-    m_activeReplies.insert(reply, operation);
-    qDebug() << "请求已发送到DeepSeek API";
+// 取消请求
+void DeepSeekService::cancelRequest(int requestId)
+{
+    m_backgroundRequests.remove(requestId);
+    if (m_summaryJobs.contains(requestId)) {
+        cancelSummaryJob(requestId);
+        return;
+    }
+    if (!m_activeReplies.contains(requestId)) {
+        return;
+    }
+    
+    m_activeReplies.remove(requestId);
+    m_streamStates.remove(requestId);
+    m_replyCacheKeys.remove(requestId);
+    m_jobRequests.remove(requestId);
+    m_scheduler->cancel(requestId);
+}
+
+// 设置最多同时发出的请求数
+void DeepSeekService::setMaxConcurrentRequests(int maxConcurrent)
+{
+    m_scheduler->setMaxInFlight(maxConcurrent);
 }
 
 // 处理网络响应
-void DeepSeekService::handleNetworkReply(QNetworkReply *reply)
+void DeepSeekService::handleNetworkReply(int requestId, QNetworkReply *reply)
 {
     // 确保reply被删除
     reply->deleteLater(); 
     
     // 从 m_activeReplies 中获取操作类型并移除该条目
-    if (!m_activeReplies.contains(reply)) {
+    if (!m_activeReplies.contains(requestId)) {
         qWarning() << "收到未追踪的网络响应，忽略。URL:" << (reply ? reply->url().toString() : "N/A");
         return;
     }
-    QString operation = m_activeReplies.take(reply);
+    QString operation = m_activeReplies.take(requestId);
     QString operationDesc = operationToDescription(operation);
+    bool isStream = m_streamStates.contains(requestId);
+    StreamState streamState = m_streamStates.take(requestId);
+    QString cacheKey = m_replyCacheKeys.take(requestId);
     QString requestUrl = reply->url().toString();
 
     // 记录响应信息
@@ -257,7 +411,8 @@ void DeepSeekService::handleNetworkReply(QNetworkReply *reply)
                 break;
             case QNetworkReply::OperationCanceledError:
                 // 区分是用户取消还是超时取消
-                if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isNull()) {
+                if (reply->property(AiRequestScheduler::TIMED_OUT_PROPERTY).toBool()
+                    || reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isNull()) {
                     // 如果没有HTTP状态码，很可能是定时器触发的abort
                     errorMsg = "请求超时 (120s)"; 
                 } else {
@@ -317,17 +472,18 @@ void DeepSeekService::handleNetworkReply(QNetworkReply *reply)
         qWarning() << "HTTP状态码:" << reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
         qWarning() << "错误字符串:" << reply->errorString();
         
-        emit aiError(operationDesc, errorMsg);
+        failRequest(requestId, operationDesc, errorMsg);
         return;
     }
 
-    // 读取响应数据
+    // 读取响应数据，流式请求的数据大多已在handleStreamData中读取
     QByteArray responseData = reply->readAll();
 
     // 检查响应数据是否为空
-    if (responseData.isEmpty()) {
+    bool streamHasData = streamState.sawEvent || !streamState.rawResponse.isEmpty() || !streamState.buffer.isEmpty();
+    if (responseData.isEmpty() && !(isStream && streamHasData)) {
         qWarning() << "DeepSeek服务器返回空响应";
-        emit aiError(operationDesc, "服务器返回的数据为空");
+        failRequest(requestId, operationDesc, "服务器返回的数据为空");
         return;
     }
 
@@ -341,34 +497,359 @@ void DeepSeekService::handleNetworkReply(QNetworkReply *reply)
         }
         
         // 解析响应数据并提取生成的文本
-        QString generatedText = parseResponse(responseData);
+        QString generatedText;
+        if (isStream) {
+            streamState.buffer += responseData;
+            QString delta = consumeStreamLines(streamState, true);
+            if (!delta.isEmpty() && !m_backgroundRequests.contains(requestId)) {
+                emit partialTextReceived(operationDesc, delta);
+            }
+            
+            if (!streamState.errorPayload.isEmpty()) {
+                generatedText = parseResponse(streamState.errorPayload); // 解析事件中的错误信息并抛出
+            } else if (streamState.sawEvent) {
+                generatedText = streamState.text;
+            } else {
+                // 服务器未按流式返回(如错误响应)，按普通响应解析
+                generatedText = parseResponse(streamState.rawResponse);
+            }
+            qDebug() << "流式回复完成，总耗时:" << streamState.elapsed.elapsed() << "毫秒";
+        } else {
+            generatedText = parseResponse(responseData);
+        }
         qDebug() << "解析成功，生成文本长度:" << generatedText.length() << "(" << operationDesc << ")";
 
-        // 根据操作类型发出对应的完成信号
-        if (operation == "rewrite") {
-            // emit rewriteFinished(originalText, generatedText); // 需要 originalText
-            emit genericTextFinished("", generatedText); // 暂时用通用信号替代，或者修改信号
-        } else if (operation == "summarize") {
-            // emit summaryFinished(originalText, generatedText); // 需要 originalText
-            emit genericTextFinished("", generatedText); // 暂时用通用信号替代
-        } else if (operation == "fix") {
-            // emit fixFinished(originalText, generatedText); // 需要 originalText
-            emit genericTextFinished("", generatedText); // 暂时用通用信号替代
-        } else if (operation == "generic") {
-            // emit genericTextFinished(originalText, generatedText); // 需要 originalText
-            emit genericTextFinished("", generatedText); // 暂时用通用信号替代，第二个参数是生成的文本
-        } else {
-             qWarning() << "未知的操作类型，无法发出完成信号:" << operation;
+        // 保存到回复缓存，之后对同一文本执行同一操作时直接返回
+        if (!cacheKey.isEmpty()) {
+            m_responseCache.store(cacheKey, operation, m_modelName, generatedText);
         }
+        
+        completeRequest(requestId, operation, generatedText);
     } catch (const std::exception& e) {
         // 捕获解析过程中的异常
         QString errorMessage = QString("处理API响应时出错 (%1): %2").arg(operationDesc).arg(e.what());
         qWarning() << errorMessage;
         qWarning() << "原始响应:" << responseData;
+        failRequest(requestId, operationDesc, errorMessage);
+    }
+}
+
+// 请求成功完成
+void DeepSeekService::completeRequest(int requestId, const QString& operation, const QString& generatedText)
+{
+    if (m_jobRequests.contains(requestId)) {
+        onSummaryStepFinished(m_jobRequests.take(requestId), generatedText);
+        return;
+    }
+    emitOperationFinished(requestId, operation, generatedText);
+}
+
+// 请求失败
+void DeepSeekService::failRequest(int requestId, const QString& operationDesc, const QString& errorMessage)
+{
+    // 任意一段失败时整个总结无法完成，取消其余请求，错误按任务ID报告
+    if (m_jobRequests.contains(requestId)) {
+        requestId = m_jobRequests.take(requestId).jobId;
+        cancelSummaryJob(requestId);
+    }
+    reportFailure(requestId, operationDesc, errorMessage);
+}
+
+// 已分配请求ID的请求失败
+void DeepSeekService::reportFailure(int requestId, const QString& operationDesc, const QString& errorMessage)
+{
+    bool background = m_backgroundRequests.remove(requestId);
+    emit requestFailed(requestId, errorMessage);
+    if (!background) {
         emit aiError(operationDesc, errorMessage);
     }
 }
 
+// 请求发出前的参数或配置错误
+void DeepSeekService::reportError(const QString& operationDesc, const QString& errorMessage, RequestPriority priority)
+{
+    // 后台请求由调用方根据返回的0处理，不打扰前台对话框
+    if (priority == BackgroundPriority) {
+        qWarning() << "后台AI请求未发出(" << operationDesc << "):" << errorMessage;
+        return;
+    }
+    emit aiError(operationDesc, errorMessage);
+}
+
+// 用缓存的结果完成请求
+int DeepSeekService::finishFromCache(const QString& operation, const QString& cachedText, RequestPriority priority)
+{
+    // 同样分配请求ID，调用方可以像网络请求一样等待完成信号或取消；信号在下一次事件循环发出
+    int requestId = m_scheduler->allocateRequestId();
+    m_activeReplies.insert(requestId, operation);
+    if (priority == BackgroundPriority) {
+        m_backgroundRequests.insert(requestId);
+    }
+    QTimer::singleShot(0, this, [this, requestId, operation, cachedText]() {
+        if (!m_activeReplies.contains(requestId)) {
+            return; // 已被取消
+        }
+        m_activeReplies.remove(requestId);
+        emitOperationFinished(requestId, operation, cachedText);
+    });
+    return requestId;
+}
+
+// 开始长文本分段总结
+int DeepSeekService::startLongSummary(const QString& text, const QString& systemPrompt, const RequestOptions& options)
+{
+    if (!checkServiceConfig("summarize", options.priority)) {
+        return 0;
+    }
+
+    // 整体结果与普通总结共用缓存键，再次总结同一文本时直接返回
+    SummaryJob job;
+    job.options = options;
+    if (m_responseCache.isEnabled()) {
+        job.cacheKey = AiResponseCache::makeKey("summarize", m_modelName, systemPrompt, text);
+        QString cachedText;
+        if (!options.bypassCache && m_responseCache.lookup(job.cacheKey, &cachedText)) {
+            qDebug() << "长文本总结命中回复缓存，长度:" << cachedText.length();
+            return finishFromCache("summarize", cachedText, options.priority);
+        }
+    }
+
+    QStringList chunks = AiTextChunker::split(text, LONG_DOCUMENT_TOKEN_BUDGET);
+    int jobId = m_scheduler->allocateRequestId();
+    job.totalSteps = chunks.size() + 1; // 各段加上最终合并
+    m_summaryJobs.insert(jobId, job);
+    if (options.priority == BackgroundPriority) {
+        m_backgroundRequests.insert(jobId);
+    }
+
+    qDebug() << "长文本分段总结，任务ID:" << jobId << "文本长度:" << text.length() << "分段数:" << chunks.size();
+    if (options.priority == InteractivePriority) {
+        emit progressChanged(operationToDescription("summarize"), 0, job.totalSteps);
+    }
+    // 调用方尚未拿到任务ID，第一轮未能发出时按请求未发出返回0，错误已由sendRequest报告
+    if (!startSummaryRound(jobId, chunks)) {
+        m_backgroundRequests.remove(jobId);
+        return 0;
+    }
+    return jobId;
+}
+
+// 并行发出一轮各段的总结请求
+bool DeepSeekService::startSummaryRound(int jobId, const QStringList& pieces)
+{
+    SummaryJob &job = m_summaryJobs[jobId];
+    job.round++;
+    job.results = QStringList();
+    for (int i = 0; i < pieces.size(); ++i) {
+        job.results.append(QString());
+    }
+    job.remaining = pieces.size();
+
+    // 第一轮总结原文片段，之后各轮合并上一轮的部分总结
+    QString systemPrompt = job.round == 1
+        ? "你是一位专业的文字编辑。用户提供的文本是一篇长文档中的一个片段，请对该片段进行简明扼要的总结，保留其中的关键信息、数据和核心观点，不要添加片段中没有的内容。"
+        : "你是一位专业的文字编辑。用户提供的文本是同一篇长文档中连续几部分的总结，请将它们合并为一份更精炼的总结，保留关键信息和核心观点，并保持原有的先后顺序。";
+
+    qDebug() << "分段总结第" << job.round << "轮，任务ID:" << jobId << "段数:" << pieces.size();
+    for (int i = 0; i < pieces.size(); ++i) {
+        JobStep step;
+        step.jobId = jobId;
+        step.index = i;
+        // 任意一段未发出时本轮无法完成，取消已发出的请求，否则任务永远等不到结束
+        if (!sendJobRequest(step, "summarize_chunk", pieces.at(i), systemPrompt)) {
+            qWarning() << "分段总结请求未能发出，任务ID:" << jobId << "段序号:" << i;
+            cancelSummaryJob(jobId);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 以任务的优先级和缓存设置发出请求
+bool DeepSeekService::sendJobRequest(const JobStep& step, const QString& operation, const QString& text,
+                                     const QString& systemPrompt)
+{
+    // 后续轮次在之后的事件循环中发出，使用发起任务时的选项，而不是此时的默认设置
+    RequestOptions options = m_summaryJobs.value(step.jobId).options;
+    return sendRequest(operation, text, systemPrompt, options, step) != 0;
+}
+
+// 任务中的一个请求完成
+void DeepSeekService::onSummaryStepFinished(const JobStep& step, const QString& generatedText)
+{
+    auto it = m_summaryJobs.find(step.jobId);
+    if (it == m_summaryJobs.end()) {
+        return; // 任务已取消或失败
+    }
+
+    it->completedSteps++;
+    if (it->options.priority == InteractivePriority) {
+        emit progressChanged(operationToDescription("summarize"), it->completedSteps, it->totalSteps);
+    }
+
+    // 最终合并完成，整体结果作为普通总结返回
+    if (it->reducing) {
+        SummaryJob job = m_summaryJobs.take(step.jobId);
+        if (!job.cacheKey.isEmpty()) {
+            m_responseCache.store(job.cacheKey, "summarize", m_modelName, generatedText);
+        }
+        qDebug() << "长文本分段总结完成，任务ID:" << step.jobId << "轮数:" << job.round;
+        emitOperationFinished(step.jobId, "summarize", generatedText);
+        return;
+    }
+
+    if (step.index >= 0 && step.index < it->results.size()) {
+        it->results[step.index] = generatedText.trimmed();
+    }
+    if (--it->remaining > 0) {
+        return;
+    }
+
+    QStringList results;
+    for (const QString &result : it->results) {
+        if (!result.isEmpty()) {
+            results.append(result);
+        }
+    }
+    if (results.isEmpty()) {
+        cancelSummaryJob(step.jobId);
+        reportFailure(step.jobId, operationToDescription("summarize"), "分段总结结果为空");
+        return;
+    }
+
+    // 部分总结合起来仍然过长时再做一轮，轮数达到上限后直接合并
+    QString joined = results.join("\n\n");
+    if (AiTextChunker::estimateTokens(joined) <= LONG_DOCUMENT_TOKEN_BUDGET || it->round >= MAX_REDUCE_ROUNDS) {
+        it->reducing = true;
+        JobStep reduceStep;
+        reduceStep.jobId = step.jobId;
+        if (!sendJobRequest(reduceStep, "summarize_reduce", joined,
+                            "你是一位专业的文字编辑。用户提供的文本是同一篇长文档按顺序分段得到的多个总结，请将它们合并为一份完整、连贯的总结，去除重复内容，保留文本的关键信息和核心观点。总结应该简洁明了，突出文本的主要内容。")) {
+            cancelSummaryJob(step.jobId);
+            reportFailure(step.jobId, operationToDescription("summarize"), "合并总结请求未能发出");
+        }
+        return;
+    }
+
+    QStringList groups = AiTextChunker::group(results, LONG_DOCUMENT_TOKEN_BUDGET, "\n\n");
+    it->totalSteps += groups.size();
+    if (it->options.priority == InteractivePriority) {
+        emit progressChanged(operationToDescription("summarize"), it->completedSteps, it->totalSteps);
+    }
+    if (!startSummaryRound(step.jobId, groups)) {
+        reportFailure(step.jobId, operationToDescription("summarize"), "分段总结请求未能发出");
+    }
+}
+
+// 取消任务
+void DeepSeekService::cancelSummaryJob(int jobId)
+{
+    if (!m_summaryJobs.remove(jobId)) {
+        return;
+    }
+
+    QList<int> requestIds;
+    for (auto it = m_jobRequests.cbegin(); it != m_jobRequests.cend(); ++it) {
+        if (it->jobId == jobId) {
+            requestIds.append(it.key());
+        }
+    }
+    for (int requestId : requestIds) {
+        cancelRequest(requestId);
+    }
+    qDebug() << "分段总结任务已取消，ID:" << jobId << "取消请求数:" << requestIds.size();
+}
+
+// 处理流式请求新到达的数据
+void DeepSeekService::handleStreamData(int requestId, QNetworkReply *reply)
+{
+    auto it = m_streamStates.find(requestId);
+    if (it == m_streamStates.end()) {
+        return;
+    }
+    
+    // 错误响应的内容在handleNetworkReply中统一处理
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode >= 400) {
+        return;
+    }
+    
+    // 收到数据即重新计时，只有长时间没有数据才算超时
+    QTimer *timeoutTimer = reply->findChild<QTimer*>("timeoutTimer");
+    if (timeoutTimer) {
+        timeoutTimer->start(REQUEST_TIMEOUT_MS);
+    }
+    
+    StreamState &state = it.value();
+    state.buffer += reply->readAll();
+    QString delta = consumeStreamLines(state, false);
+    if (delta.isEmpty()) {
+        return;
+    }
+    
+    if (!state.firstTokenLogged) {
+        state.firstTokenLogged = true;
+        qDebug() << "收到首个回复片段，耗时:" << state.elapsed.elapsed() << "毫秒";
+        // 已有内容输出，之后连接中断时不能再重试
+        m_scheduler->markDelivered(requestId);
+    }
+    if (!m_backgroundRequests.contains(requestId)) {
+        emit partialTextReceived(operationToDescription(m_activeReplies.value(requestId)), delta);
+    }
+}
+
+// 解析缓冲区中完整的SSE行
+QString DeepSeekService::consumeStreamLines(StreamState &state, bool flush)
+{
+    QString delta;
+    int start = 0;
+    
+    while (start < state.buffer.size()) {
+        int end = state.buffer.indexOf('\n', start);
+        if (end < 0) {
+            if (!flush) {
+                break;
+            }
+            end = state.buffer.size();
+        }
+        
+        QByteArray line = state.buffer.mid(start, end - start).trimmed();
+        start = end + 1;
+        
+        // 空行分隔事件，以冒号开头的是保活注释；其余非data行说明服务器未按流式返回
+        if (!line.startsWith("data:")) {
+            if (!line.isEmpty() && !line.startsWith(':') && !state.sawEvent) {
+                state.rawResponse += line;
+            }
+            continue;
+        }
+        
+        state.sawEvent = true;
+        QByteArray data = line.mid(5).trimmed();
+        if (data == "[DONE]") {
+            continue;
+        }
+        
+        QJsonDocument doc = QJsonDocument::fromJson(data);
+        QJsonObject eventObj = doc.object();
+        if (eventObj.contains("error")) {
+            state.errorPayload = data;
+            continue;
+        }
+        
+        // 每个事件的choices[0].delta.content是新增的文本
+        QJsonArray choices = eventObj["choices"].toArray();
+        if (choices.isEmpty()) {
+            continue;
+        }
+        delta += choices.first().toObject()["delta"].toObject()["content"].toString();
+    }
+    
+    state.buffer.remove(0, qMin(start, static_cast<int>(state.buffer.size())));
+    state.text += delta;
+    return delta;
+}
+
 // 构建请求体JSON
 QJsonObject DeepSeekService::buildRequestPayload(const QString& systemPrompt, const QString& userPrompt)
 {
@@ -518,12 +999,43 @@ QString DeepSeekService::parseResponse(const QByteArray& jsonResponse)
     return content;
 }
 
+// 根据操作类型发出对应的完成信号
+void DeepSeekService::emitOperationFinished(int requestId, const QString& operation, const QString& generatedText)
+{
+    bool background = m_backgroundRequests.remove(requestId);
+    emit requestFinished(requestId, generatedText);
+    if (background) {
+        return;
+    }
+
+    if (operation == "rewrite") {
+        // emit rewriteFinished(originalText, generatedText); // 需要 originalText
+        emit genericTextFinished("", generatedText); // 暂时用通用信号替代，或者修改信号
+    } else if (operation == "summarize") {
+        // emit summaryFinished(originalText, generatedText); // 需要 originalText
+        emit genericTextFinished("", generatedText); // 暂时用通用信号替代
+    } else if (operation == "fix") {
+        // emit fixFinished(originalText, generatedText); // 需要 originalText
+        emit genericTextFinished("", generatedText); // 暂时用通用信号替代
+    } else if (operation == "generic") {
+        // emit genericTextFinished(originalText, generatedText); // 需要 originalText
+        emit genericTextFinished("", generatedText); // 暂时用通用信号替代，第二个参数是生成的文本
+    } else if (operation == "tag") {
+        emit genericTextFinished("", generatedText);
+    } else {
+         qWarning() << "未知的操作类型，无法发出完成信号:" << operation;
+    }
+}
+
 // 将操作类型转换为描述性文字
 QString DeepSeekService::operationToDescription(const QString& operation)
 {
     if (operation == "rewrite") return "润色";
     if (operation == "summarize") return "总结";
+    if (operation == "summarize_chunk") return "总结";
+    if (operation == "summarize_reduce") return "总结";
     if (operation == "fix") return "修复";
     if (operation == "generic") return "通用对话";
+    if (operation == "tag") return "生成标签";
     return operation;
 } 
\ No newline at end of file
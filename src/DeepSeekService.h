@@ -17,6 +17,11 @@
 #include <QJsonObject>
 #include <QTimer>
 #include <QMap>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QStringList>
+#include "airesponsecache.h"
+#include "airequestscheduler.h"
 
 /**
  * @brief DeepSeek API服务实现类
@@ -54,41 +59,254 @@ public:
      * @brief 润色文本
      * @param textToRewrite 需要润色的文本
      */
-    void rewriteText(const QString& textToRewrite) override;
+    int rewriteText(const QString& textToRewrite) override;
 
     /**
      * @brief 总结文本
      * @param textToSummarize 需要总结的文本
      */
-    void summarizeText(const QString& textToSummarize) override;
+    int summarizeText(const QString& textToSummarize) override;
 
     /**
      * @brief 修复文本(语法纠错等)
      * @param textToFix 需要修复的文本
      */
-    void fixText(const QString& textToFix) override;
+    int fixText(const QString& textToFix) override;
 
     /**
      * @brief 生成通用文本(用于侧边栏通用对话)
      * @param prompt 用户输入的提示词
      */
-    void generateGenericText(const QString& prompt) override;
+    int generateGenericText(const QString& prompt) override;
+
+    /**
+     * @brief 为笔记生成标签
+     * @param text 笔记文本
+     */
+    int generateTags(const QString& text) override;
+
+    /**
+     * @brief 取消请求
+     * @param requestId 请求ID
+     */
+    void cancelRequest(int requestId) override;
+
+    /**
+     * @brief 设置之后发出的请求的优先级
+     * @param priority 优先级
+     */
+    void setRequestPriority(RequestPriority priority) override { m_requestPriority = priority; }
+
+    /**
+     * @brief 设置最多同时发出的请求数
+     * @param maxConcurrent 请求数
+     */
+    void setMaxConcurrentRequests(int maxConcurrent);
+
+    /**
+     * @brief 设置是否以流式方式(server-sent events)接收回复
+     * @param enabled 是否开启
+     */
+    void setStreamingEnabled(bool enabled) override;
+
+    /**
+     * @brief 是否以流式方式接收回复
+     * @return 开启时返回true
+     */
+    bool isStreamingEnabled() const override { return m_streamingEnabled; }
+
+    /**
+     * @brief 设置是否缓存回复，有效期和大小上限从设置中读取
+     * @param enabled 是否开启
+     */
+    void setResponseCacheEnabled(bool enabled) override;
+
+    /**
+     * @brief 设置之后的请求是否跳过缓存
+     * @param bypass 是否跳过
+     */
+    void setBypassCache(bool bypass) override { m_bypassCache = bypass; }
+
+    /**
+     * @brief 关闭回复缓存的数据库连接
+     */
+    void closeResponseCache() override { m_responseCache.close(); }
+
+    static const int REQUEST_TIMEOUT_MS = 120000; // 请求超时时间，流式请求为两次收到数据之间的最长间隔
+    static const int LONG_DOCUMENT_TOKEN_BUDGET = 3000; // 总结时超过该估算token数的文本分段处理，也是每段的预算
+    static const int MAX_REDUCE_ROUNDS = 3;       // 分段总结最多的轮数，超过后直接合并
 
 private slots:
+    /**
+     * @brief 请求(或其一次重试)已发出，设置超时并接收流式数据
+     * @param requestId 请求ID
+     * @param reply 网络响应对象
+     */
+    void onRequestStarted(int requestId, QNetworkReply *reply);
+
     /**
      * @brief 处理网络请求完成的响应
+     * @param requestId 请求ID
      * @param reply 网络响应对象
      */
-    void handleNetworkReply(QNetworkReply *reply);
+    void handleNetworkReply(int requestId, QNetworkReply *reply);
 
 private:
+    // 流式请求的接收状态
+    struct StreamState {
+        QByteArray buffer;        // 尚未组成完整行的数据
+        QString text;             // 已收到的全部文本
+        bool sawEvent = false;    // 是否收到过data事件
+        QByteArray rawResponse;   // 非事件内容，服务器未按流式返回时按普通响应解析
+        QByteArray errorPayload;  // 事件中携带的错误信息
+        QElapsedTimer elapsed;    // 请求发出后的耗时
+        bool firstTokenLogged = false;
+    };
+
+    // 单个请求的优先级和缓存方式，在发起时确定，之后不受setRequestPriority/setBypassCache影响
+    struct RequestOptions {
+        RequestPriority priority = InteractivePriority;
+        bool bypassCache = false;  // 是否跳过缓存查找，结果仍写入缓存
+    };
+
+    // 分段总结任务中的一个请求
+    struct JobStep {
+        int jobId = 0;   // 任务ID
+        int index = -1;  // 本轮中的段序号，最终合并请求为-1
+    };
+
+    // 长文本分段总结任务：先并行总结各段，再合并各段的总结
+    struct SummaryJob {
+        QString cacheKey;          // 完整文本的缓存键，完成后写入缓存
+        QStringList results;       // 本轮各段的总结
+        int remaining = 0;         // 本轮尚未完成的段数
+        int round = 0;             // 当前轮次
+        bool reducing = false;     // 是否已发出最终合并请求
+        int completedSteps = 0;    // 已完成的请求数，用于报告进度
+        int totalSteps = 0;        // 总请求数
+        RequestOptions options;    // 发起任务时的请求选项，后续各轮沿用
+    };
+
+    /**
+     * @brief 处理流式请求新到达的数据，发出partialTextReceived信号
+     * @param requestId 请求ID
+     * @param reply 网络响应对象
+     */
+    void handleStreamData(int requestId, QNetworkReply *reply);
+
+    /**
+     * @brief 解析缓冲区中完整的SSE行
+     * @param state 流式接收状态
+     * @param flush 是否把最后不完整的一行也一并解析(响应结束时)
+     * @return 本次新增的文本
+     */
+    QString consumeStreamLines(StreamState &state, bool flush);
+
     /**
      * @brief 发送请求到DeepSeek API
      * @param operation 操作类型标识符(如 "rewrite", "summarize", "fix", "generic")
      * @param originalText 原始文本
      * @param systemPrompt 系统提示词
+     * @param options 请求的优先级和缓存方式
+     * @param step 所属分段总结任务中的位置，不属于任务时jobId为0
+     * @return 请求ID，请求未发出时为0；任务中的请求命中缓存时返回任务ID
+     */
+    int sendRequest(const QString& operation, const QString& originalText, const QString& systemPrompt,
+                    const RequestOptions& options, const JobStep& step = JobStep());
+
+    /**
+     * @brief 通过公开接口发起的请求使用的选项，由setRequestPriority和setBypassCache设置
+     */
+    RequestOptions defaultOptions() const;
+
+    /**
+     * @brief 检查API密钥和端点配置，无效时发出aiError信号
+     * @param operation 操作类型
+     * @param priority 请求优先级，后台请求只记录日志
+     * @return 配置有效时返回true
+     */
+    bool checkServiceConfig(const QString& operation, RequestPriority priority);
+
+    /**
+     * @brief 开始长文本分段总结
+     * @param text 需要总结的文本
+     * @param systemPrompt 普通总结使用的系统提示词，用于计算缓存键
+     * @param options 任务中所有请求使用的选项
+     * @return 任务ID，可用于cancelRequest；未发出请求时为0
+     */
+    int startLongSummary(const QString& text, const QString& systemPrompt, const RequestOptions& options);
+
+    /**
+     * @brief 为任务的一轮并行发出各段的总结请求
+     * @param jobId 任务ID
+     * @param pieces 本轮需要总结的各段文本
+     * @return 是否全部发出，有一段未能发出时任务已被取消，由调用方报告失败
+     */
+    bool startSummaryRound(int jobId, const QStringList& pieces);
+
+    /**
+     * @brief 以任务的优先级和缓存设置发出任务中的一个请求
+     * @param step 请求在任务中的位置
+     * @param operation 操作类型
+     * @param text 请求文本
+     * @param systemPrompt 系统提示词
+     * @return 是否已发出(或命中缓存)
+     */
+    bool sendJobRequest(const JobStep& step, const QString& operation, const QString& text, const QString& systemPrompt);
+
+    /**
+     * @brief 任务中的一个请求完成，本轮全部完成后开始下一轮或合并
+     * @param step 请求在任务中的位置
+     * @param generatedText 生成的文本
+     */
+    void onSummaryStepFinished(const JobStep& step, const QString& generatedText);
+
+    /**
+     * @brief 取消任务及其所有未完成的请求
+     * @param jobId 任务ID
+     */
+    void cancelSummaryJob(int jobId);
+
+    /**
+     * @brief 请求成功完成，任务中的请求交给任务处理，其余发出完成信号
+     * @param requestId 请求ID
+     * @param operation 操作类型
+     * @param generatedText 生成的文本
+     */
+    void completeRequest(int requestId, const QString& operation, const QString& generatedText);
+
+    /**
+     * @brief 请求失败，任务中的请求失败时取消整个任务，只发出一次错误信号
+     * @param requestId 请求ID
+     * @param operationDesc 操作描述
+     * @param errorMessage 错误信息
+     */
+    void failRequest(int requestId, const QString& operationDesc, const QString& errorMessage);
+
+    /**
+     * @brief 发出请求失败信号，后台请求不发出aiError
+     * @param requestId 请求或任务ID
+     * @param operationDesc 操作描述
+     * @param errorMessage 错误信息
      */
-    void sendRequest(const QString& operation, const QString& originalText, const QString& systemPrompt);
+    void reportFailure(int requestId, const QString& operationDesc, const QString& errorMessage);
+
+    /**
+     * @brief 报告请求发出前的错误，后台请求只记录日志
+     * @param operationDesc 操作描述
+     * @param errorMessage 错误信息
+     * @param priority 请求优先级
+     */
+    void reportError(const QString& operationDesc, const QString& errorMessage, RequestPriority priority);
+
+    /**
+     * @brief 用缓存的结果完成请求，完成信号在下一次事件循环发出
+     * @param operation 操作类型
+     * @param cachedText 缓存的文本
+     * @param priority 请求优先级，后台请求的结果只通过requestFinished返回
+     * @return int 分配的请求ID
+     */
+    int finishFromCache(const QString& operation, const QString& cachedText, RequestPriority priority);
 
     /**
      * @brief 构建请求体JSON
@@ -112,11 +330,29 @@ private:
      */
     QString operationToDescription(const QString& operation);
 
+    /**
+     * @brief 发出requestFinished，交互请求还根据操作类型发出对应的完成信号
+     * @param requestId 请求或任务ID
+     * @param operation 操作类型
+     * @param generatedText 生成的文本
+     */
+    void emitOperationFinished(int requestId, const QString& operation, const QString& generatedText);
+
     QNetworkAccessManager *m_networkManager; // 网络请求管理器
     QString m_apiKey;                       // DeepSeek API密钥
     QString m_apiEndpoint;                  // API端点URL
     QString m_modelName;                    // 模型名称
-    QMap<QNetworkReply*, QString> m_activeReplies; // 声明 activeReplies
+    AiRequestScheduler *m_scheduler;        // 请求调度器，限制并发并在限流时退避重试
+    QMap<int, QString> m_activeReplies;     // 请求ID -> 操作类型
+    QMap<int, StreamState> m_streamStates;  // 流式请求的接收状态
+    bool m_streamingEnabled;                // 是否以流式方式接收回复
+    AiResponseCache m_responseCache;        // 回复缓存
+    QMap<int, QString> m_replyCacheKeys;    // 请求对应的缓存键，完成后写入缓存
+    bool m_bypassCache;                     // 之后通过公开接口发出的请求是否跳过缓存查找
+    RequestPriority m_requestPriority;      // 之后通过公开接口发出的请求的优先级
+    QMap<int, SummaryJob> m_summaryJobs;    // 任务ID -> 分段总结任务
+    QMap<int, JobStep> m_jobRequests;       // 请求ID -> 所属任务中的位置
+    QSet<int> m_backgroundRequests;         // 后台请求和任务的ID，结果只通过requestFinished/requestFailed返回
 };
 
 #endif // DEEPSEEKSERVICE_H 
\ No newline at end of file
@@ -23,6 +23,12 @@ class IAiService : public QObject
     Q_OBJECT
 
 public:
+    // 请求优先级：交互请求优先于后台批量请求发出
+    enum RequestPriority {
+        InteractivePriority,
+        BackgroundPriority
+    };
+
     IAiService() = default;
     explicit IAiService(QObject *parent) : QObject(parent) {}
     virtual ~IAiService() = default;
@@ -36,28 +42,115 @@ public:
     /**
      * @brief 润色文本
      * @param textToRewrite 需要润色的文本
+     * @return 请求ID，可用于cancelRequest；请求未发出(参数错误)时为0
      */
-    virtual void rewriteText(const QString& textToRewrite) = 0;
+    virtual int rewriteText(const QString& textToRewrite) = 0;
 
     /**
      * @brief 总结文本
      * @param textToSummarize 需要总结的文本
+     * @return 请求ID，可用于cancelRequest；请求未发出(参数错误)时为0
      */
-    virtual void summarizeText(const QString& textToSummarize) = 0;
+    virtual int summarizeText(const QString& textToSummarize) = 0;
 
     /**
      * @brief 修复文本(语法纠错等)
      * @param textToFix 需要修复的文本
+     * @return 请求ID，可用于cancelRequest；请求未发出(参数错误)时为0
      */
-    virtual void fixText(const QString& textToFix) = 0;
+    virtual int fixText(const QString& textToFix) = 0;
 
     /**
      * @brief 生成通用文本(用于侧边栏通用对话)
      * @param prompt 用户输入的提示词
+     * @return 请求ID，可用于cancelRequest；请求未发出(参数错误)时为0
+     */
+    virtual int generateGenericText(const QString& prompt) = 0;
+
+    /**
+     * @brief 为文本生成标签
+     * @param text 需要生成标签的文本
+     * @return 请求ID，可用于cancelRequest；请求未发出(参数错误)时为0。结果为以逗号分隔的标签
+     */
+    virtual int generateTags(const QString& text) = 0;
+
+    /**
+     * @brief 取消请求，已取消的请求不再发出完成或错误信号
+     * @param requestId 请求ID
+     */
+    virtual void cancelRequest(int requestId) = 0;
+
+    /**
+     * @brief 设置之后发出的请求的优先级，默认为交互请求
+     * 后台请求只发出requestFinished/requestFailed信号，不发出按操作区分的完成、流式和错误信号，
+     * 避免批量任务的结果显示到对话框中
+     * @param priority 优先级
+     */
+    virtual void setRequestPriority(RequestPriority priority) { Q_UNUSED(priority); }
+
+    /**
+     * @brief 设置是否以流式方式接收回复
+     * 开启后生成过程中会不断发出partialTextReceived信号，完成信号仍携带完整文本。
+     * 不支持流式接收的服务可以忽略该设置
+     * @param enabled 是否开启
+     */
+    virtual void setStreamingEnabled(bool enabled) { Q_UNUSED(enabled); }
+
+    /**
+     * @brief 是否以流式方式接收回复
+     * @return 开启时返回true
+     */
+    virtual bool isStreamingEnabled() const { return false; }
+
+    /**
+     * @brief 设置是否缓存回复，对同一文本重复执行同一操作时直接返回上次的结果
+     * 不支持缓存的服务可以忽略该设置
+     * @param enabled 是否开启
+     */
+    virtual void setResponseCacheEnabled(bool enabled) { Q_UNUSED(enabled); }
+
+    /**
+     * @brief 设置之后的请求是否跳过缓存，用于用户明确要求重新生成时。结果仍会写入缓存
+     * @param bypass 是否跳过
+     */
+    virtual void setBypassCache(bool bypass) { Q_UNUSED(bypass); }
+
+    /**
+     * @brief 关闭回复缓存占用的数据库文件，下次使用缓存时重新打开
+     * 恢复备份或迁移笔记本前调用，没有缓存的服务可以忽略
      */
-    virtual void generateGenericText(const QString& prompt) = 0;
+    virtual void closeResponseCache() {}
 
 signals:
+    /**
+     * @brief 请求完成信号，所有请求(包括后台请求)都会发出
+     * @param requestId 请求ID
+     * @param generatedText 生成的文本
+     */
+    void requestFinished(int requestId, const QString& generatedText);
+
+    /**
+     * @brief 请求失败信号，所有已返回请求ID的请求都会发出
+     * @param requestId 请求ID
+     * @param errorMessage 错误信息
+     */
+    void requestFailed(int requestId, const QString& errorMessage);
+
+    /**
+     * @brief 流式回复收到新内容信号
+     * @param operationDescription 操作描述(如 "润色", "总结", "通用对话" 等)
+     * @param textDelta 本次新增的文本片段
+     */
+    void partialTextReceived(const QString& operationDescription, const QString& textDelta);
+
+    /**
+     * @brief 多步操作(如长文本分段总结)的进度信号
+     * @param operationDescription 操作描述(如 "总结")
+     * @param completed 已完成的步骤数
+     * @param total 总步骤数，进行中可能增加
+     */
+    void progressChanged(const QString& operationDescription, int completed, int total);
+
     /**
      * @brief 润色完成信号
      * @param originalText 原始文本
@@ -25,6 +25,8 @@
 #include <QTimer>
 #include <QFile>
 #include <QMessageBox>
+#include <QScrollBar>
+#include <QTextCursor>
 
 // 构造函数
 AiAssistantDialog::AiAssistantDialog(QWidget *parent)
@@ -47,6 +49,8 @@ AiAssistantDialog::AiAssistantDialog(QWidget *parent)
       m_currentTone("专业"), // 默认语气
       m_aiService(nullptr), // 初始无AI服务
       m_lastErrorType(""),
+      m_streamingResponse(false),
+      m_currentRequestId(0),
       m_animationTimer(nullptr), // 初始化定时器指针
       m_animationDotIndex(0),    // 初始化点索引
       m_floatingToolBar(nullptr) // 初始化悬浮工具栏
@@ -480,6 +484,10 @@ void AiAssistantDialog::setupFunctionMenu()
     m_simplifyContentAction->setCheckable(true);
     m_simplifyContentAction->setChecked(m_currentFunction == "内容精简");
     
+    m_summarizeContentAction = new QAction(QIcon(":/icons/editor/simplify-content.svg"), "内容总结", this);
+    m_summarizeContentAction->setCheckable(true);
+    m_summarizeContentAction->setChecked(m_currentFunction == "内容总结");
+    
     m_grammarCheckAction = new QAction(QIcon(":/icons/editor/grammar-check.svg"), "语法纠错", this);
     m_grammarCheckAction->setCheckable(true);
     m_grammarCheckAction->setChecked(m_currentFunction == "语法纠错");
@@ -529,6 +537,7 @@ void AiAssistantDialog::setupFunctionMenu()
     m_functionMenu->addAction(m_polishContentAction);
     m_functionMenu->addAction(m_expandContentAction);
     m_functionMenu->addAction(m_simplifyContentAction);
+    m_functionMenu->addAction(m_summarizeContentAction);
     m_functionMenu->addAction(m_grammarCheckAction);
     m_functionMenu->addAction(m_changeToneAction);
     
@@ -550,6 +559,9 @@ void AiAssistantDialog::setupFunctionMenu()
     connect(m_simplifyContentAction, &QAction::triggered, this, [this]() { 
         onFunctionSelected(m_simplifyContentAction); 
     });
+    connect(m_summarizeContentAction, &QAction::triggered, this, [this]() { 
+        onFunctionSelected(m_summarizeContentAction); 
+    });
     connect(m_grammarCheckAction, &QAction::triggered, this, [this]() { 
         onFunctionSelected(m_grammarCheckAction); 
     });
@@ -596,7 +608,8 @@ void AiAssistantDialog::onFunctionSelected(QAction* action)
     // 取消选中其他功能选项
     for (QAction* functionAction : {m_continueWritingAction, m_polishContentAction, 
                                       m_expandContentAction, m_simplifyContentAction, 
-                                      m_grammarCheckAction, m_changeToneAction}) {
+                                      m_summarizeContentAction, m_grammarCheckAction, 
+                                      m_changeToneAction}) {
         if (functionAction != action) {
             functionAction->setChecked(false);
         }
@@ -630,7 +643,7 @@ void AiAssistantDialog::onToneSelected(QAction* action)
     // 取消选中其他功能选项
     for (QAction* functionAction : {m_continueWritingAction, m_polishContentAction, 
                                       m_expandContentAction, m_simplifyContentAction, 
-                                      m_grammarCheckAction}) {
+                                      m_summarizeContentAction, m_grammarCheckAction}) {
         functionAction->setChecked(false);
     }
     
@@ -649,6 +662,8 @@ void AiAssistantDialog::showLoadingState()
     m_sendButton->setEnabled(false);
     m_functionButton->setEnabled(false);
     m_responseTextEdit->setReadOnly(true);
+    m_streamingResponse = false;
+    m_progressText.clear();
     
     // 停止并删除旧的定时器（如果存在）
     if (m_animationTimer) {
@@ -667,7 +682,7 @@ void AiAssistantDialog::showLoadingState()
         if (m_titleLabel && !dots.isEmpty()) { // 增加列表非空检查
              int currentSize = static_cast<int>(dots.size());
              if (m_animationDotIndex >= 0 && m_animationDotIndex < currentSize) {
-                 m_titleLabel->setText("AI助手 - 处理中" + dots.at(m_animationDotIndex)); 
+                 m_titleLabel->setText("AI助手 - 处理中" + m_progressText + dots.at(m_animationDotIndex)); 
              } else {
                  qWarning() << "m_animationDotIndex is out of range:" << m_animationDotIndex << "size:" << currentSize;
                  m_titleLabel->setText("AI助手 - 处理中..."); // Fallback text
@@ -738,26 +753,32 @@ void AiAssistantDialog::processAiRequest()
     // 获取用户输入或选中文本
     QString text = !m_selectedText.isEmpty() ? m_selectedText : m_inputLineEdit->text().trimmed();
     
+    // 同一时间只保留一个请求，未完成的旧请求不再需要
+    cancelPendingRequest();
+    
     // 根据当前功能调用不同的AI服务方法
     if (m_currentFunction == "自由对话") {
         // 自由对话不添加任何额外提示词，直接发送用户输入
-        m_aiService->generateGenericText(text);
+        m_currentRequestId = m_aiService->generateGenericText(text);
     } else if (m_currentFunction == "继续写作") {
-        m_aiService->generateGenericText("请继续完成下面的文本，保持风格一致：\n\n" + text);
+        m_currentRequestId = m_aiService->generateGenericText("请继续完成下面的文本，保持风格一致：\n\n" + text);
     } else if (m_currentFunction == "内容润色") {
-        m_aiService->rewriteText(text);
+        m_currentRequestId = m_aiService->rewriteText(text);
     } else if (m_currentFunction == "语法纠错") {
-        m_aiService->fixText(text);
+        m_currentRequestId = m_aiService->fixText(text);
     } else if (m_currentFunction == "内容精简") {
-        m_aiService->generateGenericText("请将以下文本精简，保留核心信息但使表达更加简洁：\n\n" + text);
+        m_currentRequestId = m_aiService->generateGenericText("请将以下文本精简，保留核心信息但使表达更加简洁：\n\n" + text);
+    } else if (m_currentFunction == "内容总结") {
+        // 长文本由服务分段总结后再合并，过程中通过progressChanged报告进度
+        m_currentRequestId = m_aiService->summarizeText(text);
     } else if (m_currentFunction == "内容扩写") {
-        m_aiService->generateGenericText("请扩展以下内容，增加细节和相关信息，使文本更加丰富：\n\n" + text);
+        m_currentRequestId = m_aiService->generateGenericText("请扩展以下内容，增加细节和相关信息，使文本更加丰富：\n\n" + text);
     } else if (m_currentFunction == "语气转变") {
         QString tonePrompt = "请将以下文本转变为" + m_currentTone + "的语气，但保持原意不变：\n\n";
-        m_aiService->generateGenericText(tonePrompt + text);
+        m_currentRequestId = m_aiService->generateGenericText(tonePrompt + text);
     } else {
         // 默认使用通用文本生成
-        m_aiService->generateGenericText(text);
+        m_currentRequestId = m_aiService->generateGenericText(text);
     }
 }
 
@@ -805,17 +826,31 @@ void AiAssistantDialog::onRetryButtonClicked()
        
     }
     
-    // 重新处理AI请求
+    // 重新处理AI请求，用户明确要求重新生成，不使用缓存的结果
+    m_aiService->setBypassCache(true);
     processAiRequest();
+    m_aiService->setBypassCache(false);
 }
 
 // 取消按钮点击处理
 void AiAssistantDialog::onCancelButtonClicked()
 {
+    // 取消未完成的请求，关闭后不再显示结果
+    cancelPendingRequest();
+    
     // 关闭对话框
     reject();
 }
 
+// 取消未完成的AI请求
+void AiAssistantDialog::cancelPendingRequest()
+{
+    if (m_aiService && m_currentRequestId > 0) {
+        m_aiService->cancelRequest(m_currentRequestId);
+    }
+    m_currentRequestId = 0;
+}
+
 // 设置AI服务
 void AiAssistantDialog::setAiService(IAiService *service)
 {
@@ -858,6 +893,14 @@ void AiAssistantDialog::connectAiServiceSignals()
     connect(m_aiService, &IAiService::genericTextFinished, 
             this, &AiAssistantDialog::handleGenericTextFinished, Qt::UniqueConnection);
     
+    // 连接流式回复信号，生成过程中逐段显示
+    connect(m_aiService, &IAiService::partialTextReceived, 
+            this, &AiAssistantDialog::handlePartialText, Qt::UniqueConnection);
+    
+    // 连接进度信号，长文本分段总结时在标题中显示进度
+    connect(m_aiService, &IAiService::progressChanged, 
+            this, &AiAssistantDialog::handleProgress, Qt::UniqueConnection);
+    
     // 连接错误信号
     connect(m_aiService, &IAiService::aiError, 
             this, &AiAssistantDialog::handleAiError, Qt::UniqueConnection);
@@ -866,6 +909,7 @@ void AiAssistantDialog::connectAiServiceSignals()
 // 处理润色完成
 void AiAssistantDialog::handleRewriteFinished(const QString& originalText, const QString& rewrittenText)
 {
+    m_currentRequestId = 0; // 请求已结束
     stopLoadingAnimation(); // 停止动画
      // 恢复UI状态
     m_inputLineEdit->setEnabled(true);
@@ -893,6 +937,7 @@ void AiAssistantDialog::handleRewriteFinished(const QString& originalText, const
 // 处理总结完成
 void AiAssistantDialog::handleSummaryFinished(const QString& originalText, const QString& summaryText)
 {
+    m_currentRequestId = 0; // 请求已结束
     stopLoadingAnimation(); // 停止动画
      // 恢复UI状态
     m_inputLineEdit->setEnabled(true);
@@ -920,6 +965,7 @@ void AiAssistantDialog::handleSummaryFinished(const QString& originalText, const
 // 处理修复完成
 void AiAssistantDialog::handleFixFinished(const QString& originalText, const QString& fixedText)
 {
+    m_currentRequestId = 0; // 请求已结束
     stopLoadingAnimation(); // 停止动画
     // 恢复UI状态
     m_inputLineEdit->setEnabled(true);
@@ -947,6 +993,7 @@ void AiAssistantDialog::handleFixFinished(const QString& originalText, const QSt
 // 处理通用文本生成完成
 void AiAssistantDialog::handleGenericTextFinished(const QString& prompt, const QString& generatedText)
 {
+    m_currentRequestId = 0; // 请求已结束
     stopLoadingAnimation(); // 停止动画
      // 恢复UI状态
     m_inputLineEdit->setEnabled(true);
@@ -972,6 +1019,11 @@ void AiAssistantDialog::handleGenericTextFinished(const QString& prompt, const Q
         m_responseTextEdit->append(m_selectedText); // 使用成员变量m_selectedText
         m_responseTextEdit->append("\n<b>精简后：</b>");
         m_responseTextEdit->append(generatedText);
+    } else if (m_currentFunction == "内容总结") {
+        m_responseTextEdit->append("<b>原文：</b>");
+        m_responseTextEdit->append(m_selectedText); // 使用成员变量m_selectedText
+        m_responseTextEdit->append("\n<b>总结：</b>");
+        m_responseTextEdit->append(generatedText);
     } else if (m_currentFunction == "语气转变") {
         m_responseTextEdit->append("<b>原文：</b>");
         m_responseTextEdit->append(m_selectedText); // 使用成员变量m_selectedText
@@ -997,9 +1049,54 @@ void AiAssistantDialog::handleGenericTextFinished(const QString& prompt, const Q
     m_retryButton->setEnabled(true);
 }
 
+// 处理流式回复的新增内容
+void AiAssistantDialog::handlePartialText(const QString& operationDescription, const QString& textDelta)
+{
+    Q_UNUSED(operationDescription);
+    
+    // 收到第一段内容时结束等待动画并清空显示区域，完成信号到达后再按功能排版完整结果
+    if (!m_streamingResponse) {
+        m_streamingResponse = true;
+        stopLoadingAnimation();
+        if(m_titleLabel) m_titleLabel->setText("AI助手 - 生成中...");
+        m_responseTextEdit->clear();
+        m_responseTextEdit->setAlignment(Qt::AlignLeft);
+        m_generatedContent.clear();
+    }
+    
+    // 在末尾追加文本，不重新设置整个文档
+    QScrollBar *scrollBar = m_responseTextEdit->verticalScrollBar();
+    bool atBottom = scrollBar->value() >= scrollBar->maximum();
+    QTextCursor cursor(m_responseTextEdit->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(textDelta);
+    m_generatedContent += textDelta;
+    
+    // 用户未向上翻看时跟随到最新内容
+    if (atBottom) {
+        scrollBar->setValue(scrollBar->maximum());
+    }
+}
+
+// 处理多步操作的进度
+void AiAssistantDialog::handleProgress(const QString& operationDescription, int completed, int total)
+{
+    Q_UNUSED(operationDescription);
+
+    // 只在等待结果时显示，开始流式显示最终结果后不再更新标题
+    if (total <= 0 || m_streamingResponse) {
+        return;
+    }
+    m_progressText = QString(" (%1/%2)").arg(completed).arg(total);
+    if (m_titleLabel && m_animationTimer && m_animationTimer->isActive()) {
+        m_titleLabel->setText("AI助手 - 处理中" + m_progressText + "...");
+    }
+}
+
 // AI错误处理
 void AiAssistantDialog::handleAiError(const QString& operationDescription, const QString& errorMessage)
 {
+    m_currentRequestId = 0; // 请求已结束
     stopLoadingAnimation(); // 停止动画
     qWarning() << "AI错误:" << operationDescription << "-" << errorMessage;
     
@@ -92,6 +92,8 @@ private slots:
     void handleSummaryFinished(const QString& originalText, const QString& summaryText);
     void handleFixFinished(const QString& originalText, const QString& fixedText);
     void handleGenericTextFinished(const QString& prompt, const QString& generatedText);
+    void handlePartialText(const QString& operationDescription, const QString& textDelta); // 流式回复的新增内容
+    void handleProgress(const QString& operationDescription, int completed, int total); // 多步操作的进度
     void handleAiError(const QString& operationDescription, const QString& errorMessage);
 
 private:
@@ -118,6 +120,7 @@ private:
     QAction *m_polishContentAction;    // 内容润色
     QAction *m_expandContentAction;    // 内容扩写
     QAction *m_simplifyContentAction;  // 内容精简
+    QAction *m_summarizeContentAction; // 内容总结
     QAction *m_grammarCheckAction;     // 语法纠错
     QAction *m_changeToneAction;       // 语气转变
     QAction *m_humorousToneAction;     // 幽默语气
@@ -136,6 +139,9 @@ private:
     QString m_currentTone;           // 当前选中的语气
     IAiService *m_aiService;         // AI服务接口
     QString m_lastErrorType;         // 上一次错误的类型，用于重试逻辑
+    bool m_streamingResponse;        // 当前请求是否已开始显示流式回复
+    int m_currentRequestId;          // 未完成的AI请求ID，没有时为0
+    QString m_progressText;          // 多步操作的进度，显示在标题中，如" (2/5)"
     
     // 拖拽相关
     bool m_dragging;                 // 是否正在拖拽
@@ -169,6 +175,9 @@ private:
     
     // 处理AI请求
     void processAiRequest();
+    
+    // 取消未完成的AI请求
+    void cancelPendingRequest();
 };
 
 #endif // AIASSISTANTDIALOG_H 
\ No newline at end of file
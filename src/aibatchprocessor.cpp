@@ -0,0 +1,386 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-05 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-05 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\aibatchprocessor.cpp
+ * @Description: AI批量处理器实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "aibatchprocessor.h"
+#include "databasemanager.h"
+
+#include <QRegularExpression>
+#include <QDebug>
+
+AiBatchProcessor::AiBatchProcessor(DatabaseManager *dbManager, QObject *parent)
+    : QObject(parent)
+    , m_dbManager(dbManager)
+{
+    // 上次任务的笔记已全部处理完，但在删除检查点前程序退出，这类任务不需要继续
+    if (m_dbManager) {
+        int deleted = m_dbManager->deleteFinishedAiBatchJobs();
+        if (deleted > 0) {
+            qDebug() << "已删除" << deleted << "个处理完成但未清理的AI批量任务";
+        }
+    }
+}
+
+AiBatchProcessor::~AiBatchProcessor()
+{
+    // 数据库管理器可能已先于本对象销毁，这里只取消请求，检查点留待下次启动时继续
+    if (m_aiService) {
+        for (auto it = m_inFlight.constBegin(); it != m_inFlight.constEnd(); ++it) {
+            m_aiService->cancelRequest(it.key());
+        }
+    }
+}
+
+void AiBatchProcessor::setAiService(IAiService *aiService)
+{
+    if (m_aiService == aiService) {
+        return;
+    }
+
+    if (m_aiService) {
+        disconnect(m_aiService, nullptr, this, nullptr);
+        for (auto it = m_inFlight.constBegin(); it != m_inFlight.constEnd(); ++it) {
+            m_aiService->cancelRequest(it.key());
+        }
+        // 已发出的请求随旧服务一起丢弃，对应笔记重新排队
+        for (int noteId : m_inFlight) {
+            m_queue.prepend(noteId);
+        }
+        m_inFlight.clear();
+    }
+
+    m_aiService = aiService;
+
+    if (m_aiService) {
+        connect(m_aiService, &IAiService::requestFinished, this, &AiBatchProcessor::onRequestFinished);
+        connect(m_aiService, &IAiService::requestFailed, this, &AiBatchProcessor::onRequestFailed);
+        if (isRunning()) {
+            submitNext();
+        }
+    }
+}
+
+QString AiBatchProcessor::operationName(Operation operation)
+{
+    switch (operation) {
+    case SummarizeOperation: return "summarize";
+    case TagOperation: return "tag";
+    case FixOperation: return "fix";
+    }
+    return QString();
+}
+
+QString AiBatchProcessor::operationDescription(Operation operation)
+{
+    switch (operation) {
+    case SummarizeOperation: return "总结";
+    case TagOperation: return "生成标签";
+    case FixOperation: return "语法纠错";
+    }
+    return QString();
+}
+
+bool AiBatchProcessor::operationFromName(const QString &name, Operation *operation)
+{
+    for (Operation candidate : {SummarizeOperation, TagOperation, FixOperation}) {
+        if (operationName(candidate) == name) {
+            *operation = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AiBatchProcessor::start(Operation operation, const QList<int> &noteIds, const QString &sourceName)
+{
+    if (isRunning()) {
+        qWarning() << "已有AI批量任务正在运行";
+        return false;
+    }
+    if (!m_dbManager || !m_aiService || noteIds.isEmpty()) {
+        return false;
+    }
+
+    // 去掉重复的笔记ID，保持原有顺序
+    QList<int> uniqueIds;
+    for (int noteId : noteIds) {
+        if (!uniqueIds.contains(noteId)) {
+            uniqueIds.append(noteId);
+        }
+    }
+
+    int jobId = m_dbManager->createAiBatchJob(operationName(operation), sourceName, uniqueIds);
+    if (jobId < 0) {
+        return false;
+    }
+
+    m_jobId = jobId;
+    m_operation = operation;
+    m_queue = uniqueIds;
+    m_total = uniqueIds.size();
+    m_succeeded = 0;
+    m_failed = 0;
+    m_skipped = 0;
+    m_failureStreak.clear();
+
+    qDebug() << "AI批量任务开始，ID:" << m_jobId << "操作:" << operationName(operation)
+             << "来源:" << sourceName << "笔记数:" << m_total;
+    emit jobStarted(operationDescription(operation), sourceName, 0, m_total);
+    submitNext();
+    return true;
+}
+
+bool AiBatchProcessor::resumePendingJob()
+{
+    if (isRunning() || !m_dbManager || !m_aiService) {
+        return false;
+    }
+
+    AiBatchJobInfo job = m_dbManager->getUnfinishedAiBatchJob();
+    if (job.id < 0) {
+        return false;
+    }
+
+    Operation operation;
+    if (!operationFromName(job.operation, &operation)) {
+        qWarning() << "未知的AI批量任务操作:" << job.operation << "，删除该任务";
+        m_dbManager->deleteAiBatchJob(job.id);
+        return false;
+    }
+
+    m_jobId = job.id;
+    m_operation = operation;
+    m_queue = job.pendingNoteIds;
+    m_total = job.total;
+    m_succeeded = job.succeeded;
+    m_failed = job.failed;
+    m_skipped = job.skipped;
+    m_failureStreak.clear();
+
+    qDebug() << "继续AI批量任务，ID:" << m_jobId << "操作:" << job.operation
+             << "剩余笔记数:" << m_queue.size() << "/" << m_total;
+    emit jobStarted(operationDescription(operation), job.source, m_succeeded + m_failed + m_skipped, m_total);
+    submitNext();
+    return true;
+}
+
+void AiBatchProcessor::cancel()
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    qDebug() << "AI批量任务已取消，ID:" << m_jobId;
+    m_dbManager->deleteAiBatchJob(m_jobId);
+
+    QString description = operationDescription(m_operation);
+    int succeeded = m_succeeded;
+    int failed = m_failed;
+    int skipped = m_skipped;
+    reset();
+    emit jobFinished(description, succeeded, failed, skipped, true);
+}
+
+void AiBatchProcessor::discardPendingJob()
+{
+    if (isRunning() || !m_dbManager) {
+        return;
+    }
+
+    AiBatchJobInfo job = m_dbManager->getUnfinishedAiBatchJob();
+    if (job.id >= 0) {
+        qDebug() << "放弃AI批量任务，ID:" << job.id << "剩余笔记数:" << job.pendingNoteIds.size();
+        m_dbManager->deleteAiBatchJob(job.id);
+    }
+}
+
+void AiBatchProcessor::submitNext()
+{
+    if (!isRunning() || !m_aiService) {
+        return;
+    }
+
+    while (m_inFlight.size() < MAX_NOTES_IN_FLIGHT && !m_queue.isEmpty()) {
+        int noteId = m_queue.takeFirst();
+
+        // 任务开始后被删除(或移入回收站)的笔记和空笔记没有可处理的内容，记为跳过
+        NoteInfo note = m_dbManager->getNoteById(noteId);
+        if (note.id != noteId || note.is_trashed) {
+            qDebug() << "AI批量处理跳过已删除的笔记，ID:" << noteId;
+            markNote(noteId, DatabaseManager::AiBatchItemSkipped);
+            continue;
+        }
+        QString text = m_dbManager->getNotePlainText(noteId).trimmed();
+        if (text.isEmpty()) {
+            markNote(noteId, DatabaseManager::AiBatchItemSkipped);
+            continue;
+        }
+
+        int requestId = submitNote(text);
+        if (requestId == 0) {
+            // 参数都已检查过，未发出只可能是服务配置有误，继续提交也会同样失败
+            m_queue.prepend(noteId);
+            pause("AI服务配置无效，请在设置中检查API密钥和端点");
+            return;
+        }
+        m_inFlight.insert(requestId, noteId);
+    }
+
+    if (m_queue.isEmpty() && m_inFlight.isEmpty()) {
+        qDebug() << "AI批量任务完成，ID:" << m_jobId << "成功:" << m_succeeded << "失败:" << m_failed
+                 << "跳过:" << m_skipped;
+        m_dbManager->deleteAiBatchJob(m_jobId);
+
+        QString description = operationDescription(m_operation);
+        int succeeded = m_succeeded;
+        int failed = m_failed;
+        int skipped = m_skipped;
+        reset();
+        emit jobFinished(description, succeeded, failed, skipped, false);
+    }
+}
+
+int AiBatchProcessor::submitNote(const QString &text)
+{
+    m_aiService->setRequestPriority(IAiService::BackgroundPriority);
+
+    int requestId = 0;
+    switch (m_operation) {
+    case SummarizeOperation:
+        requestId = m_aiService->summarizeText(text);
+        break;
+    case TagOperation:
+        // 标签只需概括主题，长笔记取开头部分即可
+        requestId = m_aiService->generateTags(text.left(TAG_INPUT_CHARS));
+        break;
+    case FixOperation:
+        requestId = m_aiService->fixText(text);
+        break;
+    }
+
+    m_aiService->setRequestPriority(IAiService::InteractivePriority);
+    return requestId;
+}
+
+void AiBatchProcessor::onRequestFinished(int requestId, const QString &generatedText)
+{
+    if (!m_inFlight.contains(requestId)) {
+        return;
+    }
+
+    int noteId = m_inFlight.take(requestId);
+    bool succeeded = writeResult(noteId, generatedText);
+    if (succeeded) {
+        m_failureStreak.clear();
+    }
+    markNote(noteId, succeeded ? DatabaseManager::AiBatchItemSucceeded : DatabaseManager::AiBatchItemFailed);
+    submitNext();
+}
+
+void AiBatchProcessor::onRequestFailed(int requestId, const QString &errorMessage)
+{
+    if (!m_inFlight.contains(requestId)) {
+        return;
+    }
+
+    int noteId = m_inFlight.take(requestId);
+    qWarning() << "AI批量处理笔记失败，笔记ID:" << noteId << "错误:" << errorMessage;
+    markNote(noteId, DatabaseManager::AiBatchItemFailed);
+    m_failureStreak.append(noteId);
+
+    // 连续失败通常是网络或额度问题，暂停任务而不是把剩余笔记全部标记为失败
+    if (m_failureStreak.size() >= MAX_CONSECUTIVE_FAILURES) {
+        for (int failedId : m_failureStreak) {
+            m_dbManager->setAiBatchItemStatus(m_jobId, failedId, DatabaseManager::AiBatchItemPending);
+        }
+        m_failed -= m_failureStreak.size();
+        pause(errorMessage);
+        return;
+    }
+
+    submitNext();
+}
+
+bool AiBatchProcessor::writeResult(int noteId, const QString &generatedText)
+{
+    QString result = generatedText.trimmed();
+    if (result.isEmpty()) {
+        qWarning() << "AI批量处理结果为空，笔记ID:" << noteId;
+        return false;
+    }
+
+    if (m_operation != TagOperation) {
+        return m_dbManager->saveNoteAiResult(noteId, operationName(m_operation), result);
+    }
+
+    // 生成的标签合并到已有标签之后，不重复添加
+    NoteInfo note = m_dbManager->getNoteById(noteId);
+    QStringList tags = parseTags(note.tags);
+    for (const QString &tag : parseTags(result).mid(0, MAX_TAGS)) {
+        if (!tags.contains(tag, Qt::CaseInsensitive)) {
+            tags.append(tag);
+        }
+    }
+    return m_dbManager->setNoteTags(noteId, tags.join(","));
+}
+
+void AiBatchProcessor::markNote(int noteId, int status)
+{
+    m_dbManager->setAiBatchItemStatus(m_jobId, noteId, status);
+    if (status == DatabaseManager::AiBatchItemSucceeded) {
+        m_succeeded++;
+    } else if (status == DatabaseManager::AiBatchItemSkipped) {
+        m_skipped++;
+    } else {
+        m_failed++;
+    }
+    emit progressChanged(m_succeeded + m_failed + m_skipped, m_total);
+}
+
+void AiBatchProcessor::pause(const QString &errorMessage)
+{
+    qWarning() << "AI批量任务暂停，ID:" << m_jobId << "原因:" << errorMessage;
+
+    // 仍在进行的请求被取消，对应笔记在检查点中仍为未处理
+    QString description = operationDescription(m_operation);
+    reset();
+    emit jobFailed(description, errorMessage);
+}
+
+void AiBatchProcessor::reset()
+{
+    if (m_aiService) {
+        for (auto it = m_inFlight.constBegin(); it != m_inFlight.constEnd(); ++it) {
+            m_aiService->cancelRequest(it.key());
+        }
+    }
+    m_inFlight.clear();
+    m_queue.clear();
+    m_failureStreak.clear();
+    m_jobId = -1;
+    m_total = 0;
+    m_succeeded = 0;
+    m_failed = 0;
+    m_skipped = 0;
+}
+
+QStringList AiBatchProcessor::parseTags(const QString &text)
+{
+    static const QRegularExpression separators("[,，、;；\\n#]");
+
+    QStringList tags;
+    const QStringList parts = text.split(separators, Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        QString tag = part.trimmed();
+        if (!tag.isEmpty() && !tags.contains(tag, Qt::CaseInsensitive)) {
+            tags.append(tag);
+        }
+    }
+    return tags;
+}
@@ -0,0 +1,197 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-05 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-05 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\aibatchprocessor.h
+ * @Description: AI批量处理器，对文件夹或搜索结果中的多篇笔记执行总结、生成标签或纠错
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef AIBATCHPROCESSOR_H
+#define AIBATCHPROCESSOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QStringList>
+#include "IAiService.h"
+
+class DatabaseManager;
+
+/**
+ * @brief AI批量处理器
+ *
+ * 笔记逐篇以后台优先级提交给AI服务，同时处理的笔记数有上限，交互请求仍然优先发出。
+ * 每篇笔记处理完成后立即写回结果并更新数据库中的检查点，程序退出或崩溃后可以从未处理的笔记继续。
+ * 同一时间只运行一个批量任务。
+ */
+class AiBatchProcessor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation {
+        SummarizeOperation, // 总结，结果保存到NoteAiResults，在编辑器的"AI结果"中查看
+        TagOperation,       // 生成标签，合并到笔记已有的标签中
+        FixOperation        // 语法纠错，结果保存到NoteAiResults，不覆盖笔记正文，由用户在"AI结果"中确认应用
+    };
+
+    static const int MAX_NOTES_IN_FLIGHT = 2;      // 同时处理的笔记数
+    static const int MAX_CONSECUTIVE_FAILURES = 3; // 连续失败达到该次数时暂停任务
+    static const int TAG_INPUT_CHARS = 4000;       // 生成标签时最多发送的字符数
+    static const int MAX_TAGS = 5;                 // 每次生成的标签数上限
+
+    /**
+     * @param dbManager 数据库管理器，用于读取笔记、写回结果和保存检查点
+     * @param parent 父对象
+     */
+    explicit AiBatchProcessor(DatabaseManager *dbManager, QObject *parent = nullptr);
+    ~AiBatchProcessor();
+
+    /**
+     * @brief 设置AI服务
+     * @param aiService AI服务
+     */
+    void setAiService(IAiService *aiService);
+
+    /**
+     * @brief 开始批量任务
+     * @param operation 操作类型
+     * @param noteIds 需要处理的笔记ID
+     * @param sourceName 笔记来源描述，如文件夹名称
+     * @return bool 是否已开始，已有任务运行、没有笔记或没有AI服务时返回false
+     */
+    bool start(Operation operation, const QList<int> &noteIds, const QString &sourceName);
+
+    /**
+     * @brief 继续上次未完成的批量任务
+     * @return bool 是否有任务被继续
+     */
+    bool resumePendingJob();
+
+    /**
+     * @brief 取消当前任务，已写回的结果保留，检查点被删除
+     */
+    void cancel();
+
+    /**
+     * @brief 放弃已暂停的任务，剩余笔记不再处理
+     */
+    void discardPendingJob();
+
+    /**
+     * @brief 是否有任务正在运行
+     */
+    bool isRunning() const { return m_jobId > 0; }
+
+    /**
+     * @brief 操作类型的标识符，保存在检查点中
+     */
+    static QString operationName(Operation operation);
+
+    /**
+     * @brief 操作类型的描述性文字
+     */
+    static QString operationDescription(Operation operation);
+
+    /**
+     * @brief 根据标识符获取操作类型
+     * @param name 标识符
+     * @param operation 输出的操作类型
+     * @return bool 标识符是否有效
+     */
+    static bool operationFromName(const QString &name, Operation *operation);
+
+signals:
+    /**
+     * @brief 任务开始(或从检查点继续)
+     * @param description 操作描述
+     * @param sourceName 笔记来源描述
+     * @param processed 已处理的笔记数，继续的任务不为0
+     * @param total 笔记总数
+     */
+    void jobStarted(const QString &description, const QString &sourceName, int processed, int total);
+
+    /**
+     * @brief 处理进度变化
+     * @param processed 已处理的笔记数(包括失败和跳过的)
+     * @param total 笔记总数
+     */
+    void progressChanged(int processed, int total);
+
+    /**
+     * @brief 任务结束
+     * @param description 操作描述
+     * @param succeeded 成功的笔记数
+     * @param failed 失败的笔记数
+     * @param skipped 跳过的笔记数(已删除或没有内容)
+     * @param cancelled 是否被取消
+     */
+    void jobFinished(const QString &description, int succeeded, int failed, int skipped, bool cancelled);
+
+    /**
+     * @brief 任务因错误暂停，检查点保留，下次启动时继续
+     * @param description 操作描述
+     * @param errorMessage 错误信息
+     */
+    void jobFailed(const QString &description, const QString &errorMessage);
+
+private slots:
+    void onRequestFinished(int requestId, const QString &generatedText);
+    void onRequestFailed(int requestId, const QString &errorMessage);
+
+private:
+    /**
+     * @brief 在未达到并发上限时继续提交笔记，全部完成后结束任务
+     */
+    void submitNext();
+
+    /**
+     * @brief 以后台优先级提交一篇笔记
+     * @return int 请求ID，未发出时为0
+     */
+    int submitNote(const QString &text);
+
+    /**
+     * @brief 写回一篇笔记的处理结果
+     * @return bool 是否成功
+     */
+    bool writeResult(int noteId, const QString &generatedText);
+
+    /**
+     * @brief 记录一篇笔记的处理结果并更新检查点
+     * @param status 处理状态(DatabaseManager::AiBatchItemStatus)
+     */
+    void markNote(int noteId, int status);
+
+    /**
+     * @brief 暂停任务，未完成的笔记在检查点中保持未处理
+     */
+    void pause(const QString &errorMessage);
+
+    /**
+     * @brief 取消仍在进行的请求并清空任务状态
+     */
+    void reset();
+
+    /**
+     * @brief 把AI返回的标签文本解析为标签列表
+     */
+    static QStringList parseTags(const QString &text);
+
+    DatabaseManager *m_dbManager;
+    QPointer<IAiService> m_aiService;
+    int m_jobId = -1;                   // 当前任务ID，没有任务时为-1
+    Operation m_operation = SummarizeOperation;
+    QList<int> m_queue;                 // 尚未提交的笔记ID
+    QHash<int, int> m_inFlight;         // 请求ID -> 笔记ID
+    QList<int> m_failureStreak;         // 连续失败的笔记ID，暂停时恢复为未处理
+    int m_total = 0;
+    int m_succeeded = 0;
+    int m_failed = 0;
+    int m_skipped = 0;
+};
+
+#endif // AIBATCHPROCESSOR_H
@@ -0,0 +1,251 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-03 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-03 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\airequestscheduler.cpp
+ * @Description: AI请求调度器实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "airequestscheduler.h"
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <climits>
+#include <QDebug>
+
+AiRequestScheduler::AiRequestScheduler(QNetworkAccessManager *manager, QObject *parent)
+    : QObject(parent)
+    , m_manager(manager)
+    , m_resumeTimer(new QTimer(this))
+{
+    m_resumeTimer->setSingleShot(true);
+    connect(m_resumeTimer, &QTimer::timeout, this, &AiRequestScheduler::dispatch);
+}
+
+AiRequestScheduler::~AiRequestScheduler()
+{
+    // 中止仍在发送的请求，析构期间不再发出信号
+    QList<QNetworkReply*> replies;
+    for (const Request &request : m_requests) {
+        if (request.reply) {
+            replies.append(request.reply);
+        }
+    }
+    m_requests.clear();
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void AiRequestScheduler::setMaxInFlight(int maxInFlight)
+{
+    m_maxInFlight = qMax(1, maxInFlight);
+    dispatch();
+}
+
+int AiRequestScheduler::submit(const QNetworkRequest &request, const QByteArray &body, Priority priority)
+{
+    Request entry;
+    entry.id = m_nextId++;
+    entry.request = request;
+    entry.body = body;
+    entry.priority = priority;
+    m_requests.insert(entry.id, entry);
+    m_queues[priority].append(entry.id);
+
+    qDebug() << "AI请求入队，ID:" << entry.id << "优先级:" << priority
+             << "排队:" << pendingCount() << "发送中:" << m_inFlight;
+
+    // 在下一次事件循环中发送，调用方可以先用返回的ID登记请求再收到requestStarted
+    QMetaObject::invokeMethod(this, "dispatch", Qt::QueuedConnection);
+    return entry.id;
+}
+
+bool AiRequestScheduler::cancel(int requestId)
+{
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end()) {
+        return false;
+    }
+
+    Request request = it.value();
+    m_requests.erase(it);
+    m_queues[request.priority].removeOne(requestId);
+    delete request.retryTimer;
+
+    if (request.reply) {
+        // 已从m_requests中移除，中止触发的finished信号会被忽略
+        QNetworkReply *reply = request.reply;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+        --m_inFlight;
+        dispatch();
+    }
+
+    qDebug() << "AI请求已取消，ID:" << requestId;
+    return true;
+}
+
+void AiRequestScheduler::markDelivered(int requestId)
+{
+    auto it = m_requests.find(requestId);
+    if (it != m_requests.end()) {
+        it->delivered = true;
+    }
+}
+
+int AiRequestScheduler::pendingCount() const
+{
+    return m_requests.size() - m_inFlight;
+}
+
+void AiRequestScheduler::dispatch()
+{
+    // 限流暂停期间等待恢复定时器
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (m_pausedUntil > now) {
+        if (!m_resumeTimer->isActive()) {
+            m_resumeTimer->start(int(m_pausedUntil - now));
+        }
+        return;
+    }
+
+    while (m_inFlight < m_maxInFlight) {
+        // 交互请求优先
+        QList<int> &queue = !m_queues[InteractivePriority].isEmpty() ? m_queues[InteractivePriority]
+                                                                     : m_queues[BackgroundPriority];
+        if (queue.isEmpty()) {
+            return;
+        }
+
+        int requestId = queue.takeFirst();
+        Request &request = m_requests[requestId];
+        request.attempts++;
+        request.reply = m_manager->post(request.request, request.body);
+        m_inFlight++;
+
+        QNetworkReply *reply = request.reply;
+        connect(reply, &QNetworkReply::finished, this, [this, requestId, reply]() {
+            onReplyFinished(requestId, reply);
+        });
+        emit requestStarted(requestId, reply);
+    }
+}
+
+void AiRequestScheduler::onReplyFinished(int requestId, QNetworkReply *reply)
+{
+    auto it = m_requests.find(requestId);
+    if (it == m_requests.end() || it->reply != reply) {
+        return;
+    }
+
+    m_inFlight--;
+    it->reply = nullptr;
+
+    if (shouldRetry(it.value(), reply)) {
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        int delay = retryDelayMs(it.value(), reply);
+        qWarning() << "AI请求失败，ID:" << requestId << "HTTP状态码:" << status
+                   << "，" << delay << "毫秒后进行第" << it->attempts << "次重试";
+        reply->deleteLater();
+
+        // 限流时暂停整个队列，其余请求也不再立即发出
+        if (status == 429) {
+            m_pausedUntil = qMax(m_pausedUntil, QDateTime::currentMSecsSinceEpoch() + delay);
+        }
+
+        QTimer *retryTimer = new QTimer(this);
+        retryTimer->setSingleShot(true);
+        connect(retryTimer, &QTimer::timeout, this, [this, requestId, retryTimer]() {
+            retryTimer->deleteLater();
+            auto retryIt = m_requests.find(requestId);
+            if (retryIt == m_requests.end()) {
+                return;
+            }
+            retryIt->retryTimer = nullptr;
+            // 重试的请求排在同一优先级的最前面
+            m_queues[retryIt->priority].prepend(requestId);
+            dispatch();
+        });
+        it->retryTimer = retryTimer;
+        retryTimer->start(delay);
+
+        dispatch();
+        return;
+    }
+
+    m_requests.erase(it);
+    dispatch();
+    emit requestFinished(requestId, reply);
+}
+
+bool AiRequestScheduler::shouldRetry(const Request &request, QNetworkReply *reply) const
+{
+    if (request.attempts > MAX_RETRIES) {
+        return false;
+    }
+
+    // 流式回复中途断开时已有片段交给调用方，重发会从头输出，只能按失败处理
+    if (request.delivered) {
+        return false;
+    }
+
+    // 限流和服务器错误在响应头到达时即可确定，此时还没有流式内容交给调用方，重发不会重复输出
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 429 || (status >= 500 && status < 600)) {
+        // 服务器要求的等待时间超过上限时不再重试，直接把错误交给调用方
+        if (retryAfterMs(reply) > MAX_BACKOFF_MS) {
+            qWarning() << "服务器要求" << retryAfterMs(reply) << "毫秒后重试，超过等待上限，不再重试";
+            return false;
+        }
+        return true;
+    }
+    if (status != 0) {
+        return false;
+    }
+
+    // 超时中止和临时网络故障一样按临时故障处理；用户取消的请求已从队列移除，不会走到这里
+    switch (reply->error()) {
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::TimeoutError:
+        return true;
+    case QNetworkReply::OperationCanceledError:
+        return reply->property(TIMED_OUT_PROPERTY).toBool();
+    default:
+        return false;
+    }
+}
+
+int AiRequestScheduler::retryAfterMs(QNetworkReply *reply)
+{
+    // Retry-After以秒为单位，没有或无法解析时返回-1
+    bool ok = false;
+    int retryAfter = reply->rawHeader("Retry-After").trimmed().toInt(&ok);
+    if (!ok || retryAfter < 0) {
+        return -1;
+    }
+    return int(qMin<qint64>(qint64(retryAfter) * 1000, INT_MAX));
+}
+
+int AiRequestScheduler::retryDelayMs(const Request &request, QNetworkReply *reply) const
+{
+    // 优先使用服务器给出的Retry-After，超过上限的情况已在shouldRetry中排除
+    int retryAfter = retryAfterMs(reply);
+    if (retryAfter >= 0) {
+        return retryAfter;
+    }
+
+    // 指数退避，加入最多20%的随机抖动，避免多个请求同时重试
+    qint64 delay = qint64(BASE_BACKOFF_MS) << qMin(request.attempts - 1, 10);
+    delay = qMin<qint64>(delay, MAX_BACKOFF_MS);
+    delay += QRandomGenerator::global()->bounded(int(delay / 5) + 1);
+    return int(delay);
+}
@@ -0,0 +1,146 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-03 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-03 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\airequestscheduler.h
+ * @Description: AI请求调度器，限制并发、区分优先级并在限流或服务器错误时退避重试
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef AIREQUESTSCHEDULER_H
+#define AIREQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include <QNetworkRequest>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+/**
+ * @brief AI请求调度器
+ *
+ * 所有请求先进入队列，同时发出的请求数不超过上限；对话框等交互请求优先于后台批量请求。
+ * 服务器返回429或5xx时按指数退避重新发送，429还会暂停整个队列，避免继续触发限流。
+ * 已有流式内容交给调用方的请求不再重试，否则重发的回复会与已显示的内容重复。
+ * 每个请求有唯一ID，可以在排队、等待重试或发送过程中取消，取消后不再发出任何信号。
+ */
+class AiRequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        InteractivePriority = 0, // 用户正在等待结果的请求
+        BackgroundPriority = 1   // 后台批量请求
+    };
+
+    static const int DEFAULT_MAX_IN_FLIGHT = 2; // 默认最多同时发出的请求数
+    static const int MAX_RETRIES = 3;           // 最多重试次数
+    static const int BASE_BACKOFF_MS = 1000;    // 首次重试的等待时间
+    static const int MAX_BACKOFF_MS = 30000;    // 重试等待时间上限，服务器要求等待更久时不再重试
+
+    // 调用方因超时中止请求时在reply上设置为true的属性，超时按临时故障重试
+    static constexpr const char *TIMED_OUT_PROPERTY = "timedOut";
+
+    /**
+     * @param manager 用于发送请求的网络管理器
+     * @param parent 父对象
+     */
+    explicit AiRequestScheduler(QNetworkAccessManager *manager, QObject *parent = nullptr);
+    ~AiRequestScheduler();
+
+    /**
+     * @brief 设置最多同时发出的请求数
+     * @param maxInFlight 请求数，至少为1
+     */
+    void setMaxInFlight(int maxInFlight);
+
+    /**
+     * @brief 提交POST请求
+     * @param request 网络请求
+     * @param body 请求体
+     * @param priority 优先级
+     * @return int 请求ID，大于0
+     */
+    int submit(const QNetworkRequest &request, const QByteArray &body, Priority priority);
+
+    /**
+     * @brief 分配一个不对应任何请求的ID，供由多个请求组成的任务使用，与请求ID互不重复
+     * @return int 任务ID，大于0
+     */
+    int allocateRequestId() { return m_nextId++; }
+
+    /**
+     * @brief 取消请求，正在发送的请求被中止
+     * @param requestId 请求ID
+     * @return bool 请求是否存在且尚未完成
+     */
+    bool cancel(int requestId);
+
+    /**
+     * @brief 标记请求已有内容交给调用方，此后出错不再重试
+     * @param requestId 请求ID
+     */
+    void markDelivered(int requestId);
+
+    /**
+     * @brief 排队和等待重试的请求数
+     */
+    int pendingCount() const;
+
+    /**
+     * @brief 正在发送的请求数
+     */
+    int inFlightCount() const { return m_inFlight; }
+
+signals:
+    /**
+     * @brief 请求(或其一次重试)已发出，可在此连接readyRead接收流式数据
+     * @param requestId 请求ID
+     * @param reply 本次发送的网络响应对象
+     */
+    void requestStarted(int requestId, QNetworkReply *reply);
+
+    /**
+     * @brief 请求完成(成功，或出错且不再重试)，接收方负责对reply调用deleteLater
+     * @param requestId 请求ID
+     * @param reply 最后一次发送的网络响应对象
+     */
+    void requestFinished(int requestId, QNetworkReply *reply);
+
+private slots:
+    void dispatch();
+
+private:
+    struct Request {
+        int id = 0;
+        QNetworkRequest request;
+        QByteArray body;
+        Priority priority = InteractivePriority;
+        int attempts = 0;                 // 已发送次数
+        bool delivered = false;           // 是否已有流式内容交给调用方
+        QNetworkReply *reply = nullptr;   // 正在发送时的响应对象
+        QTimer *retryTimer = nullptr;     // 等待重试时的定时器
+    };
+
+    void onReplyFinished(int requestId, QNetworkReply *reply);
+    bool shouldRetry(const Request &request, QNetworkReply *reply) const;
+    int retryDelayMs(const Request &request, QNetworkReply *reply) const;
+    static int retryAfterMs(QNetworkReply *reply);
+
+    QNetworkAccessManager *m_manager;
+    QHash<int, Request> m_requests;
+    QList<int> m_queues[2];      // 按优先级排队等待发送的请求ID
+    int m_inFlight = 0;
+    int m_maxInFlight = DEFAULT_MAX_IN_FLIGHT;
+    int m_nextId = 1;
+    qint64 m_pausedUntil = 0;    // 触发限流后暂停发送直到该时间(毫秒时间戳)
+    QTimer *m_resumeTimer;       // 暂停结束后恢复发送
+};
+
+#endif // AIREQUESTSCHEDULER_H
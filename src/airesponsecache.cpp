@@ -0,0 +1,252 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-02 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-02 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\airesponsecache.cpp
+ * @Description: AI回复的持久化缓存实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "airesponsecache.h"
+#include "settingsdialog.h"
+
+#include <QtSql/QSqlQuery>
+#include <QtSql/QSqlError>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QSettings>
+#include <QStringList>
+#include <QDir>
+#include <QDebug>
+
+AiResponseCache::Config AiResponseCache::Config::fromSettings()
+{
+    // 与SettingsDialog使用同一份INI配置
+    QSettings settings(QSettings::IniFormat, QSettings::UserScope,
+                       QCoreApplication::organizationName(), QCoreApplication::applicationName());
+    Config config;
+    config.enabled = settings.value("AIService/CacheEnabled", config.enabled).toBool();
+    config.ttlDays = qMax(1, settings.value("AIService/CacheTtlDays", config.ttlDays).toInt());
+    config.maxSizeMB = qMax(1, settings.value("AIService/CacheMaxSizeMB", config.maxSizeMB).toInt());
+    return config;
+}
+
+AiResponseCache::AiResponseCache()
+{
+}
+
+AiResponseCache::~AiResponseCache()
+{
+    close();
+}
+
+void AiResponseCache::setConfig(const Config &config)
+{
+    m_config = config;
+    if (!m_config.enabled) {
+        close();
+    }
+}
+
+QString AiResponseCache::makeKey(const QString &operation, const QString &model,
+                                 const QString &systemPrompt, const QString &input)
+{
+    // 各字段之间用单元分隔符隔开，避免不同组合拼接出相同的内容
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    const QStringList parts = {operation, model, systemPrompt, input};
+    for (const QString &part : parts) {
+        hash.addData(part.toUtf8());
+        hash.addData(QByteArray(1, '\x1f'));
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool AiResponseCache::ensureOpen()
+{
+    if (m_db.isOpen()) {
+        return true;
+    }
+    if (m_openFailed) {
+        return false;
+    }
+
+    // 与notes.db放在同一目录，删除缓存文件不影响笔记数据
+    QString notebookPath = SettingsDialog::getNotebookPath();
+    QDir().mkpath(notebookPath);
+    QString dbPath = notebookPath + "/" + DATABASE_FILE_NAME;
+
+    m_db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    m_db.setDatabaseName(dbPath);
+    if (!m_db.open()) {
+        qWarning() << "无法打开AI回复缓存:" << m_db.lastError().text();
+        m_openFailed = true;
+        close();
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    if (!query.exec("CREATE TABLE IF NOT EXISTS AiResponses ("
+                    "cache_key TEXT PRIMARY KEY, "
+                    "operation TEXT NOT NULL, "
+                    "model TEXT NOT NULL, "
+                    "response TEXT NOT NULL, "
+                    "size INTEGER NOT NULL, "
+                    "created_at INTEGER NOT NULL, "
+                    "last_used_at INTEGER NOT NULL)")
+        || !query.exec("CREATE INDEX IF NOT EXISTS idx_ai_responses_last_used ON AiResponses(last_used_at)")) {
+        qWarning() << "创建AI回复缓存表失败:" << query.lastError().text();
+        m_openFailed = true;
+        close();
+        return false;
+    }
+
+    qDebug() << "AI回复缓存路径:" << dbPath;
+
+    // 打开时清理一次过期条目
+    removeExpired();
+    return true;
+}
+
+void AiResponseCache::close()
+{
+    if (!m_db.isValid()) {
+        return;
+    }
+
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+bool AiResponseCache::lookup(const QString &key, QString *response)
+{
+    if (!m_config.enabled || !ensureOpen()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare("SELECT response, created_at FROM AiResponses WHERE cache_key = :key");
+    query.bindValue(":key", key);
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    qint64 createdAt = query.value(1).toLongLong();
+    if (now - createdAt > qint64(m_config.ttlDays) * 24 * 3600) {
+        QSqlQuery remove(m_db);
+        remove.prepare("DELETE FROM AiResponses WHERE cache_key = :key");
+        remove.bindValue(":key", key);
+        remove.exec();
+        return false;
+    }
+
+    if (response) {
+        *response = query.value(0).toString();
+    }
+    query.finish();
+
+    QSqlQuery touch(m_db);
+    touch.prepare("UPDATE AiResponses SET last_used_at = :now WHERE cache_key = :key");
+    touch.bindValue(":now", now);
+    touch.bindValue(":key", key);
+    touch.exec();
+
+    return true;
+}
+
+bool AiResponseCache::store(const QString &key, const QString &operation, const QString &model, const QString &response)
+{
+    if (!m_config.enabled || response.isEmpty() || !ensureOpen()) {
+        return false;
+    }
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR REPLACE INTO AiResponses "
+                  "(cache_key, operation, model, response, size, created_at, last_used_at) "
+                  "VALUES (:key, :operation, :model, :response, :size, :now, :now)");
+    query.bindValue(":key", key);
+    query.bindValue(":operation", operation);
+    query.bindValue(":model", model);
+    query.bindValue(":response", response);
+    query.bindValue(":size", response.toUtf8().size());
+    query.bindValue(":now", now);
+    if (!query.exec()) {
+        qWarning() << "保存AI回复缓存失败:" << query.lastError().text();
+        return false;
+    }
+
+    enforceSizeLimit();
+    return true;
+}
+
+bool AiResponseCache::clear()
+{
+    if (!ensureOpen()) {
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    if (!query.exec("DELETE FROM AiResponses")) {
+        qWarning() << "清除AI回复缓存失败:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void AiResponseCache::removeExpired()
+{
+    qint64 expireBefore = QDateTime::currentSecsSinceEpoch() - qint64(m_config.ttlDays) * 24 * 3600;
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM AiResponses WHERE created_at < :expire");
+    query.bindValue(":expire", expireBefore);
+    if (!query.exec()) {
+        qWarning() << "清理过期AI回复缓存失败:" << query.lastError().text();
+    } else if (query.numRowsAffected() > 0) {
+        qDebug() << "清理过期AI回复缓存:" << query.numRowsAffected() << "条";
+    }
+}
+
+void AiResponseCache::enforceSizeLimit()
+{
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT COALESCE(SUM(size), 0) FROM AiResponses") || !query.next()) {
+        return;
+    }
+
+    qint64 maxSize = qint64(m_config.maxSizeMB) * 1024 * 1024;
+    qint64 excess = query.value(0).toLongLong() - maxSize;
+    query.finish();
+    if (excess <= 0) {
+        return;
+    }
+
+    // 从最久未使用的条目开始删除，直到总大小不超过上限
+    QStringList keys;
+    QSqlQuery oldest(m_db);
+    oldest.setForwardOnly(true);
+    if (!oldest.exec("SELECT cache_key, size FROM AiResponses ORDER BY last_used_at ASC")) {
+        return;
+    }
+    while (excess > 0 && oldest.next()) {
+        keys.append(oldest.value(0).toString());
+        excess -= oldest.value(1).toLongLong();
+    }
+    oldest.finish();
+
+    QSqlQuery remove(m_db);
+    remove.prepare("DELETE FROM AiResponses WHERE cache_key = :key");
+    m_db.transaction();
+    for (const QString &key : keys) {
+        remove.bindValue(":key", key);
+        remove.exec();
+    }
+    m_db.commit();
+
+    qDebug() << "AI回复缓存超过大小上限，删除" << keys.size() << "条最久未使用的条目";
+}
@@ -0,0 +1,107 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-02 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-02 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\airesponsecache.h
+ * @Description: AI回复的持久化缓存
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef AIRESPONSECACHE_H
+#define AIRESPONSECACHE_H
+
+#include <QString>
+#include <QtSql/QSqlDatabase>
+
+/**
+ * @brief 按(操作, 模型, 系统提示词, 输入文本)缓存AI回复
+ *
+ * 对同一段文本重复执行润色、总结等操作时直接返回上次的结果，不再请求网络。
+ * 缓存保存在笔记库目录下的ai_cache.db中，与notes.db分开，删除不影响笔记数据。
+ * 条目超过有效期后失效；总大小超过上限时删除最久未使用的条目。
+ */
+class AiResponseCache
+{
+public:
+    static constexpr const char *CONNECTION_NAME = "ai_cache_connection";
+    static constexpr const char *DATABASE_FILE_NAME = "ai_cache.db";
+
+    // 缓存配置，保存在QSettings的AIService分组下
+    struct Config {
+        bool enabled = true;  // 是否启用缓存
+        int ttlDays = 7;      // 条目有效期(天)
+        int maxSizeMB = 20;   // 回复文本总大小上限(MB)
+
+        /**
+         * @brief 从QSettings读取缓存配置
+         * @return Config 缓存配置
+         */
+        static Config fromSettings();
+    };
+
+    AiResponseCache();
+    ~AiResponseCache();
+
+    /**
+     * @brief 设置缓存配置，关闭缓存时不再打开数据库
+     * @param config 缓存配置
+     */
+    void setConfig(const Config &config);
+
+    /**
+     * @brief 缓存是否启用
+     */
+    bool isEnabled() const { return m_config.enabled; }
+
+    /**
+     * @brief 计算缓存键
+     * @param operation 操作类型标识符
+     * @param model 模型名称
+     * @param systemPrompt 系统提示词
+     * @param input 用户输入的文本
+     * @return QString 十六进制的SHA-256摘要
+     */
+    static QString makeKey(const QString &operation, const QString &model,
+                           const QString &systemPrompt, const QString &input);
+
+    /**
+     * @brief 查找未过期的回复，命中时更新最近使用时间
+     * @param key 缓存键
+     * @param response 输出命中的回复
+     * @return bool 是否命中
+     */
+    bool lookup(const QString &key, QString *response);
+
+    /**
+     * @brief 保存回复，超过大小上限时删除最久未使用的条目
+     * @param key 缓存键
+     * @param operation 操作类型标识符，仅用于统计和排查
+     * @param model 模型名称
+     * @param response 回复文本
+     * @return bool 是否保存成功
+     */
+    bool store(const QString &key, const QString &operation, const QString &model, const QString &response);
+
+    /**
+     * @brief 删除全部缓存条目
+     * @return bool 是否成功
+     */
+    bool clear();
+
+    /**
+     * @brief 关闭缓存数据库连接，下次查找或保存时重新打开
+     */
+    void close();
+
+private:
+    bool ensureOpen();
+    void removeExpired();
+    void enforceSizeLimit();
+
+    Config m_config;
+    QSqlDatabase m_db;
+    bool m_openFailed = false; // 打开失败后不再重试，直接按未命中处理
+};
+
+#endif // AIRESPONSECACHE_H
@@ -0,0 +1,133 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-04 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-04 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\aitextchunker.cpp
+ * @Description: 长文本切分实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "aitextchunker.h"
+
+#include <QtMath>
+
+double AiTextChunker::charTokens(QChar ch)
+{
+    // 中日韩字符及全角符号通常各占一个token，拉丁字母等约4个字符一个token
+    return ch.unicode() >= 0x2E80 ? 1.0 : 0.25;
+}
+
+int AiTextChunker::estimateTokens(const QString &text)
+{
+    double tokens = 0;
+    for (const QChar &ch : text) {
+        tokens += charTokens(ch);
+    }
+    return qCeil(tokens);
+}
+
+QStringList AiTextChunker::split(const QString &text, int tokenBudget)
+{
+    tokenBudget = qMax(1, tokenBudget);
+
+    // 编辑器导出的纯文本可能使用Unicode段落分隔符
+    QString normalized = text;
+    normalized.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+    normalized.replace(QChar::LineSeparator, QLatin1Char('\n'));
+
+    QStringList units;
+    const QStringList lines = normalized.split(QLatin1Char('\n'));
+    for (const QString &line : lines) {
+        if (line.trimmed().isEmpty()) {
+            continue;
+        }
+        if (estimateTokens(line) <= tokenBudget) {
+            units.append(line);
+        } else {
+            units.append(splitParagraph(line, tokenBudget));
+        }
+    }
+
+    return group(units, tokenBudget);
+}
+
+QStringList AiTextChunker::group(const QStringList &pieces, int tokenBudget, const QString &separator)
+{
+    QStringList groups;
+    QString current;
+    int currentTokens = 0;
+    int separatorTokens = estimateTokens(separator);
+
+    for (const QString &piece : pieces) {
+        int tokens = estimateTokens(piece);
+        if (!current.isEmpty() && currentTokens + separatorTokens + tokens > tokenBudget) {
+            groups.append(current);
+            current.clear();
+            currentTokens = 0;
+        }
+        if (!current.isEmpty()) {
+            current += separator;
+            currentTokens += separatorTokens;
+        }
+        current += piece;
+        currentTokens += tokens;
+    }
+
+    if (!current.isEmpty()) {
+        groups.append(current);
+    }
+    return groups;
+}
+
+QStringList AiTextChunker::splitParagraph(const QString &paragraph, int tokenBudget)
+{
+    // 在句末标点之后断句，英文句点需后跟空白，避免拆开小数和缩写
+    QStringList sentences;
+    int start = 0;
+    for (int i = 0; i < paragraph.size(); ++i) {
+        QChar ch = paragraph.at(i);
+        bool isEnd = QStringLiteral("。！？；!?;").contains(ch)
+            || (ch == QLatin1Char('.') && (i + 1 == paragraph.size() || paragraph.at(i + 1).isSpace()));
+        if (isEnd) {
+            sentences.append(paragraph.mid(start, i + 1 - start));
+            start = i + 1;
+        }
+    }
+    if (start < paragraph.size()) {
+        sentences.append(paragraph.mid(start));
+    }
+
+    QStringList pieces;
+    for (const QString &sentence : sentences) {
+        if (estimateTokens(sentence) <= tokenBudget) {
+            pieces.append(sentence);
+        } else {
+            pieces.append(hardCut(sentence, tokenBudget));
+        }
+    }
+
+    // 同一段落内的句子直接拼接，不额外插入换行
+    return group(pieces, tokenBudget, QString());
+}
+
+QStringList AiTextChunker::hardCut(const QString &sentence, int tokenBudget)
+{
+    QStringList pieces;
+    int start = 0;
+    double tokens = 0;
+    for (int i = 0; i < sentence.size(); ++i) {
+        double cost = charTokens(sentence.at(i));
+        // 不在代理对中间截断
+        if (tokens + cost > tokenBudget && i > start && !sentence.at(i).isLowSurrogate()) {
+            pieces.append(sentence.mid(start, i - start));
+            start = i;
+            tokens = 0;
+        }
+        tokens += cost;
+    }
+    if (start < sentence.size()) {
+        pieces.append(sentence.mid(start));
+    }
+    return pieces;
+}
@@ -0,0 +1,57 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-04 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-04 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\aitextchunker.h
+ * @Description: 按token预算把长文本切分为多段，用于分段总结
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef AITEXTCHUNKER_H
+#define AITEXTCHUNKER_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 长文本切分工具
+ *
+ * 优先在段落边界切分，单个段落超出预算时再按句子切分，仍然超出的句子按字符截断。
+ * token数是估算值：中日韩字符按每字1个token，其余字符按每4个字符1个token计算。
+ */
+class AiTextChunker
+{
+public:
+    /**
+     * @brief 估算文本的token数
+     * @param text 文本
+     * @return int 估算的token数
+     */
+    static int estimateTokens(const QString &text);
+
+    /**
+     * @brief 把文本切分为不超过预算的多段，段内保留原有的换行
+     * @param text 纯文本
+     * @param tokenBudget 每段的token预算
+     * @return QStringList 按原文顺序排列的各段，不含空段
+     */
+    static QStringList split(const QString &text, int tokenBudget);
+
+    /**
+     * @brief 按顺序把多个片段合并为不超过预算的若干组
+     * @param pieces 片段
+     * @param tokenBudget 每组的token预算，单个片段超出预算时单独成组
+     * @param separator 组内片段之间的分隔符
+     * @return QStringList 合并后的各组
+     */
+    static QStringList group(const QStringList &pieces, int tokenBudget,
+                             const QString &separator = QStringLiteral("\n"));
+
+private:
+    static QStringList splitParagraph(const QString &paragraph, int tokenBudget);
+    static QStringList hardCut(const QString &sentence, int tokenBudget);
+    static double charTokens(QChar ch);
+};
+
+#endif // AITEXTCHUNKER_H
@@ -0,0 +1,173 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-26 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-26 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\autosavewriter.cpp
+ * @Description: 后台自动保存写入线程实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "autosavewriter.h"
+#include "databasemanager.h"
+#include "texteditormanager.h"
+#include "notedocumentcodec.h"
+
+#include <QTextDocument>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+AutosaveWorker::AutosaveWorker(AutosaveWriter *writer, QObject *parent)
+    : QObject(parent), m_writer(writer)
+{
+}
+
+bool AutosaveWorker::ensureDatabase()
+{
+    if (m_dbManager) {
+        return true;
+    }
+
+    // 数据库连接只能在创建它的线程中使用，因此在写入线程中首次保存时创建
+    // 表结构和迁移已由界面线程的主连接完成，这里只打开连接
+    m_dbManager = new DatabaseManager("autosave_writer_connection", this);
+    m_dbManager->setSecondaryConnection(true);
+    m_dbManager->setTreeCacheEnabled(false);
+    if (!m_dbManager->initialize()) {
+        qCritical() << "自动保存线程初始化数据库失败";
+        delete m_dbManager;
+        m_dbManager = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void AutosaveWorker::drain()
+{
+    while (true) {
+        QHash<int, AutosaveWriter::Snapshot> batch = m_writer->takePending();
+        if (batch.isEmpty()) {
+            return;
+        }
+
+        for (auto it = batch.begin(); it != batch.end(); ++it) {
+            const int noteId = it.key();
+            QTextDocument *document = it.value().document;
+
+            QElapsedTimer timer;
+            timer.start();
+
+            bool success = false;
+            if (ensureDatabase()) {
+                // 序列化在写入线程中完成，界面线程只负责复制文档；
+                // 优先使用二进制格式，含表格等不支持的结构时退回HTML
+                QList<ContentBlock> blocks = NoteDocumentCodec::encode(noteId, document);
+                if (blocks.isEmpty()) {
+                    blocks = TextEditorManager::splitHtmlIntoBlocks(noteId, document->toHtml());
+                }
+                success = m_dbManager->saveNoteContent(noteId, blocks, document->toPlainText());
+            }
+            delete document;
+
+            qDebug() << "自动保存笔记" << noteId << (success ? "成功" : "失败") << "，耗时" << timer.elapsed() << "毫秒";
+            emit noteSaved(noteId, it.value().generation, success);
+        }
+    }
+}
+
+void AutosaveWorker::closeDatabase()
+{
+    // 连接在创建它的写入线程中关闭
+    delete m_dbManager;
+    m_dbManager = nullptr;
+}
+
+AutosaveWriter::AutosaveWriter(QObject *parent)
+    : QObject(parent)
+{
+    m_worker = new AutosaveWorker(this);
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &AutosaveWorker::noteSaved, this, &AutosaveWriter::noteSaved);
+    m_thread.setObjectName("AutosaveThread");
+    m_thread.start();
+}
+
+AutosaveWriter::~AutosaveWriter()
+{
+    // 退出前写完所有已提交的快照
+    flush();
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void AutosaveWriter::submit(int noteId, int generation, QTextDocument *snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+
+    // 快照交给写入线程使用和释放
+    snapshot->setParent(nullptr);
+    snapshot->moveToThread(&m_thread);
+
+    bool scheduleDrain = false;
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // 尚未写入的旧快照直接被新快照取代
+        auto it = m_pending.find(noteId);
+        if (it != m_pending.end()) {
+            it.value().document->deleteLater();
+            it.value().generation = generation;
+            it.value().document = snapshot;
+        } else {
+            Snapshot pending;
+            pending.generation = generation;
+            pending.document = snapshot;
+            m_pending.insert(noteId, pending);
+        }
+
+        if (!m_drainScheduled) {
+            m_drainScheduled = true;
+            scheduleDrain = true;
+        }
+    }
+
+    if (scheduleDrain) {
+        QMetaObject::invokeMethod(m_worker, "drain", Qt::QueuedConnection);
+    }
+}
+
+void AutosaveWriter::flush()
+{
+    if (!m_thread.isRunning()) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_worker, "drain", Qt::BlockingQueuedConnection);
+}
+
+void AutosaveWriter::releaseDatabase()
+{
+    if (!m_thread.isRunning()) {
+        return;
+    }
+
+    flush();
+    QMetaObject::invokeMethod(m_worker, "closeDatabase", Qt::BlockingQueuedConnection);
+}
+
+QHash<int, AutosaveWriter::Snapshot> AutosaveWriter::takePending()
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<int, Snapshot> batch;
+    batch.swap(m_pending);
+    if (batch.isEmpty()) {
+        m_drainScheduled = false;
+    }
+    return batch;
+}
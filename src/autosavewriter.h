@@ -0,0 +1,119 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-26 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-26 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\autosavewriter.h
+ * @Description: 后台自动保存写入线程
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef AUTOSAVEWRITER_H
+#define AUTOSAVEWRITER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+
+class QTextDocument;
+class DatabaseManager;
+class AutosaveWriter;
+
+/**
+ * @brief 运行在写入线程中的工作对象，持有独立的数据库连接
+ */
+class AutosaveWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AutosaveWorker(AutosaveWriter *writer, QObject *parent = nullptr);
+
+public slots:
+    /**
+     * @brief 写入所有待保存的快照，直到队列为空
+     */
+    void drain();
+
+    /**
+     * @brief 关闭写入线程的数据库连接，下次写入时重新打开
+     */
+    void closeDatabase();
+
+signals:
+    void noteSaved(int noteId, int generation, bool success);
+
+private:
+    AutosaveWriter *m_writer;
+    DatabaseManager *m_dbManager = nullptr;
+
+    bool ensureDatabase();
+};
+
+/**
+ * @brief 自动保存写入器，界面线程提交文档快照，写入线程负责序列化和数据库事务
+ *
+ * 快照是编辑器文档的副本(QTextDocument::clone)，toHtml、拆分内容块和写库都在写入线程完成。
+ * 同一笔记在写入前提交的多个快照只保留最新的一个，所有写入在同一线程中按顺序执行。
+ */
+class AutosaveWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AutosaveWriter(QObject *parent = nullptr);
+    ~AutosaveWriter();
+
+    /**
+     * @brief 提交笔记快照，写入器接管快照的所有权
+     * @param noteId 笔记ID
+     * @param generation 快照对应的编辑版本号，随noteSaved信号返回
+     * @param snapshot 文档副本，需在界面线程中创建且没有父对象
+     */
+    void submit(int noteId, int generation, QTextDocument *snapshot);
+
+    /**
+     * @brief 阻塞等待所有已提交的快照写入完成(退出程序前调用)
+     */
+    void flush();
+
+    /**
+     * @brief 写完所有已提交的快照后关闭写入线程的数据库连接
+     *
+     * 恢复备份或迁移笔记本前调用，保证没有排队中的保存落到替换后的数据库里，
+     * 且写入线程不再占用数据库文件。之后提交的快照会重新打开连接。
+     */
+    void releaseDatabase();
+
+signals:
+    /**
+     * @brief 快照写入完成，在界面线程中发出
+     * @param noteId 笔记ID
+     * @param generation 快照的编辑版本号
+     * @param success 是否写入成功
+     */
+    void noteSaved(int noteId, int generation, bool success);
+
+private:
+    friend class AutosaveWorker;
+
+    struct Snapshot {
+        int generation = 0;
+        QTextDocument *document = nullptr;
+    };
+
+    QThread m_thread;
+    AutosaveWorker *m_worker;
+    QMutex m_mutex; // 保护m_pending和m_drainScheduled
+    QHash<int, Snapshot> m_pending; // 笔记ID -> 最新的待写入快照
+    bool m_drainScheduled = false;
+
+    /**
+     * @brief 取出所有待写入的快照，队列为空时清除调度标记
+     * @return QHash<int, Snapshot> 取出的快照
+     */
+    QHash<int, Snapshot> takePending();
+};
+
+#endif // AUTOSAVEWRITER_H
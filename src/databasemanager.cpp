@@ -10,10 +10,20 @@
  */
 #include "databasemanager.h"
 #include "settingsdialog.h"
+#include "mediastore.h"
+#include "notedocumentcodec.h"
 #include <QCoreApplication>
 #include <QFile>
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QTextDocumentFragment>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QSet>
+#include <algorithm>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <climits>
 
 DatabaseManager::DatabaseManager(QObject *parent)
     : QObject(parent)
@@ -21,12 +31,27 @@ DatabaseManager::DatabaseManager(QObject *parent)
     // 在构造函数中不执行初始化，让调用者决定何时初始化
 }
 
+DatabaseManager::DatabaseManager(const QString &connectionName, QObject *parent)
+    : QObject(parent), m_connectionName(connectionName)
+{
+}
+
 DatabaseManager::~DatabaseManager()
 {
+    // 缓存的语句需在连接关闭前释放
+    qDeleteAll(m_statementCache);
+    m_statementCache.clear();
+    
     // 关闭数据库连接
     if (m_db.isOpen()) {
         m_db.close();
     }
+    
+    // 命名连接需要在析构时移除，释放前先清空对连接的引用
+    if (!m_connectionName.isEmpty()) {
+        m_db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
 }
 
 bool DatabaseManager::initialize()
@@ -52,28 +77,260 @@ bool DatabaseManager::initialize()
     }
     qDebug() << "媒体文件夹路径:" << m_mediaPath;
     
-    // 初始化数据库连接
-    m_db = QSqlDatabase::addDatabase("QSQLITE");
+    // 初始化数据库连接，工作线程使用独立的命名连接
+    m_db = m_connectionName.isEmpty() ? QSqlDatabase::addDatabase("QSQLITE")
+                                      : QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
     m_db.setDatabaseName(m_dbPath);
     
+    // 连接选项：忙等待超时使读写连接并发时不会立即返回SQLITE_BUSY
+    StorageConfig config = StorageConfig::fromSettings();
+    m_compressContent = config.compressContent;
+    QString connectOptions = QString("QSQLITE_BUSY_TIMEOUT=%1").arg(config.busyTimeoutMs);
+    if (m_readOnly) {
+        connectOptions += ";QSQLITE_OPEN_READONLY";
+    }
+    m_db.setConnectOptions(connectOptions);
+    
     // 打开数据库
     if (!m_db.open()) {
         qCritical() << "无法打开数据库:" << m_db.lastError().text();
         return false;
     }
     
+    // 应用存储配置，失败只影响性能，不影响使用
+    applyStorageConfig(config);
+    
+    // 只读连接和辅助连接不修改表结构，只检测全文索引状态；表结构和迁移由主连接负责
+    if (m_readOnly || m_secondary) {
+        m_ftsEnabled = detectFullTextIndex();
+        return true;
+    }
+    
     // 创建数据库表
     if (!createTables()) {
         qCritical() << "创建数据库表失败";
         return false;
     }
     
+    // 压缩已有内容块，失败时旧块仍按未压缩读取
+    if (m_compressContent) {
+        migrateContentCompression();
+    }
+    
+    // 旧版本的媒体文件迁移为按内容哈希存放，纳入引用计数清理
+    migrateLegacyMediaFiles();
+    
+    // 补写绕过DatabaseManager写入的笔记的纯文本，否则搜索不到其正文
+    backfillNoteTexts();
+    
+    // 加载文件夹/笔记层级缓存，失败时读取接口退回查询数据库
+    if (m_treeCacheEnabled) {
+        reloadTreeCache();
+    }
+    
+    return true;
+}
+
+bool DatabaseManager::reloadTreeCache()
+{
+    m_treeCache.clear();
+    
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    
+    if (!query.exec("SELECT folder_id, name, parent_id, path, created_at FROM Folders")) {
+        qWarning() << "加载文件夹缓存失败:" << query.lastError().text();
+        return false;
+    }
+    
+    while (query.next()) {
+        FolderInfo folder;
+        folder.id = query.value(0).toInt();
+        folder.name = query.value(1).toString();
+        folder.parent_id = query.value(2).toInt();
+        folder.path = query.value(3).toString();
+        folder.created_at = query.value(4).toString();
+        m_treeCache.upsertFolder(folder);
+    }
+    
+    // 只加载笔记头信息，正文仍按需从ContentBlocks读取
+    if (!query.exec("SELECT note_id, title, created_at, updated_at, folder_id, tags, is_trashed FROM Notes")) {
+        qWarning() << "加载笔记缓存失败:" << query.lastError().text();
+        m_treeCache.clear();
+        return false;
+    }
+    
+    while (query.next()) {
+        NoteInfo note;
+        note.id = query.value(0).toInt();
+        note.title = query.value(1).toString();
+        note.created_at = query.value(2).toString();
+        note.updated_at = query.value(3).toString();
+        note.folder_id = query.value(4).toInt();
+        note.tags = query.value(5).toString();
+        note.is_trashed = query.value(6).toBool();
+        m_treeCache.upsertNote(note);
+    }
+    
+    m_treeCache.setLoaded(true);
+    qDebug() << "层级缓存已加载，文件夹:" << m_treeCache.folderCount() << "笔记:" << m_treeCache.noteCount();
     return true;
 }
 
+FolderInfo DatabaseManager::refreshCachedFolder(int folder_id)
+{
+    FolderInfo folder;
+    folder.id = -1;
+    folder.parent_id = -1;
+    
+    QSqlQuery &query = preparedQuery("SELECT folder_id, name, parent_id, path, created_at FROM Folders WHERE folder_id = :folder_id");
+    query.bindValue(":folder_id", folder_id);
+    
+    if (query.exec() && query.next()) {
+        folder.id = query.value(0).toInt();
+        folder.name = query.value(1).toString();
+        folder.parent_id = query.value(2).toInt();
+        folder.path = query.value(3).toString();
+        folder.created_at = query.value(4).toString();
+        
+        if (m_treeCache.isLoaded()) {
+            m_treeCache.upsertFolder(folder);
+        }
+    }
+    query.finish();
+    
+    return folder;
+}
+
+void DatabaseManager::notifyNoteChanged(int note_id)
+{
+    int oldFolderId = m_treeCache.containsNote(note_id) ? m_treeCache.note(note_id).folder_id : -1;
+    
+    NoteInfo note = refreshCachedNote(note_id);
+    if (note.id > 0) {
+        emit noteChanged(note, oldFolderId);
+    }
+}
+
+NoteInfo DatabaseManager::refreshCachedNote(int note_id)
+{
+    NoteInfo note;
+    note.id = -1;
+    note.folder_id = -1;
+    note.is_trashed = false;
+    
+    QSqlQuery &query = preparedQuery("SELECT note_id, title, created_at, updated_at, folder_id, tags, is_trashed "
+                                     "FROM Notes WHERE note_id = :note_id");
+    query.bindValue(":note_id", note_id);
+    
+    if (query.exec() && query.next()) {
+        note.id = query.value(0).toInt();
+        note.title = query.value(1).toString();
+        note.created_at = query.value(2).toString();
+        note.updated_at = query.value(3).toString();
+        note.folder_id = query.value(4).toInt();
+        note.tags = query.value(5).toString();
+        note.is_trashed = query.value(6).toBool();
+        
+        if (m_treeCache.isLoaded()) {
+            m_treeCache.upsertNote(note);
+        }
+    }
+    query.finish();
+    
+    return note;
+}
+
+DatabaseManager::StorageConfig DatabaseManager::StorageConfig::fromSettings()
+{
+    // 与SettingsDialog使用同一份INI配置
+    QSettings settings(QSettings::IniFormat, QSettings::UserScope,
+                       QCoreApplication::organizationName(), QCoreApplication::applicationName());
+    StorageConfig config;
+    config.walMode = settings.value("DataStorage/WalMode", config.walMode).toBool();
+    config.synchronous = settings.value("DataStorage/Synchronous", config.synchronous).toString().toUpper();
+    config.cacheSizeMB = settings.value("DataStorage/CacheSizeMB", config.cacheSizeMB).toInt();
+    config.mmapSizeMB = settings.value("DataStorage/MmapSizeMB", config.mmapSizeMB).toInt();
+    config.tempStoreMemory = settings.value("DataStorage/TempStoreMemory", config.tempStoreMemory).toBool();
+    config.compressContent = settings.value("DataStorage/CompressContent", config.compressContent).toBool();
+    
+    // 只接受SQLite支持的同步级别
+    static const QStringList validSynchronous = {"OFF", "NORMAL", "FULL"};
+    if (!validSynchronous.contains(config.synchronous)) {
+        config.synchronous = "NORMAL";
+    }
+    
+    return config;
+}
+
+bool DatabaseManager::applyStorageConfig(const StorageConfig &config)
+{
+    QSqlQuery query(m_db);
+    QStringList pragmas;
+    
+    // 日志模式是持久化到数据库文件的，由可写连接设置
+    if (!m_readOnly) {
+        pragmas << QString("PRAGMA journal_mode=%1").arg(config.walMode ? "WAL" : "DELETE");
+    }
+    pragmas << QString("PRAGMA synchronous=%1").arg(config.synchronous)
+            // cache_size为负数时单位为KiB
+            << QString("PRAGMA cache_size=-%1").arg(qMax(1, config.cacheSizeMB) * 1024)
+            << QString("PRAGMA mmap_size=%1").arg(qint64(qMax(0, config.mmapSizeMB)) * 1024 * 1024)
+            << QString("PRAGMA temp_store=%1").arg(config.tempStoreMemory ? "MEMORY" : "DEFAULT");
+    
+    bool success = true;
+    for (const QString &pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qWarning() << "设置数据库参数失败:" << pragma << query.lastError().text();
+            success = false;
+        }
+    }
+    
+    qDebug() << "数据库存储配置 - WAL:" << config.walMode << "synchronous:" << config.synchronous
+             << "cache:" << config.cacheSizeMB << "MB mmap:" << config.mmapSizeMB << "MB"
+             << (m_readOnly ? "(只读连接)" : "");
+    return success;
+}
+
+bool DatabaseManager::checkpointDatabaseFile(const QString &dbPath)
+{
+    if (!QFile::exists(dbPath)) {
+        return false;
+    }
+    
+    bool success = false;
+    QString connectionName = "checkpoint_connection_" + QString::number(QDateTime::currentMSecsSinceEpoch());
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(dbPath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+        if (db.open()) {
+            // 将WAL中的内容写回主数据库文件，之后单独复制notes.db即是完整数据
+            QSqlQuery query(db);
+            success = query.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+            if (!success) {
+                qWarning() << "数据库检查点失败:" << query.lastError().text();
+            }
+            db.close();
+        } else {
+            qWarning() << "无法打开数据库执行检查点:" << db.lastError().text();
+        }
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+    
+    return success;
+}
+
+void DatabaseManager::removeWalFiles(const QString &dbPath)
+{
+    // 替换数据库文件后，旧的WAL和共享内存文件不能再被应用到新文件上
+    QFile::remove(dbPath + "-wal");
+    QFile::remove(dbPath + "-shm");
+}
+
 bool DatabaseManager::createTables()
 {
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     
     // 创建Folders表
     if (!tableExists("Folders")) {
@@ -127,6 +384,9 @@ bool DatabaseManager::createTables()
             "content_text TEXT, "
             "media_path TEXT, "
             "properties TEXT, "
+            "content_hash TEXT, "
+            "content_data BLOB, "
+            "compression INTEGER DEFAULT 0, "
             "FOREIGN KEY (note_id) REFERENCES Notes(note_id)"
             ")";
         
@@ -139,6 +399,25 @@ bool DatabaseManager::createTables()
         if (!executeQuery(query, sql)) {
             return false;
         }
+    } else {
+        if (!columnExists("ContentBlocks", "content_hash")) {
+            // 旧版本数据库补充内容哈希列，旧块在下次保存时整体替换
+            if (!executeQuery(query, "ALTER TABLE ContentBlocks ADD COLUMN content_hash TEXT")) {
+                return false;
+            }
+        }
+        if (!columnExists("ContentBlocks", "content_data")) {
+            // 补充二进制内容列，旧笔记仍按HTML读取，下次保存时转换
+            if (!executeQuery(query, "ALTER TABLE ContentBlocks ADD COLUMN content_data BLOB")) {
+                return false;
+            }
+        }
+        if (!columnExists("ContentBlocks", "compression")) {
+            // 补充压缩方式列，已有的块为未压缩
+            if (!executeQuery(query, "ALTER TABLE ContentBlocks ADD COLUMN compression INTEGER DEFAULT 0")) {
+                return false;
+            }
+        }
     }
     
     // 创建Annotations表
@@ -164,41 +443,1068 @@ bool DatabaseManager::createTables()
         }
     }
     
+    // 创建NoteTexts表，保存笔记正文的纯文本投影，供搜索、预览和字数统计使用
+    if (!tableExists("NoteTexts")) {
+        QString sql = 
+            "CREATE TABLE NoteTexts ("
+            "note_id INTEGER PRIMARY KEY, "
+            "plain_text TEXT NOT NULL DEFAULT '', "
+            "char_count INTEGER DEFAULT 0, "
+            "word_count INTEGER DEFAULT 0, "
+            "FOREIGN KEY (note_id) REFERENCES Notes(note_id)"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+        
+        // 回填已有笔记的纯文本
+        if (!rebuildNoteTexts()) {
+            return false;
+        }
+    }
+    
+    // 创建MediaFiles表，按内容哈希登记媒体文件，ref_count为引用该文件的笔记数
+    if (!tableExists("MediaFiles")) {
+        QString sql = 
+            "CREATE TABLE MediaFiles ("
+            "hash TEXT PRIMARY KEY, "
+            "relative_path TEXT NOT NULL, "
+            "size INTEGER DEFAULT 0, "
+            "ref_count INTEGER DEFAULT 0, "
+            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP, "
+            "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    // 创建NoteMedia表，记录笔记引用了哪些媒体文件
+    if (!tableExists("NoteMedia")) {
+        QString sql = 
+            "CREATE TABLE NoteMedia ("
+            "note_id INTEGER NOT NULL, "
+            "hash TEXT NOT NULL, "
+            "PRIMARY KEY (note_id, hash), "
+            "FOREIGN KEY (note_id) REFERENCES Notes(note_id), "
+            "FOREIGN KEY (hash) REFERENCES MediaFiles(hash)"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+        
+        sql = "CREATE INDEX idx_note_media_hash ON NoteMedia(hash)";
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    // 创建NoteAiResults表，保存AI批量处理的结果，不修改笔记正文
+    if (!tableExists("NoteAiResults")) {
+        QString sql = 
+            "CREATE TABLE NoteAiResults ("
+            "note_id INTEGER NOT NULL, "
+            "operation TEXT NOT NULL, "
+            "result TEXT NOT NULL, "
+            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP, "
+            "PRIMARY KEY (note_id, operation), "
+            "FOREIGN KEY (note_id) REFERENCES Notes(note_id)"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    // 创建AI批量任务的检查点表，程序退出或崩溃后从未处理的笔记继续
+    if (!tableExists("AiBatchJobs")) {
+        QString sql = 
+            "CREATE TABLE AiBatchJobs ("
+            "job_id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "operation TEXT NOT NULL, "
+            "source TEXT, "
+            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    if (!tableExists("AiBatchItems")) {
+        QString sql = 
+            "CREATE TABLE AiBatchItems ("
+            "job_id INTEGER NOT NULL, "
+            "note_id INTEGER NOT NULL, "
+            "position INTEGER NOT NULL, "
+            "status INTEGER DEFAULT 0, "
+            "PRIMARY KEY (job_id, note_id), "
+            "FOREIGN KEY (job_id) REFERENCES AiBatchJobs(job_id)"
+            ")";
+        
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    // 创建全文索引，失败时不影响使用，搜索会退回LIKE扫描
+    m_ftsEnabled = createFullTextIndex();
+    if (!m_ftsEnabled) {
+        qWarning() << "全文索引不可用，搜索将使用LIKE扫描";
+    }
+    
     return true;
 }
 
-bool DatabaseManager::executeQuery(QSqlQuery &query, const QString &sql)
+bool DatabaseManager::createFullTextIndex()
 {
-    if (!query.exec(sql)) {
-        qCritical() << "SQL执行错误:" << query.lastError().text();
-        qCritical() << "SQL语句:" << sql;
+    QSqlQuery query(m_db);
+    bool created = false;
+    
+    if (!tableExists("NotesFts")) {
+        // 优先使用trigram分词器，支持中文等无空格文本的子串匹配(需要SQLite 3.34+)
+        if (query.exec("CREATE VIRTUAL TABLE NotesFts USING fts5(title, body, tokenize='trigram')")) {
+            m_ftsTrigram = true;
+        } else if (query.exec("CREATE VIRTUAL TABLE NotesFts USING fts5(title, body, tokenize='unicode61')")) {
+            m_ftsTrigram = false;
+        } else {
+            qWarning() << "创建FTS5全文索引失败:" << query.lastError().text();
+            return false;
+        }
+        created = true;
+    } else {
+        detectFullTextIndex();
+    }
+    
+    // 标题通过触发器与Notes表保持同步，正文在saveNoteContent中更新
+    const QStringList triggers = {
+        "CREATE TRIGGER IF NOT EXISTS notes_fts_insert AFTER INSERT ON Notes BEGIN "
+        "INSERT INTO NotesFts(rowid, title, body) VALUES (new.note_id, new.title, ''); END",
+        "CREATE TRIGGER IF NOT EXISTS notes_fts_update AFTER UPDATE OF title ON Notes BEGIN "
+        "UPDATE NotesFts SET title = new.title WHERE rowid = new.note_id; END",
+        "CREATE TRIGGER IF NOT EXISTS notes_fts_delete AFTER DELETE ON Notes BEGIN "
+        "DELETE FROM NotesFts WHERE rowid = old.note_id; END"
+    };
+    for (const QString &sql : triggers) {
+        if (!executeQuery(query, sql)) {
+            return false;
+        }
+    }
+    
+    // 首次创建时回填已有笔记
+    if (created && !rebuildFullTextIndex()) {
         return false;
     }
+    
     return true;
 }
 
-bool DatabaseManager::tableExists(const QString &tableName)
+bool DatabaseManager::detectFullTextIndex()
 {
-    QSqlQuery query;
-    query.prepare("SELECT name FROM sqlite_master WHERE type='table' AND name=:name");
-    query.bindValue(":name", tableName);
+    QSqlQuery query(m_db);
     
+    // 读取建表语句判断索引是否存在及分词器类型
+    query.prepare("SELECT sql FROM sqlite_master WHERE type='table' AND name='NotesFts'");
     if (!query.exec() || !query.next()) {
         return false;
     }
     
+    m_ftsTrigram = query.value(0).toString().contains("trigram");
     return true;
 }
 
-QList<FolderInfo> DatabaseManager::getAllFolders()
+bool DatabaseManager::rebuildFullTextIndex()
+{
+    QSqlQuery query(m_db);
+    
+    m_db.transaction();
+    
+    try {
+        if (!query.exec("DELETE FROM NotesFts")) {
+            throw std::runtime_error("清空全文索引失败");
+        }
+        
+        // 正文直接取自NoteTexts中的纯文本
+        if (!query.exec("INSERT INTO NotesFts(rowid, title, body) "
+                        "SELECT n.note_id, n.title, COALESCE(t.plain_text, '') FROM Notes n "
+                        "LEFT JOIN NoteTexts t ON t.note_id = n.note_id")) {
+            throw std::runtime_error("写入全文索引失败");
+        }
+        
+        if (!m_db.commit()) {
+            throw std::runtime_error("提交事务失败");
+        }
+        
+        return true;
+    }
+    catch (const std::exception &e) {
+        m_db.rollback();
+        qCritical() << "重建全文索引错误:" << e.what();
+        return false;
+    }
+}
+
+bool DatabaseManager::rebuildNoteTexts()
+{
+    QSqlQuery query(m_db);
+    
+    m_db.transaction();
+    
+    try {
+        // 按笔记汇总文本块，从HTML转换为纯文本
+        if (!query.exec("SELECT note_id, content_text, content_data, compression FROM ContentBlocks "
+                        "WHERE block_type = 'text' ORDER BY note_id, position")) {
+            throw std::runtime_error("读取笔记内容失败");
+        }
+        
+        QMap<int, QStringList> texts;
+        while (query.next()) {
+            ContentBlock block;
+            block.id = -1;
+            block.content_text = query.value(1).toString();
+            block.content_data = query.value(2).toByteArray();
+            if (!decompressBlock(block, query.value(3).toInt())) {
+                continue;
+            }
+            if (!block.content_text.isEmpty()) {
+                texts[query.value(0).toInt()].append(htmlToPlainText(block.content_text));
+            }
+        }
+        
+        for (auto it = texts.constBegin(); it != texts.constEnd(); ++it) {
+            if (!updateNoteText(it.key(), it.value().join("\n"))) {
+                throw std::runtime_error("写入纯文本失败");
+            }
+        }
+        
+        if (!m_db.commit()) {
+            throw std::runtime_error("提交事务失败");
+        }
+        
+        return true;
+    }
+    catch (const std::exception &e) {
+        m_db.rollback();
+        qCritical() << "回填笔记纯文本错误:" << e.what();
+        return false;
+    }
+}
+
+int DatabaseManager::backfillNoteTexts()
 {
+    QSqlQuery query(m_db);
+    
+    // 查找没有NoteTexts行的笔记，没有内容块的笔记也写入空行，下次启动不再重复处理
+    if (!query.exec("SELECT n.note_id, cb.content_text, cb.content_data, cb.compression "
+                    "FROM Notes n LEFT JOIN NoteTexts t ON t.note_id = n.note_id "
+                    "LEFT JOIN ContentBlocks cb ON cb.note_id = n.note_id AND cb.block_type = 'text' "
+                    "WHERE t.note_id IS NULL ORDER BY n.note_id, cb.position")) {
+        qCritical() << "查找缺少纯文本的笔记失败:" << query.lastError().text();
+        return -1;
+    }
+    
+    QMap<int, QStringList> texts;
+    while (query.next()) {
+        int noteId = query.value(0).toInt();
+        QStringList &parts = texts[noteId];
+        if (query.value(1).isNull() && query.value(2).isNull()) {
+            continue;
+        }
+        ContentBlock block;
+        block.id = -1;
+        block.content_text = query.value(1).toString();
+        block.content_data = query.value(2).toByteArray();
+        if (decompressBlock(block, query.value(3).toInt()) && !block.content_text.isEmpty()) {
+            parts.append(htmlToPlainText(block.content_text));
+        }
+    }
+    query.finish();
+    
+    if (texts.isEmpty()) {
+        return 0;
+    }
+    
+    m_db.transaction();
+    for (auto it = texts.constBegin(); it != texts.constEnd(); ++it) {
+        QString plainText = it.value().join("\n");
+        if (!updateNoteText(it.key(), plainText) || !updateFullTextBody(it.key(), plainText)) {
+            m_db.rollback();
+            qCritical() << "补写笔记纯文本失败，笔记ID:" << it.key();
+            return -1;
+        }
+    }
+    if (!m_db.commit()) {
+        qCritical() << "补写笔记纯文本提交事务失败:" << m_db.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    
+    qDebug() << "已补写" << texts.size() << "篇笔记的纯文本";
+    return texts.size();
+}
+
+CompressionBenchmarkResult DatabaseManager::benchmarkCompression()
+{
+    CompressionBenchmarkResult result;
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    
+    if (!query.exec("SELECT block_id, note_id, content_text, content_data, compression "
+                    "FROM ContentBlocks ORDER BY note_id, position")) {
+        qCritical() << "读取内容块失败:" << query.lastError().text();
+        return result;
+    }
+    
+    QElapsedTimer decodeTimer;
+    qint64 totalDecodeNs = 0;
+    qint64 noteDecodeNs = 0;
+    int currentNoteId = -1;
+    
+    // 一篇笔记的内容块读完后记录其解压耗时
+    auto finishNote = [&]() {
+        if (currentNoteId < 0) {
+            return;
+        }
+        double decodeMs = noteDecodeNs / 1000000.0;
+        if (decodeMs > result.maxDecodeMs || result.slowestNoteId < 0) {
+            result.maxDecodeMs = decodeMs;
+            result.slowestNoteId = currentNoteId;
+        }
+        totalDecodeNs += noteDecodeNs;
+        ++result.notes;
+    };
+    
+    while (query.next()) {
+        int noteId = query.value(1).toInt();
+        if (noteId != currentNoteId) {
+            finishNote();
+            currentNoteId = noteId;
+            noteDecodeNs = 0;
+        }
+        
+        ContentBlock block;
+        block.id = query.value(0).toInt();
+        block.content_text = query.value(2).toString();
+        block.content_data = query.value(3).toByteArray();
+        int compression = query.value(4).toInt();
+        
+        result.storedBytes += block.content_text.toUtf8().size() + block.content_data.size();
+        ++result.blocks;
+        
+        if (compression != COMPRESSION_NONE) {
+            ++result.compressedBlocks;
+            decodeTimer.start();
+            bool decoded = decompressBlock(block, compression);
+            noteDecodeNs += decodeTimer.nsecsElapsed();
+            if (!decoded) {
+                ++result.failedBlocks;
+                continue;
+            }
+        }
+        
+        result.rawBytes += block.content_text.toUtf8().size() + block.content_data.size();
+    }
+    finishNote();
+    
+    if (result.notes > 0) {
+        result.averageDecodeMs = totalDecodeNs / 1000000.0 / result.notes;
+    }
+    return result;
+}
+
+bool DatabaseManager::updateNoteText(int note_id, const QString &plainText)
+{
+    QSqlQuery &query = preparedQuery("INSERT OR REPLACE INTO NoteTexts (note_id, plain_text, char_count, word_count) "
+                  "VALUES (:note_id, :plain_text, :char_count, :word_count)");
+    query.bindValue(":note_id", note_id);
+    query.bindValue(":plain_text", plainText);
+    // 统计方式与编辑器的字数统计保持一致
+    QString simplified = plainText.simplified();
+    query.bindValue(":char_count", simplified.length());
+    query.bindValue(":word_count", simplified.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts).count());
+    
+    if (!query.exec()) {
+        qCritical() << "更新笔记纯文本失败:" << query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+QString DatabaseManager::getNotePlainText(int note_id)
+{
+    QSqlQuery &query = preparedQuery("SELECT plain_text FROM NoteTexts WHERE note_id = :note_id");
+    query.bindValue(":note_id", note_id);
+    
+    QString plainText;
+    if (query.exec() && query.next()) {
+        plainText = query.value(0).toString();
+    }
+    query.finish();
+    
+    return plainText;
+}
+
+bool DatabaseManager::setNoteTags(int note_id, const QString &tags)
+{
+    QSqlQuery &query = preparedQuery("UPDATE Notes SET tags = :tags WHERE note_id = :note_id");
+    query.bindValue(":tags", tags);
+    query.bindValue(":note_id", note_id);
+    
+    if (!query.exec()) {
+        qCritical() << "设置笔记标签失败:" << query.lastError().text();
+        return false;
+    }
+    
+    notifyNoteChanged(note_id);
+    
+    return true;
+}
+
+bool DatabaseManager::saveNoteAiResult(int note_id, const QString &operation, const QString &result)
+{
+    QSqlQuery &query = preparedQuery("INSERT OR REPLACE INTO NoteAiResults (note_id, operation, result, created_at) "
+                  "VALUES (:note_id, :operation, :result, CURRENT_TIMESTAMP)");
+    query.bindValue(":note_id", note_id);
+    query.bindValue(":operation", operation);
+    query.bindValue(":result", result);
+    
+    if (!query.exec()) {
+        qCritical() << "保存AI处理结果失败:" << query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+QString DatabaseManager::getNoteAiResult(int note_id, const QString &operation)
+{
+    QSqlQuery &query = preparedQuery("SELECT result FROM NoteAiResults WHERE note_id = :note_id AND operation = :operation");
+    query.bindValue(":note_id", note_id);
+    query.bindValue(":operation", operation);
+    
+    QString result;
+    if (query.exec() && query.next()) {
+        result = query.value(0).toString();
+    }
+    query.finish();
+    
+    return result;
+}
+
+int DatabaseManager::createAiBatchJob(const QString &operation, const QString &source, const QList<int> &noteIds)
+{
+    QSqlQuery query(m_db);
+    
+    // 任务和全部笔记条目在一个事务中写入，中途失败不会留下不完整的检查点
+    m_db.transaction();
+    
+    try {
+        query.prepare("INSERT INTO AiBatchJobs (operation, source) VALUES (:operation, :source)");
+        query.bindValue(":operation", operation);
+        query.bindValue(":source", source);
+        
+        if (!query.exec()) {
+            throw std::runtime_error("创建批量任务失败");
+        }
+        int jobId = query.lastInsertId().toInt();
+        
+        query.prepare("INSERT OR IGNORE INTO AiBatchItems (job_id, note_id, position, status) "
+                      "VALUES (:job_id, :note_id, :position, 0)");
+        for (int i = 0; i < noteIds.size(); ++i) {
+            query.bindValue(":job_id", jobId);
+            query.bindValue(":note_id", noteIds.at(i));
+            query.bindValue(":position", i);
+            
+            if (!query.exec()) {
+                throw std::runtime_error("写入批量任务笔记失败");
+            }
+        }
+        
+        if (!m_db.commit()) {
+            throw std::runtime_error("提交事务失败");
+        }
+        
+        return jobId;
+    }
+    catch (const std::exception &e) {
+        m_db.rollback();
+        qCritical() << "创建批量任务错误:" << e.what() << query.lastError().text();
+        return -1;
+    }
+}
+
+bool DatabaseManager::setAiBatchItemStatus(int job_id, int note_id, int status)
+{
+    QSqlQuery &query = preparedQuery("UPDATE AiBatchItems SET status = :status WHERE job_id = :job_id AND note_id = :note_id");
+    query.bindValue(":status", status);
+    query.bindValue(":job_id", job_id);
+    query.bindValue(":note_id", note_id);
+    
+    if (!query.exec()) {
+        qCritical() << "更新批量任务进度失败:" << query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+AiBatchJobInfo DatabaseManager::getUnfinishedAiBatchJob()
+{
+    AiBatchJobInfo job;
+    QSqlQuery query(m_db);
+    
+    if (!query.exec("SELECT j.job_id, j.operation, j.source FROM AiBatchJobs j "
+                    "WHERE EXISTS (SELECT 1 FROM AiBatchItems i WHERE i.job_id = j.job_id AND i.status = 0) "
+                    "ORDER BY j.job_id LIMIT 1") || !query.next()) {
+        return job;
+    }
+    job.id = query.value(0).toInt();
+    job.operation = query.value(1).toString();
+    job.source = query.value(2).toString();
+    query.finish();
+    
+    query.prepare("SELECT note_id, status FROM AiBatchItems WHERE job_id = :job_id ORDER BY position");
+    query.bindValue(":job_id", job.id);
+    if (!query.exec()) {
+        qCritical() << "读取批量任务检查点失败:" << query.lastError().text();
+        return AiBatchJobInfo();
+    }
+    
+    while (query.next()) {
+        int status = query.value(1).toInt();
+        if (status == AiBatchItemSucceeded) {
+            job.succeeded++;
+        } else if (status == AiBatchItemFailed) {
+            job.failed++;
+        } else if (status == AiBatchItemSkipped) {
+            job.skipped++;
+        } else {
+            job.pendingNoteIds.append(query.value(0).toInt());
+        }
+        job.total++;
+    }
+    
+    return job;
+}
+
+int DatabaseManager::deleteFinishedAiBatchJobs()
+{
+    QSqlQuery query(m_db);
+    
+    m_db.transaction();
+    
+    // 先删除没有未处理笔记的任务，再删除不再属于任何任务的条目
+    bool success = query.exec("DELETE FROM AiBatchJobs WHERE NOT EXISTS "
+                              "(SELECT 1 FROM AiBatchItems i WHERE i.job_id = AiBatchJobs.job_id AND i.status = 0)");
+    int deleted = success ? query.numRowsAffected() : 0;
+    if (success) {
+        success = query.exec("DELETE FROM AiBatchItems WHERE job_id NOT IN (SELECT job_id FROM AiBatchJobs)");
+    }
+    
+    if (!success || !m_db.commit()) {
+        qCritical() << "删除已完成的批量任务失败:" << query.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    
+    return deleted;
+}
+
+bool DatabaseManager::deleteAiBatchJob(int job_id)
+{
+    QSqlQuery query(m_db);
+    
+    m_db.transaction();
+    
+    query.prepare("DELETE FROM AiBatchItems WHERE job_id = :job_id");
+    query.bindValue(":job_id", job_id);
+    bool success = query.exec();
+    
+    if (success) {
+        query.prepare("DELETE FROM AiBatchJobs WHERE job_id = :job_id");
+        query.bindValue(":job_id", job_id);
+        success = query.exec();
+    }
+    
+    if (!success || !m_db.commit()) {
+        qCritical() << "删除批量任务失败:" << query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseManager::updateFullTextBody(int note_id, const QString &body)
+{
+    if (!m_ftsEnabled) {
+        return true;
+    }
+    
+    // FTS5表不支持按rowid的UPSERT，先删除再从Notes表取标题重新插入
+    QSqlQuery &deleteQuery = preparedQuery("DELETE FROM NotesFts WHERE rowid = :note_id");
+    deleteQuery.bindValue(":note_id", note_id);
+    if (!deleteQuery.exec()) {
+        qCritical() << "删除全文索引条目失败:" << deleteQuery.lastError().text();
+        return false;
+    }
+    
+    QSqlQuery &query = preparedQuery("INSERT INTO NotesFts(rowid, title, body) "
+                  "SELECT note_id, title, :body FROM Notes WHERE note_id = :note_id");
+    query.bindValue(":body", body);
+    query.bindValue(":note_id", note_id);
+    if (!query.exec()) {
+        qCritical() << "更新全文索引失败:" << query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+QString DatabaseManager::buildFtsMatchExpression(const QString &keyword) const
+{
+    QStringList terms = keyword.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    if (terms.isEmpty()) {
+        return QString();
+    }
+    
+    QStringList parts;
+    for (QString term : terms) {
+        // trigram分词器无法匹配少于3个字符的词，交给LIKE处理
+        if (m_ftsTrigram && term.length() < 3) {
+            return QString();
+        }
+        // 每个词作为短语加引号，避免用户输入被解析为FTS语法
+        term.replace("\"", "\"\"");
+        parts.append(m_ftsTrigram ? QString("\"%1\"").arg(term)
+                                  : QString("\"%1\"*").arg(term));
+    }
+    
+    return parts.join(" ");
+}
+
+QString DatabaseManager::htmlToPlainText(const QString &html)
+{
+    return QTextDocumentFragment::fromHtml(html).toPlainText();
+}
+
+bool DatabaseManager::executeQuery(QSqlQuery &query, const QString &sql)
+{
+    if (!query.exec(sql)) {
+        qCritical() << "SQL执行错误:" << query.lastError().text();
+        qCritical() << "SQL语句:" << sql;
+        return false;
+    }
+    return true;
+}
+
+QSqlQuery &DatabaseManager::preparedQuery(const QString &sql)
+{
+    auto it = m_statementCache.constFind(sql);
+    if (it != m_statementCache.constEnd()) {
+        ++m_statementCacheHits;
+        // 重置上一次执行的状态，避免未读完的结果集占用读事务
+        it.value()->finish();
+        return *it.value();
+    }
+    
+    ++m_statementCacheMisses;
+    QSqlQuery *query = new QSqlQuery(m_db);
+    if (!query->prepare(sql)) {
+        qCritical() << "预编译SQL失败:" << query->lastError().text() << "SQL:" << sql;
+    }
+    m_statementCache.insert(sql, query);
+    return *query;
+}
+
+bool DatabaseManager::columnExists(const QString &tableName, const QString &columnName)
+{
+    QSqlQuery query(m_db);
+    if (!query.exec(QString("PRAGMA table_info(%1)").arg(tableName))) {
+        return false;
+    }
+    
+    while (query.next()) {
+        if (query.value("name").toString() == columnName) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+QString DatabaseManager::contentBlockHash(const ContentBlock &block)
+{
+    // 类型、内容和属性共同决定块是否变化，位置不参与哈希以便识别移动的块
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(block.block_type.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(block.content_text.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(block.media_path.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(block.properties.toUtf8());
+    hash.addData(QByteArray(1, '\0'));
+    hash.addData(block.content_data);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+int DatabaseManager::compressBlock(const ContentBlock &block, QString *text, QByteArray *data)
+{
+    *text = block.content_text;
+    *data = block.content_data;
+    
+    // 二进制块压缩content_data，HTML块压缩content_text
+    bool binary = !block.content_data.isEmpty();
+    if (binary && !block.content_text.isEmpty()) {
+        return COMPRESSION_NONE;
+    }
+    QByteArray raw = binary ? block.content_data : block.content_text.toUtf8();
+    if (raw.size() < COMPRESSION_MIN_BYTES) {
+        return COMPRESSION_NONE;
+    }
+    
+    // 收益不足一成时不压缩，避免每次读取都白白解压
+    QByteArray compressed = qCompress(raw);
+    if (compressed.size() > raw.size() * 9 / 10) {
+        return COMPRESSION_NONE;
+    }
+    
+    *data = compressed;
+    if (binary) {
+        return COMPRESSION_ZLIB_DATA;
+    }
+    *text = QString();
+    return COMPRESSION_ZLIB_TEXT;
+}
+
+bool DatabaseManager::decompressBlock(ContentBlock &block, int compression)
+{
+    if (compression == COMPRESSION_NONE) {
+        return true;
+    }
+    if (compression != COMPRESSION_ZLIB_TEXT && compression != COMPRESSION_ZLIB_DATA) {
+        qWarning() << "未知的内容块压缩方式:" << compression << "块ID:" << block.id;
+        return false;
+    }
+    
+    // 压缩的块至少有COMPRESSION_MIN_BYTES字节，解压为空说明数据已损坏
+    QByteArray raw = qUncompress(block.content_data);
+    if (raw.isEmpty()) {
+        qWarning() << "内容块解压失败，块ID:" << block.id;
+        return false;
+    }
+    
+    if (compression == COMPRESSION_ZLIB_TEXT) {
+        block.content_text = QString::fromUtf8(raw);
+        block.content_data = QByteArray();
+    } else {
+        block.content_data = raw;
+    }
+    return true;
+}
+
+bool DatabaseManager::migrateContentCompression()
+{
+    QSqlQuery query(m_db);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        qWarning() << "读取数据库版本失败:" << query.lastError().text();
+        return false;
+    }
+    if (query.value(0).toInt() >= COMPRESSION_SCHEMA_VERSION) {
+        return true;
+    }
+    query.finish();
+    
+    QElapsedTimer timer;
+    timer.start();
+    qint64 originalBytes = 0;
+    qint64 compressedBytes = 0;
+    int compressedBlocks = 0;
+    
+    m_db.transaction();
+    
+    try {
+        QSqlQuery selectQuery(m_db);
+        selectQuery.setForwardOnly(true);
+        selectQuery.prepare("SELECT block_id, content_text, content_data FROM ContentBlocks "
+                            "WHERE compression = 0 AND block_id > :last_id ORDER BY block_id LIMIT 500");
+        QSqlQuery updateQuery(m_db);
+        updateQuery.prepare("UPDATE ContentBlocks SET content_text = :content_text, content_data = :content_data, "
+                            "compression = :compression WHERE block_id = :block_id");
+        
+        int lastId = 0;
+        while (true) {
+            // 先读出一批再更新，不在未结束的查询上修改同一张表
+            selectQuery.bindValue(":last_id", lastId);
+            if (!selectQuery.exec()) {
+                throw std::runtime_error("读取内容块失败");
+            }
+            QList<ContentBlock> batch;
+            while (selectQuery.next()) {
+                ContentBlock block;
+                block.id = selectQuery.value(0).toInt();
+                block.content_text = selectQuery.value(1).toString();
+                block.content_data = selectQuery.value(2).toByteArray();
+                batch.append(block);
+            }
+            selectQuery.finish();
+            if (batch.isEmpty()) {
+                break;
+            }
+            
+            for (const ContentBlock &block : batch) {
+                lastId = block.id;
+                QString text;
+                QByteArray data;
+                int compression = compressBlock(block, &text, &data);
+                if (compression == COMPRESSION_NONE) {
+                    continue;
+                }
+                
+                updateQuery.bindValue(":content_text", text);
+                updateQuery.bindValue(":content_data", data);
+                updateQuery.bindValue(":compression", compression);
+                updateQuery.bindValue(":block_id", block.id);
+                if (!updateQuery.exec()) {
+                    throw std::runtime_error("写入压缩内容块失败");
+                }
+                
+                originalBytes += compression == COMPRESSION_ZLIB_TEXT ? block.content_text.toUtf8().size()
+                                                                      : block.content_data.size();
+                compressedBytes += data.size();
+                ++compressedBlocks;
+            }
+        }
+        
+        // user_version随事务一起提交，迁移中断时下次启动重新执行
+        if (!query.exec(QString("PRAGMA user_version = %1").arg(COMPRESSION_SCHEMA_VERSION))) {
+            throw std::runtime_error("更新数据库版本失败");
+        }
+        
+        if (!m_db.commit()) {
+            throw std::runtime_error("提交事务失败");
+        }
+        
+        qDebug() << "内容块压缩迁移完成 - 压缩块数:" << compressedBlocks
+                 << "原始大小:" << originalBytes << "压缩后:" << compressedBytes
+                 << "压缩率:" << (originalBytes > 0 ? double(compressedBytes) / originalBytes : 1.0)
+                 << "耗时(ms):" << timer.elapsed();
+        return true;
+    }
+    catch (const std::exception &e) {
+        m_db.rollback();
+        qCritical() << "压缩内容块错误:" << e.what();
+        return false;
+    }
+}
+
+bool DatabaseManager::migrateLegacyMediaFiles()
+{
+    // 旧文件直接位于媒体目录下，按内容寻址的文件都在两位哈希前缀的子目录中
+    QDir mediaDir(m_mediaPath);
+    QStringList legacyFiles;
+    const QStringList entries = mediaDir.entryList(QDir::Files | QDir::NoDotAndDotDot);
+    for (const QString &name : entries) {
+        if (!name.endsWith(".tmp")) {
+            legacyFiles.append(name);
+        }
+    }
+    if (legacyFiles.isEmpty()) {
+        return true;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // 复制到按内容寻址的位置；旧文件在事务提交后才删除，中断后下次启动重新迁移
+    QHash<QString, QString> newPaths; // 旧文件名 -> 新的相对路径
+    QHash<QString, QString> hashes;   // 新的相对路径 -> 内容哈希
+    for (const QString &name : legacyFiles) {
+        QString hash;
+        QString relativePath = MediaStore::store(m_mediaPath, m_mediaPath + "/" + name, &hash);
+        if (relativePath.isEmpty()) {
+            qWarning() << "迁移旧媒体文件失败，保留原文件:" << name;
+            continue;
+        }
+        newPaths.insert(name, relativePath);
+        hashes.insert(relativePath, hash);
+    }
+    if (newPaths.isEmpty()) {
+        return false;
+    }
+    
+    m_db.transaction();
+    
+    try {
+        // 先登记全部文件，没有笔记引用的文件引用计数为0，过了宽限期后被清理
+        for (auto it = hashes.constBegin(); it != hashes.constEnd(); ++it) {
+            if (!registerMediaFile(it.value(), it.key())) {
+                throw std::runtime_error("登记媒体文件失败");
+            }
+        }
+        
+        // 引用可能是相对路径，也可能是包含notes_media的绝对路径或file:// URL
+        QList<QPair<QRegularExpression, QString>> replacements;
+        for (auto it = newPaths.constBegin(); it != newPaths.constEnd(); ++it) {
+            QRegularExpression pattern("notes_media[/\\\\]" + QRegularExpression::escape(it.key()) + "(?![\\w.-])");
+            replacements.append(qMakePair(pattern, "notes_media/" + it.value()));
+        }
+        
+        QSqlQuery selectQuery(m_db);
+        selectQuery.setForwardOnly(true);
+        selectQuery.prepare("SELECT block_id, note_id, block_type, content_text, media_path, properties, "
+                            "content_data, compression FROM ContentBlocks "
+                            "WHERE block_id > :last_id ORDER BY block_id LIMIT 500");
+        QSqlQuery updateQuery(m_db);
+        updateQuery.prepare("UPDATE ContentBlocks SET content_text = :content_text, media_path = :media_path, "
+                            "content_data = :content_data, compression = :compression, content_hash = :content_hash "
+                            "WHERE block_id = :block_id");
+        
+        QSet<int> affectedNotes;
+        int rewrittenBlocks = 0;
+        int lastId = 0;
+        while (true) {
+            // 先读出一批再更新，不在未结束的查询上修改同一张表
+            selectQuery.bindValue(":last_id", lastId);
+            if (!selectQuery.exec()) {
+                throw std::runtime_error("读取内容块失败");
+            }
+            QList<QPair<int, ContentBlock>> batch;
+            while (selectQuery.next()) {
+                ContentBlock block;
+                block.id = selectQuery.value(0).toInt();
+                block.note_id = selectQuery.value(1).toInt();
+                block.block_type = selectQuery.value(2).toString();
+                block.content_text = selectQuery.value(3).toString();
+                block.media_path = selectQuery.value(4).toString();
+                block.properties = selectQuery.value(5).toString();
+                block.content_data = selectQuery.value(6).toByteArray();
+                batch.append(qMakePair(selectQuery.value(7).toInt(), block));
+            }
+            selectQuery.finish();
+            if (batch.isEmpty()) {
+                break;
+            }
+            
+            for (auto &entry : batch) {
+                ContentBlock &block = entry.second;
+                lastId = block.id;
+                // 损坏的块无法判断是否引用了旧文件，中止迁移，避免被引用的文件计数为0后被清理
+                if (!decompressBlock(block, entry.first)) {
+                    throw std::runtime_error("内容块解压失败");
+                }
+                if (block.block_type == NoteDocumentCodec::FORMATS_BLOCK_TYPE) {
+                    // 二进制格式的图片路径保存在格式表的图片格式中，段落块的media_path只是副本
+                    bool changed = false;
+                    if (!NoteDocumentCodec::rewriteImageNames(&block, replacements, &changed)) {
+                        throw std::runtime_error("格式表解码失败");
+                    }
+                    if (!changed) {
+                        continue;
+                    }
+                } else {
+                    if (!block.content_text.contains("notes_media") && !block.media_path.contains("notes_media")) {
+                        continue;
+                    }
+                    
+                    QString text = block.content_text;
+                    QString mediaPath = block.media_path;
+                    for (const auto &replacement : replacements) {
+                        text.replace(replacement.first, replacement.second);
+                        mediaPath.replace(replacement.first, replacement.second);
+                    }
+                    if (text == block.content_text && mediaPath == block.media_path) {
+                        continue;
+                    }
+                    block.content_text = text;
+                    block.media_path = mediaPath;
+                }
+                
+                QString storedText;
+                QByteArray storedData;
+                int compression = m_compressContent ? compressBlock(block, &storedText, &storedData) : COMPRESSION_NONE;
+                if (compression == COMPRESSION_NONE) {
+                    storedText = block.content_text;
+                    storedData = block.content_data;
+                }
+                
+                updateQuery.bindValue(":content_text", storedText);
+                updateQuery.bindValue(":media_path", block.media_path);
+                updateQuery.bindValue(":content_data", storedData);
+                updateQuery.bindValue(":compression", compression);
+                updateQuery.bindValue(":content_hash", contentBlockHash(block));
+                updateQuery.bindValue(":block_id", block.id);
+                if (!updateQuery.exec()) {
+                    throw std::runtime_error("改写内容块失败");
+                }
+                affectedNotes.insert(block.note_id);
+                ++rewrittenBlocks;
+            }
+        }
+        
+        // 按改写后的笔记内容重新计算引用
+        for (int noteId : affectedNotes) {
+            bool loaded = false;
+            QList<ContentBlock> blocks = getNoteContent(noteId, &loaded);
+            if (!loaded) {
+                throw std::runtime_error("读取笔记内容失败");
+            }
+            if (!syncNoteMedia(noteId, blocks)) {
+                throw std::runtime_error("更新媒体引用失败");
+            }
+        }
+        
+        if (!m_db.commit()) {
+            throw std::runtime_error("提交事务失败");
+        }
+        
+        // 引用已全部改写，旧文件可以删除
+        for (auto it = newPaths.constBegin(); it != newPaths.constEnd(); ++it) {
+            if (!QFile::remove(m_mediaPath + "/" + it.key())) {
+                qWarning() << "无法删除已迁移的旧媒体文件:" << it.key();
+            }
+        }
+        
+        qDebug() << "旧媒体文件迁移完成 - 文件数:" << newPaths.size() << "改写内容块:" << rewrittenBlocks
+                 << "涉及笔记:" << affectedNotes.size() << "耗时(ms):" << timer.elapsed();
+        return true;
+    }
+    catch (const std::exception &e) {
+        m_db.rollback();
+        qCritical() << "迁移旧媒体文件错误:" << e.what();
+        return false;
+    }
+}
+
+bool DatabaseManager::tableExists(const QString &tableName)
+{
+    QSqlQuery &query = preparedQuery("SELECT name FROM sqlite_master WHERE type='table' AND name=:name");
+    query.bindValue(":name", tableName);
+    
+    bool exists = query.exec() && query.next();
+    query.finish();
+    
+    return exists;
+}
+
+QList<FolderInfo> DatabaseManager::getAllFolders()
+{
+    if (m_treeCache.isLoaded()) {
+        return m_treeCache.allFolders();
+    }
+    
     QList<FolderInfo> folders;
-    QSqlQuery query;
     
     // 查询所有文件夹，按照创建时间排序
-    QString sql = "SELECT folder_id, name, parent_id, path, created_at FROM Folders ORDER BY created_at";
+    QSqlQuery &query = preparedQuery("SELECT folder_id, name, parent_id, path, created_at FROM Folders ORDER BY created_at");
     
-    if (!executeQuery(query, sql)) {
+    if (!query.exec()) {
+        qCritical() << "获取文件夹失败:" << query.lastError().text();
         return folders;
     }
     
@@ -219,15 +1525,18 @@ QList<FolderInfo> DatabaseManager::getAllFolders()
 
 QList<NoteInfo> DatabaseManager::getNotesInFolder(int folder_id)
 {
+    if (m_treeCache.isLoaded()) {
+        return m_treeCache.notesInFolder(folder_id);
+    }
+    
     QList<NoteInfo> notes;
-    QSqlQuery query;
     
     // 查询指定文件夹下的所有非回收站笔记
     QString sql = "SELECT note_id, title, created_at, updated_at, folder_id, tags, is_trashed "
                   "FROM Notes WHERE folder_id = :folder_id AND is_trashed = 0 "
                   "ORDER BY updated_at DESC";
     
-    query.prepare(sql);
+    QSqlQuery &query = preparedQuery(sql);
     query.bindValue(":folder_id", folder_id);
     
     if (!query.exec()) {
@@ -254,14 +1563,17 @@ QList<NoteInfo> DatabaseManager::getNotesInFolder(int folder_id)
 
 NoteInfo DatabaseManager::getNoteById(int note_id)
 {
-    NoteInfo note;
-    QSqlQuery query;
+    if (m_treeCache.containsNote(note_id)) {
+        return m_treeCache.note(note_id);
+    }
+    
+    NoteInfo note{}; // 未找到时id为0
     
     // 查询指定ID的笔记
     QString sql = "SELECT note_id, title, created_at, updated_at, folder_id, tags, is_trashed "
                  "FROM Notes WHERE note_id = :note_id";
     
-    query.prepare(sql);
+    QSqlQuery &query = preparedQuery(sql);
     query.bindValue(":note_id", note_id);
     
     if (!query.exec()) {
@@ -281,10 +1593,26 @@ NoteInfo DatabaseManager::getNoteById(int note_id)
     } else {
         qWarning() << "未找到ID为" << note_id << "的笔记";
     }
+    query.finish();
     
     return note;
 }
 
+FolderInfo DatabaseManager::getFolderById(int folder_id)
+{
+    if (m_treeCache.isLoaded()) {
+        if (m_treeCache.containsFolder(folder_id)) {
+            return m_treeCache.folder(folder_id);
+        }
+        FolderInfo folder;
+        folder.id = -1;
+        folder.parent_id = -1;
+        return folder;
+    }
+    
+    return refreshCachedFolder(folder_id);
+}
+
 int DatabaseManager::createFolder(const QString &name, int parent_id)
 {
     if (name.isEmpty()) {
@@ -292,29 +1620,33 @@ int DatabaseManager::createFolder(const QString &name, int parent_id)
         return -1;
     }
     
-    QSqlQuery query;
-    
     // 首先获取父文件夹路径
     QString parentPath = "/root"; // 默认为根路径
     
-    if (parent_id > 0) {
-        QString sql = "SELECT path FROM Folders WHERE folder_id = :parent_id";
-        query.prepare(sql);
-        query.bindValue(":parent_id", parent_id);
+    if (parent_id > 0 && m_treeCache.isLoaded()) {
+        if (!m_treeCache.containsFolder(parent_id)) {
+            qWarning() << "无法找到父文件夹:" << parent_id;
+            return -1;
+        }
+        parentPath = m_treeCache.folder(parent_id).path;
+    } else if (parent_id > 0) {
+        QSqlQuery &pathQuery = preparedQuery("SELECT path FROM Folders WHERE folder_id = :parent_id");
+        pathQuery.bindValue(":parent_id", parent_id);
         
-        if (!query.exec() || !query.next()) {
+        if (!pathQuery.exec() || !pathQuery.next()) {
             qWarning() << "无法找到父文件夹:" << parent_id;
             return -1;
         }
         
-        parentPath = query.value(0).toString();
+        parentPath = pathQuery.value(0).toString();
+        pathQuery.finish();
     }
     
     // 构建新文件夹的路径
     QString path = parentPath + "/" + name;
     
     // 插入新文件夹
-    query.prepare("INSERT INTO Folders (name, parent_id, path) VALUES (:name, :parent_id, :path)");
+    QSqlQuery &query = preparedQuery("INSERT INTO Folders (name, parent_id, path) VALUES (:name, :parent_id, :path)");
     query.bindValue(":name", name);
     query.bindValue(":parent_id", parent_id);
     query.bindValue(":path", path);
@@ -324,8 +1656,16 @@ int DatabaseManager::createFolder(const QString &name, int parent_id)
         return -1;
     }
     
+    int folderId = query.lastInsertId().toInt();
+    
+    // created_at由数据库默认值生成，回读后写入缓存
+    FolderInfo folder = refreshCachedFolder(folderId);
+    if (folder.id > 0) {
+        emit folderAdded(folder);
+    }
+    
     // 返回新文件夹的ID
-    return query.lastInsertId().toInt();
+    return folderId;
 }
 
 int DatabaseManager::createNote(const QString &title, int folder_id)
@@ -335,23 +1675,22 @@ int DatabaseManager::createNote(const QString &title, int folder_id)
         return -1;
     }
     
-    QSqlQuery query;
-    
     // 检查文件夹是否存在
     if (folder_id > 0) {
-        query.prepare("SELECT folder_id FROM Folders WHERE folder_id = :folder_id");
-        query.bindValue(":folder_id", folder_id);
+        QSqlQuery &checkQuery = preparedQuery("SELECT folder_id FROM Folders WHERE folder_id = :folder_id");
+        checkQuery.bindValue(":folder_id", folder_id);
         
-        if (!query.exec() || !query.next()) {
+        if (!checkQuery.exec() || !checkQuery.next()) {
             qWarning() << "无法找到文件夹:" << folder_id;
             return -1;
         }
+        checkQuery.finish();
     }
     
     // 插入新笔记
     QString currentTime = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
     
-    query.prepare("INSERT INTO Notes (title, folder_id, created_at, updated_at) "
+    QSqlQuery &query = preparedQuery("INSERT INTO Notes (title, folder_id, created_at, updated_at) "
                  "VALUES (:title, :folder_id, :created_at, :updated_at)");
     query.bindValue(":title", title);
     query.bindValue(":folder_id", folder_id);
@@ -363,9 +1702,30 @@ int DatabaseManager::createNote(const QString &title, int folder_id)
         return -1;
     }
     
-    return query.lastInsertId().toInt();
+    NoteInfo note;
+    note.id = query.lastInsertId().toInt();
+    note.title = title;
+    note.created_at = currentTime;
+    note.updated_at = currentTime;
+    note.folder_id = folder_id;
+    note.is_trashed = false;
+    
+    if (m_treeCache.isLoaded()) {
+        m_treeCache.upsertNote(note);
+    }
+    emit noteAdded(note);
+    
+    return note.id;
 }
 
+// 以指定文件夹为根的子树(含根)，供删除时各条语句复用
+static const char *SUBTREE_CTE =
+    "WITH RECURSIVE subtree(folder_id) AS ("
+    "SELECT :folder_id "
+    "UNION ALL "
+    "SELECT f.folder_id FROM Folders f JOIN subtree s ON f.parent_id = s.folder_id"
+    ") ";
+
 bool DatabaseManager::deleteFolder(int folder_id)
 {
     // 不允许删除根文件夹
@@ -374,57 +1734,59 @@ bool DatabaseManager::deleteFolder(int folder_id)
         return false;
     }
     
-    QSqlQuery query;
+    // 整个子树在一个事务中按集合删除，不再逐个文件夹、逐个笔记递归
+    const QStringList statements = {
+        "UPDATE MediaFiles SET ref_count = ref_count - "
+        "(SELECT COUNT(*) FROM NoteMedia nm WHERE nm.hash = MediaFiles.hash AND nm.note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree))), "
+        "updated_at = CURRENT_TIMESTAMP "
+        "WHERE hash IN (SELECT hash FROM NoteMedia WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree)))",
+        "DELETE FROM NoteMedia WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree))",
+        "DELETE FROM Annotations WHERE block_id IN (SELECT block_id FROM ContentBlocks WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree)))",
+        "DELETE FROM ContentBlocks WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree))",
+        "DELETE FROM NoteTexts WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree))",
+        "DELETE FROM NoteAiResults WHERE note_id IN "
+        "(SELECT note_id FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree))",
+        "DELETE FROM Notes WHERE folder_id IN (SELECT folder_id FROM subtree)",
+        "DELETE FROM Folders WHERE folder_id IN (SELECT folder_id FROM subtree)"
+    };
     
     // 开始事务
     m_db.transaction();
     
     try {
-        // 查询子文件夹
-        query.prepare("SELECT folder_id FROM Folders WHERE parent_id = :parent_id");
-        query.bindValue(":parent_id", folder_id);
-        
-        if (!query.exec()) {
-            throw std::runtime_error("查询子文件夹失败");
-        }
-        
-        // 递归删除子文件夹
-        while (query.next()) {
-            int childId = query.value(0).toInt();
-            if (!deleteFolder(childId)) {
-                throw std::runtime_error("删除子文件夹失败");
-            }
-        }
-        
-        // 获取文件夹内的所有笔记
-        query.prepare("SELECT note_id FROM Notes WHERE folder_id = :folder_id");
-        query.bindValue(":folder_id", folder_id);
-        
-        if (!query.exec()) {
-            throw std::runtime_error("查询文件夹笔记失败");
-        }
-        
-        // 删除所有笔记
-        while (query.next()) {
-            int noteId = query.value(0).toInt();
-            if (!deleteNote(noteId)) {
-                throw std::runtime_error("删除笔记失败");
+        for (const QString &statement : statements) {
+            QSqlQuery &query = preparedQuery(SUBTREE_CTE + statement);
+            query.bindValue(":folder_id", folder_id);
+            
+            if (!query.exec()) {
+                qCritical() << "删除文件夹子树失败:" << query.lastError().text();
+                throw std::runtime_error("删除文件夹失败");
             }
         }
         
-        // 删除文件夹本身
-        query.prepare("DELETE FROM Folders WHERE folder_id = :folder_id");
-        query.bindValue(":folder_id", folder_id);
-        
-        if (!query.exec()) {
-            throw std::runtime_error("删除文件夹失败");
-        }
-        
         // 提交事务
         if (!m_db.commit()) {
             throw std::runtime_error("提交事务失败");
         }
         
+        // 从缓存中移除整个子树
+        int parentId = m_treeCache.containsFolder(folder_id) ? m_treeCache.folder(folder_id).parent_id : 0;
+        const QList<int> folderIds = m_treeCache.subtreeFolderIds(folder_id);
+        for (int id : folderIds) {
+            const QList<int> noteIds = m_treeCache.noteIdsInFolder(id);
+            for (int noteId : noteIds) {
+                m_treeCache.removeNote(noteId);
+            }
+            m_treeCache.removeFolder(id);
+        }
+        emit folderRemoved(folder_id, parentId);
+        
         return true;
     }
     catch (const std::exception &e) {
@@ -435,6 +1797,99 @@ bool DatabaseManager::deleteFolder(int folder_id)
     }
 }
 
+FolderSubtree DatabaseManager::getFolderSubtree(int folder_id, int maxDepth)
+{
+    FolderSubtree subtree;
+    
+    // 缓存已加载时逐层展开，不访问数据库
+    if (m_treeCache.isLoaded()) {
+        if (!m_treeCache.containsFolder(folder_id)) {
+            return subtree;
+        }
+        subtree.found = true;
+        
+        QList<int> level = {folder_id};
+        for (int depth = 0; !level.isEmpty() && (maxDepth < 0 || depth < maxDepth); ++depth) {
+            QList<int> nextLevel;
+            for (int id : level) {
+                const QList<FolderInfo> children = m_treeCache.childFolders(id);
+                for (const FolderInfo &child : children) {
+                    if (child.id != id) {
+                        subtree.folders.append(child);
+                        nextLevel.append(child.id);
+                    }
+                }
+                subtree.notes.append(m_treeCache.notesInFolder(id));
+            }
+            level = nextLevel;
+        }
+        
+        // 排序规则与下面的递归查询一致
+        std::stable_sort(subtree.folders.begin(), subtree.folders.end(), [](const FolderInfo &a, const FolderInfo &b) {
+            return a.created_at < b.created_at;
+        });
+        std::stable_sort(subtree.notes.begin(), subtree.notes.end(), [](const NoteInfo &a, const NoteInfo &b) {
+            return a.updated_at > b.updated_at;
+        });
+        return subtree;
+    }
+    
+    // 一次递归查询同时取出子树中的文件夹和笔记头信息，depth为相对根文件夹的层级
+    QSqlQuery &query = preparedQuery(
+        "WITH RECURSIVE subtree(folder_id, name, parent_id, path, created_at, depth) AS ("
+        "SELECT folder_id, name, parent_id, path, created_at, 0 FROM Folders WHERE folder_id = :folder_id "
+        "UNION ALL "
+        "SELECT f.folder_id, f.name, f.parent_id, f.path, f.created_at, s.depth + 1 "
+        "FROM Folders f JOIN subtree s ON f.parent_id = s.folder_id WHERE s.depth < :max_depth"
+        ") "
+        "SELECT 0 AS kind, folder_id AS id, name, parent_id, path, created_at, "
+        "NULL AS updated_at, NULL AS tags, depth FROM subtree "
+        "UNION ALL "
+        "SELECT 1, n.note_id, n.title, n.folder_id, NULL, n.created_at, n.updated_at, n.tags, s.depth + 1 "
+        "FROM Notes n JOIN subtree s ON n.folder_id = s.folder_id "
+        "WHERE n.is_trashed = 0 AND s.depth < :max_depth "
+        // 文件夹按创建时间、笔记按修改时间倒序，与getAllFolders/getNotesInFolder一致
+        "ORDER BY kind, CASE WHEN kind = 0 THEN created_at END, CASE WHEN kind = 1 THEN updated_at END DESC");
+    query.bindValue(":folder_id", folder_id);
+    query.bindValue(":max_depth", maxDepth < 0 ? INT_MAX : maxDepth);
+    
+    if (!query.exec()) {
+        qCritical() << "获取文件夹子树失败:" << query.lastError().text();
+        return subtree;
+    }
+    
+    while (query.next()) {
+        if (query.value(0).toInt() == 0) {
+            FolderInfo folder;
+            folder.id = query.value(1).toInt();
+            folder.name = query.value(2).toString();
+            folder.parent_id = query.value(3).toInt();
+            folder.path = query.value(4).toString();
+            folder.created_at = query.value(5).toString();
+            
+            // 根文件夹本身只用于判断是否存在
+            if (query.value(8).toInt() == 0) {
+                subtree.found = true;
+            } else {
+                subtree.folders.append(folder);
+            }
+        } else {
+            NoteInfo note;
+            note.id = query.value(1).toInt();
+            note.title = query.value(2).toString();
+            note.folder_id = query.value(3).toInt();
+            note.created_at = query.value(5).toString();
+            note.updated_at = query.value(6).toString();
+            note.tags = query.value(7).toString();
+            note.is_trashed = false;
+            
+            subtree.notes.append(note);
+        }
+    }
+    
+    return subtree;
+}
+
 bool DatabaseManager::renameFolder(int folder_id, const QString &new_name)
 {
     // 不允许重命名根文件夹
@@ -448,7 +1903,7 @@ bool DatabaseManager::renameFolder(int folder_id, const QString &new_name)
         return false;
     }
     
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     
     // 开始事务
     m_db.transaction();
@@ -514,6 +1969,16 @@ bool DatabaseManager::renameFolder(int folder_id, const QString &new_name)
             throw std::runtime_error("提交事务失败");
         }
         
+        m_treeCache.renameFolder(folder_id, new_name, newPath);
+        
+        FolderInfo folder;
+        folder.id = folder_id;
+        folder.name = new_name;
+        folder.parent_id = parentId;
+        folder.path = newPath;
+        folder.created_at = m_treeCache.containsFolder(folder_id) ? m_treeCache.folder(folder_id).created_at : QString();
+        emit folderRenamed(folder);
+        
         return true;
     }
     catch (const std::exception &e) {
@@ -531,10 +1996,8 @@ bool DatabaseManager::renameNote(int note_id, const QString &new_title)
         return false;
     }
     
-    QSqlQuery query;
-    
     // 更新笔记标题和时间戳
-    query.prepare("UPDATE Notes SET title = :title, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
+    QSqlQuery &query = preparedQuery("UPDATE Notes SET title = :title, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
     query.bindValue(":title", new_title);
     query.bindValue(":note_id", note_id);
     
@@ -543,15 +2006,15 @@ bool DatabaseManager::renameNote(int note_id, const QString &new_title)
         return false;
     }
     
+    notifyNoteChanged(note_id);
+    
     return true;
 }
 
 bool DatabaseManager::moveNoteToTrash(int note_id)
 {
-    QSqlQuery query;
-    
     // 更新笔记状态为已删除
-    query.prepare("UPDATE Notes SET is_trashed = 1, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
+    QSqlQuery &query = preparedQuery("UPDATE Notes SET is_trashed = 1, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
     query.bindValue(":note_id", note_id);
     
     if (!query.exec()) {
@@ -559,12 +2022,14 @@ bool DatabaseManager::moveNoteToTrash(int note_id)
         return false;
     }
     
+    notifyNoteChanged(note_id);
+    
     return true;
 }
 
 bool DatabaseManager::deleteNote(int note_id)
 {
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     
     // 开始事务
     m_db.transaction();
@@ -587,6 +2052,38 @@ bool DatabaseManager::deleteNote(int note_id)
             throw std::runtime_error("删除笔记内容块失败");
         }
         
+        // 释放笔记引用的媒体文件
+        query.prepare("UPDATE MediaFiles SET ref_count = ref_count - 1, updated_at = CURRENT_TIMESTAMP "
+                      "WHERE hash IN (SELECT hash FROM NoteMedia WHERE note_id = :note_id)");
+        query.bindValue(":note_id", note_id);
+        
+        if (!query.exec()) {
+            throw std::runtime_error("释放笔记媒体引用失败");
+        }
+        
+        query.prepare("DELETE FROM NoteMedia WHERE note_id = :note_id");
+        query.bindValue(":note_id", note_id);
+        
+        if (!query.exec()) {
+            throw std::runtime_error("删除笔记媒体引用失败");
+        }
+        
+        // 删除笔记的纯文本
+        query.prepare("DELETE FROM NoteTexts WHERE note_id = :note_id");
+        query.bindValue(":note_id", note_id);
+        
+        if (!query.exec()) {
+            throw std::runtime_error("删除笔记纯文本失败");
+        }
+        
+        // 删除AI处理结果
+        query.prepare("DELETE FROM NoteAiResults WHERE note_id = :note_id");
+        query.bindValue(":note_id", note_id);
+        
+        if (!query.exec()) {
+            throw std::runtime_error("删除笔记AI处理结果失败");
+        }
+        
         // 删除笔记本身
         query.prepare("DELETE FROM Notes WHERE note_id = :note_id");
         query.bindValue(":note_id", note_id);
@@ -600,6 +2097,10 @@ bool DatabaseManager::deleteNote(int note_id)
             throw std::runtime_error("提交事务失败");
         }
         
+        int folderId = m_treeCache.containsNote(note_id) ? m_treeCache.note(note_id).folder_id : -1;
+        m_treeCache.removeNote(note_id);
+        emit noteRemoved(note_id, folderId);
+        
         return true;
     }
     catch (const std::exception &e) {
@@ -612,21 +2113,20 @@ bool DatabaseManager::deleteNote(int note_id)
 
 bool DatabaseManager::moveNote(int note_id, int folder_id)
 {
-    QSqlQuery query;
-    
     // 检查文件夹是否存在
     if (folder_id > 0) {
-        query.prepare("SELECT folder_id FROM Folders WHERE folder_id = :folder_id");
-        query.bindValue(":folder_id", folder_id);
+        QSqlQuery &checkQuery = preparedQuery("SELECT folder_id FROM Folders WHERE folder_id = :folder_id");
+        checkQuery.bindValue(":folder_id", folder_id);
         
-        if (!query.exec() || !query.next()) {
+        if (!checkQuery.exec() || !checkQuery.next()) {
             qWarning() << "无法找到目标文件夹:" << folder_id;
             return false;
         }
+        checkQuery.finish();
     }
     
     // 移动笔记到指定文件夹
-    query.prepare("UPDATE Notes SET folder_id = :folder_id, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
+    QSqlQuery &query = preparedQuery("UPDATE Notes SET folder_id = :folder_id, updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
     query.bindValue(":folder_id", folder_id);
     query.bindValue(":note_id", note_id);
     
@@ -635,16 +2135,19 @@ bool DatabaseManager::moveNote(int note_id, int folder_id)
         return false;
     }
     
+    notifyNoteChanged(note_id);
+    
     return true;
 }
 
-QList<ContentBlock> DatabaseManager::getNoteContent(int note_id)
+QList<ContentBlock> DatabaseManager::getNoteContent(int note_id, bool *ok)
 {
     QList<ContentBlock> blocks;
-    QSqlQuery query;
-    
+    if (ok) {
+        *ok = false;
+    }
     // 查询笔记的所有内容块，按位置排序
-    query.prepare("SELECT block_id, note_id, block_type, position, content_text, media_path, properties "
+    QSqlQuery &query = preparedQuery("SELECT block_id, note_id, block_type, position, content_text, media_path, properties, content_data, compression "
                  "FROM ContentBlocks WHERE note_id = :note_id ORDER BY position");
     query.bindValue(":note_id", note_id);
     
@@ -653,6 +2156,10 @@ QList<ContentBlock> DatabaseManager::getNoteContent(int note_id)
         return blocks;
     }
     
+    QElapsedTimer decodeTimer;
+    qint64 decodeNs = 0;
+    int compressedBlocks = 0;
+    
     // 遍历查询结果
     while (query.next()) {
         ContentBlock block;
@@ -663,20 +2170,40 @@ QList<ContentBlock> DatabaseManager::getNoteContent(int note_id)
         block.content_text = query.value(4).toString();
         block.media_path = query.value(5).toString();
         block.properties = query.value(6).toString();
+        block.content_data = query.value(7).toByteArray();
+        
+        int compression = query.value(8).toInt();
+        if (compression != COMPRESSION_NONE) {
+            decodeTimer.start();
+            bool decoded = decompressBlock(block, compression);
+            decodeNs += decodeTimer.nsecsElapsed();
+            ++compressedBlocks;
+            if (!decoded) {
+                // 缺块的内容一旦被保存，损坏的块会随之删除，因此整篇笔记按读取失败处理
+                qCritical() << "笔记内容块已损坏，无法读取笔记 - ID:" << note_id << "块ID:" << block.id;
+                return QList<ContentBlock>();
+            }
+        }
         
         blocks.append(block);
     }
     
+    if (compressedBlocks > 0) {
+        qDebug() << "解压笔记内容 - ID:" << note_id << "块数:" << compressedBlocks
+                 << "耗时(ms):" << decodeNs / 1000000.0;
+    }
+    
+    if (ok) {
+        *ok = true;
+    }
     return blocks;
 }
 
 QList<Annotation> DatabaseManager::getImageAnnotations(int block_id)
 {
     QList<Annotation> annotations;
-    QSqlQuery query;
-    
     // 查询图片块的所有标注
-    query.prepare("SELECT annotation_id, block_id, annotation_type, data, created_at "
+    QSqlQuery &query = preparedQuery("SELECT annotation_id, block_id, annotation_type, data, created_at "
                  "FROM Annotations WHERE block_id = :block_id ORDER BY created_at");
     query.bindValue(":block_id", block_id);
     
@@ -700,45 +2227,128 @@ QList<Annotation> DatabaseManager::getImageAnnotations(int block_id)
     return annotations;
 }
 
-bool DatabaseManager::saveNoteContent(int note_id, const QList<ContentBlock> &blocks)
+bool DatabaseManager::saveNoteContent(int note_id, const QList<ContentBlock> &blocks, const QString &plainText)
 {
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     
     // 开始事务
     m_db.transaction();
     
     try {
-        // 删除笔记的所有旧标注
-        query.prepare("DELETE FROM Annotations WHERE block_id IN "
-                     "(SELECT block_id FROM ContentBlocks WHERE note_id = :note_id)");
+        // 读取已有内容块的哈希，按位置排序
+        query.prepare("SELECT block_id, position, content_hash FROM ContentBlocks "
+                      "WHERE note_id = :note_id ORDER BY position");
         query.bindValue(":note_id", note_id);
         
         if (!query.exec()) {
-            throw std::runtime_error("删除旧标注失败");
+            throw std::runtime_error("读取旧内容块失败");
         }
         
-        // 删除笔记的所有旧内容块
-        query.prepare("DELETE FROM ContentBlocks WHERE note_id = :note_id");
-        query.bindValue(":note_id", note_id);
+        // 哈希 -> 具有该哈希的旧内容块(block_id, position)，按位置先后排列
+        QHash<QString, QList<QPair<int, int>>> existingBlocks;
+        QSet<int> unusedBlockIds;
+        while (query.next()) {
+            int blockId = query.value(0).toInt();
+            existingBlocks[query.value(2).toString()].append(qMakePair(blockId, query.value(1).toInt()));
+            unusedBlockIds.insert(blockId);
+        }
         
-        if (!query.exec()) {
-            throw std::runtime_error("删除旧内容块失败");
-        }
-        
-        // 插入新内容块
-        for (const ContentBlock &block : blocks) {
-            query.prepare("INSERT INTO ContentBlocks (note_id, block_type, position, content_text, media_path, properties) "
-                         "VALUES (:note_id, :block_type, :position, :content_text, :media_path, :properties)");
-            query.bindValue(":note_id", note_id);
-            query.bindValue(":block_type", block.block_type);
-            query.bindValue(":position", block.position);
-            query.bindValue(":content_text", block.content_text);
-            query.bindValue(":media_path", block.media_path);
-            query.bindValue(":properties", block.properties);
+        // 增量保存只需三条语句，在循环外各准备一次
+        QSqlQuery insertQuery(m_db);
+        insertQuery.prepare("INSERT INTO ContentBlocks (note_id, block_type, position, content_text, media_path, properties, content_hash, content_data, compression) "
+                            "VALUES (:note_id, :block_type, :position, :content_text, :media_path, :properties, :content_hash, :content_data, :compression)");
+        QSqlQuery moveQuery(m_db);
+        moveQuery.prepare("UPDATE ContentBlocks SET position = :position WHERE block_id = :block_id");
+        
+        int inserted = 0;
+        int moved = 0;
+        
+        for (int i = 0; i < blocks.size(); ++i) {
+            const ContentBlock &block = blocks.at(i);
+            QString hash = contentBlockHash(block);
             
-            if (!query.exec()) {
+            // 内容未变的块直接复用，必要时只更新位置
+            auto it = existingBlocks.find(hash);
+            if (it != existingBlocks.end() && !it->isEmpty()) {
+                QPair<int, int> existing = it->takeFirst();
+                unusedBlockIds.remove(existing.first);
+                if (existing.second != i) {
+                    moveQuery.bindValue(":position", i);
+                    moveQuery.bindValue(":block_id", existing.first);
+                    if (!moveQuery.exec()) {
+                        throw std::runtime_error("更新内容块位置失败");
+                    }
+                    ++moved;
+                }
+                continue;
+            }
+            
+            // 哈希按未压缩内容计算，压缩与否不影响块的复用
+            QString text = block.content_text;
+            QByteArray data = block.content_data;
+            int compression = m_compressContent ? compressBlock(block, &text, &data) : COMPRESSION_NONE;
+            
+            insertQuery.bindValue(":note_id", note_id);
+            insertQuery.bindValue(":block_type", block.block_type);
+            insertQuery.bindValue(":position", i);
+            insertQuery.bindValue(":content_text", text);
+            insertQuery.bindValue(":media_path", block.media_path);
+            insertQuery.bindValue(":properties", block.properties);
+            insertQuery.bindValue(":content_hash", hash);
+            insertQuery.bindValue(":content_data", data.isNull() ? QVariant() : QVariant(data));
+            insertQuery.bindValue(":compression", compression);
+            
+            if (!insertQuery.exec()) {
                 throw std::runtime_error("插入内容块失败");
             }
+            ++inserted;
+        }
+        
+        // 删除不再使用的旧内容块及其标注
+        if (!unusedBlockIds.isEmpty()) {
+            QSqlQuery deleteAnnotationsQuery(m_db);
+            deleteAnnotationsQuery.prepare("DELETE FROM Annotations WHERE block_id = :block_id");
+            QSqlQuery deleteBlockQuery(m_db);
+            deleteBlockQuery.prepare("DELETE FROM ContentBlocks WHERE block_id = :block_id");
+            
+            for (int blockId : unusedBlockIds) {
+                deleteAnnotationsQuery.bindValue(":block_id", blockId);
+                if (!deleteAnnotationsQuery.exec()) {
+                    throw std::runtime_error("删除旧标注失败");
+                }
+                deleteBlockQuery.bindValue(":block_id", blockId);
+                if (!deleteBlockQuery.exec()) {
+                    throw std::runtime_error("删除旧内容块失败");
+                }
+            }
+        }
+        
+        qDebug() << "保存笔记内容 - ID:" << note_id << "新增:" << inserted << "移动:" << moved
+                 << "删除:" << unusedBlockIds.size() << "未变:" << blocks.size() - inserted - moved;
+        
+        // 保存纯文本投影，调用方未提供时从HTML内容块中提取
+        QString text = plainText;
+        if (text.isNull()) {
+            QStringList textParts;
+            for (const ContentBlock &block : blocks) {
+                if (block.block_type == "text" && !block.content_text.isEmpty()) {
+                    textParts.append(htmlToPlainText(block.content_text));
+                }
+            }
+            text = textParts.join("\n");
+        }
+        if (!updateNoteText(note_id, text)) {
+            throw std::runtime_error("更新笔记纯文本失败");
+        }
+        
+        // 同步全文索引正文
+        if (!updateFullTextBody(note_id, text)) {
+            throw std::runtime_error("更新全文索引失败");
+        }
+        
+        // 同步笔记对媒体文件的引用计数
+        if (!syncNoteMedia(note_id, blocks)) {
+            throw std::runtime_error("更新媒体引用失败");
         }
         
         // 更新笔记时间戳
@@ -751,6 +2361,9 @@ bool DatabaseManager::saveNoteContent(int note_id, const QList<ContentBlock> &bl
             throw std::runtime_error("提交事务失败");
         }
         
+        // 提交后再同步缓存中的修改时间，回滚时缓存保持不变
+        notifyNoteChanged(note_id);
+        
         return true;
     }
     catch (const std::exception &e) {
@@ -763,7 +2376,7 @@ bool DatabaseManager::saveNoteContent(int note_id, const QList<ContentBlock> &bl
 
 bool DatabaseManager::saveImageAnnotations(int block_id, const QList<Annotation> &annotations)
 {
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     
     // 开始事务
     m_db.transaction();
@@ -810,6 +2423,8 @@ bool DatabaseManager::saveImageAnnotations(int block_id, const QList<Annotation>
             throw std::runtime_error("提交事务失败");
         }
         
+        notifyNoteChanged(note_id);
+        
         return true;
     }
     catch (const std::exception &e) {
@@ -822,10 +2437,8 @@ bool DatabaseManager::saveImageAnnotations(int block_id, const QList<Annotation>
 
 bool DatabaseManager::updateNoteTimestamp(int note_id)
 {
-    QSqlQuery query;
-    
     // 更新笔记的最后修改时间
-    query.prepare("UPDATE Notes SET updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
+    QSqlQuery &query = preparedQuery("UPDATE Notes SET updated_at = CURRENT_TIMESTAMP WHERE note_id = :note_id");
     query.bindValue(":note_id", note_id);
     
     if (!query.exec()) {
@@ -838,25 +2451,21 @@ bool DatabaseManager::updateNoteTimestamp(int note_id)
 
 QString DatabaseManager::importImageToMedia(const QString &source_path)
 {
-    // 检查源文件是否存在
-    QFileInfo sourceInfo(source_path);
-    if (!sourceInfo.exists() || !sourceInfo.isFile()) {
-        qWarning() << "源图片文件不存在:" << source_path;
+    // 按内容哈希存放，相同图片只保存一份
+    QString hash;
+    QString relativePath = MediaStore::store(m_mediaPath, source_path, &hash);
+    if (relativePath.isEmpty()) {
+        qCritical() << "导入图片失败:" << source_path;
         return QString();
     }
     
-    // 生成唯一文件名
-    QString filename = generateUniqueFilename(sourceInfo.fileName());
-    QString destPath = m_mediaPath + "/" + filename;
-    
-    // 复制文件
-    if (!QFile::copy(source_path, destPath)) {
-        qCritical() << "复制图片文件失败:" << source_path << "->" << destPath;
-        return QString();
+    // 登记媒体文件，引用计数在笔记保存时更新
+    if (!registerMediaFile(hash, relativePath)) {
+        qWarning() << "登记媒体文件失败:" << relativePath;
     }
     
     // 返回相对路径
-    return "notes_media/" + filename;
+    return "notes_media/" + relativePath;
 }
 
 QString DatabaseManager::getMediaAbsolutePath(const QString &relative_path)
@@ -879,80 +2488,155 @@ QString DatabaseManager::getMediaAbsolutePath(const QString &relative_path)
     return notebookPath + "/notes_media/" + path;
 }
 
-QString DatabaseManager::generateUniqueFilename(const QString &original_name)
+bool DatabaseManager::registerMediaFile(const QString &hash, const QString &relative_path)
+{
+    // 已登记的文件只刷新修改时间，使清理的宽限期重新计算
+    QSqlQuery &query = preparedQuery(
+        "INSERT INTO MediaFiles (hash, relative_path, size) VALUES (:hash, :relative_path, :size) "
+        "ON CONFLICT(hash) DO UPDATE SET updated_at = CURRENT_TIMESTAMP");
+    query.bindValue(":hash", hash);
+    query.bindValue(":relative_path", relative_path);
+    query.bindValue(":size", QFileInfo(m_mediaPath + "/" + relative_path).size());
+    
+    if (!query.exec()) {
+        qCritical() << "登记媒体文件失败:" << query.lastError().text();
+        return false;
+    }
+    
+    return true;
+}
+
+bool DatabaseManager::syncNoteMedia(int note_id, const QList<ContentBlock> &blocks)
 {
-    // 获取文件后缀
-    QFileInfo info(original_name);
-    QString suffix = info.suffix();
+    // 从内容块中收集按内容寻址的媒体文件: 哈希 -> 相对路径
+    static const QRegularExpression mediaPattern("notes_media[/\\\\]([0-9a-f]{2})[/\\\\](\\1[0-9a-f]{62})(\\.\\w+)?");
+    QHash<QString, QString> current;
+    for (const ContentBlock &block : blocks) {
+        for (const QString &text : {block.content_text, block.media_path}) {
+            if (!text.contains("notes_media")) {
+                continue;
+            }
+            QRegularExpressionMatchIterator it = mediaPattern.globalMatch(text);
+            while (it.hasNext()) {
+                QRegularExpressionMatch match = it.next();
+                current.insert(match.captured(2), match.captured(1) + "/" + match.captured(2) + match.captured(3));
+            }
+        }
+    }
+    
+    // 读取已有引用
+    QSqlQuery &selectQuery = preparedQuery("SELECT hash FROM NoteMedia WHERE note_id = :note_id");
+    selectQuery.bindValue(":note_id", note_id);
+    if (!selectQuery.exec()) {
+        qCritical() << "读取笔记媒体引用失败:" << selectQuery.lastError().text();
+        return false;
+    }
+    QSet<QString> existing;
+    while (selectQuery.next()) {
+        existing.insert(selectQuery.value(0).toString());
+    }
+    selectQuery.finish();
+    
+    // 新增引用
+    for (auto it = current.cbegin(); it != current.cend(); ++it) {
+        if (existing.remove(it.key())) {
+            continue;
+        }
+        
+        // 编辑器直接写入媒体目录的图片此时才登记
+        if (!registerMediaFile(it.key(), it.value())) {
+            return false;
+        }
+        
+        QSqlQuery &linkQuery = preparedQuery("INSERT INTO NoteMedia (note_id, hash) VALUES (:note_id, :hash)");
+        linkQuery.bindValue(":note_id", note_id);
+        linkQuery.bindValue(":hash", it.key());
+        if (!linkQuery.exec()) {
+            qCritical() << "添加笔记媒体引用失败:" << linkQuery.lastError().text();
+            return false;
+        }
+        
+        QSqlQuery &refQuery = preparedQuery("UPDATE MediaFiles SET ref_count = ref_count + 1, updated_at = CURRENT_TIMESTAMP "
+                                            "WHERE hash = :hash");
+        refQuery.bindValue(":hash", it.key());
+        if (!refQuery.exec()) {
+            qCritical() << "增加媒体引用计数失败:" << refQuery.lastError().text();
+            return false;
+        }
+    }
     
-    // 生成基于UUID和时间戳的唯一文件名
-    QString uniqueId = QUuid::createUuid().toString(QUuid::WithoutBraces);
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    // 剩下的是不再引用的文件
+    for (const QString &hash : existing) {
+        QSqlQuery &unlinkQuery = preparedQuery("DELETE FROM NoteMedia WHERE note_id = :note_id AND hash = :hash");
+        unlinkQuery.bindValue(":note_id", note_id);
+        unlinkQuery.bindValue(":hash", hash);
+        if (!unlinkQuery.exec()) {
+            qCritical() << "删除笔记媒体引用失败:" << unlinkQuery.lastError().text();
+            return false;
+        }
+        
+        QSqlQuery &refQuery = preparedQuery("UPDATE MediaFiles SET ref_count = ref_count - 1, updated_at = CURRENT_TIMESTAMP "
+                                            "WHERE hash = :hash");
+        refQuery.bindValue(":hash", hash);
+        if (!refQuery.exec()) {
+            qCritical() << "减少媒体引用计数失败:" << refQuery.lastError().text();
+            return false;
+        }
+    }
     
-    return QString("%1_%2.%3").arg(timestamp).arg(uniqueId).arg(suffix);
+    return true;
 }
 
 int DatabaseManager::cleanUnusedMediaFiles()
 {
     int count = 0;
-    QSqlQuery query;
     
-    // 获取数据库中所有已使用的媒体文件路径
-    QStringList usedPaths;
+    // 只清理引用计数归零且超过宽限期的文件，刚导入还未随笔记保存的图片不会被误删。
+    // 旧版本按UUID命名的文件在启动时由migrateLegacyMediaFiles迁移登记，同样在清理范围内
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT hash, relative_path FROM MediaFiles "
+                    "WHERE ref_count <= 0 AND updated_at < datetime('now', '-1 day')")) {
+        qCritical() << "查询未使用的媒体文件失败:" << query.lastError().text();
+        return 0;
+    }
     
-    if (query.exec("SELECT DISTINCT media_path FROM ContentBlocks WHERE media_path IS NOT NULL")) {
-        while (query.next()) {
-            QString path = query.value(0).toString();
-            if (!path.isEmpty()) {
-                // 规范化路径格式
-                if (path.startsWith("notes_media/")) {
-                    path = path.mid(12);
-                }
-                usedPaths.append(path);
-            }
-        }
+    QList<QPair<QString, QString>> candidates;
+    while (query.next()) {
+        candidates.append(qMakePair(query.value(0).toString(), query.value(1).toString()));
     }
     
-    // 遍历媒体文件夹
-    QDir mediaDir(m_mediaPath);
-    QStringList files = mediaDir.entryList(QDir::Files);
-    
-    // 删除未使用的文件
-    for (const QString &file : files) {
-        if (!usedPaths.contains(file)) {
-            if (mediaDir.remove(file)) {
-                count++;
-                qDebug() << "删除未使用的媒体文件:" << file;
-            } else {
-                qWarning() << "无法删除未使用的媒体文件:" << file;
-            }
+    QSqlQuery deleteQuery(m_db);
+    deleteQuery.prepare("DELETE FROM MediaFiles WHERE hash = :hash AND ref_count <= 0");
+    
+    for (const auto &candidate : candidates) {
+        // 删除前再次确认引用计数，期间被重新引用的文件保留
+        deleteQuery.bindValue(":hash", candidate.first);
+        if (!deleteQuery.exec() || deleteQuery.numRowsAffected() <= 0) {
+            continue;
+        }
+        
+        QString filePath = m_mediaPath + "/" + candidate.second;
+        if (!QFileInfo::exists(filePath) || QFile::remove(filePath)) {
+            count++;
+            qDebug() << "删除未使用的媒体文件:" << candidate.second;
+        } else {
+            qWarning() << "无法删除未使用的媒体文件:" << candidate.second;
         }
     }
     
     return count;
 }
 
-QList<SearchResultInfo> DatabaseManager::searchNotes(
-    const QString &keyword, 
-    int dateFilter, 
-    int contentType, 
-    int sortType
-) {
-    QList<SearchResultInfo> results;
-    
-    // 构建基本查询
-    QString sql = "SELECT n.note_id, n.title, n.created_at, n.updated_at, n.folder_id, "
-                 "f.path as folder_path, "
-                 "(SELECT c.content_text FROM ContentBlocks c WHERE c.note_id = n.note_id "
-                 "ORDER BY c.position LIMIT 1) as preview "
-                 "FROM Notes n "
-                 "LEFT JOIN Folders f ON n.folder_id = f.folder_id "
-                 "WHERE n.is_trashed = 0 ";
+QString DatabaseManager::buildSearchFilter(const QString &keyword, bool useMatch, int dateFilter, int contentType,
+                                          int sortType) const
+{
+    QString sql = "WHERE n.is_trashed = 0 ";
                  
     // 添加关键词搜索条件 (如果关键词非空)
-    if (!keyword.isEmpty()) {
-        sql += "AND (n.title LIKE :keyword OR EXISTS (SELECT 1 FROM ContentBlocks c WHERE "
-               "c.note_id = n.note_id AND c.content_text LIKE :keyword)) ";
+    if (useMatch) {
+        sql += "AND NotesFts MATCH :match ";
+    } else if (!keyword.isEmpty()) {
+        sql += "AND (n.title LIKE :keyword OR t.plain_text LIKE :keyword) ";
     }
     
     // 添加日期筛选
@@ -980,22 +2664,23 @@ QList<SearchResultInfo> DatabaseManager::searchNotes(
     
     // 添加内容类型筛选
     if (contentType > 0) {
-        QString blockType;
+        // 二进制格式的段落块(doc_block)按文本处理，引用了图片的段落按图片处理
+        QString blockCondition;
         switch (contentType) {
             case 1: // 文本
-                blockType = "text";
+                blockCondition = "c.block_type IN ('text', 'doc_block')";
                 break;
             case 2: // 图片
-                blockType = "image";
+                blockCondition = "(c.block_type = 'image' OR (c.block_type = 'doc_block' AND c.media_path <> ''))";
                 break;
             case 3: // 列表
-                blockType = "list";
+                blockCondition = "c.block_type = 'list'";
                 break;
         }
         
-        if (!blockType.isEmpty()) {
+        if (!blockCondition.isEmpty()) {
             sql += QString("AND EXISTS (SELECT 1 FROM ContentBlocks c WHERE c.note_id = n.note_id "
-                           "AND c.block_type = \'%1\') ").arg(blockType);
+                           "AND %1) ").arg(blockCondition);
         }
     }
     
@@ -1007,17 +2692,107 @@ QList<SearchResultInfo> DatabaseManager::searchNotes(
         case 2: // 按名称排序
             sql += "ORDER BY n.title COLLATE NOCASE ";
             break;
+        case 3: // 按相关度，标题命中的权重高于正文
+            if (useMatch) {
+                sql += "ORDER BY bm25(NotesFts, 10.0, 1.0), n.updated_at DESC ";
+            } else {
+                sql += "ORDER BY n.updated_at DESC ";
+            }
+            break;
         default: // 最近修改
             sql += "ORDER BY n.updated_at DESC ";
             break;
     }
     
-    QSqlQuery query;
+    // note_id作为次级排序保证翻页时顺序稳定
+    sql += ", n.note_id ";
+    return sql;
+}
+
+QList<int> DatabaseManager::searchNoteIds(const QString &keyword, int dateFilter, int contentType, int sortType)
+{
+    QList<int> noteIds;
+    
+    QString matchExpr = (m_ftsEnabled && !keyword.isEmpty()) ? buildFtsMatchExpression(keyword) : QString();
+    bool useMatch = !matchExpr.isEmpty();
+    
+    // 只取ID，不生成snippet和预览，也不需要文件夹路径
+    QString sql = "SELECT n.note_id FROM Notes n ";
+    if (useMatch) {
+        sql += "JOIN NotesFts ON NotesFts.rowid = n.note_id ";
+    }
+    sql += "LEFT JOIN NoteTexts t ON t.note_id = n.note_id ";
+    sql += buildSearchFilter(keyword, useMatch, dateFilter, contentType, sortType);
+    
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    if (useMatch) {
+        query.bindValue(":match", matchExpr);
+    } else if (!keyword.isEmpty()) {
+        query.bindValue(":keyword", "%" + keyword + "%");
+    }
+    
+    if (!query.exec()) {
+        qCritical() << "查询搜索结果ID失败:" << query.lastError().text();
+        return noteIds;
+    }
+    while (query.next()) {
+        noteIds.append(query.value(0).toInt());
+    }
+    
+    qDebug() << "DatabaseManager::searchNoteIds - Keyword:" << keyword << "Results count:" << noteIds.size();
+    return noteIds;
+}
+
+QList<SearchResultInfo> DatabaseManager::searchNotes(
+    const QString &keyword, 
+    int dateFilter, 
+    int contentType, 
+    int sortType,
+    int limit,
+    int offset
+) {
+    QList<SearchResultInfo> results;
+    
+    // 关键词能转换为MATCH表达式时走FTS5索引，否则在索引的纯文本列上做LIKE
+    QString matchExpr = (m_ftsEnabled && !keyword.isEmpty()) ? buildFtsMatchExpression(keyword) : QString();
+    bool useMatch = !matchExpr.isEmpty();
+    
+    // 构建基本查询
+    // 预览和关键词匹配均基于NoteTexts中的纯文本，不再扫描HTML内容
+    QString sql = "SELECT n.note_id, n.title, n.created_at, n.updated_at, n.folder_id, "
+                 "f.path as folder_path, t.word_count, ";
+    if (useMatch) {
+        sql += "snippet(NotesFts, 1, '', '', '...', 32) as preview "
+               "FROM Notes n "
+               "JOIN NotesFts ON NotesFts.rowid = n.note_id ";
+    } else {
+        sql += "substr(t.plain_text, 1, 200) as preview "
+               "FROM Notes n ";
+    }
+    sql += "LEFT JOIN NoteTexts t ON t.note_id = n.note_id "
+           "LEFT JOIN Folders f ON n.folder_id = f.folder_id ";
+    sql += buildSearchFilter(keyword, useMatch, dateFilter, contentType, sortType);
+    
+    // 分页
+    if (limit >= 0) {
+        sql += "LIMIT :limit OFFSET :offset ";
+    }
+    
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
     query.prepare(sql);
     // 只有当关键词非空时才绑定
-    if (!keyword.isEmpty()) {
+    if (useMatch) {
+        query.bindValue(":match", matchExpr);
+    } else if (!keyword.isEmpty()) {
         query.bindValue(":keyword", "%" + keyword + "%");
     }
+    if (limit >= 0) {
+        query.bindValue(":limit", limit);
+        query.bindValue(":offset", offset);
+    }
     
     if (query.exec()) {
         while (query.next()) {
@@ -1027,6 +2802,7 @@ QList<SearchResultInfo> DatabaseManager::searchNotes(
             info.created_at = query.value("created_at").toString();
             info.updated_at = query.value("updated_at").toString();
             info.folder_id = query.value("folder_id").toInt();
+            info.wordCount = query.value("word_count").toInt();
             
             // 构建路径
             QString folderPath = query.value("folder_path").toString();
@@ -1050,6 +2826,6 @@ QList<SearchResultInfo> DatabaseManager::searchNotes(
         qCritical() << "SQL:" << query.lastQuery(); // 输出失败的SQL语句
     }
     
-    qDebug() << "DatabaseManager::searchNotes - Keyword:" << keyword << "Results count:" << results.size(); // 添加日志
+    qDebug() << "DatabaseManager::searchNotes - Keyword:" << keyword << "Offset:" << offset << "Results count:" << results.size(); // 添加日志
     return results;
 } 
\ No newline at end of file
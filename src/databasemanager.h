@@ -24,6 +24,9 @@
 #include <QUuid>
 #include <QDateTime>
 #include <QFileInfo>
+#include <QMetaType>
+#include <QHash>
+#include "foldertreecache.h"
 
 // 笔记结构类型声明
 struct NoteInfo {
@@ -45,7 +48,9 @@ struct ContentBlock {
     QString content_text;
     QString media_path;
     QString properties;
+    QByteArray content_data; // 二进制内容(NoteDocumentCodec格式)，HTML内容块为空
 };
+Q_DECLARE_METATYPE(ContentBlock)
 
 // 图片标注类型声明
 struct Annotation {
@@ -65,6 +70,13 @@ struct FolderInfo {
     QString created_at;
 };
 
+// 文件夹子树结构
+struct FolderSubtree {
+    bool found = false; // 根文件夹是否存在
+    QList<FolderInfo> folders; // 子树中的文件夹(不含根)，按创建时间排序
+    QList<NoteInfo> notes; // 子树中未删除的笔记，按修改时间倒序
+};
+
 // 搜索结果结构
 struct SearchResultInfo {
     int id;
@@ -74,6 +86,33 @@ struct SearchResultInfo {
     QString created_at;
     QString updated_at;
     int folder_id;
+    int wordCount; // 正文字数，来自NoteTexts
+};
+Q_DECLARE_METATYPE(SearchResultInfo)
+
+// AI批量任务的检查点，记录任务中每篇笔记的处理状态
+struct AiBatchJobInfo {
+    int id = -1; // 任务ID，不存在时为-1
+    QString operation; // 操作类型标识符(summarize/tag/fix)
+    QString source; // 笔记来源描述，如文件夹名称或搜索关键词
+    QList<int> pendingNoteIds; // 尚未处理的笔记ID，按加入顺序排列
+    int total = 0; // 笔记总数
+    int succeeded = 0; // 已成功处理的笔记数
+    int failed = 0; // 处理失败的笔记数
+    int skipped = 0; // 跳过的笔记数(已删除或没有内容)
+};
+
+// 内容块压缩的统计结果，由--bench-compression模式输出
+struct CompressionBenchmarkResult {
+    int notes = 0; // 有内容块的笔记数
+    int blocks = 0; // 内容块总数
+    int compressedBlocks = 0; // 压缩保存的内容块数
+    int failedBlocks = 0; // 解压失败的内容块数
+    qint64 storedBytes = 0; // 数据库中保存的字节数
+    qint64 rawBytes = 0; // 解压后的字节数
+    double averageDecodeMs = 0; // 每篇笔记的平均解压耗时(毫秒)
+    double maxDecodeMs = 0; // 单篇笔记的最长解压耗时(毫秒)
+    int slowestNoteId = -1; // 解压最慢的笔记ID
 };
 
 /**
@@ -84,9 +123,75 @@ class DatabaseManager : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * @brief SQLite连接的存储配置，保存在QSettings的DataStorage分组中，新建连接时生效
+     */
+    struct StorageConfig {
+        bool walMode = true; // 使用WAL日志，读连接不会被写事务阻塞
+        QString synchronous = "NORMAL"; // 同步级别: OFF/NORMAL/FULL
+        int cacheSizeMB = 32; // 页缓存大小(MB)
+        int mmapSizeMB = 256; // 内存映射大小(MB)，0表示关闭
+        bool tempStoreMemory = true; // 临时表和索引放在内存中
+        int busyTimeoutMs = 5000; // 数据库被锁定时的等待时间(毫秒)
+        bool compressContent = true; // 压缩保存较大的内容块
+
+        /**
+         * @brief 从QSettings读取存储配置
+         * @return StorageConfig 存储配置
+         */
+        static StorageConfig fromSettings();
+    };
+
+    // AI批量任务中笔记的处理状态
+    enum AiBatchItemStatus {
+        AiBatchItemPending = 0,
+        AiBatchItemSucceeded = 1,
+        AiBatchItemFailed = 2,
+        AiBatchItemSkipped = 3  // 笔记已删除或没有内容，不需要处理
+    };
+
     explicit DatabaseManager(QObject *parent = nullptr);
+
+    /**
+     * @brief 使用命名连接构造，供工作线程持有独立的数据库连接
+     * @param connectionName 连接名称，需在所有DatabaseManager实例中唯一
+     * @param parent 父对象
+     */
+    explicit DatabaseManager(const QString &connectionName, QObject *parent = nullptr);
     ~DatabaseManager();
 
+    /**
+     * @brief 设置为只读连接，需在initialize之前调用。只读连接不创建表结构，用于搜索等后台读取
+     * @param readOnly 是否只读
+     */
+    void setReadOnly(bool readOnly) { m_readOnly = readOnly; }
+
+    /**
+     * @brief 设置为辅助可写连接，需在initialize之前调用。辅助连接只打开数据库并应用连接参数，
+     *        建表、迁移和回填只由主连接在启动时执行一次，用于自动保存等后台写入
+     * @param secondary 是否为辅助连接
+     */
+    void setSecondaryConnection(bool secondary) { m_secondary = secondary; }
+
+    /**
+     * @brief 设置是否加载文件夹/笔记层级缓存，需在initialize之前调用。只写内容的后台连接无需缓存
+     * @param enabled 是否启用
+     */
+    void setTreeCacheEnabled(bool enabled) { m_treeCacheEnabled = enabled; }
+
+    /**
+     * @brief 对数据库文件执行WAL检查点，使复制notes.db即可得到完整数据(用于备份)
+     * @param dbPath 数据库文件路径
+     * @return bool 是否成功
+     */
+    static bool checkpointDatabaseFile(const QString &dbPath);
+
+    /**
+     * @brief 删除数据库文件对应的-wal和-shm文件(用于替换数据库文件之后)
+     * @param dbPath 数据库文件路径
+     */
+    static void removeWalFiles(const QString &dbPath);
+
     /**
      * @brief 初始化数据库连接和表结构
      * @return bool 是否成功初始化
@@ -106,6 +211,14 @@ public:
      */
     QList<NoteInfo> getNotesInFolder(int folder_id);
 
+    /**
+     * @brief 用一次递归查询获取文件夹子树中的文件夹和笔记
+     * @param folder_id 根文件夹ID
+     * @param maxDepth 最大层级，1表示只取直接子项，-1表示不限制
+     * @return FolderSubtree 子树内容
+     */
+    FolderSubtree getFolderSubtree(int folder_id, int maxDepth = -1);
+
     /**
      * @brief 根据ID获取笔记信息
      * @param note_id 笔记ID
@@ -113,6 +226,13 @@ public:
      */
     NoteInfo getNoteById(int note_id);
 
+    /**
+     * @brief 根据ID获取文件夹信息
+     * @param folder_id 文件夹ID
+     * @return FolderInfo 文件夹信息，不存在时id为-1
+     */
+    FolderInfo getFolderById(int folder_id);
+
     /**
      * @brief 创建新文件夹
      * @param name 文件夹名称
@@ -130,7 +250,7 @@ public:
     int createNote(const QString &title, int folder_id = 0);
 
     /**
-     * @brief 删除文件夹
+     * @brief 删除文件夹及其整个子树(子文件夹、笔记、内容块和标注)，在单个事务中完成
      * @param folder_id 文件夹ID
      * @return bool 是否成功删除
      */
@@ -177,9 +297,11 @@ public:
     /**
      * @brief 获取笔记内容块
      * @param note_id 笔记ID
-     * @return QList<ContentBlock> 内容块列表
+     * @param ok 输出是否读取成功，可为空。任一内容块解压失败即视为失败，不返回部分内容块，
+     *           避免调用方把缺块的内容当作完整笔记保存而删除损坏的块
+     * @return QList<ContentBlock> 内容块列表，失败时为空
      */
-    QList<ContentBlock> getNoteContent(int note_id);
+    QList<ContentBlock> getNoteContent(int note_id, bool *ok = nullptr);
 
     /**
      * @brief 获取图片块的所有标注
@@ -189,12 +311,13 @@ public:
     QList<Annotation> getImageAnnotations(int block_id);
 
     /**
-     * @brief 保存笔记内容
+     * @brief 保存笔记内容(增量)，按哈希比对只插入、移动或删除发生变化的内容块
      * @param note_id 笔记ID
      * @param blocks 内容块列表
+     * @param plainText 笔记正文纯文本，为空(null)时从内容块HTML中提取
      * @return bool 是否成功保存
      */
-    bool saveNoteContent(int note_id, const QList<ContentBlock> &blocks);
+    bool saveNoteContent(int note_id, const QList<ContentBlock> &blocks, const QString &plainText = QString());
 
     /**
      * @brief 保存图片标注
@@ -205,9 +328,9 @@ public:
     bool saveImageAnnotations(int block_id, const QList<Annotation> &annotations);
 
     /**
-     * @brief 导入图片到媒体文件夹
+     * @brief 导入图片到媒体文件夹，相同内容的图片共用一个文件
      * @param source_path 源图片路径
-     * @return QString 导入后的相对路径
+     * @return QString 导入后的相对路径(notes_media/<哈希前两位>/<哈希>.<扩展名>)
      */
     QString importImageToMedia(const QString &source_path);
 
@@ -219,7 +342,7 @@ public:
     QString getMediaAbsolutePath(const QString &relative_path);
 
     /**
-     * @brief 清理未使用的媒体文件
+     * @brief 清理引用计数为零且超过一天未被引用的媒体文件
      * @return int 清理的文件数量
      */
     int cleanUnusedMediaFiles();
@@ -229,20 +352,206 @@ public:
      * @param keyword 搜索关键词
      * @param dateFilter 日期筛选类型: 0-全部时间, 1-今天, 2-最近一周, 3-最近一月
      * @param contentType 内容类型筛选: 0-全部类型, 1-文本, 2-图片, 3-列表
-     * @param sortType 排序方式: 0-最近修改, 1-创建时间, 2-按名称排序
+     * @param sortType 排序方式: 0-最近修改, 1-创建时间, 2-按名称排序, 3-按相关度
+     * @param limit 最多返回的条数，-1表示不限制
+     * @param offset 跳过的条数，配合limit实现分页
      * @return QList<SearchResultInfo> 搜索结果
      */
     QList<SearchResultInfo> searchNotes(
         const QString &keyword, 
         int dateFilter = 0, 
         int contentType = 0, 
-        int sortType = 0
+        int sortType = 0,
+        int limit = -1,
+        int offset = 0
     );
 
+    /**
+     * @brief 按与searchNotes相同的条件和顺序只查询笔记ID，不生成预览文本
+     * @param keyword 搜索关键词
+     * @param dateFilter 日期筛选类型，含义同searchNotes
+     * @param contentType 内容类型筛选，含义同searchNotes
+     * @param sortType 排序方式，含义同searchNotes
+     * @return QList<int> 全部匹配的笔记ID
+     */
+    QList<int> searchNoteIds(const QString &keyword, int dateFilter = 0, int contentType = 0, int sortType = 0);
+
+    /**
+     * @brief 设置笔记标签，不更新修改时间
+     * @param note_id 笔记ID
+     * @param tags 以逗号分隔的标签
+     * @return bool 是否成功
+     */
+    bool setNoteTags(int note_id, const QString &tags);
+
+    /**
+     * @brief 保存AI对笔记的处理结果(如总结、纠错后的文本)，同一操作只保留最新一份
+     * @param note_id 笔记ID
+     * @param operation 操作类型标识符
+     * @param result 结果文本
+     * @return bool 是否成功
+     */
+    bool saveNoteAiResult(int note_id, const QString &operation, const QString &result);
+
+    /**
+     * @brief 获取AI对笔记的处理结果
+     * @param note_id 笔记ID
+     * @param operation 操作类型标识符
+     * @return QString 结果文本，不存在时返回空字符串
+     */
+    QString getNoteAiResult(int note_id, const QString &operation);
+
+    /**
+     * @brief 创建AI批量任务的检查点，所有笔记初始为未处理
+     * @param operation 操作类型标识符
+     * @param source 笔记来源描述
+     * @param noteIds 需要处理的笔记ID
+     * @return int 任务ID，失败返回-1
+     */
+    int createAiBatchJob(const QString &operation, const QString &source, const QList<int> &noteIds);
+
+    /**
+     * @brief 更新批量任务中一篇笔记的处理状态
+     * @param job_id 任务ID
+     * @param note_id 笔记ID
+     * @param status 处理状态(AiBatchItemStatus)
+     * @return bool 是否成功
+     */
+    bool setAiBatchItemStatus(int job_id, int note_id, int status);
+
+    /**
+     * @brief 获取最早创建且仍有未处理笔记的批量任务，用于中断后继续
+     * @return AiBatchJobInfo 任务检查点，没有时id为-1
+     */
+    AiBatchJobInfo getUnfinishedAiBatchJob();
+
+    /**
+     * @brief 删除批量任务及其检查点(任务完成或被取消后调用)
+     * @param job_id 任务ID
+     * @return bool 是否成功
+     */
+    bool deleteAiBatchJob(int job_id);
+
+    /**
+     * @brief 删除所有笔记都已处理完的批量任务，任务结束后、删除检查点前程序退出时会留下这类任务
+     * @return int 删除的任务数，失败返回-1
+     */
+    int deleteFinishedAiBatchJobs();
+
+    /**
+     * @brief 获取笔记正文的纯文本
+     * @param note_id 笔记ID
+     * @return QString 纯文本，不存在时返回空字符串
+     */
+    QString getNotePlainText(int note_id);
+
+    /**
+     * @brief 全文索引是否可用(FTS5)
+     * @return bool 不可用时搜索退回LIKE扫描
+     */
+    bool isFullTextSearchEnabled() const { return m_ftsEnabled; }
+
+    /**
+     * @brief 预编译语句缓存命中次数
+     */
+    int statementCacheHits() const { return m_statementCacheHits; }
+
+    /**
+     * @brief 预编译语句缓存未命中(新编译)次数
+     */
+    int statementCacheMisses() const { return m_statementCacheMisses; }
+
+    /**
+     * @brief 文件夹/笔记层级缓存是否已加载，加载后层级读取不再访问数据库
+     */
+    bool isTreeCacheLoaded() const { return m_treeCache.isLoaded(); }
+
+    /**
+     * @brief 从数据库重新加载文件夹/笔记层级缓存(数据库被外部替换后调用)
+     * @return bool 是否成功加载
+     */
+    bool reloadTreeCache();
+
+    /**
+     * @brief 为没有纯文本投影的笔记(如由其他连接直接写入的导入笔记)补写纯文本和全文索引正文
+     * @return int 补写的笔记数，失败返回-1
+     */
+    int backfillNoteTexts();
+
+    /**
+     * @brief 读取全部内容块，统计压缩率和每篇笔记的解压耗时
+     * @return CompressionBenchmarkResult 统计结果，查询失败时notes为0
+     */
+    CompressionBenchmarkResult benchmarkCompression();
+
+    /**
+     * @brief 笔记被其他连接修改后(如自动保存线程)重新读取其头信息，并发出noteChanged信号
+     * @param note_id 笔记ID
+     */
+    void refreshNoteHeader(int note_id) { notifyNoteChanged(note_id); }
+
+signals:
+    /**
+     * @brief 新建文件夹后发出
+     * @param folder 新文件夹信息
+     */
+    void folderAdded(const FolderInfo &folder);
+
+    /**
+     * @brief 文件夹重命名后发出，子孙文件夹的路径已一并更新
+     * @param folder 更新后的文件夹信息
+     */
+    void folderRenamed(const FolderInfo &folder);
+
+    /**
+     * @brief 文件夹及其子树被删除后发出
+     * @param folder_id 被删除的文件夹ID
+     * @param parent_id 原父文件夹ID
+     */
+    void folderRemoved(int folder_id, int parent_id);
+
+    /**
+     * @brief 新建笔记后发出
+     * @param note 新笔记信息
+     */
+    void noteAdded(const NoteInfo &note);
+
+    /**
+     * @brief 笔记头信息变化(重命名、移动、移入回收站、修改时间更新)后发出
+     * @param note 更新后的笔记信息
+     * @param oldFolderId 变化前所属的文件夹ID，与note.folder_id不同表示笔记被移动
+     */
+    void noteChanged(const NoteInfo &note, int oldFolderId);
+
+    /**
+     * @brief 笔记被永久删除后发出
+     * @param note_id 笔记ID
+     * @param folder_id 原所属文件夹ID
+     */
+    void noteRemoved(int note_id, int folder_id);
+
 private:
     QSqlDatabase m_db; // 数据库连接
+    QString m_connectionName; // 连接名称，为空时使用默认连接
+    bool m_readOnly = false; // 是否为只读连接
+    bool m_secondary = false; // 是否为辅助可写连接，不执行建表和迁移
+    bool m_treeCacheEnabled = true; // 是否加载层级缓存
+    QHash<QString, QSqlQuery*> m_statementCache; // 预编译语句缓存，键为SQL文本
+    int m_statementCacheHits = 0; // 缓存命中次数
+    int m_statementCacheMisses = 0; // 缓存未命中次数
     QString m_dbPath; // 数据库文件路径
     QString m_mediaPath; // 媒体文件夹路径
+    bool m_ftsEnabled = false; // 是否已建立FTS5全文索引
+    bool m_ftsTrigram = false; // 全文索引是否使用trigram分词器(支持中文子串匹配)
+    bool m_compressContent = true; // 新写入的内容块是否压缩
+    FolderTreeCache m_treeCache; // 文件夹/笔记层级缓存，只在读写连接上加载
+
+    /**
+     * @brief 对当前连接应用存储配置(journal_mode、synchronous、cache_size等)
+     * @param config 存储配置
+     * @return bool 是否全部设置成功
+     */
+    bool applyStorageConfig(const StorageConfig &config);
 
     /**
      * @brief 创建数据库表
@@ -258,6 +567,13 @@ private:
      */
     bool executeQuery(QSqlQuery &query, const QString &sql);
 
+    /**
+     * @brief 从缓存获取已预编译的语句，首次使用时编译并缓存
+     * @param sql SQL语句(只用于固定SQL文本，不要传入拼接了参数值的语句)
+     * @return QSqlQuery& 已重置的预编译语句，由缓存持有
+     */
+    QSqlQuery &preparedQuery(const QString &sql);
+
     /**
      * @brief 检查表是否存在
      * @param tableName 表名
@@ -265,6 +581,79 @@ private:
      */
     bool tableExists(const QString &tableName);
 
+    /**
+     * @brief 检查表中是否存在指定列
+     * @param tableName 表名
+     * @param columnName 列名
+     * @return bool 列是否存在
+     */
+    bool columnExists(const QString &tableName, const QString &columnName);
+
+    /**
+     * @brief 计算内容块的哈希，用于增量保存时识别未变化的块
+     * @param block 内容块
+     * @return QString 十六进制哈希值
+     */
+    static QString contentBlockHash(const ContentBlock &block);
+
+    // ContentBlocks.compression取值
+    static constexpr int COMPRESSION_NONE = 0;      // 未压缩
+    static constexpr int COMPRESSION_ZLIB_TEXT = 1; // content_text的UTF-8经zlib压缩后存入content_data
+    static constexpr int COMPRESSION_ZLIB_DATA = 2; // content_data经zlib压缩
+    static constexpr int COMPRESSION_MIN_BYTES = 256; // 小于该大小的块不压缩，压缩头开销得不偿失
+    static constexpr int COMPRESSION_SCHEMA_VERSION = 1; // user_version达到该值表示已有内容块已完成压缩迁移
+
+    /**
+     * @brief 按存储格式压缩内容块，压缩后不够小时保持原样
+     * @param block 内容块
+     * @param text 输出要写入content_text的值
+     * @param data 输出要写入content_data的值
+     * @return int 压缩方式(COMPRESSION_*)
+     */
+    static int compressBlock(const ContentBlock &block, QString *text, QByteArray *data);
+
+    /**
+     * @brief 将读出的内容块还原为未压缩形式
+     * @param block 内容块，content_text/content_data为数据库中的原值
+     * @param compression 压缩方式(COMPRESSION_*)
+     * @return bool 是否成功，数据损坏时返回false
+     */
+    static bool decompressBlock(ContentBlock &block, int compression);
+
+    /**
+     * @brief 将已有的未压缩内容块压缩保存，完成后记录在PRAGMA user_version中，只执行一次
+     * @return bool 是否成功
+     */
+    bool migrateContentCompression();
+
+    /**
+     * @brief 将旧版本按UUID命名、直接放在媒体目录下的文件迁移为按内容哈希存放，
+     * 改写内容块中的引用并按现有笔记内容登记引用计数，之后由cleanUnusedMediaFiles统一清理。
+     * 迁移成功后删除旧文件，媒体目录下不再有旧文件时不做任何事
+     * @return bool 是否成功
+     */
+    bool migrateLegacyMediaFiles();
+
+    /**
+     * @brief 从数据库重新读取单个文件夹到层级缓存
+     * @param folder_id 文件夹ID
+     * @return FolderInfo 文件夹信息，不存在时id为-1
+     */
+    FolderInfo refreshCachedFolder(int folder_id);
+
+    /**
+     * @brief 从数据库重新读取单个笔记头信息到层级缓存
+     * @param note_id 笔记ID
+     * @return NoteInfo 笔记信息，不存在时id为-1
+     */
+    NoteInfo refreshCachedNote(int note_id);
+
+    /**
+     * @brief 笔记头信息被修改后刷新缓存并发出noteChanged信号
+     * @param note_id 笔记ID
+     */
+    void notifyNoteChanged(int note_id);
+
     /**
      * @brief 更新笔记的最后修改时间
      * @param note_id 笔记ID
@@ -273,11 +662,85 @@ private:
     bool updateNoteTimestamp(int note_id);
 
     /**
-     * @brief 生成唯一文件名
-     * @param original_name 原始文件名
-     * @return QString 新的唯一文件名
+     * @brief 登记按内容寻址的媒体文件，已登记时只刷新修改时间
+     * @param hash 内容哈希
+     * @param relative_path 相对媒体目录的路径
+     * @return bool 是否成功
+     */
+    bool registerMediaFile(const QString &hash, const QString &relative_path);
+
+    /**
+     * @brief 根据内容块中引用的媒体文件更新NoteMedia和引用计数(需在事务中调用)
+     * @param note_id 笔记ID
+     * @param blocks 笔记的全部内容块
+     * @return bool 是否成功
+     */
+    bool syncNoteMedia(int note_id, const QList<ContentBlock> &blocks);
+
+    /**
+     * @brief 创建FTS5全文索引表及同步触发器，首次创建时回填已有笔记
+     * @return bool 全文索引是否可用
+     */
+    bool createFullTextIndex();
+
+    /**
+     * @brief 检测全文索引是否存在并读取分词器类型
+     * @return bool 全文索引是否存在
+     */
+    bool detectFullTextIndex();
+
+    /**
+     * @brief 根据NoteTexts重建全部笔记的全文索引
+     * @return bool 是否成功重建
+     */
+    bool rebuildFullTextIndex();
+
+    /**
+     * @brief 更新单个笔记在全文索引中的正文
+     * @param note_id 笔记ID
+     * @param body 笔记纯文本正文
+     * @return bool 是否成功更新
+     */
+    bool updateFullTextBody(int note_id, const QString &body);
+
+    /**
+     * @brief 从内容块重新生成全部笔记的纯文本投影
+     * @return bool 是否成功
+     */
+    bool rebuildNoteTexts();
+
+    /**
+     * @brief 写入单个笔记的纯文本及字数统计
+     * @param note_id 笔记ID
+     * @param plainText 纯文本
+     * @return bool 是否成功写入
+     */
+    bool updateNoteText(int note_id, const QString &plainText);
+
+    /**
+     * @brief 将用户输入的关键词转换为FTS5 MATCH表达式
+     * @param keyword 搜索关键词
+     * @return QString MATCH表达式，关键词不适合走索引时返回空字符串
+     */
+    QString buildFtsMatchExpression(const QString &keyword) const;
+
+    /**
+     * @brief 生成搜索的筛选和排序子句(从WHERE到ORDER BY)，searchNotes和searchNoteIds共用
+     * @param keyword 搜索关键词，非空且未走索引时使用:keyword参数
+     * @param useMatch 是否以:match参数走FTS5索引
+     * @param dateFilter 日期筛选类型
+     * @param contentType 内容类型筛选
+     * @param sortType 排序方式
+     * @return QString SQL子句
+     */
+    QString buildSearchFilter(const QString &keyword, bool useMatch, int dateFilter, int contentType, int sortType) const;
+
+    /**
+     * @brief 将HTML内容转换为纯文本
+     * @param html HTML内容
+     * @return QString 纯文本
      */
-    QString generateUniqueFilename(const QString &original_name);
+    static QString htmlToPlainText(const QString &html);
 };
 
 #endif // DATABASEMANAGER_H 
\ No newline at end of file
@@ -0,0 +1,283 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-24 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-24 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\foldertreecache.cpp
+ * @Description: 文件夹/笔记层级的内存缓存实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "foldertreecache.h"
+#include "databasemanager.h"
+
+#include <algorithm>
+
+// 用最后一个元素填补被删除的位置，避免移动整列
+template <typename T>
+static void swapRemove(QVector<T> &column, int row)
+{
+    const int last = column.size() - 1;
+    if (row != last) {
+        column[row] = column[last];
+    }
+    column.removeLast();
+}
+
+void FolderTreeCache::clear()
+{
+    m_loaded = false;
+
+    m_folderIds.clear();
+    m_folderParentIds.clear();
+    m_folderNames.clear();
+    m_folderPaths.clear();
+    m_folderCreatedAt.clear();
+    m_folderRows.clear();
+    m_childFolderIds.clear();
+
+    m_noteIds.clear();
+    m_noteFolderIds.clear();
+    m_noteTitles.clear();
+    m_noteCreatedAt.clear();
+    m_noteUpdatedAt.clear();
+    m_noteTags.clear();
+    m_noteTrashed.clear();
+    m_noteRows.clear();
+    m_folderNoteIds.clear();
+}
+
+void FolderTreeCache::upsertFolder(const FolderInfo &folder)
+{
+    auto it = m_folderRows.constFind(folder.id);
+    if (it == m_folderRows.constEnd()) {
+        m_folderRows.insert(folder.id, m_folderIds.size());
+        m_folderIds.append(folder.id);
+        m_folderParentIds.append(folder.parent_id);
+        m_folderNames.append(folder.name);
+        m_folderPaths.append(folder.path);
+        m_folderCreatedAt.append(folder.created_at);
+        m_childFolderIds.insert(folder.parent_id, folder.id);
+        return;
+    }
+
+    const int row = it.value();
+    if (m_folderParentIds[row] != folder.parent_id) {
+        m_childFolderIds.remove(m_folderParentIds[row], folder.id);
+        m_childFolderIds.insert(folder.parent_id, folder.id);
+        m_folderParentIds[row] = folder.parent_id;
+    }
+    m_folderNames[row] = folder.name;
+    m_folderPaths[row] = folder.path;
+    m_folderCreatedAt[row] = folder.created_at;
+}
+
+void FolderTreeCache::renameFolder(int folder_id, const QString &newName, const QString &newPath)
+{
+    auto it = m_folderRows.constFind(folder_id);
+    if (it == m_folderRows.constEnd()) {
+        return;
+    }
+
+    const int row = it.value();
+    const QString oldPath = m_folderPaths[row];
+    m_folderNames[row] = newName;
+    m_folderPaths[row] = newPath;
+
+    // 子孙文件夹路径以旧路径为前缀，与数据库中的更新规则一致
+    const QList<int> descendants = subtreeFolderIds(folder_id);
+    for (int i = 1; i < descendants.size(); ++i) {
+        QString &path = m_folderPaths[m_folderRows.value(descendants.at(i))];
+        if (path.startsWith(oldPath + "/")) {
+            path.replace(0, oldPath.length(), newPath);
+        }
+    }
+}
+
+void FolderTreeCache::removeFolder(int folder_id)
+{
+    auto it = m_folderRows.constFind(folder_id);
+    if (it == m_folderRows.constEnd()) {
+        return;
+    }
+
+    const int row = it.value();
+    m_childFolderIds.remove(m_folderParentIds[row], folder_id);
+    m_folderRows.remove(folder_id);
+
+    // 末尾行移动到被删除的位置，更新其索引
+    const int last = m_folderIds.size() - 1;
+    if (row != last) {
+        m_folderRows[m_folderIds[last]] = row;
+    }
+    swapRemove(m_folderIds, row);
+    swapRemove(m_folderParentIds, row);
+    swapRemove(m_folderNames, row);
+    swapRemove(m_folderPaths, row);
+    swapRemove(m_folderCreatedAt, row);
+}
+
+FolderInfo FolderTreeCache::folder(int folder_id) const
+{
+    return folderAt(m_folderRows.value(folder_id, -1));
+}
+
+QList<FolderInfo> FolderTreeCache::allFolders() const
+{
+    QList<FolderInfo> folders;
+    folders.reserve(m_folderIds.size());
+    for (int row = 0; row < m_folderIds.size(); ++row) {
+        folders.append(folderAt(row));
+    }
+
+    std::stable_sort(folders.begin(), folders.end(), [](const FolderInfo &a, const FolderInfo &b) {
+        return a.created_at < b.created_at;
+    });
+    return folders;
+}
+
+QList<FolderInfo> FolderTreeCache::childFolders(int parent_id) const
+{
+    QList<FolderInfo> folders;
+    for (auto it = m_childFolderIds.constFind(parent_id); it != m_childFolderIds.constEnd() && it.key() == parent_id; ++it) {
+        folders.append(folderAt(m_folderRows.value(it.value())));
+    }
+
+    // 创建时间相同时按ID排序，保证顺序稳定
+    std::sort(folders.begin(), folders.end(), [](const FolderInfo &a, const FolderInfo &b) {
+        return a.created_at != b.created_at ? a.created_at < b.created_at : a.id < b.id;
+    });
+    return folders;
+}
+
+QList<int> FolderTreeCache::subtreeFolderIds(int folder_id) const
+{
+    QList<int> ids;
+    if (!m_folderRows.contains(folder_id)) {
+        return ids;
+    }
+
+    // 广度优先遍历，ids同时作为队列
+    ids.append(folder_id);
+    for (int i = 0; i < ids.size(); ++i) {
+        const int current = ids.at(i);
+        for (auto it = m_childFolderIds.constFind(current); it != m_childFolderIds.constEnd() && it.key() == current; ++it) {
+            // 根文件夹的parent_id可能指向自身，跳过自环
+            if (it.value() != current) {
+                ids.append(it.value());
+            }
+        }
+    }
+    return ids;
+}
+
+void FolderTreeCache::upsertNote(const NoteInfo &note)
+{
+    auto it = m_noteRows.constFind(note.id);
+    if (it == m_noteRows.constEnd()) {
+        m_noteRows.insert(note.id, m_noteIds.size());
+        m_noteIds.append(note.id);
+        m_noteFolderIds.append(note.folder_id);
+        m_noteTitles.append(note.title);
+        m_noteCreatedAt.append(note.created_at);
+        m_noteUpdatedAt.append(note.updated_at);
+        m_noteTags.append(note.tags);
+        m_noteTrashed.append(note.is_trashed);
+        m_folderNoteIds.insert(note.folder_id, note.id);
+        return;
+    }
+
+    const int row = it.value();
+    if (m_noteFolderIds[row] != note.folder_id) {
+        m_folderNoteIds.remove(m_noteFolderIds[row], note.id);
+        m_folderNoteIds.insert(note.folder_id, note.id);
+        m_noteFolderIds[row] = note.folder_id;
+    }
+    m_noteTitles[row] = note.title;
+    m_noteCreatedAt[row] = note.created_at;
+    m_noteUpdatedAt[row] = note.updated_at;
+    m_noteTags[row] = note.tags;
+    m_noteTrashed[row] = note.is_trashed;
+}
+
+void FolderTreeCache::removeNote(int note_id)
+{
+    auto it = m_noteRows.constFind(note_id);
+    if (it == m_noteRows.constEnd()) {
+        return;
+    }
+
+    const int row = it.value();
+    m_folderNoteIds.remove(m_noteFolderIds[row], note_id);
+    m_noteRows.remove(note_id);
+
+    const int last = m_noteIds.size() - 1;
+    if (row != last) {
+        m_noteRows[m_noteIds[last]] = row;
+    }
+    swapRemove(m_noteIds, row);
+    swapRemove(m_noteFolderIds, row);
+    swapRemove(m_noteTitles, row);
+    swapRemove(m_noteCreatedAt, row);
+    swapRemove(m_noteUpdatedAt, row);
+    swapRemove(m_noteTags, row);
+    swapRemove(m_noteTrashed, row);
+}
+
+NoteInfo FolderTreeCache::note(int note_id) const
+{
+    return noteAt(m_noteRows.value(note_id, -1));
+}
+
+QList<NoteInfo> FolderTreeCache::notesInFolder(int folder_id) const
+{
+    QList<NoteInfo> notes;
+    for (auto it = m_folderNoteIds.constFind(folder_id); it != m_folderNoteIds.constEnd() && it.key() == folder_id; ++it) {
+        const int row = m_noteRows.value(it.value());
+        if (!m_noteTrashed[row]) {
+            notes.append(noteAt(row));
+        }
+    }
+
+    std::sort(notes.begin(), notes.end(), [](const NoteInfo &a, const NoteInfo &b) {
+        return a.updated_at != b.updated_at ? a.updated_at > b.updated_at : a.id > b.id;
+    });
+    return notes;
+}
+
+FolderInfo FolderTreeCache::folderAt(int row) const
+{
+    FolderInfo folder;
+    if (row < 0 || row >= m_folderIds.size()) {
+        folder.id = -1;
+        folder.parent_id = -1;
+        return folder;
+    }
+
+    folder.id = m_folderIds[row];
+    folder.parent_id = m_folderParentIds[row];
+    folder.name = m_folderNames[row];
+    folder.path = m_folderPaths[row];
+    folder.created_at = m_folderCreatedAt[row];
+    return folder;
+}
+
+NoteInfo FolderTreeCache::noteAt(int row) const
+{
+    NoteInfo note;
+    if (row < 0 || row >= m_noteIds.size()) {
+        note.id = -1;
+        note.folder_id = -1;
+        note.is_trashed = false;
+        return note;
+    }
+
+    note.id = m_noteIds[row];
+    note.folder_id = m_noteFolderIds[row];
+    note.title = m_noteTitles[row];
+    note.created_at = m_noteCreatedAt[row];
+    note.updated_at = m_noteUpdatedAt[row];
+    note.tags = m_noteTags[row];
+    note.is_trashed = m_noteTrashed[row];
+    return note;
+}
@@ -0,0 +1,169 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-24 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-24 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\foldertreecache.h
+ * @Description: 文件夹/笔记层级的内存缓存
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef FOLDERTREECACHE_H
+#define FOLDERTREECACHE_H
+
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+#include <QString>
+#include <QList>
+
+struct FolderInfo;
+struct NoteInfo;
+
+/**
+ * @brief 常驻内存的文件夹和笔记头信息缓存
+ *
+ * 启动时由DatabaseManager一次性加载，之后随各个修改操作同步更新，侧边栏的读取不再访问数据库。
+ * 数据按列存放(结构数组)，行号通过ID索引查找，删除时用末尾行填补空位。
+ * 笔记只缓存头信息(标题、时间、标签等)，不包含正文。
+ */
+class FolderTreeCache
+{
+public:
+    /**
+     * @brief 清空缓存并标记为未加载
+     */
+    void clear();
+
+    /**
+     * @brief 缓存是否已从数据库完整加载
+     */
+    bool isLoaded() const { return m_loaded; }
+
+    /**
+     * @brief 设置加载状态，加载完成后读取接口才会使用缓存
+     * @param loaded 是否已加载
+     */
+    void setLoaded(bool loaded) { m_loaded = loaded; }
+
+    /**
+     * @brief 插入或更新文件夹
+     * @param folder 文件夹信息
+     */
+    void upsertFolder(const FolderInfo &folder);
+
+    /**
+     * @brief 重命名文件夹，同时替换所有子孙文件夹路径中的旧前缀
+     * @param folder_id 文件夹ID
+     * @param newName 新名称
+     * @param newPath 新路径
+     */
+    void renameFolder(int folder_id, const QString &newName, const QString &newPath);
+
+    /**
+     * @brief 移除文件夹本身(不处理子项)
+     * @param folder_id 文件夹ID
+     */
+    void removeFolder(int folder_id);
+
+    /**
+     * @brief 文件夹是否在缓存中
+     */
+    bool containsFolder(int folder_id) const { return m_folderRows.contains(folder_id); }
+
+    /**
+     * @brief 获取文件夹信息，调用前应先用containsFolder判断
+     * @param folder_id 文件夹ID
+     * @return FolderInfo 文件夹信息
+     */
+    FolderInfo folder(int folder_id) const;
+
+    /**
+     * @brief 获取全部文件夹，按创建时间排序
+     * @return QList<FolderInfo> 文件夹列表
+     */
+    QList<FolderInfo> allFolders() const;
+
+    /**
+     * @brief 获取直接子文件夹，按创建时间排序
+     * @param parent_id 父文件夹ID
+     * @return QList<FolderInfo> 子文件夹列表
+     */
+    QList<FolderInfo> childFolders(int parent_id) const;
+
+    /**
+     * @brief 获取以指定文件夹为根的子树中所有文件夹ID(含根)
+     * @param folder_id 根文件夹ID
+     * @return QList<int> 文件夹ID列表，根在最前
+     */
+    QList<int> subtreeFolderIds(int folder_id) const;
+
+    /**
+     * @brief 插入或更新笔记头信息，所属文件夹变化时同步更新索引
+     * @param note 笔记信息
+     */
+    void upsertNote(const NoteInfo &note);
+
+    /**
+     * @brief 移除笔记
+     * @param note_id 笔记ID
+     */
+    void removeNote(int note_id);
+
+    /**
+     * @brief 笔记是否在缓存中
+     */
+    bool containsNote(int note_id) const { return m_noteRows.contains(note_id); }
+
+    /**
+     * @brief 获取笔记头信息，调用前应先用containsNote判断
+     * @param note_id 笔记ID
+     * @return NoteInfo 笔记信息
+     */
+    NoteInfo note(int note_id) const;
+
+    /**
+     * @brief 获取文件夹下未删除的笔记，按修改时间倒序
+     * @param folder_id 文件夹ID
+     * @return QList<NoteInfo> 笔记列表
+     */
+    QList<NoteInfo> notesInFolder(int folder_id) const;
+
+    /**
+     * @brief 获取文件夹下所有笔记ID(含回收站中的)
+     * @param folder_id 文件夹ID
+     * @return QList<int> 笔记ID列表
+     */
+    QList<int> noteIdsInFolder(int folder_id) const { return m_folderNoteIds.values(folder_id); }
+
+    int folderCount() const { return m_folderIds.size(); }
+    int noteCount() const { return m_noteIds.size(); }
+
+private:
+    bool m_loaded = false;
+
+    // 文件夹列
+    QVector<int> m_folderIds;
+    QVector<int> m_folderParentIds;
+    QVector<QString> m_folderNames;
+    QVector<QString> m_folderPaths;
+    QVector<QString> m_folderCreatedAt;
+    QHash<int, int> m_folderRows; // 文件夹ID -> 行号
+    QMultiHash<int, int> m_childFolderIds; // 父文件夹ID -> 子文件夹ID
+
+    // 笔记列
+    QVector<int> m_noteIds;
+    QVector<int> m_noteFolderIds;
+    QVector<QString> m_noteTitles;
+    QVector<QString> m_noteCreatedAt;
+    QVector<QString> m_noteUpdatedAt;
+    QVector<QString> m_noteTags;
+    QVector<bool> m_noteTrashed;
+    QHash<int, int> m_noteRows; // 笔记ID -> 行号
+    QMultiHash<int, int> m_folderNoteIds; // 文件夹ID -> 笔记ID
+
+    FolderInfo folderAt(int row) const;
+    NoteInfo noteAt(int row) const;
+};
+
+#endif // FOLDERTREECACHE_H
@@ -0,0 +1,142 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-28 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-28 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\imagerenditioncache.cpp
+ * @Description: 笔记图片的显示尺寸副本缓存实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "imagerenditioncache.h"
+#include "mediastore.h"
+#include "settingsdialog.h"
+
+#include <QImageReader>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QUrl>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDebug>
+#include <climits>
+
+QString ImageRenditionCache::resolveImagePath(const QString &name)
+{
+    if (name.isEmpty() || name.startsWith("data:")) {
+        return QString();
+    }
+
+    if (name.startsWith("file:")) {
+        return QUrl(name).toLocalFile();
+    }
+
+    // 数据库中的相对路径相对于笔记本目录
+    if (name.startsWith("notes_media/")) {
+        return SettingsDialog::getNotebookPath() + "/" + name;
+    }
+
+    return QFileInfo(name).isAbsolute() ? name : QString();
+}
+
+QSize ImageRenditionCache::originalSize(const QString &originalPath)
+{
+    QImageReader reader(originalPath);
+    return reader.size();
+}
+
+QString ImageRenditionCache::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/media_renditions";
+}
+
+QString ImageRenditionCache::renditionPath(const QString &originalPath, int maxWidth)
+{
+    // 按内容寻址的文件直接用内容哈希；旧文件用路径、大小和修改时间区分，原图被替换后自动失效
+    QString key = MediaStore::hashFromPath(originalPath);
+    if (key.isEmpty()) {
+        QFileInfo info(originalPath);
+        QByteArray identity = info.absoluteFilePath().toUtf8() + '|'
+                            + QByteArray::number(info.size()) + '|'
+                            + QByteArray::number(info.lastModified().toMSecsSinceEpoch());
+        key = QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex());
+    }
+
+    // 照片用JPEG，其他格式(可能带透明通道)用PNG
+    QString suffix = QFileInfo(originalPath).suffix().toLower();
+    QString format = (suffix == "jpg" || suffix == "jpeg") ? "jpg" : "png";
+
+    return QString("%1/%2/%3_%4.%5").arg(cacheDirectory(), key.left(2), key).arg(maxWidth).arg(format);
+}
+
+QImage ImageRenditionCache::decodeScaled(const QString &originalPath, int maxWidth, bool *scaled)
+{
+    *scaled = false;
+
+    QImageReader reader(originalPath);
+    QSize size = reader.size();
+    if (size.isValid() && size.width() > maxWidth) {
+        // 由解码器直接输出缩小后的图像，JPEG等格式无需先解码全尺寸
+        reader.setScaledSize(size.scaled(maxWidth, INT_MAX, Qt::KeepAspectRatio));
+        *scaled = true;
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "无法解码图片:" << originalPath << reader.errorString();
+        *scaled = false;
+    }
+    return image;
+}
+
+bool ImageRenditionCache::writeRendition(const QImage &image, const QString &path)
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qWarning() << "无法创建图片缓存目录:" << QFileInfo(path).absolutePath();
+        return false;
+    }
+
+    // QSaveFile先写临时文件再替换，多个线程同时生成同一副本时也不会读到半个文件
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    const char *format = path.endsWith(".jpg") ? "JPG" : "PNG";
+    if (!image.save(&file, format, path.endsWith(".jpg") ? 90 : -1)) {
+        file.cancelWriting();
+        qWarning() << "写入图片副本失败:" << path;
+        return false;
+    }
+    return file.commit();
+}
+
+QImage ImageRenditionCache::load(const QString &originalPath, int maxWidth)
+{
+    QString path = renditionPath(originalPath, maxWidth);
+    if (QFileInfo::exists(path)) {
+        QImage cached(path);
+        if (!cached.isNull()) {
+            return cached;
+        }
+    }
+
+    bool scaled = false;
+    QImage image = decodeScaled(originalPath, maxWidth, &scaled);
+
+    // 原图本身足够小时不生成副本
+    if (scaled) {
+        writeRendition(image, path);
+    }
+    return image;
+}
+
+void ImageRenditionCache::generate(const QString &originalPath)
+{
+    bool scaled = false;
+    QImage display = decodeScaled(originalPath, DISPLAY_WIDTH, &scaled);
+    if (!display.isNull() && scaled) {
+        writeRendition(display, renditionPath(originalPath, DISPLAY_WIDTH));
+    }
+}
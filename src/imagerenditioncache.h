@@ -0,0 +1,72 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-28 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-28 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\imagerenditioncache.h
+ * @Description: 笔记图片的显示尺寸副本缓存
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef IMAGERENDITIONCACHE_H
+#define IMAGERENDITIONCACHE_H
+
+#include <QString>
+#include <QImage>
+#include <QSize>
+
+/**
+ * @brief 为笔记图片生成并缓存缩小后的副本
+ *
+ * 编辑器显示图片时使用显示尺寸副本，不再解码原图；原图只在复制、另存为等操作中按需读取。
+ * 副本可随时由原图重新生成，因此保存在系统缓存目录而不是笔记本目录，不参与备份。
+ * 所有函数只使用QImage/QImageReader，可在工作线程中调用。
+ */
+class ImageRenditionCache
+{
+public:
+    static constexpr int DISPLAY_WIDTH = 1200;   // 显示副本最大宽度(默认插入宽度600的两倍，适配高分屏)
+
+    /**
+     * @brief 将编辑器中的图片名(绝对路径、file:// URL或notes_media/相对路径)转换为本地绝对路径
+     * @param name 图片名
+     * @return QString 本地文件路径，无法识别时返回空字符串
+     */
+    static QString resolveImagePath(const QString &name);
+
+    /**
+     * @brief 只读取图片文件头获取原始尺寸，不解码像素
+     * @param originalPath 原图路径
+     * @return QSize 原始尺寸，无法读取时无效
+     */
+    static QSize originalSize(const QString &originalPath);
+
+    /**
+     * @brief 获取不超过指定宽度的图片副本，缓存中没有时从原图生成
+     * @param originalPath 原图路径
+     * @param maxWidth 最大宽度
+     * @return QImage 图片副本，原图本身不超过该宽度时直接返回原图
+     */
+    static QImage load(const QString &originalPath, int maxWidth);
+
+    /**
+     * @brief 导入图片时预先生成显示副本
+     * @param originalPath 原图路径
+     */
+    static void generate(const QString &originalPath);
+
+    /**
+     * @brief 副本在缓存目录中的路径
+     * @param originalPath 原图路径
+     * @param maxWidth 最大宽度
+     * @return QString 副本路径
+     */
+    static QString renditionPath(const QString &originalPath, int maxWidth);
+
+private:
+    static QString cacheDirectory();
+    static QImage decodeScaled(const QString &originalPath, int maxWidth, bool *scaled);
+    static bool writeRendition(const QImage &image, const QString &path);
+};
+
+#endif // IMAGERENDITIONCACHE_H
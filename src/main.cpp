@@ -1,6 +1,8 @@
 #include "mainwindow.h"
 #include "DeepSeekService.h"
 #include "settingsdialog.h"
+#include "databasemanager.h"
+#include "streamingbenchmark.h"
 
 #include <QApplication>
 #include <QFile>
@@ -10,6 +12,8 @@
 #include <QSettings>
 #include <QLocale>
 #include <QDir>
+#include <QTextStream>
+#include <QLockFile>
 
 // 加载并应用样式表的辅助函数
 QString loadStyleSheet(const QString &sheetName)
@@ -71,6 +75,36 @@ void loadTranslation(QApplication &app)
     }
 }
 
+// 统计笔记库中内容块的压缩率和每篇笔记的解压耗时，以只读连接打开，不修改数据库
+int runCompressionBenchmark()
+{
+    QTextStream out(stdout);
+    DatabaseManager dbManager("compression_benchmark_connection");
+    dbManager.setReadOnly(true);
+    dbManager.setTreeCacheEnabled(false);
+    if (!dbManager.initialize()) {
+        out << "无法打开数据库" << Qt::endl;
+        return 1;
+    }
+    
+    CompressionBenchmarkResult result = dbManager.benchmarkCompression();
+    if (result.notes == 0) {
+        out << "数据库中没有内容块" << Qt::endl;
+        return 1;
+    }
+    
+    double ratio = result.rawBytes > 0 ? double(result.storedBytes) / result.rawBytes : 1.0;
+    out << "笔记数: " << result.notes << Qt::endl;
+    out << "内容块数: " << result.blocks << "，压缩的块: " << result.compressedBlocks
+        << "，解压失败的块: " << result.failedBlocks << Qt::endl;
+    out << "保存字节数: " << result.storedBytes << "，解压后字节数: " << result.rawBytes
+        << "，压缩率: " << QString::number(ratio * 100, 'f', 1) << "%" << Qt::endl;
+    out << "每篇笔记解压耗时(ms) - 平均: " << QString::number(result.averageDecodeMs, 'f', 3)
+        << "，最长: " << QString::number(result.maxDecodeMs, 'f', 3)
+        << "(笔记ID " << result.slowestNoteId << ")" << Qt::endl;
+    return result.failedBlocks > 0 ? 2 : 0;
+}
+
 int main(int argc, char *argv[])
 {
   // 实现应用程序重启机制
@@ -81,15 +115,33 @@ int main(int argc, char *argv[])
     // 设置组织名和应用名，用于QSettings和QStandardPaths
     QApplication::setOrganizationName("IntelliMedia");
     QApplication::setApplicationName("IntelliMedia_Notes");
+    
+    // 压缩统计模式：输出结果后直接退出，不显示界面
+    if (QApplication::arguments().contains("--bench-compression")) {
+        return runCompressionBenchmark();
+    }
+    
+    // 流式回复统计模式：用本地回放服务器比较流式和非流式的首个片段耗时
+    if (QApplication::arguments().contains("--bench-streaming")) {
+        return StreamingBenchmark::run();
+    }
         
-        // 检查并执行待处理的笔记库位置移动
-        if (SettingsDialog::executePendingNotebookMove()) {
-            qDebug() << "成功执行笔记库位置移动";
-        }
-        
-        // 检查并执行待处理的备份恢复操作
-        if (SettingsDialog::executePendingRestore()) {
-            qDebug() << "成功执行备份恢复操作";
+        // 实例锁在进程退出、数据库连接全部关闭后才释放。重启时等待上一个实例退出，
+        // 确认没有其他实例占用数据库后才移动或替换数据库文件，否则留到下次启动
+        QLockFile instanceLock(QDir::temp().absoluteFilePath("IntelliMedia_Notes.lock"));
+        const int lockTimeoutMs = QApplication::arguments().contains("--restarted") ? 30000 : 0;
+        if (instanceLock.tryLock(lockTimeoutMs)) {
+            // 检查并执行待处理的笔记库位置移动
+            if (SettingsDialog::executePendingNotebookMove()) {
+                qDebug() << "成功执行笔记库位置移动";
+            }
+            
+            // 检查并执行待处理的备份恢复操作
+            if (SettingsDialog::executePendingRestore()) {
+                qDebug() << "成功执行备份恢复操作";
+            }
+        } else {
+            qWarning() << "另一个实例仍在使用笔记库，待处理的移动和恢复操作推迟到下次启动";
         }
     
     // 加载翻译文件
@@ -127,6 +179,13 @@ int main(int argc, char *argv[])
         aiService->setApiKey(deobfuscatedKey);
     }
     
+    // 默认以流式方式接收回复，生成过程中即可看到内容
+    aiService->setStreamingEnabled(settings.value("AIService/StreamResponses", true).toBool());
+    
+    // 同时发出的请求数上限，超出的请求排队等待
+    aiService->setMaxConcurrentRequests(settings.value("AIService/MaxConcurrentRequests",
+                                                       AiRequestScheduler::DEFAULT_MAX_IN_FLIGHT).toInt());
+    
     MainWindow w;
     
     // 将AI服务传递给主窗口
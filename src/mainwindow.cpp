@@ -17,6 +17,7 @@
 #include "IAiService.h" // 包含AI服务接口头文件
 #include "DeepSeekService.h" // 包含DeepSeek服务头文件
 #include "settingsdialog.h" // 包含设置对话框头文件
+#include "aibatchprocessor.h" // 包含AI批量处理器头文件
 
 #include <QToolButton>
 #include <QIcon>
@@ -47,6 +48,7 @@
 #include <QSystemTrayIcon> // 添加系统托盘图标
 #include <QMenu> // 添加菜单
 #include <QResizeEvent> // 添加大小改变事件头文件
+#include <QProgressBar> // AI批量任务进度条
 
 // 定义窗口大小调整敏感区域的大小（像素）
 #define RESIZE_BORDER_SIZE 8 // 调整区域大小
@@ -190,6 +192,24 @@ MainWindow::MainWindow(QWidget *parent)
     settingsButton->setStyleSheet("QToolButton { border: none; background-color: transparent; } QToolButton:hover { background-color: #555; border-radius: 4px; }");
     connect(settingsButton, &QToolButton::clicked, this, &MainWindow::openSettings);
     
+    // --- 4c. AI批量任务进度，只在任务运行时显示 ---
+    m_aiBatchProgressBar = new QProgressBar(this);
+    m_aiBatchProgressBar->setFixedSize(160, 16);
+    m_aiBatchProgressBar->setTextVisible(true);
+    m_aiBatchProgressBar->hide();
+    
+    m_aiBatchCancelButton = new QToolButton(this);
+    m_aiBatchCancelButton->setIcon(QIcon("://icons/round_close_fill.svg"));
+    m_aiBatchCancelButton->setFixedSize(20, 20);
+    m_aiBatchCancelButton->setToolTip(tr("取消AI批量任务"));
+    m_aiBatchCancelButton->setStyleSheet("QToolButton { border: none; background-color: transparent; } QToolButton:hover { background-color: #555; border-radius: 4px; }");
+    m_aiBatchCancelButton->hide();
+    connect(m_aiBatchCancelButton, &QToolButton::clicked, this, [this]() {
+        if (m_aiBatchProcessor) {
+            m_aiBatchProcessor->cancel();
+        }
+    });
+    
     // --- 5. 使用Designer中创建的widget作为按钮容器 ---
     // 获取Designer中添加的widget控件
     QWidget* buttonWidget = ui->widget;  // 确保widget是您在Designer中添加的控件名称
@@ -205,6 +225,11 @@ MainWindow::MainWindow(QWidget *parent)
     // 添加拉伸项，使右侧按钮靠右
     buttonLayout->addStretch(1);
     
+    // AI批量任务进度放在主题按钮左侧
+    buttonLayout->addWidget(m_aiBatchProgressBar);
+    buttonLayout->addWidget(m_aiBatchCancelButton);
+    buttonLayout->addSpacing(6);
+    
     // 在右侧添加主题和设置按钮 (在窗口控制按钮之前)
     buttonLayout->addWidget(themeToggleButton);
     buttonLayout->addWidget(settingsButton);
@@ -253,6 +278,15 @@ MainWindow::~MainWindow()
         }
     }
     
+    // 等待后台写入线程写完所有快照，再释放数据库连接
+    if (m_textEditorManager) {
+        m_textEditorManager->flushAutosave();
+    }
+    
+    // 批量处理器使用侧边栏管理器的数据库管理器，需先释放；未完成的任务留在检查点中
+    delete m_aiBatchProcessor;
+    m_aiBatchProcessor = nullptr;
+    
     delete ui;
     delete m_sidebarManager; // 释放侧边栏管理器
     delete m_searchManager;
@@ -488,6 +522,12 @@ void MainWindow::applySettings()
             QMetaObject::invokeMethod(m_aiService, "setApiEndpoint", Q_ARG(QString, apiEndpoint));
             qDebug() << "应用新设置：已更新AI服务API端点 -" << apiEndpoint;
         }
+        
+        // 读取流式回复设置
+        m_aiService->setStreamingEnabled(settings.value("AIService/StreamResponses", true).toBool());
+        
+        // 读取回复缓存设置
+        m_aiService->setResponseCacheEnabled(settings.value("AIService/CacheEnabled", true).toBool());
     } else {
         qWarning() << "应用新设置：AI服务实例为空，无法更新API设置";
     }
@@ -829,9 +869,9 @@ void MainWindow::handleContentModified()
         m_textEditorManager->markContentModified();
     }
     
-    // 如果启用了自动保存且是即时保存模式(间隔为0)
-    if (autoSaveEnabled && autoSaveInterval == 0 && !m_currentNotePath.isEmpty()) {
-        saveCurrentNote();
+    // 如果启用了自动保存且是即时保存模式(间隔为0)，防抖后由后台线程写入，不阻塞界面
+    if (autoSaveEnabled && autoSaveInterval == 0 && !m_currentNotePath.isEmpty() && m_textEditorManager) {
+        m_textEditorManager->scheduleAutosave();
     }
 }
 
@@ -848,6 +888,16 @@ void MainWindow::setupTextEditor()
     connect(m_textEditorManager, &TextEditorManager::requestShowAiAssistant, 
             this, &MainWindow::showAiAssistantWithText);
 
+    // 侧边栏展开文件夹或显示搜索结果时，在后台预读可能打开的笔记
+    if (m_sidebarManager) {
+        connect(m_sidebarManager, &SidebarManager::prefetchRequested,
+                m_textEditorManager, &TextEditorManager::prefetchNotes);
+    }
+    if (m_searchManager) {
+        connect(m_searchManager, &SearchManager::prefetchRequested,
+                m_textEditorManager, &TextEditorManager::prefetchNotes);
+    }
+
     // 设置数据库管理器引用
     if (m_sidebarManager && m_sidebarManager->getDatabaseManager()) {
         m_textEditorManager->setDatabaseManager(m_sidebarManager->getDatabaseManager());
@@ -912,6 +962,145 @@ void MainWindow::setupAiAssistant()
          qDebug() << "AiAssistantDialog (" << m_aiAssistantDialog << ") already exists, ensuring service is set.";
          m_aiAssistantDialog->setAiService(m_aiService);
     }
+    
+    setupAiBatchProcessor();
+}
+
+// 初始化AI批量处理器
+void MainWindow::setupAiBatchProcessor()
+{
+    if (m_aiBatchProcessor) {
+        m_aiBatchProcessor->setAiService(m_aiService);
+        return;
+    }
+    
+    if (!m_sidebarManager || !m_sidebarManager->getDatabaseManager()) {
+        qWarning() << "警告: 无法从侧边栏管理器获取数据库管理器，AI批量处理不可用";
+        return;
+    }
+    
+    m_aiBatchProcessor = new AiBatchProcessor(m_sidebarManager->getDatabaseManager(), this);
+    m_aiBatchProcessor->setAiService(m_aiService);
+    
+    connect(m_aiBatchProcessor, &AiBatchProcessor::jobStarted, this, &MainWindow::onAiBatchStarted);
+    connect(m_aiBatchProcessor, &AiBatchProcessor::progressChanged, this, &MainWindow::onAiBatchProgress);
+    connect(m_aiBatchProcessor, &AiBatchProcessor::jobFinished, this, &MainWindow::onAiBatchFinished);
+    connect(m_aiBatchProcessor, &AiBatchProcessor::jobFailed, this, &MainWindow::onAiBatchFailed);
+    
+    // 侧边栏文件夹右键菜单和搜索结果都可以发起批量任务
+    connect(m_sidebarManager, &SidebarManager::aiBatchRequested, this, &MainWindow::startAiBatch);
+    if (m_searchManager) {
+        connect(m_searchManager, &SearchManager::aiBatchRequested, this, &MainWindow::startAiBatch);
+    }
+    
+    // 启动完成后再继续上次中断的任务，避免与启动时的加载争抢
+    QTimer::singleShot(3000, this, [this]() {
+        if (m_aiBatchProcessor) {
+            m_aiBatchProcessor->resumePendingJob();
+        }
+    });
+}
+
+// 确认后开始AI批量任务
+void MainWindow::startAiBatch(const QString &operation, const QList<int> &noteIds, const QString &sourceName)
+{
+    if (!m_aiBatchProcessor) {
+        qWarning() << "错误: AI批量处理器尚未初始化";
+        return;
+    }
+    
+    AiBatchProcessor::Operation batchOperation;
+    if (!AiBatchProcessor::operationFromName(operation, &batchOperation)) {
+        qWarning() << "未知的AI批量处理操作:" << operation;
+        return;
+    }
+    
+    if (noteIds.isEmpty()) {
+        QMessageBox::information(this, tr("AI批量处理"), tr("“%1”中没有可处理的笔记。").arg(sourceName));
+        return;
+    }
+    
+    if (m_aiBatchProcessor->isRunning()) {
+        QMessageBox::warning(this, tr("AI批量处理"), tr("已有AI批量任务正在运行，请等待完成或取消后再试。"));
+        return;
+    }
+    
+    QString description = AiBatchProcessor::operationDescription(batchOperation);
+    QString detail = batchOperation == AiBatchProcessor::TagOperation
+        ? tr("生成的标签将合并到笔记已有的标签中。")
+        : tr("结果将单独保存，不会修改笔记正文。");
+    QMessageBox::StandardButton reply = QMessageBox::question(this, tr("AI批量处理"),
+        tr("将对“%1”中的 %2 篇笔记执行%3。\n%4\n\n任务在后台运行，退出程序后下次启动时会继续。是否开始？")
+            .arg(sourceName).arg(noteIds.size()).arg(description, detail),
+        QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes) {
+        return;
+    }
+    
+    if (!m_aiBatchProcessor->start(batchOperation, noteIds, sourceName)) {
+        QMessageBox::warning(this, tr("AI批量处理"), tr("无法开始AI批量任务，请检查AI服务设置。"));
+    }
+}
+
+// AI批量任务开始或继续
+void MainWindow::onAiBatchStarted(const QString &description, const QString &sourceName, int processed, int total)
+{
+    m_aiBatchProgressBar->setRange(0, total);
+    m_aiBatchProgressBar->setValue(processed);
+    m_aiBatchProgressBar->setFormat(tr("批量%1 %v/%m").arg(description));
+    m_aiBatchProgressBar->setToolTip(tr("AI批量%1：%2").arg(description, sourceName));
+    m_aiBatchProgressBar->show();
+    m_aiBatchCancelButton->show();
+}
+
+// AI批量任务进度更新
+void MainWindow::onAiBatchProgress(int processed, int total)
+{
+    m_aiBatchProgressBar->setRange(0, total);
+    m_aiBatchProgressBar->setValue(processed);
+}
+
+// AI批量任务结束
+void MainWindow::onAiBatchFinished(const QString &description, int succeeded, int failed, int skipped, bool cancelled)
+{
+    m_aiBatchProgressBar->hide();
+    m_aiBatchCancelButton->hide();
+    
+    QString message = cancelled
+        ? tr("AI批量%1已取消，已处理 %2 篇笔记").arg(description).arg(succeeded + failed + skipped)
+        : tr("AI批量%1完成：成功 %2 篇，失败 %3 篇").arg(description).arg(succeeded).arg(failed);
+    if (!cancelled && skipped > 0) {
+        message += tr("，跳过已删除或空白的笔记 %1 篇").arg(skipped);
+    }
+    // 总结和纠错结果不写入正文，提示在哪里查看
+    if (succeeded > 0 && description != AiBatchProcessor::operationDescription(AiBatchProcessor::TagOperation)) {
+        message += tr("，打开笔记后可在编辑器工具栏的“AI结果”中查看");
+    }
+    qDebug() << message;
+    
+    if (m_trayIcon && m_trayIcon->isVisible()) {
+        m_trayIcon->showMessage(tr("IntelliMedia Notes"), message, QIcon(":/icons/app_tray_icon.svg"), 3000);
+    }
+}
+
+// AI批量任务因错误暂停
+void MainWindow::onAiBatchFailed(const QString &description, const QString &errorMessage)
+{
+    m_aiBatchProgressBar->hide();
+    m_aiBatchCancelButton->hide();
+    
+    QMessageBox msgBox(this);
+    msgBox.setIcon(QMessageBox::Warning);
+    msgBox.setWindowTitle(tr("AI批量处理"));
+    msgBox.setText(tr("AI批量%1已暂停：%2").arg(description, errorMessage));
+    msgBox.setInformativeText(tr("未处理的笔记将在下次启动时继续。"));
+    QPushButton *discardButton = msgBox.addButton(tr("放弃剩余笔记"), QMessageBox::DestructiveRole);
+    msgBox.addButton(tr("稍后继续"), QMessageBox::AcceptRole);
+    msgBox.exec();
+    
+    if (msgBox.clickedButton() == discardButton && m_aiBatchProcessor) {
+        m_aiBatchProcessor->discardPendingJob();
+    }
 }
 
 // 显示AI助手对话框 (无参版本，由快捷键等直接调用)
@@ -1053,6 +1242,10 @@ void MainWindow::showSettingsDialog()
         connect(m_settingsDialog, &SettingsDialog::languageChanged, this, &MainWindow::applyLanguage);
         // 连接自动保存间隔改变信号到应用自动保存间隔槽
         connect(m_settingsDialog, &SettingsDialog::autoSaveIntervalChanged, this, &MainWindow::applyAutoSaveInterval);
+        // 连接笔记导入完成信号
+        connect(m_settingsDialog, &SettingsDialog::notesImported, this, &MainWindow::onNotesImported);
+        // 恢复备份或迁移笔记本重启前，先释放后台线程占用的数据库文件
+        connect(m_settingsDialog, &SettingsDialog::databaseReleaseRequested, this, &MainWindow::releaseDatabase);
         // 连接对话框关闭信号
         connect(m_settingsDialog, &QDialog::finished, this, &MainWindow::onSettingsClosed);
         
@@ -1090,6 +1283,43 @@ void MainWindow::showSettingsDialog()
     // 不再在这里调用applyThemeFromSettings，因为主题已经通过信号直接应用
 }
 
+// 笔记导入完成
+void MainWindow::onNotesImported()
+{
+    DatabaseManager *dbManager = m_sidebarManager ? m_sidebarManager->getDatabaseManager() : nullptr;
+    if (!dbManager) {
+        return;
+    }
+    
+    // 导入器使用独立连接直接写入ContentBlocks，补写纯文本和全文索引后才能按正文搜索
+    dbManager->backfillNoteTexts();
+    
+    // 导入的笔记没有经过DatabaseManager，层级缓存和文件树都不知道它们，需整体重新加载
+    if (dbManager->isTreeCacheLoaded()) {
+        dbManager->reloadTreeCache();
+    }
+    if (m_sidebarManager->getTreeModel()) {
+        m_sidebarManager->getTreeModel()->reload();
+    }
+}
+
+// 释放数据库文件
+void MainWindow::releaseDatabase()
+{
+    // 排队中的保存先写完，再在各自线程中关闭写入、加载和搜索连接，
+    // 新进程替换文件时不会有旧进程的写入落到恢复后的数据库里
+    saveCurrentNote();
+    if (m_textEditorManager) {
+        m_textEditorManager->releaseDatabase();
+    }
+    if (m_searchManager) {
+        m_searchManager->releaseDatabase();
+    }
+    if (m_aiService) {
+        m_aiService->closeResponseCache();
+    }
+}
+
 // 应用语言设置
 void MainWindow::applyLanguage(const QString &language)
 {
@@ -1126,8 +1356,8 @@ void MainWindow::restartApplication()
 {
     qDebug() << "正在重启应用程序...";
     
-    // 保存所有未保存的数据
-    saveCurrentNote();
+    // 保存所有未保存的数据，等待后台写入完成并释放数据库文件后再启动新进程
+    releaseDatabase();
     
     // 保存当前状态（如打开的文件路径）
     QSettings settings(QSettings::IniFormat, QSettings::UserScope, QApplication::organizationName(), QApplication::applicationName());
@@ -48,6 +48,8 @@ class TextEditorManager; // 添加文本编辑器管理器前向声明
 class AiAssistantDialog; // 添加AI助手对话框前向声明
 class IAiService; // 添加AI服务接口前向声明
 class SettingsDialog; // 添加设置对话框前向声明
+class AiBatchProcessor; // AI批量处理器前向声明
+class QProgressBar;
 
 class MainWindow : public QMainWindow
 {
@@ -103,6 +105,13 @@ private slots:
     void handleContentModified(); // 处理编辑器内容修改
     void insertAiContent(const QString &content); // 插入AI生成的内容
     
+    // AI批量处理相关槽函数
+    void startAiBatch(const QString &operation, const QList<int> &noteIds, const QString &sourceName); // 确认后开始批量任务
+    void onAiBatchStarted(const QString &description, const QString &sourceName, int processed, int total);
+    void onAiBatchProgress(int processed, int total);
+    void onAiBatchFinished(const QString &description, int succeeded, int failed, int skipped, bool cancelled);
+    void onAiBatchFailed(const QString &description, const QString &errorMessage);
+    
     // 设置相关槽函数
     void onSettingsClosed();     // 处理设置对话框关闭事件
     void applySettings();        // 应用设置
@@ -112,6 +121,8 @@ private slots:
     void applyAutoSaveInterval(int interval); // 应用自动保存间隔设置
     void restartApplication(); // 重启应用程序
     void restoreLastSession(); // 恢复上次会话状态
+    void onNotesImported();    // 笔记导入完成后刷新派生数据
+    void releaseDatabase();    // 写完待保存的内容并关闭后台线程的数据库连接（替换数据库文件前调用）
     
     // 系统托盘相关槽函数
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason); // 处理托盘图标激活
@@ -129,6 +140,8 @@ private:
     QToolButton *closeButton;
     QToolButton *themeToggleButton;   // 主题切换按钮
     QToolButton *settingsButton;      // 设置按钮
+    QProgressBar *m_aiBatchProgressBar; // AI批量任务进度，空闲时隐藏
+    QToolButton *m_aiBatchCancelButton; // 取消AI批量任务按钮
     
     // 用于窗口拖动
     bool m_isResizing = false;
@@ -173,6 +186,7 @@ private:
     // AI相关
     AiAssistantDialog *m_aiAssistantDialog = nullptr; // AI助手对话框
     IAiService *m_aiService = nullptr;  // AI服务接口
+    AiBatchProcessor *m_aiBatchProcessor = nullptr; // AI批量处理器
     
     // 设置相关
     SettingsDialog *m_settingsDialog = nullptr; // 设置对话框
@@ -198,6 +212,9 @@ private:
     // 初始化AI助手
     void setupAiAssistant();
     
+    // 初始化AI批量处理器，并继续上次未完成的任务
+    void setupAiBatchProcessor();
+    
     // 初始化设置
     void setupSettings();
     
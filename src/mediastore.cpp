@@ -0,0 +1,113 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-27 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-27 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\mediastore.cpp
+ * @Description: 按内容寻址的媒体文件存储实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "mediastore.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QDebug>
+
+QString MediaStore::hashFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "无法读取媒体文件:" << filePath << file.errorString();
+        return QString();
+    }
+
+    // addData(QIODevice*)分块读取，不会把整个文件读入内存
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        qWarning() << "计算媒体文件哈希失败:" << filePath;
+        return QString();
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString MediaStore::relativePathFor(const QString &hash, const QString &suffix)
+{
+    QString fileName = suffix.isEmpty() ? hash : hash + "." + suffix.toLower();
+    return hash.left(2) + "/" + fileName;
+}
+
+QString MediaStore::store(const QString &mediaRoot, const QString &sourcePath, QString *hash)
+{
+    QFileInfo sourceInfo(sourcePath);
+    if (!sourceInfo.exists() || !sourceInfo.isFile()) {
+        qWarning() << "源媒体文件不存在:" << sourcePath;
+        return QString();
+    }
+
+    QString contentHash = hashFile(sourcePath);
+    if (contentHash.isEmpty()) {
+        return QString();
+    }
+    if (hash) {
+        *hash = contentHash;
+    }
+
+    QString relativePath = relativePathFor(contentHash, sourceInfo.suffix());
+    QString destPath = mediaRoot + "/" + relativePath;
+
+    // 相同内容已存在，直接复用
+    if (QFileInfo::exists(destPath)) {
+        return relativePath;
+    }
+
+    // 先复制到临时文件再改名，避免中断后留下不完整的文件
+    QString tempPath = destPath + ".tmp";
+    QFile::remove(tempPath);
+    if (!copyFile(sourcePath, tempPath)) {
+        qCritical() << "复制媒体文件失败:" << sourcePath << "->" << tempPath;
+        return QString();
+    }
+    if (!QFile::rename(tempPath, destPath)) {
+        QFile::remove(tempPath);
+        // 可能已被其他线程写入同一内容
+        if (!QFileInfo::exists(destPath)) {
+            qCritical() << "保存媒体文件失败:" << destPath;
+            return QString();
+        }
+    }
+
+    return relativePath;
+}
+
+QString MediaStore::hashFromPath(const QString &path)
+{
+    static const QRegularExpression pattern("(?:^|[/\\\\])([0-9a-f]{2})[/\\\\](\\1[0-9a-f]{62})(?:\\.\\w+)?$");
+    QRegularExpressionMatch match = pattern.match(path);
+    return match.hasMatch() ? match.captured(2) : QString();
+}
+
+QStringList MediaStore::listFiles(const QString &mediaRoot)
+{
+    QStringList files;
+    QDir root(mediaRoot);
+    QDirIterator it(mediaRoot, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        files.append(root.relativeFilePath(it.next()));
+    }
+    return files;
+}
+
+bool MediaStore::copyFile(const QString &sourcePath, const QString &destPath)
+{
+    QString destDir = QFileInfo(destPath).absolutePath();
+    if (!QDir().mkpath(destDir)) {
+        qWarning() << "无法创建目录:" << destDir;
+        return false;
+    }
+    return QFile::copy(sourcePath, destPath);
+}
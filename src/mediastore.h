@@ -0,0 +1,73 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-27 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-27 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\mediastore.h
+ * @Description: 按内容寻址的媒体文件存储
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef MEDIASTORE_H
+#define MEDIASTORE_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 按内容哈希存放媒体文件，相同内容的图片只保存一份
+ *
+ * 文件路径为 notes_media/<哈希前两位>/<SHA-256>.<扩展名>，按前两位分目录避免单个目录文件过多。
+ * 引用计数由DatabaseManager的MediaFiles/NoteMedia表维护，这里只负责文件本身。
+ */
+class MediaStore
+{
+public:
+    /**
+     * @brief 计算文件内容的SHA-256
+     * @param filePath 文件路径
+     * @return QString 十六进制哈希，读取失败返回空字符串
+     */
+    static QString hashFile(const QString &filePath);
+
+    /**
+     * @brief 由哈希和扩展名得到相对媒体目录的路径
+     * @param hash 内容哈希
+     * @param suffix 扩展名(不含点)
+     * @return QString 如"ab/ab12...ef.png"
+     */
+    static QString relativePathFor(const QString &hash, const QString &suffix);
+
+    /**
+     * @brief 将文件存入媒体目录，内容已存在时直接复用已有文件
+     * @param mediaRoot 媒体目录(notes_media)的绝对路径
+     * @param sourcePath 源文件路径
+     * @param hash 输出参数，文件内容哈希，可为nullptr
+     * @return QString 相对媒体目录的路径，失败返回空字符串
+     */
+    static QString store(const QString &mediaRoot, const QString &sourcePath, QString *hash = nullptr);
+
+    /**
+     * @brief 从媒体文件路径(相对或绝对)中解析内容哈希
+     * @param path 文件路径
+     * @return QString 内容哈希，不是按内容寻址的文件时返回空字符串
+     */
+    static QString hashFromPath(const QString &path);
+
+    /**
+     * @brief 递归列出媒体目录中的所有文件
+     * @param mediaRoot 媒体目录的绝对路径
+     * @return QStringList 相对媒体目录的路径
+     */
+    static QStringList listFiles(const QString &mediaRoot);
+
+    /**
+     * @brief 复制文件，目标目录不存在时自动创建(用于备份和迁移分目录存放的媒体文件)
+     * @param sourcePath 源文件路径
+     * @param destPath 目标文件路径
+     * @return bool 是否复制成功
+     */
+    static bool copyFile(const QString &sourcePath, const QString &destPath);
+};
+
+#endif // MEDIASTORE_H
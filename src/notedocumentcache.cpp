@@ -0,0 +1,86 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-30 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-30 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notedocumentcache.cpp
+ * @Description: 最近打开笔记的文档缓存实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "notedocumentcache.h"
+
+#include <QDebug>
+
+NoteDocumentCache::NoteDocumentCache(qint64 budgetBytes)
+    : m_budgetBytes(budgetBytes)
+{
+}
+
+NoteDocumentCache::~NoteDocumentCache()
+{
+    clear();
+}
+
+void NoteDocumentCache::insert(int noteId, const Entry &entry)
+{
+    if (!entry.document) {
+        return;
+    }
+
+    remove(noteId);
+
+    Entry stored = entry;
+    stored.cost = estimateCost(entry.document);
+    m_entries.insert(noteId, stored);
+    m_order.prepend(noteId);
+    m_totalCost += stored.cost;
+
+    evict();
+}
+
+NoteDocumentCache::Entry NoteDocumentCache::take(int noteId)
+{
+    auto it = m_entries.find(noteId);
+    if (it == m_entries.end()) {
+        return Entry();
+    }
+
+    Entry entry = it.value();
+    m_entries.erase(it);
+    m_order.removeOne(noteId);
+    m_totalCost -= entry.cost;
+    return entry;
+}
+
+void NoteDocumentCache::remove(int noteId)
+{
+    Entry entry = take(noteId);
+    delete entry.document.data();
+}
+
+void NoteDocumentCache::clear()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        delete it.value().document.data();
+    }
+    m_entries.clear();
+    m_order.clear();
+    m_totalCost = 0;
+}
+
+qint64 NoteDocumentCache::estimateCost(const QTextDocument *document)
+{
+    // 文本按UTF-16计算，片段、格式和排版信息按经验约为文本的数倍，另加每个段落的固定开销；
+    // 图片在切换前已释放为单色占位图，不单独计算
+    return qint64(document->characterCount()) * 8 + qint64(document->blockCount()) * 512;
+}
+
+void NoteDocumentCache::evict()
+{
+    while (!m_order.isEmpty() && (m_totalCost > m_budgetBytes || m_order.size() > MAX_ENTRIES)) {
+        int noteId = m_order.last();
+        qDebug() << "释放缓存的笔记文档:" << noteId;
+        remove(noteId);
+    }
+}
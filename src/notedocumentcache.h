@@ -0,0 +1,90 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-30 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-30 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notedocumentcache.h
+ * @Description: 最近打开笔记的文档缓存
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef NOTEDOCUMENTCACHE_H
+#define NOTEDOCUMENTCACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QTextCursor>
+#include <QTextDocument>
+
+/**
+ * @brief 按最近使用顺序保存已解析的笔记文档
+ *
+ * 切换笔记时当前文档连同撤销记录、光标和滚动位置一起放入缓存，切换回来时直接换回编辑器，
+ * 不再读取数据库和解析内容。超过内存预算或数量上限时释放最久未使用的文档。
+ * 缓存拥有其中的文档；取出后所有权交还调用方。
+ */
+class NoteDocumentCache
+{
+public:
+    static constexpr qint64 DEFAULT_BUDGET_BYTES = 64 * 1024 * 1024; // 默认内存预算
+    static constexpr int MAX_ENTRIES = 16;                           // 最多缓存的笔记数
+
+    struct Entry {
+        QPointer<QTextDocument> document; // 文档，编辑器销毁时随之删除
+        QTextCursor cursor;               // 切换前的光标和选区
+        int scrollValue = 0;              // 切换前的垂直滚动位置
+        qint64 cost = 0;                  // 估算的内存占用
+    };
+
+    explicit NoteDocumentCache(qint64 budgetBytes = DEFAULT_BUDGET_BYTES);
+    ~NoteDocumentCache();
+
+    /**
+     * @brief 放入笔记文档，超出预算时释放最久未使用的文档(可能包括刚放入的文档)
+     * @param noteId 笔记ID
+     * @param entry 文档及其视图状态，缓存取得文档所有权
+     */
+    void insert(int noteId, const Entry &entry);
+
+    /**
+     * @brief 取出笔记文档，文档所有权交还调用方
+     * @param noteId 笔记ID
+     * @return Entry 缓存项，未缓存时document为空
+     */
+    Entry take(int noteId);
+
+    /**
+     * @brief 笔记文档是否在缓存中
+     * @param noteId 笔记ID
+     */
+    bool contains(int noteId) const { return m_entries.contains(noteId); }
+
+    /**
+     * @brief 删除并释放笔记文档，笔记被删除或在别处修改时调用
+     * @param noteId 笔记ID
+     */
+    void remove(int noteId);
+
+    /**
+     * @brief 释放全部文档
+     */
+    void clear();
+
+    /**
+     * @brief 估算文档的内存占用
+     * @param document 文档
+     * @return qint64 字节数
+     */
+    static qint64 estimateCost(const QTextDocument *document);
+
+private:
+    void evict();
+
+    QHash<int, Entry> m_entries;
+    QList<int> m_order; // 笔记ID，最近使用的在前
+    qint64 m_budgetBytes;
+    qint64 m_totalCost = 0;
+};
+
+#endif // NOTEDOCUMENTCACHE_H
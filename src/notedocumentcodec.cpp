@@ -0,0 +1,368 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-29 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-29 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notedocumentcodec.cpp
+ * @Description: 笔记文档的紧凑二进制格式实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "notedocumentcodec.h"
+
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextFrame>
+#include <QTextList>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <QMap>
+#include <QDebug>
+
+const QString NoteDocumentCodec::FORMATS_BLOCK_TYPE = "doc_formats";
+const QString NoteDocumentCodec::PARAGRAPH_BLOCK_TYPE = "doc_block";
+
+namespace {
+
+const quint32 FORMATS_MAGIC = 0x494D4446; // "IMDF"
+const quint16 CODEC_VERSION = 1;
+const QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_15; // 兼容Qt5和Qt6构建
+
+const quint8 PARAGRAPH_STARTS_LIST = 0x01; // 段落是所在列表的第一项
+
+// 编码时收集文档用到的格式，同一格式只序列化一次
+class FormatTable
+{
+public:
+    quint64 idFor(int formatIndex, const QTextFormat &format)
+    {
+        auto it = m_idByIndex.constFind(formatIndex);
+        if (it != m_idByIndex.constEnd()) {
+            return it.value();
+        }
+
+        QByteArray bytes;
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << format;
+
+        // 用格式内容的哈希作为ID，段落的序列化结果不受其他段落影响；0保留表示"无"
+        QByteArray digest = QCryptographicHash::hash(bytes, QCryptographicHash::Sha1);
+        quint64 id = qFromBigEndian<quint64>(reinterpret_cast<const uchar *>(digest.constData()));
+        if (id == 0) {
+            id = 1;
+        }
+
+        m_formats.insert(id, bytes);
+        m_idByIndex.insert(formatIndex, id);
+        return id;
+    }
+
+    QByteArray serialize() const
+    {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << FORMATS_MAGIC << CODEC_VERSION << quint32(m_formats.size());
+        for (auto it = m_formats.constBegin(); it != m_formats.constEnd(); ++it) {
+            out << it.key() << it.value();
+        }
+        return data;
+    }
+
+private:
+    QHash<int, quint64> m_idByIndex;   // 文档内格式索引 -> 格式ID
+    QMap<quint64, QByteArray> m_formats; // 按ID排序，格式表内容只取决于用到的格式集合
+};
+
+} // namespace
+
+QList<ContentBlock> NoteDocumentCodec::encode(int noteId, const QTextDocument *document)
+{
+    QList<ContentBlock> blocks;
+    if (!document) {
+        return blocks;
+    }
+
+    // 表格等子框架需要额外的结构信息，交给HTML处理
+    if (!document->rootFrame()->childFrames().isEmpty()) {
+        return blocks;
+    }
+
+    FormatTable formats;
+
+    ContentBlock formatsBlock;
+    formatsBlock.id = -1;
+    formatsBlock.note_id = noteId;
+    formatsBlock.block_type = FORMATS_BLOCK_TYPE;
+    formatsBlock.position = 0;
+    blocks.append(formatsBlock);
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+
+        // 段落格式中的列表关联是文档内的对象索引，单独保存列表格式
+        QTextBlockFormat blockFormat = block.blockFormat();
+        blockFormat.setObjectIndex(-1);
+        out << formats.idFor(block.blockFormatIndex(), blockFormat)
+            << formats.idFor(block.charFormatIndex(), block.charFormat());
+
+        quint64 listId = 0;
+        quint8 flags = 0;
+        if (QTextList *list = block.textList()) {
+            listId = formats.idFor(list->formatIndex(), list->format());
+            if (list->itemNumber(block) == 0) {
+                flags |= PARAGRAPH_STARTS_LIST;
+            }
+        }
+        out << listId << flags;
+
+        QStringList imageNames;
+        QList<QTextFragment> fragments;
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            if (it.fragment().isValid()) {
+                fragments.append(it.fragment());
+            }
+        }
+
+        out << quint32(fragments.size());
+        for (const QTextFragment &fragment : fragments) {
+            QTextCharFormat charFormat = fragment.charFormat();
+            out << formats.idFor(fragment.charFormatIndex(), charFormat) << fragment.text();
+            if (charFormat.isImageFormat()) {
+                imageNames.append(charFormat.toImageFormat().name());
+            }
+        }
+
+        ContentBlock paragraph;
+        paragraph.id = -1;
+        paragraph.note_id = noteId;
+        paragraph.block_type = PARAGRAPH_BLOCK_TYPE;
+        paragraph.position = blocks.size();
+        paragraph.content_data = data;
+        paragraph.media_path = imageNames.join('\n');
+        blocks.append(paragraph);
+    }
+
+    blocks[0].content_data = formats.serialize();
+    return blocks;
+}
+
+bool NoteDocumentCodec::isEncoded(const QList<ContentBlock> &blocks)
+{
+    return !blocks.isEmpty() && blocks.first().block_type == FORMATS_BLOCK_TYPE;
+}
+
+QString NoteDocumentCodec::toHtml(const QList<ContentBlock> &blocks)
+{
+    QTextDocument document;
+    NoteDocumentCodec codec(&document);
+    if (!codec.decode(blocks)) {
+        return QString();
+    }
+    return document.toHtml();
+}
+
+bool NoteDocumentCodec::rewriteImageNames(ContentBlock *formatsBlock,
+                                          const QList<QPair<QRegularExpression, QString>> &replacements,
+                                          bool *changed)
+{
+    if (changed) {
+        *changed = false;
+    }
+
+    QDataStream in(formatsBlock->content_data);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != FORMATS_MAGIC || version > CODEC_VERSION) {
+        qWarning() << "无法识别的笔记格式表，版本:" << version;
+        return false;
+    }
+
+    QList<QPair<quint64, QByteArray>> entries;
+    bool anyChanged = false;
+    for (quint32 i = 0; i < count; ++i) {
+        quint64 id = 0;
+        QByteArray bytes;
+        in >> id >> bytes;
+
+        QDataStream formatStream(bytes);
+        formatStream.setVersion(STREAM_VERSION);
+        QTextFormat format;
+        formatStream >> format;
+
+        if (format.isImageFormat()) {
+            QTextImageFormat imageFormat = format.toImageFormat();
+            QString name = imageFormat.name();
+            for (const auto &replacement : replacements) {
+                name.replace(replacement.first, replacement.second);
+            }
+            if (name != imageFormat.name()) {
+                imageFormat.setName(name);
+                bytes.clear();
+                QDataStream out(&bytes, QIODevice::WriteOnly);
+                out.setVersion(STREAM_VERSION);
+                out << static_cast<const QTextFormat &>(imageFormat);
+                anyChanged = true;
+            }
+        }
+        entries.append(qMakePair(id, bytes));
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "笔记格式表已损坏";
+        return false;
+    }
+
+    if (anyChanged) {
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(STREAM_VERSION);
+        out << magic << version << quint32(entries.size());
+        for (const auto &entry : entries) {
+            out << entry.first << entry.second;
+        }
+        formatsBlock->content_data = data;
+    }
+
+    if (changed) {
+        *changed = anyChanged;
+    }
+    return true;
+}
+
+NoteDocumentCodec::NoteDocumentCodec(QTextDocument *document)
+    : m_document(document)
+{
+}
+
+bool NoteDocumentCodec::begin(const ContentBlock &formatsBlock)
+{
+    m_formats.clear();
+    m_lists.clear();
+
+    QDataStream in(formatsBlock.content_data);
+    in.setVersion(STREAM_VERSION);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != FORMATS_MAGIC || version > CODEC_VERSION) {
+        qWarning() << "无法识别的笔记格式表，版本:" << version;
+        return false;
+    }
+
+    for (quint32 i = 0; i < count; ++i) {
+        quint64 id = 0;
+        QByteArray bytes;
+        in >> id >> bytes;
+
+        QDataStream formatStream(bytes);
+        formatStream.setVersion(STREAM_VERSION);
+        QTextFormat format;
+        formatStream >> format;
+        m_formats.insert(id, format);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "笔记格式表已损坏";
+        return false;
+    }
+
+    // 解码过程不进入撤销栈
+    m_undoRedoEnabled = m_document->isUndoRedoEnabled();
+    m_document->setUndoRedoEnabled(false);
+    m_document->clear();
+    m_cursor = QTextCursor(m_document);
+    m_firstBlock = true;
+    return true;
+}
+
+bool NoteDocumentCodec::append(const ContentBlock &block)
+{
+    if (block.block_type != PARAGRAPH_BLOCK_TYPE) {
+        return true;
+    }
+
+    QDataStream in(block.content_data);
+    in.setVersion(STREAM_VERSION);
+
+    quint64 blockFormatId = 0;
+    quint64 blockCharFormatId = 0;
+    quint64 listId = 0;
+    quint8 flags = 0;
+    quint32 runCount = 0;
+    in >> blockFormatId >> blockCharFormatId >> listId >> flags >> runCount;
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "段落块已损坏，位置:" << block.position;
+        return false;
+    }
+
+    QTextBlockFormat blockFormat = m_formats.value(blockFormatId).toBlockFormat();
+    QTextCharFormat blockCharFormat = m_formats.value(blockCharFormatId).toCharFormat();
+    if (m_firstBlock) {
+        // 文档清空后保留一个空段落，第一个段落直接使用它
+        m_cursor.setBlockFormat(blockFormat);
+        m_cursor.setBlockCharFormat(blockCharFormat);
+        m_firstBlock = false;
+    } else {
+        m_cursor.insertBlock(blockFormat, blockCharFormat);
+    }
+
+    if (listId != 0) {
+        QTextList *list = m_lists.value(listId);
+        if (!list || (flags & PARAGRAPH_STARTS_LIST)) {
+            m_lists.insert(listId, m_cursor.createList(m_formats.value(listId).toListFormat()));
+        } else {
+            list->add(m_cursor.block());
+        }
+    }
+
+    for (quint32 i = 0; i < runCount; ++i) {
+        quint64 formatId = 0;
+        QString text;
+        in >> formatId >> text;
+        if (in.status() != QDataStream::Ok) {
+            qWarning() << "段落块已损坏，位置:" << block.position;
+            return false;
+        }
+
+        QTextCharFormat format = m_formats.value(formatId).toCharFormat();
+        if (format.isImageFormat()) {
+            // 每个对象替换字符对应一张图片
+            for (int j = 0; j < text.length(); ++j) {
+                m_cursor.insertImage(format.toImageFormat());
+            }
+        } else {
+            m_cursor.insertText(text, format);
+        }
+    }
+
+    return true;
+}
+
+void NoteDocumentCodec::end()
+{
+    m_document->setUndoRedoEnabled(m_undoRedoEnabled);
+    m_lists.clear();
+}
+
+bool NoteDocumentCodec::decode(const QList<ContentBlock> &blocks)
+{
+    if (!isEncoded(blocks) || !begin(blocks.first())) {
+        return false;
+    }
+
+    bool success = true;
+    for (int i = 1; i < blocks.size() && success; ++i) {
+        success = append(blocks.at(i));
+    }
+    end();
+    return success;
+}
@@ -0,0 +1,120 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-29 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-29 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notedocumentcodec.h
+ * @Description: 笔记文档的紧凑二进制格式
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef NOTEDOCUMENTCODEC_H
+#define NOTEDOCUMENTCODEC_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QTextFormat>
+#include <QTextCursor>
+#include <QPair>
+#include <QRegularExpression>
+
+#include "databasemanager.h"
+
+class QTextDocument;
+class QTextList;
+
+/**
+ * @brief 将QTextDocument直接序列化为内容块，不经过toHtml/setHtml
+ *
+ * 一篇笔记由一个格式表块和若干段落块组成:
+ * - 格式表块(doc_formats)位于第0位，保存文档中用到的所有字符/段落/列表格式，每个格式只保存一次
+ * - 段落块(doc_block)对应一个QTextBlock，保存段落格式ID和若干文本片段(格式ID + 文本)
+ *
+ * 格式ID由格式内容的哈希得到，与其他段落无关，未修改的段落序列化结果不变，增量保存仍然有效。
+ * 图片是带图片格式的对象替换字符，只保存路径；段落中引用的图片路径同时写入media_path供引用计数使用。
+ * 含表格等子框架的文档不支持，encode返回空列表，调用方应退回HTML格式。
+ */
+class NoteDocumentCodec
+{
+public:
+    static const QString FORMATS_BLOCK_TYPE;   // 格式表块类型
+    static const QString PARAGRAPH_BLOCK_TYPE; // 段落块类型
+
+    /**
+     * @brief 将文档序列化为内容块
+     * @param noteId 笔记ID
+     * @param document 文档
+     * @return QList<ContentBlock> 内容块，文档含不支持的结构时为空
+     */
+    static QList<ContentBlock> encode(int noteId, const QTextDocument *document);
+
+    /**
+     * @brief 内容块是否为二进制格式
+     * @param blocks 笔记的全部内容块
+     * @return bool 第一个块是格式表块时返回true
+     */
+    static bool isEncoded(const QList<ContentBlock> &blocks);
+
+    /**
+     * @brief 将二进制格式的内容块转换为HTML，用于导出等需要HTML的场合
+     * @param blocks 笔记的全部内容块
+     * @return QString HTML，解码失败时返回空字符串
+     */
+    static QString toHtml(const QList<ContentBlock> &blocks);
+
+    /**
+     * @brief 改写格式表块中图片格式的路径，用于迁移媒体文件
+     *
+     * 格式ID保持不变，段落块无需改动即可解码；下次保存时按新的格式内容重新计算ID。
+     * @param formatsBlock 格式表块，改写结果直接写回content_data
+     * @param replacements 依次应用到图片路径上的替换规则
+     * @param changed 输出是否有路径被改写，可为空
+     * @return bool 格式表是否有效
+     */
+    static bool rewriteImageNames(ContentBlock *formatsBlock,
+                                  const QList<QPair<QRegularExpression, QString>> &replacements,
+                                  bool *changed = nullptr);
+
+    /**
+     * @brief 创建解码器，解码结果写入指定文档
+     * @param document 目标文档
+     */
+    explicit NoteDocumentCodec(QTextDocument *document);
+
+    /**
+     * @brief 清空文档并读取格式表，开始解码
+     * @param formatsBlock 格式表块
+     * @return bool 格式表是否有效
+     */
+    bool begin(const ContentBlock &formatsBlock);
+
+    /**
+     * @brief 追加一个段落块到文档末尾，可分多次调用以便分批加载
+     * @param block 段落块
+     * @return bool 是否解码成功
+     */
+    bool append(const ContentBlock &block);
+
+    /**
+     * @brief 结束解码，恢复文档的撤销记录
+     */
+    void end();
+
+    /**
+     * @brief 一次性解码全部内容块
+     * @param blocks 笔记的全部内容块
+     * @return bool 是否解码成功
+     */
+    bool decode(const QList<ContentBlock> &blocks);
+
+private:
+    QTextDocument *m_document;
+    QTextCursor m_cursor;
+    QHash<quint64, QTextFormat> m_formats;  // 格式ID -> 格式
+    QHash<quint64, QTextList *> m_lists;     // 列表格式ID -> 当前列表
+    bool m_firstBlock = true;
+    bool m_undoRedoEnabled = true;
+};
+
+#endif // NOTEDOCUMENTCODEC_H
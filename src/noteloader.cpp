@@ -0,0 +1,208 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-31 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-01 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\noteloader.cpp
+ * @Description: 在后台线程中读取笔记并构建文档实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "noteloader.h"
+#include "texteditormanager.h"
+#include "notedocumentcodec.h"
+
+#include <QTextDocument>
+#include <QElapsedTimer>
+#include <QDebug>
+
+NoteLoadWorker::NoteLoadWorker(QAtomicInt *latestLoadId, QAtomicInt *latestPrefetchId, QThread *targetThread,
+                               QObject *parent)
+    : QObject(parent)
+    , m_latestLoadId(latestLoadId)
+    , m_latestPrefetchId(latestPrefetchId)
+    , m_targetThread(targetThread)
+{
+}
+
+bool NoteLoadWorker::ensureDatabase()
+{
+    if (m_dbManager) {
+        return true;
+    }
+
+    // 数据库连接只能在创建它的线程中使用，因此在加载线程中首次使用时创建
+    m_dbManager = new DatabaseManager("note_loader_connection", this);
+    m_dbManager->setReadOnly(true);
+    if (!m_dbManager->initialize()) {
+        qCritical() << "加载线程初始化数据库失败";
+        delete m_dbManager;
+        m_dbManager = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void NoteLoadWorker::load(int loadId, int noteId)
+{
+    // 排队期间已切换到别的笔记，直接丢弃
+    if (loadId != m_latestLoadId->loadAcquire()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QTextDocument *document = nullptr;
+    QList<ContentBlock> blocks;
+    if (ensureDatabase()) {
+        bool ok = false;
+        blocks = m_dbManager->getNoteContent(noteId, &ok);
+        if (!ok) {
+            // 内容块损坏时不构建文档，由编辑器显示为无法读取
+            qWarning() << "读取笔记内容失败:" << noteId;
+        } else if (blocks.isEmpty()) {
+            // 如果笔记没有内容，显示标题和空白内容
+            NoteInfo noteInfo = m_dbManager->getNoteById(noteId);
+            document = new QTextDocument();
+            document->setHtml("<html><body><h1>" + noteInfo.title + "</h1></body></html>");
+        } else if (!NoteLoader::isLargeNote(blocks)) {
+            document = new QTextDocument();
+            if (!NoteLoader::fillDocument(document, blocks, m_dbManager)) {
+                qWarning() << "解码笔记内容失败:" << noteId;
+            }
+            blocks.clear();
+        }
+    }
+
+    // 文档交给界面线程使用和释放
+    if (document) {
+        document->moveToThread(m_targetThread);
+    }
+    qDebug() << "加载笔记" << noteId << "，耗时" << timer.elapsed() << "毫秒";
+    emit noteLoaded(loadId, noteId, document, blocks);
+}
+
+void NoteLoadWorker::prefetch(int requestId, const QList<int> &noteIds)
+{
+    if (!ensureDatabase()) {
+        return;
+    }
+
+    for (int noteId : noteIds) {
+        // 已有更新的预读请求，或用户已打开笔记时放弃剩余的笔记
+        if (requestId != m_latestPrefetchId->loadAcquire()) {
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        bool ok = false;
+        QList<ContentBlock> blocks = m_dbManager->getNoteContent(noteId, &ok);
+        if (!ok || blocks.isEmpty() || NoteLoader::isLargeNote(blocks)) {
+            continue;
+        }
+
+        QTextDocument *document = new QTextDocument();
+        if (!NoteLoader::fillDocument(document, blocks, m_dbManager)) {
+            qWarning() << "预读笔记解码失败:" << noteId;
+            delete document;
+            continue;
+        }
+
+        document->moveToThread(m_targetThread);
+        qDebug() << "预读笔记" << noteId << "，耗时" << timer.elapsed() << "毫秒";
+        emit documentPrefetched(requestId, noteId, document);
+    }
+}
+
+void NoteLoadWorker::closeDatabase()
+{
+    delete m_dbManager;
+    m_dbManager = nullptr;
+}
+
+NoteLoader::NoteLoader(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QList<ContentBlock>>("QList<ContentBlock>");
+
+    m_worker = new NoteLoadWorker(&m_latestLoadId, &m_latestPrefetchId, thread());
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(this, &NoteLoader::loadRequested, m_worker, &NoteLoadWorker::load);
+    connect(this, &NoteLoader::prefetchRequested, m_worker, &NoteLoadWorker::prefetch);
+    connect(m_worker, &NoteLoadWorker::noteLoaded, this, &NoteLoader::noteLoaded);
+    connect(m_worker, &NoteLoadWorker::documentPrefetched, this, &NoteLoader::documentPrefetched);
+    m_thread.setObjectName("NoteLoaderThread");
+    m_thread.start();
+}
+
+NoteLoader::~NoteLoader()
+{
+    // 使正在进行的加载和预读失效并等待线程退出
+    m_latestLoadId.fetchAndAddOrdered(1);
+    m_latestPrefetchId.fetchAndAddOrdered(1);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void NoteLoader::releaseDatabase()
+{
+    if (!m_thread.isRunning()) {
+        return;
+    }
+
+    // 排在前面的加载和预读请求随之失效，阻塞调用返回时它们都已结束
+    m_latestLoadId.fetchAndAddOrdered(1);
+    m_latestPrefetchId.fetchAndAddOrdered(1);
+    QMetaObject::invokeMethod(m_worker, "closeDatabase", Qt::BlockingQueuedConnection);
+}
+
+int NoteLoader::load(int noteId)
+{
+    // 打开笔记优先：使进行中的预读在当前这篇完成后停止
+    m_latestPrefetchId.fetchAndAddOrdered(1);
+
+    int loadId = m_latestLoadId.fetchAndAddOrdered(1) + 1;
+    emit loadRequested(loadId, noteId);
+    return loadId;
+}
+
+int NoteLoader::prefetch(const QList<int> &noteIds)
+{
+    int requestId = m_latestPrefetchId.fetchAndAddOrdered(1) + 1;
+    if (!noteIds.isEmpty()) {
+        emit prefetchRequested(requestId, noteIds);
+    }
+    return requestId;
+}
+
+bool NoteLoader::isLargeNote(const QList<ContentBlock> &blocks)
+{
+    qint64 totalLength = 0;
+    for (const ContentBlock &block : blocks) {
+        totalLength += block.content_text.length() + block.content_data.size();
+    }
+    return totalLength >= TextEditorManager::STREAMING_LOAD_THRESHOLD;
+}
+
+bool NoteLoader::fillDocument(QTextDocument *document, const QList<ContentBlock> &blocks, DatabaseManager *dbManager)
+{
+    // 二进制格式直接重建文档，不经过HTML解析
+    if (NoteDocumentCodec::isEncoded(blocks)) {
+        NoteDocumentCodec codec(document);
+        return codec.decode(blocks);
+    }
+
+    // 根据内容块构建HTML
+    QString htmlContent = "<html><body>";
+    for (const ContentBlock &block : blocks) {
+        htmlContent += TextEditorManager::contentBlockToHtml(block, dbManager);
+    }
+    htmlContent += "</body></html>";
+    document->setHtml(htmlContent);
+    return true;
+}
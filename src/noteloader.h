@@ -0,0 +1,163 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-31 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-01 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\noteloader.h
+ * @Description: 在后台线程中读取笔记并构建文档
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef NOTELOADER_H
+#define NOTELOADER_H
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+#include <QList>
+
+#include "databasemanager.h"
+
+class QTextDocument;
+
+/**
+ * @brief 运行在加载线程中的工作对象，持有独立的只读数据库连接
+ */
+class NoteLoadWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param latestLoadId 界面线程维护的最新加载请求ID
+     * @param latestPrefetchId 界面线程维护的最新预读请求ID
+     * @param targetThread 构建完成的文档移交到的线程
+     * @param parent 父对象
+     */
+    NoteLoadWorker(QAtomicInt *latestLoadId, QAtomicInt *latestPrefetchId, QThread *targetThread,
+                   QObject *parent = nullptr);
+
+public slots:
+    /**
+     * @brief 读取笔记并构建文档，完成后发出noteLoaded
+     * @param loadId 加载请求ID
+     * @param noteId 笔记ID
+     */
+    void load(int loadId, int noteId);
+
+    /**
+     * @brief 依次读取并构建笔记文档，每完成一篇发出一次documentPrefetched
+     * @param requestId 预读请求ID
+     * @param noteIds 笔记ID，按打开的可能性从高到低排列
+     */
+    void prefetch(int requestId, const QList<int> &noteIds);
+
+    /**
+     * @brief 关闭加载线程的数据库连接，下次加载时重新打开
+     */
+    void closeDatabase();
+
+signals:
+    void noteLoaded(int loadId, int noteId, QTextDocument *document, const QList<ContentBlock> &blocks);
+    void documentPrefetched(int requestId, int noteId, QTextDocument *document);
+
+private:
+    QAtomicInt *m_latestLoadId;
+    QAtomicInt *m_latestPrefetchId;
+    QThread *m_targetThread;
+    DatabaseManager *m_dbManager = nullptr; // 加载线程专用的数据库管理器，首次使用时创建
+
+    bool ensureDatabase();
+};
+
+/**
+ * @brief 笔记加载器，把读取数据库、拼接HTML和解析文档移出界面线程
+ *
+ * 加载分为两个阶段：加载线程读取内容块并构建完整的QTextDocument，再移交界面线程；
+ * 界面线程只需把文档换入编辑器。超过分批加载阈值的大笔记只在加载线程中读取内容块，
+ * 由编辑器分批追加，首屏内容可以更早显示。
+ *
+ * 同一线程也用于预读：侧边栏展开文件夹或显示搜索结果时构建最可能打开的几篇笔记，
+ * 交给编辑器放入最近笔记缓存。打开笔记的请求会打断尚未完成的预读。
+ */
+class NoteLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int MAX_PREFETCH_NOTES = 4; // 每次最多预读的笔记数
+
+    explicit NoteLoader(QObject *parent = nullptr);
+    ~NoteLoader();
+
+    /**
+     * @brief 加载笔记，取代尚未完成的旧加载请求并打断预读
+     * @param noteId 笔记ID
+     * @return int 本次加载请求的ID
+     */
+    int load(int noteId);
+
+    /**
+     * @brief 预读笔记，取代尚未完成的旧预读请求
+     * @param noteIds 笔记ID，调用方应已去掉不需要预读的笔记
+     * @return int 本次预读请求的ID
+     */
+    int prefetch(const QList<int> &noteIds);
+
+    /**
+     * @brief 最近一次预读请求的ID，尚未请求过时为0
+     */
+    int latestPrefetchId() const { return m_latestPrefetchId.loadAcquire(); }
+
+    /**
+     * @brief 放弃尚未完成的加载和预读，并在加载线程中关闭其数据库连接
+     *
+     * 恢复备份或迁移笔记本前调用，返回时加载线程已不再占用数据库文件
+     */
+    void releaseDatabase();
+
+    /**
+     * @brief 内容是否大到需要分批加载
+     * @param blocks 笔记的全部内容块
+     */
+    static bool isLargeNote(const QList<ContentBlock> &blocks);
+
+    /**
+     * @brief 用内容块构建文档：二进制格式直接重建，其余拼接HTML后解析。可在任意线程调用
+     * @param document 目标文档，原有内容被替换
+     * @param blocks 笔记的全部内容块
+     * @param dbManager 用于解析图片路径，须属于调用线程
+     * @return bool 是否构建成功，失败时文档中可能只有部分内容
+     */
+    static bool fillDocument(QTextDocument *document, const QList<ContentBlock> &blocks, DatabaseManager *dbManager);
+
+signals:
+    /**
+     * @brief 笔记已加载，在界面线程中发出，接收方取得文档所有权
+     * @param loadId 加载请求ID
+     * @param noteId 笔记ID
+     * @param document 构建完成的文档，没有父对象；大笔记或读取失败时为空
+     * @param blocks 需要分批加载的大笔记的内容块，其余情况为空；与document同时为空表示读取失败
+     */
+    void noteLoaded(int loadId, int noteId, QTextDocument *document, const QList<ContentBlock> &blocks);
+
+    /**
+     * @brief 一篇预读的笔记已构建，在界面线程中发出，接收方取得文档所有权
+     * @param requestId 所属预读请求的ID
+     * @param noteId 笔记ID
+     * @param document 构建完成的文档，没有父对象
+     */
+    void documentPrefetched(int requestId, int noteId, QTextDocument *document);
+
+    // 请求加载线程处理(内部使用)
+    void loadRequested(int loadId, int noteId);
+    void prefetchRequested(int requestId, const QList<int> &noteIds);
+
+private:
+    QThread m_thread;
+    NoteLoadWorker *m_worker;
+    QAtomicInt m_latestLoadId;
+    QAtomicInt m_latestPrefetchId;
+};
+
+#endif // NOTELOADER_H
@@ -0,0 +1,468 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-25 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-25 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notetreemodel.cpp
+ * @Description: 侧边栏文件树模型实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "notetreemodel.h"
+
+#include <QDebug>
+
+NoteTreeModel::NoteTreeModel(DatabaseManager *dbManager, QObject *parent)
+    : QAbstractListModel(parent), m_dbManager(dbManager)
+{
+    // 行数变化统一通过模型信号通知QML
+    connect(this, &QAbstractItemModel::rowsInserted, this, &NoteTreeModel::countChanged);
+    connect(this, &QAbstractItemModel::rowsRemoved, this, &NoteTreeModel::countChanged);
+    connect(this, &QAbstractItemModel::modelReset, this, &NoteTreeModel::countChanged);
+
+    if (m_dbManager) {
+        connect(m_dbManager, &DatabaseManager::folderAdded, this, &NoteTreeModel::onFolderAdded);
+        connect(m_dbManager, &DatabaseManager::folderRenamed, this, &NoteTreeModel::onFolderRenamed);
+        connect(m_dbManager, &DatabaseManager::folderRemoved, this, &NoteTreeModel::onFolderRemoved);
+        connect(m_dbManager, &DatabaseManager::noteAdded, this, &NoteTreeModel::onNoteAdded);
+        connect(m_dbManager, &DatabaseManager::noteChanged, this, &NoteTreeModel::onNoteChanged);
+        connect(m_dbManager, &DatabaseManager::noteRemoved, this, &NoteTreeModel::onNoteRemoved);
+    }
+}
+
+int NoteTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+QVariant NoteTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const Row &row = m_rows.at(index.row());
+    switch (role) {
+        case IdRole:
+            return row.id;
+        case Qt::DisplayRole:
+        case NameRole:
+            return row.name;
+        case TypeRole:
+            return row.isFolder ? QStringLiteral("folder") : QStringLiteral("note");
+        case LevelRole:
+            return row.level;
+        case ExpandedRole:
+            return row.expanded;
+        case PathRole:
+            return pathOf(row);
+        case DateRole:
+            return row.date;
+        default:
+            return QVariant();
+    }
+}
+
+QHash<int, QByteArray> NoteTreeModel::roleNames() const
+{
+    // 角色名与原先ListModel中的字段保持一致，委托无需修改
+    return {
+        {IdRole, "id"},
+        {NameRole, "name"},
+        {TypeRole, "type"},
+        {LevelRole, "level"},
+        {ExpandedRole, "expanded"},
+        {PathRole, "path"},
+        {DateRole, "date"}
+    };
+}
+
+bool NoteTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return !m_pendingRootRows.isEmpty();
+}
+
+void NoteTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    const int batch = qMin(FETCH_BATCH_SIZE, int(m_pendingRootRows.size()));
+    beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + batch - 1);
+    m_rows.append(m_pendingRootRows.mid(0, batch));
+    m_pendingRootRows.remove(0, batch);
+    markStructureChanged();
+    endInsertRows();
+}
+
+void NoteTreeModel::reload()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_pendingRootRows = loadChildren(1, 0);
+
+    // 首批直接加载，其余由视图滚动时按需加载
+    const int batch = qMin(FETCH_BATCH_SIZE, int(m_pendingRootRows.size()));
+    m_rows = m_pendingRootRows.mid(0, batch);
+    m_pendingRootRows.remove(0, batch);
+    markStructureChanged();
+    endResetModel();
+}
+
+int NoteTreeModel::indexOfPath(const QString &path) const
+{
+    if (m_indexDirty) {
+        m_rowByPath.clear();
+        m_rowByPath.reserve(m_rows.size());
+        for (int i = 0; i < m_rows.size(); ++i) {
+            m_rowByPath.insert(pathOf(m_rows.at(i)), i);
+        }
+        m_indexDirty = false;
+    }
+    return m_rowByPath.value(path, -1);
+}
+
+QVariantMap NoteTreeModel::get(int row) const
+{
+    QVariantMap result;
+    if (row < 0 || row >= m_rows.size()) {
+        return result;
+    }
+
+    const Row &item = m_rows.at(row);
+    result["id"] = item.id;
+    result["name"] = item.name;
+    result["type"] = item.isFolder ? "folder" : "note";
+    result["level"] = item.level;
+    result["expanded"] = item.expanded;
+    result["path"] = pathOf(item);
+    result["date"] = item.date;
+    return result;
+}
+
+QString NoteTreeModel::parentPath(int row) const
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return QStringLiteral("/root");
+    }
+
+    // 父文件夹是向上第一个层级更小的行
+    const int level = m_rows.at(row).level;
+    for (int i = row - 1; i >= 0; --i) {
+        if (m_rows.at(i).level < level) {
+            return pathOf(m_rows.at(i));
+        }
+    }
+    return QStringLiteral("/root");
+}
+
+void NoteTreeModel::toggleExpanded(int row)
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return;
+    }
+    setExpanded(row, !m_rows.at(row).expanded);
+}
+
+void NoteTreeModel::setExpanded(int row, bool expanded)
+{
+    if (row < 0 || row >= m_rows.size() || !m_rows.at(row).isFolder || m_rows.at(row).expanded == expanded) {
+        return;
+    }
+
+    m_rows[row].expanded = expanded;
+    emit dataChanged(index(row), index(row), {ExpandedRole});
+
+    if (expanded) {
+        // 直接子项一次性批量插入
+        const QVector<Row> children = loadChildren(m_rows.at(row).id, m_rows.at(row).level + 1);
+        if (children.isEmpty()) {
+            return;
+        }
+
+        beginInsertRows(QModelIndex(), row + 1, row + children.size());
+        m_rows.insert(row + 1, children.size(), Row());
+        for (int i = 0; i < children.size(); ++i) {
+            m_rows[row + 1 + i] = children.at(i);
+        }
+        markStructureChanged();
+        endInsertRows();
+
+        QList<int> noteIds;
+        for (const Row &child : children) {
+            if (!child.isFolder) {
+                noteIds.append(child.id);
+            }
+        }
+        if (!noteIds.isEmpty()) {
+            emit notesRevealed(noteIds);
+        }
+    } else {
+        // 移除所有展开的子孙行
+        const int end = subtreeEnd(row);
+        if (end <= row + 1) {
+            return;
+        }
+
+        beginRemoveRows(QModelIndex(), row + 1, end - 1);
+        m_rows.remove(row + 1, end - row - 1);
+        markStructureChanged();
+        endRemoveRows();
+    }
+}
+
+int NoteTreeModel::expandToPath(const QString &path)
+{
+    if (!m_dbManager || path.isEmpty() || path == "/root") {
+        return -1;
+    }
+
+    // 确定直接所属的文件夹
+    int folderId = 0;
+    const int id = path.section('_', -1).toInt();
+    if (path.startsWith("/note_")) {
+        NoteInfo note = m_dbManager->getNoteById(id);
+        if (note.id != id) {
+            return -1;
+        }
+        folderId = note.folder_id;
+    } else if (path.startsWith("/folder_")) {
+        FolderInfo folder = m_dbManager->getFolderById(id);
+        if (folder.id != id) {
+            return -1;
+        }
+        folderId = folder.parent_id;
+    } else {
+        return -1;
+    }
+
+    // 收集从根到所属文件夹的祖先链
+    QList<int> ancestors;
+    while (folderId > 1 && ancestors.size() < 64) {
+        ancestors.prepend(folderId);
+        folderId = m_dbManager->getFolderById(folderId).parent_id;
+    }
+
+    // 逐层展开，顶层项目尚未加载时先加载
+    for (int ancestorId : ancestors) {
+        int row = indexOfPath(folderPath(ancestorId));
+        while (row == -1 && canFetchMore(QModelIndex())) {
+            fetchMore(QModelIndex());
+            row = indexOfPath(folderPath(ancestorId));
+        }
+        if (row == -1) {
+            return -1;
+        }
+        setExpanded(row, true);
+    }
+
+    int row = indexOfPath(path);
+    while (row == -1 && ancestors.isEmpty() && canFetchMore(QModelIndex())) {
+        fetchMore(QModelIndex());
+        row = indexOfPath(path);
+    }
+    return row;
+}
+
+void NoteTreeModel::onFolderAdded(const FolderInfo &folder)
+{
+    insertChild(folderPath(folder.parent_id), folderRow(folder, 0));
+}
+
+void NoteTreeModel::onFolderRenamed(const FolderInfo &folder)
+{
+    updateRow(folderPath(folder.id), folder.name, QString());
+}
+
+void NoteTreeModel::onFolderRemoved(int folder_id, int parent_id)
+{
+    Q_UNUSED(parent_id);
+    removePath(folderPath(folder_id));
+}
+
+void NoteTreeModel::onNoteAdded(const NoteInfo &note)
+{
+    insertChild(folderPath(note.folder_id), noteRow(note, 0));
+}
+
+void NoteTreeModel::onNoteChanged(const NoteInfo &note, int oldFolderId)
+{
+    Row row = noteRow(note, 0);
+
+    if (note.is_trashed) {
+        // 移入回收站的笔记不在文件树中显示
+        removePath(pathOf(row));
+    } else if (oldFolderId != note.folder_id) {
+        removePath(pathOf(row));
+        insertChild(folderPath(note.folder_id), row);
+    } else {
+        updateRow(pathOf(row), note.title, note.updated_at);
+    }
+}
+
+void NoteTreeModel::onNoteRemoved(int note_id, int folder_id)
+{
+    Q_UNUSED(folder_id);
+    removePath(QString("/note_%1").arg(note_id));
+}
+
+QString NoteTreeModel::pathOf(const Row &row)
+{
+    return row.isFolder ? QString("/folder_%1").arg(row.id) : QString("/note_%1").arg(row.id);
+}
+
+QString NoteTreeModel::folderPath(int folder_id)
+{
+    return folder_id <= 1 ? QString("/root") : QString("/folder_%1").arg(folder_id);
+}
+
+NoteTreeModel::Row NoteTreeModel::folderRow(const FolderInfo &folder, int level)
+{
+    Row row;
+    row.id = folder.id;
+    row.isFolder = true;
+    row.level = level;
+    row.name = folder.name;
+    return row;
+}
+
+NoteTreeModel::Row NoteTreeModel::noteRow(const NoteInfo &note, int level)
+{
+    Row row;
+    row.id = note.id;
+    row.isFolder = false;
+    row.level = level;
+    row.name = note.title;
+    row.date = note.updated_at;
+    return row;
+}
+
+QVector<NoteTreeModel::Row> NoteTreeModel::loadChildren(int folder_id, int level) const
+{
+    QVector<Row> rows;
+    if (!m_dbManager) {
+        return rows;
+    }
+
+    FolderSubtree children = m_dbManager->getFolderSubtree(folder_id, 1);
+    rows.reserve(children.folders.size() + children.notes.size());
+    for (const FolderInfo &folder : children.folders) {
+        rows.append(folderRow(folder, level));
+    }
+    for (const NoteInfo &note : children.notes) {
+        rows.append(noteRow(note, level));
+    }
+    return rows;
+}
+
+int NoteTreeModel::subtreeEnd(int row) const
+{
+    const int level = m_rows.at(row).level;
+    int end = row + 1;
+    while (end < m_rows.size() && m_rows.at(end).level > level) {
+        ++end;
+    }
+    return end;
+}
+
+void NoteTreeModel::insertChild(const QString &parentPath, Row row)
+{
+    const QString path = pathOf(row);
+    if (indexOfPath(path) != -1) {
+        updateRow(path, row.name, row.date);
+        return;
+    }
+
+    int parentRow = -1;
+    int parentLevel = -1;
+    if (parentPath != "/root") {
+        parentRow = indexOfPath(parentPath);
+        // 父文件夹未展开时不插入，展开时会重新读取子项
+        if (parentRow == -1 || !m_rows.at(parentRow).expanded) {
+            return;
+        }
+        parentLevel = m_rows.at(parentRow).level;
+    }
+    row.level = parentLevel + 1;
+
+    // 子项中文件夹在前、笔记在后，新文件夹和新笔记都插入到两者的分界处
+    int insertRow = parentRow + 1;
+    while (insertRow < m_rows.size()) {
+        const Row &current = m_rows.at(insertRow);
+        if (current.level <= parentLevel) {
+            break;
+        }
+        if (current.level == parentLevel + 1 && !current.isFolder) {
+            break;
+        }
+        ++insertRow;
+    }
+
+    // 顶层的分界处还在未加载的部分中时，插入到待加载列表
+    if (parentRow == -1 && insertRow == m_rows.size() && !m_pendingRootRows.isEmpty()) {
+        int pendingRow = 0;
+        while (pendingRow < m_pendingRootRows.size() && m_pendingRootRows.at(pendingRow).isFolder) {
+            ++pendingRow;
+        }
+        if (pendingRow > 0) {
+            m_pendingRootRows.insert(pendingRow, row);
+            return;
+        }
+    }
+
+    beginInsertRows(QModelIndex(), insertRow, insertRow);
+    m_rows.insert(insertRow, row);
+    markStructureChanged();
+    endInsertRows();
+}
+
+void NoteTreeModel::removePath(const QString &path)
+{
+    const int row = indexOfPath(path);
+    if (row == -1) {
+        for (int i = 0; i < m_pendingRootRows.size(); ++i) {
+            if (pathOf(m_pendingRootRows.at(i)) == path) {
+                m_pendingRootRows.remove(i);
+                break;
+            }
+        }
+        return;
+    }
+
+    const int end = m_rows.at(row).isFolder ? subtreeEnd(row) : row + 1;
+    beginRemoveRows(QModelIndex(), row, end - 1);
+    m_rows.remove(row, end - row);
+    markStructureChanged();
+    endRemoveRows();
+}
+
+void NoteTreeModel::updateRow(const QString &path, const QString &name, const QString &date)
+{
+    const int row = indexOfPath(path);
+    if (row == -1) {
+        for (Row &pending : m_pendingRootRows) {
+            if (pathOf(pending) == path) {
+                pending.name = name;
+                pending.date = date;
+                break;
+            }
+        }
+        return;
+    }
+
+    m_rows[row].name = name;
+    m_rows[row].date = date;
+    emit dataChanged(index(row), index(row), {NameRole, DateRole});
+}
+
+void NoteTreeModel::markStructureChanged()
+{
+    m_indexDirty = true;
+}
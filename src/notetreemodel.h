@@ -0,0 +1,171 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-25 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-25 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\notetreemodel.h
+ * @Description: 侧边栏文件树模型
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef NOTETREEMODEL_H
+#define NOTETREEMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QHash>
+#include <QVariantMap>
+#include "databasemanager.h"
+
+/**
+ * @brief 侧边栏文件树模型，按展开状态把树平铺为ListView可直接使用的行
+ *
+ * 每行带有层级(level)和展开状态，展开文件夹时一次性批量插入其直接子项，折叠时批量移除。
+ * 路径到行号的索引在结构变化后按需重建，QML中按路径查找不再逐行扫描。
+ * 顶层项目较多时按批加载，视图滚动到末尾时通过canFetchMore/fetchMore追加。
+ * 模型监听DatabaseManager的层级变化信号，只更新受影响的行。
+ */
+class NoteTreeModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        NameRole,
+        TypeRole,
+        LevelRole,
+        ExpandedRole,
+        PathRole,
+        DateRole
+    };
+
+    explicit NoteTreeModel(DatabaseManager *dbManager, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief 当前可见的行数
+     */
+    int count() const { return m_rows.size(); }
+
+    /**
+     * @brief 重新加载顶层项目，所有文件夹恢复为折叠状态
+     */
+    Q_INVOKABLE void reload();
+
+    /**
+     * @brief 按路径查找行号
+     * @param path 项目路径，如"/folder_2"、"/note_5"
+     * @return int 行号，不在可见行中时返回-1
+     */
+    Q_INVOKABLE int indexOfPath(const QString &path) const;
+
+    /**
+     * @brief 获取一行的全部字段，键与角色名一致
+     * @param row 行号
+     * @return QVariantMap 行数据，行号无效时为空
+     */
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+    /**
+     * @brief 获取行所属父文件夹的路径
+     * @param row 行号
+     * @return QString 父文件夹路径，顶层项目返回"/root"
+     */
+    Q_INVOKABLE QString parentPath(int row) const;
+
+    /**
+     * @brief 切换文件夹的展开状态
+     * @param row 行号
+     */
+    Q_INVOKABLE void toggleExpanded(int row);
+
+    /**
+     * @brief 设置文件夹的展开状态
+     * @param row 行号
+     * @param expanded 是否展开
+     */
+    Q_INVOKABLE void setExpanded(int row, bool expanded);
+
+    /**
+     * @brief 展开项目的所有祖先文件夹，使其出现在可见行中
+     * @param path 项目路径
+     * @return int 项目的行号，找不到时返回-1
+     */
+    Q_INVOKABLE int expandToPath(const QString &path);
+
+    static const int FETCH_BATCH_SIZE = 200; // 顶层项目每批加载的行数
+
+signals:
+    void countChanged();
+
+    /**
+     * @brief 展开文件夹后其中的笔记出现在视图中，可用于预读
+     * @param noteIds 笔记ID，按显示顺序排列
+     */
+    void notesRevealed(const QList<int> &noteIds);
+
+private slots:
+    void onFolderAdded(const FolderInfo &folder);
+    void onFolderRenamed(const FolderInfo &folder);
+    void onFolderRemoved(int folder_id, int parent_id);
+    void onNoteAdded(const NoteInfo &note);
+    void onNoteChanged(const NoteInfo &note, int oldFolderId);
+    void onNoteRemoved(int note_id, int folder_id);
+
+private:
+    struct Row {
+        int id = 0;
+        bool isFolder = false;
+        int level = 0;
+        bool expanded = false;
+        QString name;
+        QString date; // 笔记的修改时间，文件夹为空
+    };
+
+    DatabaseManager *m_dbManager;
+    QVector<Row> m_rows; // 可见行
+    QVector<Row> m_pendingRootRows; // 尚未加载到视图中的顶层项目
+    mutable QHash<QString, int> m_rowByPath; // 路径 -> 行号
+    mutable bool m_indexDirty = true; // 行结构变化后需要重建索引
+
+    static QString pathOf(const Row &row);
+    static QString folderPath(int folder_id);
+    static Row folderRow(const FolderInfo &folder, int level);
+    static Row noteRow(const NoteInfo &note, int level);
+
+    /**
+     * @brief 读取文件夹的直接子项，文件夹在前(按创建时间)，笔记在后(按修改时间倒序)
+     */
+    QVector<Row> loadChildren(int folder_id, int level) const;
+
+    /**
+     * @brief 行号之后属于该文件夹的子孙行的结束位置(不含)
+     */
+    int subtreeEnd(int row) const;
+
+    /**
+     * @brief 在父文件夹的可见子项中插入一行，父文件夹未展开时忽略
+     */
+    void insertChild(const QString &parentPath, Row row);
+
+    /**
+     * @brief 移除一行及其展开的子孙行
+     */
+    void removePath(const QString &path);
+
+    /**
+     * @brief 更新一行的名称和日期
+     */
+    void updateRow(const QString &path, const QString &name, const QString &date);
+
+    void markStructureChanged();
+};
+
+#endif // NOTETREEMODEL_H
@@ -18,16 +18,62 @@
 SearchManager::SearchManager(DatabaseManager *dbManager, SidebarManager *sidebarManager, QObject *parent)
     : QObject(parent), m_dbManager(dbManager), m_sidebarManager(sidebarManager)
 {
+    qRegisterMetaType<QList<SearchResultInfo>>("QList<SearchResultInfo>");
+    
+    // 结果模型由视图滚动驱动按页加载
+    m_resultModel = new SearchResultModel(this);
+    connect(m_resultModel, &SearchResultModel::fetchRequested, this, &SearchManager::onFetchRequested);
+    
+    // 搜索在独立线程中执行，工作对象随线程结束销毁
+    m_searchWorker = new SearchWorker(&m_latestRequestId);
+    m_searchWorker->moveToThread(&m_searchThread);
+    connect(&m_searchThread, &QThread::finished, m_searchWorker, &QObject::deleteLater);
+    connect(this, &SearchManager::pageRequested, m_searchWorker, &SearchWorker::fetchPage);
+    connect(m_searchWorker, &SearchWorker::pageReady, m_resultModel, &SearchResultModel::appendPage);
+    connect(this, &SearchManager::noteIdsRequested, m_searchWorker, &SearchWorker::collectNoteIds);
+    connect(m_searchWorker, &SearchWorker::noteIdsReady, this, &SearchManager::onAiBatchNoteIdsReady);
+    // 显示新的搜索结果时预读排在最前面的笔记
+    connect(m_searchWorker, &SearchWorker::pageReady, this,
+            [this](int requestId, int offset, const QList<SearchResultInfo> &results) {
+        if (offset != 0 || requestId != m_latestRequestId.loadAcquire()) {
+            return;
+        }
+        QList<int> noteIds;
+        for (const SearchResultInfo &result : results) {
+            noteIds.append(result.id);
+        }
+        if (!noteIds.isEmpty()) {
+            emit prefetchRequested(noteIds);
+        }
+    });
+    m_searchThread.setObjectName("SearchThread");
+    m_searchThread.start();
 }
 
 SearchManager::~SearchManager()
 {
+    // 使正在进行的搜索失效并等待线程退出
+    m_latestRequestId.fetchAndAddOrdered(1);
+    m_searchThread.quit();
+    m_searchThread.wait();
+    
     if (m_searchDialog) {
         m_searchDialog->close();
         delete m_searchDialog;
     }
 }
 
+void SearchManager::releaseDatabase()
+{
+    if (!m_searchThread.isRunning()) {
+        return;
+    }
+
+    // 排在前面的搜索随之失效，阻塞调用返回时它们都已结束
+    m_latestRequestId.fetchAndAddOrdered(1);
+    QMetaObject::invokeMethod(m_searchWorker, "closeDatabase", Qt::BlockingQueuedConnection);
+}
+
 void SearchManager::showSearchDialog()
 {
     // 如果已有搜索对话框，则直接显示
@@ -66,6 +112,7 @@ void SearchManager::showSearchDialog()
     // 设置QML上下文
     QQmlContext *context = m_searchWidget->rootContext();
     context->setContextProperty("searchManager", this);
+    context->setContextProperty("searchResultModel", m_resultModel);
     context->setContextProperty("sidebarManager", m_sidebarManager);
     
     // 加载QML文件
@@ -105,26 +152,44 @@ void SearchManager::showSearchDialog()
 
 void SearchManager::searchNotes(const QString &keyword, int dateFilter, int contentType, int sortType)
 {
-    qDebug() << "SearchManager::searchNotes - Calling DB. Keyword:" << keyword;
-    if (!m_dbManager) {
-        qWarning() << "SearchManager::searchNotes - DatabaseManager is null!";
+    // 递增请求ID，后台线程中尚未执行的旧请求会被丢弃
+    int requestId = m_latestRequestId.fetchAndAddOrdered(1) + 1;
+    qDebug() << "SearchManager::searchNotes - Request" << requestId << "Keyword:" << keyword;
+    
+    m_keyword = keyword;
+    m_dateFilter = dateFilter;
+    m_contentType = contentType;
+    m_sortType = sortType;
+    
+    // 清空模型并立即请求第一页，之后的页由视图滚动触发
+    m_resultModel->reset(requestId);
+    m_resultModel->fetchMore(QModelIndex());
+}
+
+void SearchManager::requestAiBatch(const QString &operation)
+{
+    // 结果模型只加载了已滚动到的页，这里按相同条件在搜索线程中重新查询全部结果的ID
+    int batchId = m_nextAiBatchId++;
+    QString sourceName = m_keyword.isEmpty() ? QString("全部笔记") : QString("搜索\"%1\"").arg(m_keyword);
+    m_pendingAiBatches.insert(batchId, qMakePair(operation, sourceName));
+    qDebug() << "SearchManager::requestAiBatch - Operation:" << operation << "Batch:" << batchId;
+    emit noteIdsRequested(batchId, m_keyword, m_dateFilter, m_contentType, m_sortType);
+}
+
+void SearchManager::onAiBatchNoteIdsReady(int batchId, const QList<int> &noteIds)
+{
+    if (!m_pendingAiBatches.contains(batchId)) {
         return;
     }
-    QList<SearchResultInfo> results = m_dbManager->searchNotes(keyword, dateFilter, contentType, sortType);
-    qDebug() << "SearchManager::searchNotes - Received" << results.size() << "results from DB. Invoking QML update.";
-    QVariantList resultList;
-    for (const auto &result : results) {
-        resultList.append(resultToQML(result));
-    }
-    // 每次都获取顶层对象，避免m_rootObject被覆盖
-    QQuickItem* root = m_searchWidget ? m_searchWidget->rootObject() : nullptr;
-    if (root) {
-        qDebug() << "Root object type (searchNotes):" << root->metaObject()->className();
-        bool ok = QMetaObject::invokeMethod(root, "updateSearchResults", Q_ARG(QVariant, QVariant::fromValue(resultList)));
-        qDebug() << "invokeMethod updateSearchResults result:" << ok;
-    } else {
-        qWarning() << "SearchManager::searchNotes - QML root object is null!";
-    }
+    
+    QPair<QString, QString> batch = m_pendingAiBatches.take(batchId);
+    qDebug() << "SearchManager::requestAiBatch - Operation:" << batch.first << "Notes:" << noteIds.size();
+    emit aiBatchRequested(batch.first, noteIds, batch.second);
+}
+
+void SearchManager::onFetchRequested(int requestId, int offset, int limit)
+{
+    emit pageRequested(requestId, m_keyword, m_dateFilter, m_contentType, m_sortType, offset, limit);
 }
 
 void SearchManager::onDialogClosed()
@@ -143,19 +208,6 @@ void SearchManager::onNoteSelected(const QString &path, const QString &type)
     emit noteSelected(path, type);
 }
 
-QVariantMap SearchManager::resultToQML(const SearchResultInfo &result)
-{
-    QVariantMap map;
-    map["id"] = result.id;
-    map["title"] = result.title;
-    map["previewText"] = result.previewText;
-    map["path"] = result.path;
-    map["createdAt"] = result.created_at;
-    map["updatedAt"] = result.updated_at;
-    map["folderId"] = result.folder_id;
-    return map;
-}
-
 // 添加处理对话框完成的槽函数
 void SearchManager::handleDialogFinished(int result)
 {
@@ -19,7 +19,13 @@
 #include <QVariantList>
 #include <QDialog>
 #include <QPoint>
+#include <QThread>
+#include <QAtomicInt>
+#include <QHash>
+#include <QPair>
 #include "databasemanager.h" // 包含数据库管理器
+#include "searchworker.h" // 后台搜索工作对象
+#include "searchresultmodel.h" // 分页搜索结果模型
 #include "sidebarmanager.h" // 新增，便于持有指针
 
 /**
@@ -37,13 +43,20 @@ public:
      * @brief 显示搜索对话框
      */
     void showSearchDialog();
+
+    /**
+     * @brief 取消尚未完成的搜索，并在搜索线程中关闭其数据库连接
+     *
+     * 恢复备份或迁移笔记本前调用，返回时搜索线程已不再占用数据库文件
+     */
+    void releaseDatabase();
     
     /**
-     * @brief 搜索笔记
+     * @brief 搜索笔记(异步)，在后台线程执行，新的搜索会取消尚未完成的旧搜索
      * @param keyword 搜索关键词
      * @param dateFilter 日期筛选类型: 0-全部时间, 1-今天, 2-最近一周, 3-最近一月
      * @param contentType 内容类型筛选: 0-全部类型, 1-文本, 2-图片, 3-列表
-     * @param sortType 排序方式: 0-最近修改, 1-创建时间, 2-按名称排序
+     * @param sortType 排序方式: 0-最近修改, 1-创建时间, 2-按名称排序, 3-按相关度
      */
     Q_INVOKABLE void searchNotes(
         const QString &keyword, 
@@ -52,6 +65,13 @@ public:
         int sortType = 0
     );
 
+    /**
+     * @brief 对当前搜索条件下的全部结果(不限于已加载的页)执行AI批量处理，
+     *        笔记ID在搜索线程中查询，完成后发出aiBatchRequested
+     * @param operation 操作类型标识符: summarize/tag/fix
+     */
+    Q_INVOKABLE void requestAiBatch(const QString &operation);
+
 public slots:
     /**
      * @brief 处理搜索对话框关闭
@@ -77,6 +97,21 @@ private slots:
      */
     void handleDialogFinished(int result);
 
+    /**
+     * @brief 模型需要下一页时，按当前筛选条件向后台线程请求
+     * @param requestId 请求ID
+     * @param offset 起始位置
+     * @param limit 条数
+     */
+    void onFetchRequested(int requestId, int offset, int limit);
+
+    /**
+     * @brief 搜索线程查询到批量处理的笔记ID
+     * @param batchId 批量请求ID
+     * @param noteIds 笔记ID
+     */
+    void onAiBatchNoteIdsReady(int batchId, const QList<int> &noteIds);
+
 signals:
     /**
      * @brief 选中笔记的信号
@@ -96,6 +131,31 @@ signals:
      */
     void searchClosed();
 
+    /**
+     * @brief 请求预读接下来可能打开的笔记
+     * @param noteIds 笔记ID，按结果排序排列
+     */
+    void prefetchRequested(const QList<int> &noteIds);
+
+    /**
+     * @brief 请求对一组笔记执行AI批量处理
+     * @param operation 操作类型标识符
+     * @param noteIds 笔记ID
+     * @param sourceName 笔记来源描述
+     */
+    void aiBatchRequested(const QString &operation, const QList<int> &noteIds, const QString &sourceName);
+
+    /**
+     * @brief 请求后台线程加载一页结果(内部使用)
+     */
+    void pageRequested(int requestId, const QString &keyword, int dateFilter, int contentType, int sortType,
+                       int offset, int limit);
+
+    /**
+     * @brief 请求后台线程查询批量处理的全部笔记ID(内部使用)
+     */
+    void noteIdsRequested(int batchId, const QString &keyword, int dateFilter, int contentType, int sortType);
+
 private:
     DatabaseManager *m_dbManager; // 数据库管理器
     SidebarManager *m_sidebarManager; // 新增：侧边栏管理器指针
@@ -108,12 +168,20 @@ private:
     QPoint m_dragStartPos;
     // ---------------------------
     
-    /**
-     * @brief 将SearchResultInfo对象转换为QML可用的QVariantMap
-     * @param result 搜索结果
-     * @return QVariantMap QML可用的结果数据
-     */
-    QVariantMap resultToQML(const SearchResultInfo &result);
+    // --- 后台搜索 ---
+    QThread m_searchThread; // 搜索线程
+    SearchWorker *m_searchWorker = nullptr; // 运行在搜索线程中的工作对象
+    QAtomicInt m_latestRequestId; // 最新的搜索请求ID，工作线程据此取消过期搜索
+    SearchResultModel *m_resultModel = nullptr; // 暴露给QML的结果模型
+    // 当前搜索条件，翻页时沿用
+    QString m_keyword;
+    int m_dateFilter = 0;
+    int m_contentType = 0;
+    int m_sortType = 0;
+    // 等待笔记ID的批量请求: 批量请求ID -> (操作类型, 来源描述)
+    QHash<int, QPair<QString, QString>> m_pendingAiBatches;
+    int m_nextAiBatchId = 1;
+    // ---------------------------
 };
 
 #endif // SEARCHMANAGER_H 
\ No newline at end of file
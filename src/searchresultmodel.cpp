@@ -0,0 +1,127 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-20 15:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-20 15:00:00
+ * @FilePath: \IntelliMedia_Notes\src\searchresultmodel.cpp
+ * @Description: 分页加载的搜索结果模型实现
+ * 
+ * Copyright (c) 2025 by Furdow, All Rights Reserved. 
+ */
+#include "searchresultmodel.h"
+
+SearchResultModel::SearchResultModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int SearchResultModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+QVariant SearchResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    
+    const SearchResultInfo &result = m_rows.at(index.row());
+    switch (role) {
+        case IdRole:
+            return result.id;
+        case Qt::DisplayRole:
+        case TitleRole:
+            return result.title;
+        case PreviewTextRole:
+            return result.previewText;
+        case PathRole:
+            return result.path;
+        case CreatedAtRole:
+            return result.created_at;
+        case UpdatedAtRole:
+            return result.updated_at;
+        case FolderIdRole:
+            return result.folder_id;
+        case WordCountRole:
+            return result.wordCount;
+        default:
+            return QVariant();
+    }
+}
+
+QHash<int, QByteArray> SearchResultModel::roleNames() const
+{
+    // 角色名与原先QVariantMap中的键保持一致
+    return {
+        {IdRole, "id"},
+        {TitleRole, "title"},
+        {PreviewTextRole, "previewText"},
+        {PathRole, "path"},
+        {CreatedAtRole, "createdAt"},
+        {UpdatedAtRole, "updatedAt"},
+        {FolderIdRole, "folderId"},
+        {WordCountRole, "wordCount"}
+    };
+}
+
+bool SearchResultModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return false;
+    }
+    return m_hasMore && !m_fetching;
+}
+
+void SearchResultModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    
+    setFetching(true);
+    emit fetchRequested(m_requestId, m_rows.size(), PAGE_SIZE);
+}
+
+void SearchResultModel::reset(int requestId)
+{
+    beginResetModel();
+    m_rows.clear();
+    m_requestId = requestId;
+    m_hasMore = true;
+    m_fetching = false;
+    endResetModel();
+    
+    emit countChanged();
+    emit loadingChanged();
+}
+
+void SearchResultModel::appendPage(int requestId, int offset, const QList<SearchResultInfo> &page)
+{
+    // 丢弃过期请求或错位的页
+    if (requestId != m_requestId || offset != m_rows.size()) {
+        return;
+    }
+    
+    m_hasMore = page.size() >= PAGE_SIZE;
+    
+    if (!page.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + page.size() - 1);
+        m_rows.append(page);
+        endInsertRows();
+        emit countChanged();
+    }
+    
+    setFetching(false);
+}
+
+void SearchResultModel::setFetching(bool fetching)
+{
+    if (m_fetching != fetching) {
+        m_fetching = fetching;
+        emit loadingChanged();
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-20 15:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-20 15:00:00
+ * @FilePath: \IntelliMedia_Notes\src\searchresultmodel.h
+ * @Description: 分页加载的搜索结果模型
+ * 
+ * Copyright (c) 2025 by Furdow, All Rights Reserved. 
+ */
+#ifndef SEARCHRESULTMODEL_H
+#define SEARCHRESULTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include "databasemanager.h"
+
+/**
+ * @brief 搜索结果列表模型，随视图滚动按页向后台线程请求数据
+ *
+ * 模型只保存已加载的行，视图通过canFetchMore/fetchMore驱动下一页的加载。
+ * 每次新的搜索调用reset，旧请求返回的页会根据请求ID被丢弃。
+ */
+class SearchResultModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        IdRole = Qt::UserRole + 1,
+        TitleRole,
+        PreviewTextRole,
+        PathRole,
+        CreatedAtRole,
+        UpdatedAtRole,
+        FolderIdRole,
+        WordCountRole
+    };
+
+    explicit SearchResultModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief 是否正在等待某一页数据
+     */
+    bool isLoading() const { return m_fetching; }
+
+    /**
+     * @brief 已加载的行数
+     */
+    int count() const { return m_rows.size(); }
+
+    /**
+     * @brief 开始新的搜索，清空已加载的结果
+     * @param requestId 新搜索的请求ID
+     */
+    void reset(int requestId);
+
+    /**
+     * @brief 追加后台线程返回的一页结果
+     * @param requestId 请求ID，与当前搜索不一致时丢弃
+     * @param offset 本页在结果集中的起始位置
+     * @param page 本页结果
+     */
+    void appendPage(int requestId, int offset, const QList<SearchResultInfo> &page);
+
+    static const int PAGE_SIZE = 30; // 每页结果数
+
+signals:
+    /**
+     * @brief 请求加载一页数据
+     * @param requestId 请求ID
+     * @param offset 起始位置
+     * @param limit 条数
+     */
+    void fetchRequested(int requestId, int offset, int limit);
+
+    void loadingChanged();
+    void countChanged();
+
+private:
+    QList<SearchResultInfo> m_rows; // 已加载的结果
+    int m_requestId = 0; // 当前搜索的请求ID
+    bool m_hasMore = false; // 是否还有未加载的结果
+    bool m_fetching = false; // 是否有页请求尚未返回
+
+    void setFetching(bool fetching);
+};
+
+#endif // SEARCHRESULTMODEL_H
@@ -0,0 +1,121 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-20 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-20 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\searchworker.cpp
+ * @Description: 搜索工作线程对象实现
+ * 
+ * Copyright (c) 2025 by Furdow, All Rights Reserved. 
+ */
+#include "searchworker.h"
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+
+#ifdef HAVE_SQLITE3_API
+#include <sqlite3.h>
+#endif
+
+SearchWorker::SearchWorker(QAtomicInt *latestRequestId, QObject *parent)
+    : QObject(parent), m_latestRequestId(latestRequestId)
+{
+}
+
+SearchWorker::~SearchWorker()
+{
+    // m_dbManager以this为父对象，随工作对象在工作线程中一同销毁
+}
+
+bool SearchWorker::ensureDatabase()
+{
+    if (m_dbManager) {
+        return true;
+    }
+    
+    // 数据库连接只能在创建它的线程中使用，因此在工作线程中首次搜索时创建
+    m_dbManager = new DatabaseManager("search_worker_connection", this);
+    m_dbManager->setReadOnly(true);
+    if (!m_dbManager->initialize()) {
+        qCritical() << "搜索线程初始化数据库失败";
+        delete m_dbManager;
+        m_dbManager = nullptr;
+        return false;
+    }
+    
+    installInterruptHandler();
+    return true;
+}
+
+void SearchWorker::closeDatabase()
+{
+    delete m_dbManager;
+    m_dbManager = nullptr;
+}
+
+void SearchWorker::installInterruptHandler()
+{
+#ifdef HAVE_SQLITE3_API
+    QSqlDatabase db = QSqlDatabase::database("search_worker_connection", false);
+    QVariant handle = db.driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) {
+        return;
+    }
+    
+    // 链接的SQLite须与QSQLITE驱动内置的是同一版本，否则不能操作驱动的句柄
+    QSqlQuery versionQuery(db);
+    if (!versionQuery.exec("SELECT sqlite_version()") || !versionQuery.next()
+        || versionQuery.value(0).toString() != QString::fromLatin1(sqlite3_libversion())) {
+        qWarning() << "QSQLITE驱动与链接的SQLite版本不一致，搜索无法中止正在执行的查询";
+        return;
+    }
+    versionQuery.finish();
+    
+    sqlite3 *sqliteHandle = *static_cast<sqlite3 **>(handle.data());
+    if (sqliteHandle) {
+        // 每执行约1000条虚拟机指令检查一次，开销可以忽略
+        sqlite3_progress_handler(sqliteHandle, 1000, &SearchWorker::progressCallback, this);
+    }
+#endif
+}
+
+int SearchWorker::progressCallback(void *worker)
+{
+    SearchWorker *self = static_cast<SearchWorker *>(worker);
+    return self->m_activeRequestId != 0
+        && self->m_activeRequestId != self->m_latestRequestId->loadAcquire();
+}
+
+void SearchWorker::fetchPage(int requestId, const QString &keyword, int dateFilter, int contentType, int sortType,
+                             int offset, int limit)
+{
+    // 排队期间已有更新的请求，直接丢弃
+    if (requestId != m_latestRequestId->loadAcquire()) {
+        return;
+    }
+    
+    QList<SearchResultInfo> results;
+    if (ensureDatabase()) {
+        m_activeRequestId = requestId;
+        results = m_dbManager->searchNotes(keyword, dateFilter, contentType, sortType, limit, offset);
+        m_activeRequestId = 0;
+    }
+    
+    // 执行期间被新请求取代(查询可能已被中止)，结果不完整，不再发出
+    if (requestId != m_latestRequestId->loadAcquire()) {
+        return;
+    }
+    
+    emit pageReady(requestId, offset, results);
+}
+
+void SearchWorker::collectNoteIds(int batchId, const QString &keyword, int dateFilter, int contentType, int sortType)
+{
+    QList<int> noteIds;
+    if (ensureDatabase()) {
+        noteIds = m_dbManager->searchNoteIds(keyword, dateFilter, contentType, sortType);
+    }
+    emit noteIdsReady(batchId, noteIds);
+}
@@ -0,0 +1,96 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-05-20 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-05-20 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\searchworker.h
+ * @Description: 搜索工作线程对象
+ * 
+ * Copyright (c) 2025 by Furdow, All Rights Reserved. 
+ */
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include "databasemanager.h"
+
+/**
+ * @brief 搜索工作对象，运行在独立线程中并持有自己的数据库连接
+ *
+ * 每次搜索带有递增的请求ID，执行前若发现已有更新的请求，则放弃该页请求；
+ * 可用SQLite C接口时，还在连接上安装进度回调，正在执行的查询被新请求取代后立即中止。
+ * 结果按页通过pageReady信号发回界面线程。
+ */
+class SearchWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param latestRequestId 界面线程维护的最新请求ID，用于判断当前搜索是否已被取代
+     * @param parent 父对象
+     */
+    explicit SearchWorker(QAtomicInt *latestRequestId, QObject *parent = nullptr);
+    ~SearchWorker();
+
+public slots:
+    /**
+     * @brief 加载一页搜索结果，筛选参数含义同DatabaseManager::searchNotes
+     * @param requestId 请求ID
+     * @param offset 起始位置
+     * @param limit 条数
+     */
+    void fetchPage(int requestId, const QString &keyword, int dateFilter, int contentType, int sortType,
+                   int offset, int limit);
+
+    /**
+     * @brief 查询符合筛选条件的全部笔记ID，用于对搜索结果执行批量操作，不会因新的搜索而放弃
+     * @param batchId 批量请求ID，由调用方分配，原样随结果发回
+     */
+    void collectNoteIds(int batchId, const QString &keyword, int dateFilter, int contentType, int sortType);
+
+    /**
+     * @brief 关闭工作线程的数据库连接，下次搜索时重新打开
+     */
+    void closeDatabase();
+
+signals:
+    /**
+     * @brief 一页搜索结果已就绪
+     * @param requestId 请求ID
+     * @param offset 本页起始位置
+     * @param results 本页结果
+     */
+    void pageReady(int requestId, int offset, const QList<SearchResultInfo> &results);
+
+    /**
+     * @brief 全部笔记ID已查询完成
+     * @param batchId 批量请求ID
+     * @param noteIds 笔记ID，按搜索结果的顺序排列
+     */
+    void noteIdsReady(int batchId, const QList<int> &noteIds);
+
+private:
+    QAtomicInt *m_latestRequestId; // 最新请求ID(由界面线程写入)
+    int m_activeRequestId = 0; // 正在执行的请求ID，供进度回调判断是否已过期
+    DatabaseManager *m_dbManager = nullptr; // 工作线程专用的数据库管理器，首次搜索时创建
+
+    /**
+     * @brief 确保工作线程的数据库连接已初始化
+     * @return bool 是否可用
+     */
+    bool ensureDatabase();
+
+    /**
+     * @brief 在工作线程的连接上安装SQLite进度回调，用于中止过期查询
+     */
+    void installInterruptHandler();
+
+    /**
+     * @brief SQLite进度回调，返回非0时中止当前查询
+     */
+    static int progressCallback(void *worker);
+};
+
+#endif // SEARCHWORKER_H
@@ -1,4 +1,6 @@
 #include "settingsdialog.h"
+#include "databasemanager.h"
+#include "mediastore.h"
 #include <QCloseEvent>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -252,6 +254,7 @@ void SettingsDialog::applySettings()
             // 备份数据库文件
             QString dbPath = notebookLocation + "/notes.db";
             if (QFile::exists(dbPath)) {
+                DatabaseManager::checkpointDatabaseFile(dbPath);
                 QFile::copy(dbPath, backupSubDir + "/notes.db");
             }
             
@@ -262,11 +265,10 @@ void SettingsDialog::applySettings()
                 QDir().mkpath(backupSubDir + "/notes_media");
                 
                 // 复制媒体文件夹内容
-                QDir mediaDir(mediaPath);
-                QStringList mediaFiles = mediaDir.entryList(QDir::Files);
+                QStringList mediaFiles = MediaStore::listFiles(mediaPath);
                 
                 for (const QString &file : mediaFiles) {
-                    QFile::copy(mediaPath + "/" + file, backupSubDir + "/notes_media/" + file);
+                    MediaStore::copyFile(mediaPath + "/" + file, backupSubDir + "/notes_media/" + file);
                 }
             }
             
@@ -739,6 +741,9 @@ void SettingsDialog::onSelectNotebookLocationClicked()
         settings.setValue("Application/PendingRestart", true);
         settings.sync();
         
+        // 写完待保存的笔记并关闭后台线程的数据库连接，新进程启动后要移动数据库文件
+        emit databaseReleaseRequested();
+        
         // 获取应用程序路径
         QString appPath = QApplication::applicationFilePath();
         QStringList arguments = QApplication::arguments();
@@ -1091,6 +1096,9 @@ void SettingsDialog::onRestoreFromBackupClicked()
         // 使用与笔记库位置移动相同的重启机制
         qDebug() << "正在重启应用程序...";
         
+        // 写完待保存的笔记并关闭后台线程的数据库连接，新进程启动后要替换数据库文件
+        emit databaseReleaseRequested();
+        
         // 获取应用程序路径
         QString appPath = QApplication::applicationFilePath();
         QStringList arguments = QApplication::arguments();
@@ -1370,6 +1378,7 @@ void SettingsDialog::onImportNotesClicked()
             m_importNotesBtn->setEnabled(true);
             
             if (success) {
+                emit notesImported();
                 m_operationStatusLabel->setText(tr("导入已完成"));
                 QMessageBox::information(this,
                     tr("导入完成"),
@@ -1656,6 +1665,14 @@ void SettingsDialog::setupAiServiceTab()
     endpointLayout->addWidget(endpointDescLabel);
     endpointLayout->addLayout(endpointInputLayout);
     
+    QCheckBox *streamResponsesCheck = new QCheckBox(tr("流式显示回复(边生成边显示)"));
+    streamResponsesCheck->setObjectName("streamResponsesCheck");
+    endpointLayout->addWidget(streamResponsesCheck);
+    
+    QCheckBox *responseCacheCheck = new QCheckBox(tr("缓存AI回复(对相同文本重复操作时直接返回，点击重试时重新生成)"));
+    responseCacheCheck->setObjectName("responseCacheCheck");
+    endpointLayout->addWidget(responseCacheCheck);
+    
     endpointGroup->setLayout(endpointLayout);
     
     // 4. 测试连接
@@ -1735,6 +1752,57 @@ void SettingsDialog::setupDataStorageTab()
     backupLayout->addLayout(frequencyLayout);
     backupLayout->addLayout(backupButtonsLayout);
     
+    // 数据库性能设置
+    QGroupBox *performanceGroup = new QGroupBox(tr("数据库性能"));
+    QVBoxLayout *performanceLayout = new QVBoxLayout(performanceGroup);
+    
+    QCheckBox *walModeCheck = new QCheckBox(tr("启用WAL日志模式（保存时不阻塞搜索和导出）"));
+    walModeCheck->setObjectName("walModeCheck");
+    
+    QHBoxLayout *synchronousLayout = new QHBoxLayout();
+    QLabel *synchronousLabel = new QLabel(tr("写入同步级别:"));
+    QComboBox *synchronousCombo = new QComboBox();
+    synchronousCombo->setObjectName("synchronousCombo");
+    synchronousCombo->addItem(tr("标准 (NORMAL)"), "NORMAL");
+    synchronousCombo->addItem(tr("完全 (FULL)"), "FULL");
+    synchronousCombo->addItem(tr("关闭 (OFF)"), "OFF");
+    synchronousLayout->addWidget(synchronousLabel);
+    synchronousLayout->addWidget(synchronousCombo);
+    synchronousLayout->addStretch();
+    
+    QHBoxLayout *cacheLayout = new QHBoxLayout();
+    QLabel *cacheSizeLabel = new QLabel(tr("页缓存:"));
+    QSpinBox *cacheSizeSpin = new QSpinBox();
+    cacheSizeSpin->setObjectName("cacheSizeSpin");
+    cacheSizeSpin->setRange(2, 1024);
+    cacheSizeSpin->setSuffix(" MB");
+    QLabel *mmapSizeLabel = new QLabel(tr("内存映射:"));
+    QSpinBox *mmapSizeSpin = new QSpinBox();
+    mmapSizeSpin->setObjectName("mmapSizeSpin");
+    mmapSizeSpin->setRange(0, 4096);
+    mmapSizeSpin->setSuffix(" MB");
+    cacheLayout->addWidget(cacheSizeLabel);
+    cacheLayout->addWidget(cacheSizeSpin);
+    cacheLayout->addWidget(mmapSizeLabel);
+    cacheLayout->addWidget(mmapSizeSpin);
+    cacheLayout->addStretch();
+    
+    QCheckBox *tempStoreMemoryCheck = new QCheckBox(tr("临时数据保存在内存中"));
+    tempStoreMemoryCheck->setObjectName("tempStoreMemoryCheck");
+    
+    QCheckBox *compressContentCheck = new QCheckBox(tr("压缩保存笔记内容(减小数据库和备份体积)"));
+    compressContentCheck->setObjectName("compressContentCheck");
+    
+    QLabel *performanceInfoLabel = new QLabel(tr("以上设置在重启应用后生效。"));
+    performanceInfoLabel->setWordWrap(true);
+    
+    performanceLayout->addWidget(walModeCheck);
+    performanceLayout->addLayout(synchronousLayout);
+    performanceLayout->addLayout(cacheLayout);
+    performanceLayout->addWidget(tempStoreMemoryCheck);
+    performanceLayout->addWidget(compressContentCheck);
+    performanceLayout->addWidget(performanceInfoLabel);
+    
     // 导入/导出设置
     QGroupBox *exportGroup = new QGroupBox(tr("导入/导出"));
     QVBoxLayout *exportLayout = new QVBoxLayout(exportGroup);
@@ -1769,6 +1837,7 @@ void SettingsDialog::setupDataStorageTab()
     // 添加所有组到主布局
     mainLayout->addWidget(locationGroup);
     mainLayout->addWidget(backupGroup);
+    mainLayout->addWidget(performanceGroup);
     mainLayout->addWidget(exportGroup);
     mainLayout->addWidget(statusGroup);
     mainLayout->addStretch();
@@ -2004,6 +2073,16 @@ void SettingsDialog::loadSettings()
     QString apiEndpoint = m_settings.value("AIService/APIEndpoint", "https://api.deepseek.com/chat/completions").toString();
     m_apiEndpointEdit->setText(apiEndpoint);
     
+    QCheckBox *streamResponsesCheck = m_aiServiceTab->findChild<QCheckBox*>("streamResponsesCheck");
+    if (streamResponsesCheck) {
+        streamResponsesCheck->setChecked(m_settings.value("AIService/StreamResponses", true).toBool());
+    }
+    
+    QCheckBox *responseCacheCheck = m_aiServiceTab->findChild<QCheckBox*>("responseCacheCheck");
+    if (responseCacheCheck) {
+        responseCacheCheck->setChecked(m_settings.value("AIService/CacheEnabled", true).toBool());
+    }
+    
     // 加载数据与存储设置
     QString notebookLocation = m_settings.value("DataStorage/NotebookLocation", 
         QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).toString();
@@ -2023,6 +2102,33 @@ void SettingsDialog::loadSettings()
     if (backupFrequencySpin) {
         backupFrequencySpin->setValue(backupFrequency);
     }
+    
+    // 加载数据库性能设置
+    DatabaseManager::StorageConfig storageConfig = DatabaseManager::StorageConfig::fromSettings();
+    QCheckBox *walModeCheck = m_dataStorageTab->findChild<QCheckBox*>("walModeCheck");
+    if (walModeCheck) {
+        walModeCheck->setChecked(storageConfig.walMode);
+    }
+    QComboBox *synchronousCombo = m_dataStorageTab->findChild<QComboBox*>("synchronousCombo");
+    if (synchronousCombo) {
+        synchronousCombo->setCurrentIndex(qMax(0, synchronousCombo->findData(storageConfig.synchronous)));
+    }
+    QSpinBox *cacheSizeSpin = m_dataStorageTab->findChild<QSpinBox*>("cacheSizeSpin");
+    if (cacheSizeSpin) {
+        cacheSizeSpin->setValue(storageConfig.cacheSizeMB);
+    }
+    QSpinBox *mmapSizeSpin = m_dataStorageTab->findChild<QSpinBox*>("mmapSizeSpin");
+    if (mmapSizeSpin) {
+        mmapSizeSpin->setValue(storageConfig.mmapSizeMB);
+    }
+    QCheckBox *tempStoreMemoryCheck = m_dataStorageTab->findChild<QCheckBox*>("tempStoreMemoryCheck");
+    if (tempStoreMemoryCheck) {
+        tempStoreMemoryCheck->setChecked(storageConfig.tempStoreMemory);
+    }
+    QCheckBox *compressContentCheck = m_dataStorageTab->findChild<QCheckBox*>("compressContentCheck");
+    if (compressContentCheck) {
+        compressContentCheck->setChecked(storageConfig.compressContent);
+    }
 }
 
 // 保存设置
@@ -2073,6 +2179,16 @@ void SettingsDialog::saveSettings()
     
     m_settings.setValue("AIService/APIEndpoint", m_apiEndpointEdit->text());
     
+    QCheckBox *streamResponsesCheck = m_aiServiceTab->findChild<QCheckBox*>("streamResponsesCheck");
+    if (streamResponsesCheck) {
+        m_settings.setValue("AIService/StreamResponses", streamResponsesCheck->isChecked());
+    }
+    
+    QCheckBox *responseCacheCheck = m_aiServiceTab->findChild<QCheckBox*>("responseCacheCheck");
+    if (responseCacheCheck) {
+        m_settings.setValue("AIService/CacheEnabled", responseCacheCheck->isChecked());
+    }
+    
     // 保存数据与存储设置
     QString notebookLocation = m_notebookLocationLabel->text();
     m_settings.setValue("DataStorage/NotebookLocation", notebookLocation);
@@ -2089,6 +2205,32 @@ void SettingsDialog::saveSettings()
         m_settings.setValue("DataStorage/BackupFrequency", backupFrequency);
     }
     
+    // 保存数据库性能设置（新建数据库连接时生效）
+    QCheckBox *walModeCheck = m_dataStorageTab->findChild<QCheckBox*>("walModeCheck");
+    if (walModeCheck) {
+        m_settings.setValue("DataStorage/WalMode", walModeCheck->isChecked());
+    }
+    QComboBox *synchronousCombo = m_dataStorageTab->findChild<QComboBox*>("synchronousCombo");
+    if (synchronousCombo) {
+        m_settings.setValue("DataStorage/Synchronous", synchronousCombo->currentData().toString());
+    }
+    QSpinBox *cacheSizeSpin = m_dataStorageTab->findChild<QSpinBox*>("cacheSizeSpin");
+    if (cacheSizeSpin) {
+        m_settings.setValue("DataStorage/CacheSizeMB", cacheSizeSpin->value());
+    }
+    QSpinBox *mmapSizeSpin = m_dataStorageTab->findChild<QSpinBox*>("mmapSizeSpin");
+    if (mmapSizeSpin) {
+        m_settings.setValue("DataStorage/MmapSizeMB", mmapSizeSpin->value());
+    }
+    QCheckBox *tempStoreMemoryCheck = m_dataStorageTab->findChild<QCheckBox*>("tempStoreMemoryCheck");
+    if (tempStoreMemoryCheck) {
+        m_settings.setValue("DataStorage/TempStoreMemory", tempStoreMemoryCheck->isChecked());
+    }
+    QCheckBox *compressContentCheck = m_dataStorageTab->findChild<QCheckBox*>("compressContentCheck");
+    if (compressContentCheck) {
+        m_settings.setValue("DataStorage/CompressContent", compressContentCheck->isChecked());
+    }
+    
     // 同步设置
     m_settings.sync();
     
@@ -2152,7 +2294,10 @@ bool SettingsDialog::backupData(const QString &backupPath)
         }
         qDebug() << "已创建备份子目录:" << backupSubDir;
         
-        // 关闭可能的数据库连接
+        // 先将WAL中的内容写回数据库文件，再关闭可能的数据库连接
+        if (hasSourceDb) {
+            DatabaseManager::checkpointDatabaseFile(sourceDbPath);
+        }
         QStringList connections = QSqlDatabase::connectionNames();
         for (const QString &connectionName : connections) {
             QSqlDatabase db = QSqlDatabase::database(connectionName);
@@ -2218,8 +2363,7 @@ bool SettingsDialog::backupData(const QString &backupPath)
                 qDebug() << "已创建备份媒体目录:" << destMediaPath;
             
                 // 复制媒体文件
-                QDir mediaDir(sourceMediaPath);
-            QStringList mediaFiles = mediaDir.entryList(QDir::Files);
+            QStringList mediaFiles = MediaStore::listFiles(sourceMediaPath);
                 int totalFiles = mediaFiles.size();
                 int successCount = 0;
             
@@ -2227,7 +2371,7 @@ bool SettingsDialog::backupData(const QString &backupPath)
                     QString sourceFilePath = sourceMediaPath + "/" + file;
                     QString destFilePath = destMediaPath + "/" + file;
                     
-                    if (QFile::copy(sourceFilePath, destFilePath)) {
+                    if (MediaStore::copyFile(sourceFilePath, destFilePath)) {
                         // 验证文件大小
                         QFileInfo sourceInfo(sourceFilePath);
                         QFileInfo destInfo(destFilePath);
@@ -2363,6 +2507,7 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
             if (QDir().mkpath(emergencyBackupPath)) {
                 // 备份现有数据库
                 if (QFile::exists(notebookLocation + "/notes.db")) {
+                    DatabaseManager::checkpointDatabaseFile(notebookLocation + "/notes.db");
                     if (QFile::copy(notebookLocation + "/notes.db", emergencyBackupPath + "/notes.db")) {
                         qDebug() << "已备份当前数据库文件";
                         emergencyBackupCreated = true;
@@ -2374,11 +2519,10 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
                 // 备份现有媒体文件
                 if (QDir(notebookLocation + "/notes_media").exists()) {
                     QDir().mkpath(emergencyBackupPath + "/notes_media");
-                    QDir mediaDir(notebookLocation + "/notes_media");
-                    QStringList mediaFiles = mediaDir.entryList(QDir::Files);
+                    QStringList mediaFiles = MediaStore::listFiles(notebookLocation + "/notes_media");
                     
                     for (const QString &file : mediaFiles) {
-                        if (QFile::copy(notebookLocation + "/notes_media/" + file, emergencyBackupPath + "/notes_media/" + file)) {
+                        if (MediaStore::copyFile(notebookLocation + "/notes_media/" + file, emergencyBackupPath + "/notes_media/" + file)) {
                             qDebug() << "已备份媒体文件:" << file;
                         } else {
                             qWarning() << "无法备份媒体文件:" << file;
@@ -2420,6 +2564,7 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
                 return false;
             }
         }
+        DatabaseManager::removeWalFiles(currentDbPath);
         
         // 复制备份数据库到当前位置
         dbRestored = QFile::copy(backupDbPath, currentDbPath);
@@ -2491,8 +2636,7 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
             
             if (mediaRestored) {
             // 清空当前媒体目录
-            QDir currentMediaDir(currentMediaPath);
-            QStringList currentMediaFiles = currentMediaDir.entryList(QDir::Files);
+            QStringList currentMediaFiles = MediaStore::listFiles(currentMediaPath);
             for (const QString &file : currentMediaFiles) {
                     QString filePath = currentMediaPath + "/" + file;
                     if (!QFile::remove(filePath)) {
@@ -2501,13 +2645,12 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
             }
             
             // 复制备份媒体文件
-            QDir backupMediaDir(backupMediaPath);
-            QStringList backupMediaFiles = backupMediaDir.entryList(QDir::Files);
+            QStringList backupMediaFiles = MediaStore::listFiles(backupMediaPath);
                 int totalFiles = backupMediaFiles.size();
                 int successCount = 0;
                 
             for (const QString &file : backupMediaFiles) {
-                    if (QFile::copy(backupMediaPath + "/" + file, currentMediaPath + "/" + file)) {
+                    if (MediaStore::copyFile(backupMediaPath + "/" + file, currentMediaPath + "/" + file)) {
                         // 验证文件完整性
                         QFileInfo sourceInfo(backupMediaPath + "/" + file);
                         QFileInfo destInfo(currentMediaPath + "/" + file);
@@ -2517,7 +2660,7 @@ bool SettingsDialog::restoreFromBackup(const QString &backupPath)
                             qWarning() << "恢复的媒体文件大小不匹配:" << file;
                             // 尝试再次复制
                             QFile::remove(currentMediaPath + "/" + file);
-                            if (QFile::copy(backupMediaPath + "/" + file, currentMediaPath + "/" + file)) {
+                            if (MediaStore::copyFile(backupMediaPath + "/" + file, currentMediaPath + "/" + file)) {
                                 successCount++;
                             }
                         }
@@ -2603,9 +2746,10 @@ bool SettingsDialog::exportNotes(const QString &exportPath, const QString &forma
             QSqlDatabase::removeDatabase(connectionName);
         }
         
-        // 打开数据库连接
+        // 打开数据库连接，以只读方式打开，WAL模式下可与编辑器的写入并发
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
         db.setDatabaseName(dbPath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
         
         if (!db.open()) {
             qCritical() << "Failed to open database for export:" << db.lastError().text();
@@ -3141,6 +3285,11 @@ bool SettingsDialog::importNotes(const QString &importPath)
                     }
                 }
                 
+                // 本应用的ContentBlocks表还有content_hash、content_data等列，正文始终在content_text中
+                if (allColumns.contains("content_text")) {
+                    contentColumn = "content_text";
+                }
+                
                 qDebug() << "ContentBlocks表所有列:" << allColumns.join(", ");
                 qDebug() << "ContentBlocks表必填列:" << requiredColumns.join(", ");
                 
@@ -3421,6 +3570,7 @@ bool SettingsDialog::executePendingNotebookMove()
         
         // 复制数据库文件到备份
         if (QFile::exists(oldPath + "/notes.db")) {
+            DatabaseManager::checkpointDatabaseFile(oldPath + "/notes.db");
             if (QFile::copy(oldPath + "/notes.db", backupPath + "/notes.db")) {
                 qDebug() << "已备份数据库文件";
                 backupCreated = true;
@@ -3433,9 +3583,9 @@ bool SettingsDialog::executePendingNotebookMove()
         QDir mediaDir(oldPath + "/notes_media");
         if (mediaDir.exists()) {
             QDir().mkpath(backupPath + "/notes_media");
-            QStringList mediaFiles = mediaDir.entryList(QDir::Files);
+            QStringList mediaFiles = MediaStore::listFiles(oldPath + "/notes_media");
             for (const QString &file : mediaFiles) {
-                if (QFile::copy(oldPath + "/notes_media/" + file, backupPath + "/notes_media/" + file)) {
+                if (MediaStore::copyFile(oldPath + "/notes_media/" + file, backupPath + "/notes_media/" + file)) {
                     qDebug() << "已备份媒体文件:" << file;
                 } else {
                     qWarning() << "无法备份媒体文件:" << file;
@@ -3456,6 +3606,10 @@ bool SettingsDialog::executePendingNotebookMove()
         if (QFile::exists(newDbPath)) {
             QFile::remove(newDbPath);
         }
+        DatabaseManager::removeWalFiles(newDbPath);
+        
+        // 复制前把WAL中的内容写回数据库文件
+        DatabaseManager::checkpointDatabaseFile(oldDbPath);
         
         // 复制文件
         if (QFile::copy(oldDbPath, newDbPath)) {
@@ -3467,6 +3621,7 @@ bool SettingsDialog::executePendingNotebookMove()
                 // 删除源文件
                 QFile file(oldDbPath);
                 if (file.remove()) {
+                    DatabaseManager::removeWalFiles(oldDbPath);
                     dbMoved = true;
                     qDebug() << "成功移动数据库文件";
                 } else {
@@ -3535,7 +3690,7 @@ bool SettingsDialog::executePendingNotebookMove()
     
     if (oldMediaDir.exists()) {
         qDebug() << "移动媒体文件从:" << oldMediaPath << "到:" << newMediaPath;
-        QStringList mediaFiles = oldMediaDir.entryList(QDir::Files);
+        QStringList mediaFiles = MediaStore::listFiles(oldMediaPath);
         int totalFiles = mediaFiles.size();
         int successfulMoves = 0;
         
@@ -3551,7 +3706,7 @@ bool SettingsDialog::executePendingNotebookMove()
                 }
             }
             
-            if (QFile::copy(oldFilePath, newFilePath)) {
+            if (MediaStore::copyFile(oldFilePath, newFilePath)) {
                 if (QFile::remove(oldFilePath)) {
                     successfulMoves++;
                     qDebug() << "成功移动媒体文件:" << file;
@@ -3570,8 +3725,8 @@ bool SettingsDialog::executePendingNotebookMove()
         mediaMoved = (successfulMoves > 0 || totalFiles == 0);
         
         // 尝试删除旧媒体目录（如果已经空了）
-        if (oldMediaDir.entryList(QDir::Files).isEmpty()) {
-            if (!oldMediaDir.rmdir(".")) {
+        if (MediaStore::listFiles(oldMediaPath).isEmpty()) {
+            if (!oldMediaDir.removeRecursively()) {
                 qWarning() << "无法删除旧的媒体目录，但它已经是空的";
             }
         }
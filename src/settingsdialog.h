@@ -112,6 +112,17 @@ signals:
      * @param enabled 是否启用
      */
     void autoPairChanged(bool enabled);
+    
+    /**
+     * 笔记导入完成信号，导入直接写入数据库，需由数据库管理器补写派生数据
+     */
+    void notesImported();
+    
+    /**
+     * 请求释放数据库文件信号，恢复备份或迁移笔记本重启前发出，
+     * 接收方需写完待保存的内容并关闭后台线程的数据库连接
+     */
+    void databaseReleaseRequested();
 
 protected:
     /**
@@ -9,6 +9,7 @@
  * Copyright (c) 2025 by Furdow, All Rights Reserved. 
  */
 #include "sidebarmanager.h"
+#include "notedocumentcodec.h"
 #include <QFileInfo>
 #include <QFile>
 #include <QTextStream>
@@ -24,6 +25,7 @@ SidebarManager::SidebarManager(QQuickWidget *quickWidget, QObject *parent)
     , m_quickWidget(quickWidget)
     , m_rootObject(nullptr)
     , m_dbManager(nullptr)
+    , m_treeModel(nullptr)
     , m_isDarkTheme(false)
     , m_globalFontFamily("Arial") // 默认字体
 {
@@ -36,6 +38,11 @@ SidebarManager::SidebarManager(QQuickWidget *quickWidget, QObject *parent)
         qWarning() << "数据库初始化失败!";
     }
     
+    // 文件树模型监听数据库的层级变化信号，只更新受影响的行
+    m_treeModel = new NoteTreeModel(m_dbManager, this);
+    // 展开文件夹后，接下来打开的多半是其中排在前面的笔记
+    connect(m_treeModel, &NoteTreeModel::notesRevealed, this, &SidebarManager::prefetchRequested);
+    
     // 读取当前的全局字体设置
     QSettings settings(QSettings::IniFormat, QSettings::UserScope, 
                       QApplication::organizationName(), QApplication::applicationName());
@@ -57,6 +64,7 @@ void SidebarManager::initialize()
     // 设置QML上下文属性
     QQmlContext *context = m_quickWidget->rootContext();
     context->setContextProperty("sidebarManager", this);
+    context->setContextProperty("noteTreeModel", m_treeModel);
     
     // 设置QML源文件
     m_quickWidget->setSource(QUrl("qrc:/qml/Sidebar.qml"));
@@ -129,15 +137,13 @@ QVariantList SidebarManager::getFolderContents(int folder_id, int parentLevel)
     int currentLevel = parentLevel + 1;
     qDebug() << "--- [SidebarManager] getFolderContents() CALLED for ID:" << folder_id << " ParentLevel:" << parentLevel;
     
-    QList<FolderInfo> allFolders = m_dbManager->getAllFolders();
-    for (const FolderInfo &childFolder : allFolders) {
-        if (childFolder.parent_id == folder_id) {
-            result.append(folderToQML(childFolder, currentLevel, false)); 
-        }
+    // 一次查询取出直接子文件夹和笔记
+    FolderSubtree children = m_dbManager->getFolderSubtree(folder_id, 1);
+    for (const FolderInfo &childFolder : children.folders) {
+        result.append(folderToQML(childFolder, currentLevel, false)); 
     }
     
-    QList<NoteInfo> notes = m_dbManager->getNotesInFolder(folder_id);
-    for (const NoteInfo &note : notes) {
+    for (const NoteInfo &note : children.notes) {
         result.append(noteToQML(note, currentLevel));
     }
     
@@ -150,24 +156,12 @@ QVariantList SidebarManager::getAllNotes(int folder_id)
     QVariantList result;
     qDebug() << "--- [SidebarManager] getAllNotes() CALLED for ID:" << folder_id;
     
-    // 获取指定文件夹下的笔记
-    QList<NoteInfo> notes = m_dbManager->getNotesInFolder(folder_id);
-    for (const NoteInfo &note : notes) {
+    // 一次递归查询获取整个子树中的笔记
+    FolderSubtree subtree = m_dbManager->getFolderSubtree(folder_id);
+    for (const NoteInfo &note : subtree.notes) {
         result.append(noteToQML(note, 0)); // 使用0作为级别，因为我们只关心笔记本身
     }
     
-    // 递归获取所有子文件夹中的笔记
-    QList<FolderInfo> subFolders = m_dbManager->getAllFolders();
-    for (const FolderInfo &folder : subFolders) {
-        if (folder.parent_id == folder_id) {
-            // 递归调用获取子文件夹的笔记
-            QVariantList subNotes = getAllNotes(folder.id);
-            for (const QVariant &subNote : subNotes) {
-                result.append(subNote);
-            }
-        }
-    }
-    
     return result;
 }
 
@@ -202,10 +196,19 @@ void SidebarManager::onNoteSelected(const QString &path, const QString &type)
         
         if (found) {
             // 获取笔记内容块
-            QList<ContentBlock> blocks = m_dbManager->getNoteContent(noteId);
+            bool ok = false;
+            QList<ContentBlock> blocks = m_dbManager->getNoteContent(noteId, &ok);
+            if (!ok) {
+                // 仍然打开笔记，由编辑器以只读方式显示读取失败
+                qWarning() << "笔记内容已损坏，无法读取:" << noteId;
+            }
             
-            // 简单处理：将所有内容块转换为文本内容
+            // 简单处理：将所有内容块转换为文本内容，二进制格式先还原为HTML
             QString content;
+            if (NoteDocumentCodec::isEncoded(blocks)) {
+                content = NoteDocumentCodec::toHtml(blocks);
+                blocks.clear();
+            }
             for (const ContentBlock &block : blocks) {
                 if (block.block_type == "text") {
                     content += block.content_text + "\n\n";
@@ -251,11 +254,8 @@ void SidebarManager::onCreateNote(const QString &parentPath, const QString &note
         
         blocks.append(block);
         
-        // 保存内容块
+        // 保存内容块，文件树模型通过noteAdded信号更新
         m_dbManager->saveNoteContent(noteId, blocks);
-        
-        // 刷新列表
-        refreshNotesList();
     } else {
         QMessageBox::warning(nullptr, tr("错误"), tr("创建笔记失败!"));
     }
@@ -275,11 +275,8 @@ void SidebarManager::onCreateFolder(const QString &parentPath, const QString &fo
         return;
     }
     
-    // 创建文件夹
-    if (m_dbManager->createFolder(folderName, parentId) > 0) {
-        // 刷新列表
-        refreshNotesList();
-    } else {
+    // 创建文件夹，文件树模型通过folderAdded信号更新
+    if (m_dbManager->createFolder(folderName, parentId) <= 0) {
         QMessageBox::warning(nullptr, tr("错误"), tr("创建文件夹失败!"));
     }
 }
@@ -298,16 +295,12 @@ void SidebarManager::onRenameItem(const QString &path, const QString &newName)
     // 判断类型
     if (path.contains("folder_")) {
         // 重命名文件夹
-        if (m_dbManager->renameFolder(itemId, newName)) {
-            refreshNotesList();
-        } else {
+        if (!m_dbManager->renameFolder(itemId, newName)) {
             QMessageBox::warning(nullptr, tr("错误"), tr("重命名文件夹失败!"));
         }
     } else if (path.contains("note_")) {
         // 重命名笔记
-        if (m_dbManager->renameNote(itemId, newName)) {
-            refreshNotesList();
-        } else {
+        if (!m_dbManager->renameNote(itemId, newName)) {
             QMessageBox::warning(nullptr, tr("错误"), tr("重命名笔记失败!"));
         }
     }
@@ -332,9 +325,7 @@ void SidebarManager::onDeleteItem(const QString &path)
         success = m_dbManager->deleteNote(itemId);
     }
     
-    if (success) {
-        refreshNotesList();
-    } else {
+    if (!success) {
         QMessageBox::warning(nullptr, tr("错误"), tr("删除操作失败!"));
     }
 }
@@ -524,52 +515,19 @@ bool SidebarManager::deleteItem(const QString &path)
     // 判断类型
     if (path.contains("folder_")) {
         // 删除文件夹
-        // 先检查文件夹是否存在
-        bool folderExists = false;
-        QList<FolderInfo> allFolders = m_dbManager->getAllFolders();
-        for (const FolderInfo &folder : allFolders) {
-            if (folder.id == itemId) {
-                folderExists = true;
-                break;
-            }
-        }
-        
-        if (!folderExists) {
+        // 先检查文件夹是否存在，同时获取整个子树用于日志
+        FolderSubtree subtree = m_dbManager->getFolderSubtree(itemId);
+        if (!subtree.found) {
             qWarning() << "要删除的文件夹不存在:" << itemId;
             return false;
         }
         
-        // 先检查文件夹下是否有子项目
-        QList<FolderInfo> subFolders;
-        for (const FolderInfo &folder : allFolders) {
-            if (folder.parent_id == itemId) {
-                subFolders.append(folder);
-            }
-        }
-        
-        QList<NoteInfo> notes = m_dbManager->getNotesInFolder(itemId);
-        
-        // 如果有子项，先删除子项
-        if (!subFolders.isEmpty() || !notes.isEmpty()) {
-            qDebug() << "文件夹" << itemId << "下有子项，先递归删除子项";
-            
-            // 先删除所有笔记
-            for (const NoteInfo &note : notes) {
-                if (!m_dbManager->deleteNote(note.id)) {
-                    qWarning() << "删除笔记失败:" << note.id;
-                }
-            }
-            
-            // 再递归删除子文件夹
-            for (const FolderInfo &folder : subFolders) {
-                QString subPath = QString("/folder_%1").arg(folder.id);
-                if (!deleteItem(subPath)) {
-                    qWarning() << "删除子文件夹失败:" << folder.id;
-                }
-            }
+        if (!subtree.folders.isEmpty() || !subtree.notes.isEmpty()) {
+            qDebug() << "文件夹" << itemId << "下有" << subtree.folders.size() << "个子文件夹,"
+                     << subtree.notes.size() << "个笔记，将一并删除";
         }
         
-        // 尝试删除文件夹
+        // 删除文件夹及其子树（数据库在单个事务中完成）
         success = m_dbManager->deleteFolder(itemId);
         if (!success) {
             qWarning() << "删除文件夹错误: 提交事务失败";
@@ -578,7 +536,6 @@ bool SidebarManager::deleteItem(const QString &path)
                 qDebug() << "重试删除文件夹:" << itemId;
                 if (m_dbManager->deleteFolder(itemId)) {
                     qDebug() << "重试删除文件夹成功:" << itemId;
-                    refreshNotesList();
                 }
             });
         }
@@ -592,7 +549,6 @@ bool SidebarManager::deleteItem(const QString &path)
                 qDebug() << "重试删除笔记:" << itemId;
                 if (m_dbManager->deleteNote(itemId)) {
                     qDebug() << "重试删除笔记成功:" << itemId;
-                    refreshNotesList();
                 }
             });
         }
@@ -600,9 +556,7 @@ bool SidebarManager::deleteItem(const QString &path)
     
     if (success) {
         qDebug() << "[SidebarManager] Delete Success for:" << path;
-        // *** 保留信号发射，因为删除操作确实需要全局刷新 ***
-        emit folderStructureChanged(); 
-        // refreshNotesList(); // refreshNotesList 现在只是发射信号，所以直接发射即可
+        // 文件树模型通过folderRemoved/noteRemoved信号移除对应的行
         return true;
     } else {
         qWarning() << "[SidebarManager] Delete Failed for:" << path;
@@ -633,9 +587,7 @@ bool SidebarManager::renameItem(const QString &path, const QString &newName)
     
     if (success) {
         qDebug() << "[SidebarManager] Rename Success for:" << path;
-         // *** 保留信号发射，因为重命名也需要全局刷新 ***
-        emit folderStructureChanged();
-        // refreshNotesList(); // refreshNotesList 现在只是发射信号，所以直接发射即可
+        // 文件树模型通过folderRenamed/noteChanged信号更新对应的行
         return true;
     } else {
         qWarning() << "[SidebarManager] Rename Failed for:" << path;
@@ -643,6 +595,30 @@ bool SidebarManager::renameItem(const QString &path, const QString &newName)
     }
 }
 
+// 供QML调用的AI批量处理方法，由主窗口确认后执行
+void SidebarManager::requestAiBatch(const QString &folderPath, const QString &operation)
+{
+    qDebug() << "--- [SidebarManager] requestAiBatch() CALLED for Path:" << folderPath << " Operation:" << operation;
+    if (folderPath != "/root" && !folderPath.contains("folder_")) {
+        qWarning() << "AI批量处理只支持文件夹:" << folderPath;
+        return;
+    }
+    
+    int folderId = extractIdFromPath(folderPath);
+    FolderSubtree subtree = m_dbManager->getFolderSubtree(folderId);
+    if (!subtree.found) {
+        qWarning() << "要处理的文件夹不存在:" << folderId;
+        return;
+    }
+    
+    QList<int> noteIds;
+    for (const NoteInfo &note : subtree.notes) {
+        noteIds.append(note.id);
+    }
+    
+    emit aiBatchRequested(operation, noteIds, m_dbManager->getFolderById(folderId).name);
+}
+
 // 恢复侧边栏到默认视图
 void SidebarManager::resetToDefaultView()
 {
@@ -24,6 +24,7 @@
 #include <QVariantList>
 #include <QVariantMap>
 #include "databasemanager.h" // 添加数据库管理器头文件
+#include "notetreemodel.h"
 
 class SidebarManager : public QObject
 {
@@ -66,9 +67,15 @@ public:
     Q_INVOKABLE int createNote(const QString &parentPath, const QString &noteName);
     Q_INVOKABLE int createFolder(const QString &parentPath, const QString &folderName);
     
+    // 对文件夹(包括子文件夹)中的所有笔记执行AI批量处理，operation为summarize/tag/fix
+    Q_INVOKABLE void requestAiBatch(const QString &folderPath, const QString &operation);
+    
     // 获取数据库管理器
     DatabaseManager* getDatabaseManager() const { return m_dbManager; }
     
+    // 获取文件树模型
+    NoteTreeModel* getTreeModel() const { return m_treeModel; }
+    
     // 获取当前主题状态
     bool isDarkTheme() const { return m_isDarkTheme; }
     
@@ -106,16 +113,19 @@ signals:
     // 向QML发送信号
     void noteOpened(const QString &path, const QString &content);
     void aiMessageReceived(const QString &message);
-    void folderStructureChanged(); // 文件夹结构变化信号
+    void folderStructureChanged(); // 文件夹结构变化信号，QML整体重建列表
     void searchButtonClicked(); // 搜索按钮点击信号
     void themeChanged(); // 主题改变的信号
     void fontChanged(); // 字体改变的信号
+    void prefetchRequested(const QList<int> &noteIds); // 请求预读接下来可能打开的笔记
+    void aiBatchRequested(const QString &operation, const QList<int> &noteIds, const QString &sourceName); // 请求对一组笔记执行AI批量处理
     
 private:
     QQuickWidget *m_quickWidget; // QQuickWidget实例的引用
     QQuickItem *m_rootObject;    // QML根对象
     QString m_rootPath;          // 笔记根目录路径
     DatabaseManager *m_dbManager; // 数据库管理器
+    NoteTreeModel *m_treeModel;  // 文件树模型，以noteTreeModel暴露给QML
     bool m_isDarkTheme = false;  // 当前主题状态，默认为浅色主题
     QString m_globalFontFamily = "Arial"; // 当前全局字体，默认为Arial
     
@@ -0,0 +1,224 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-12 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-12 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\streamingbenchmark.cpp
+ * @Description: 用本地回放服务器测量流式回复的首个片段耗时实现
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#include "streamingbenchmark.h"
+#include "DeepSeekService.h"
+
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+
+const int FRAGMENT_INTERVAL_MS = 50;   // 模拟生成速度：每50毫秒一个片段
+const int MEASURE_TIMEOUT_MS = 30000;  // 单次测量的最长等待时间
+
+// 满足DeepSeekService格式检查的占位密钥，只发给本地服务器
+const QString BENCHMARK_API_KEY = "sk-streaming-benchmark-key";
+
+QByteArray eventData(const QString &fragment)
+{
+    QJsonObject delta;
+    delta["content"] = fragment;
+    QJsonObject choice;
+    choice["delta"] = delta;
+    QJsonObject event;
+    event["choices"] = QJsonArray{choice};
+    return QJsonDocument(event).toJson(QJsonDocument::Compact);
+}
+
+QByteArray completionBody(const QString &text)
+{
+    QJsonObject message;
+    message["role"] = "assistant";
+    message["content"] = text;
+    QJsonObject choice;
+    choice["message"] = message;
+    QJsonObject response;
+    response["choices"] = QJsonArray{choice};
+    return QJsonDocument(response).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+SseReplayServer::SseReplayServer(const QStringList &fragments, int intervalMs, QObject *parent)
+    : QTcpServer(parent), m_fragments(fragments), m_intervalMs(intervalMs)
+{
+    connect(this, &QTcpServer::newConnection, this, &SseReplayServer::onNewConnection);
+}
+
+void SseReplayServer::onNewConnection()
+{
+    while (QTcpSocket *socket = nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            // 读完请求头和Content-Length指定的请求体后再回复
+            QByteArray buffer = socket->property("requestBuffer").toByteArray() + socket->readAll();
+            socket->setProperty("requestBuffer", buffer);
+
+            int headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0 || socket->property("handled").toBool()) {
+                return;
+            }
+            int contentLength = 0;
+            const QList<QByteArray> headerLines = buffer.left(headerEnd).split('\n');
+            for (const QByteArray &line : headerLines) {
+                if (line.toLower().startsWith("content-length:")) {
+                    contentLength = line.mid(15).trimmed().toInt();
+                }
+            }
+            if (buffer.size() < headerEnd + 4 + contentLength) {
+                return;
+            }
+
+            socket->setProperty("handled", true);
+            QJsonObject payload = QJsonDocument::fromJson(buffer.mid(headerEnd + 4, contentLength)).object();
+            handleRequest(socket, payload.value("stream").toBool());
+        });
+    }
+}
+
+void SseReplayServer::handleRequest(QTcpSocket *socket, bool stream)
+{
+    if (stream) {
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/event-stream\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Connection: close\r\n\r\n");
+        sendNextEvent(socket, 0);
+        return;
+    }
+
+    // 非流式：等全部片段生成完毕后一次返回
+    QTimer::singleShot(m_intervalMs * m_fragments.size(), socket, [this, socket]() {
+        QByteArray body = completionBody(m_fragments.join(QString()));
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: application/json\r\n"
+                      "Connection: close\r\n"
+                      "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n");
+        socket->write(body);
+        socket->disconnectFromHost();
+    });
+}
+
+void SseReplayServer::sendNextEvent(QTcpSocket *socket, int index)
+{
+    QTimer::singleShot(m_intervalMs, socket, [this, socket, index]() {
+        if (index < m_fragments.size()) {
+            socket->write("data: " + eventData(m_fragments.at(index)) + "\n\n");
+            sendNextEvent(socket, index + 1);
+        } else {
+            socket->write("data: [DONE]\n\n");
+            socket->disconnectFromHost();
+        }
+    });
+}
+
+StreamingBenchmark::Result StreamingBenchmark::measure(const QString &endpoint, bool streaming)
+{
+    Result result;
+
+    DeepSeekService service;
+    service.setApiKey(BENCHMARK_API_KEY);
+    service.setApiEndpoint(endpoint);
+    service.setResponseCacheEnabled(false);
+    service.setStreamingEnabled(streaming);
+
+    QEventLoop loop;
+    QElapsedTimer timer;
+    int requestId = 0;
+
+    QObject::connect(&service, &IAiService::partialTextReceived, &loop,
+                     [&](const QString &, const QString &textDelta) {
+        if (result.firstFragmentMs < 0) {
+            result.firstFragmentMs = timer.elapsed();
+        }
+        ++result.fragments;
+        result.text += textDelta;
+    });
+    QObject::connect(&service, &IAiService::requestFinished, &loop,
+                     [&](int id, const QString &generatedText) {
+        if (id != requestId) {
+            return;
+        }
+        result.totalMs = timer.elapsed();
+        if (result.firstFragmentMs < 0) {
+            result.firstFragmentMs = result.totalMs;
+        }
+        // 流式回复逐段拼接的内容应与完成信号携带的完整文本一致
+        result.success = !streaming || result.text == generatedText;
+        if (!result.success) {
+            result.error = "流式片段拼接结果与完整回复不一致";
+        }
+        result.text = generatedText;
+        loop.quit();
+    });
+    QObject::connect(&service, &IAiService::requestFailed, &loop,
+                     [&](int id, const QString &errorMessage) {
+        if (id == requestId) {
+            result.error = errorMessage;
+            loop.quit();
+        }
+    });
+    QTimer::singleShot(MEASURE_TIMEOUT_MS, &loop, [&]() {
+        result.error = "等待回复超时";
+        loop.quit();
+    });
+
+    timer.start();
+    requestId = service.generateGenericText("streaming benchmark");
+    if (requestId <= 0) {
+        result.error = "请求未能发出";
+        return result;
+    }
+    loop.exec();
+    return result;
+}
+
+int StreamingBenchmark::run()
+{
+    QTextStream out(stdout);
+
+    QStringList fragments;
+    for (int i = 0; i < 40; ++i) {
+        fragments << QString("第%1段回复内容。").arg(i + 1);
+    }
+
+    SseReplayServer server(fragments, FRAGMENT_INTERVAL_MS);
+    if (!server.listen(QHostAddress::LocalHost)) {
+        out << "无法启动本地回放服务器: " << server.errorString() << Qt::endl;
+        return 1;
+    }
+    QString endpoint = QString("http://127.0.0.1:%1/chat/completions").arg(server.serverPort());
+
+    out << "片段数: " << fragments.size() << "，片段间隔: " << FRAGMENT_INTERVAL_MS << "毫秒" << Qt::endl;
+
+    bool ok = true;
+    for (bool streaming : {true, false}) {
+        Result result = measure(endpoint, streaming);
+        out << (streaming ? "流式" : "非流式") << " - ";
+        if (!result.success) {
+            out << "失败: " << result.error << Qt::endl;
+            ok = false;
+            continue;
+        }
+        out << "首个片段(ms): " << result.firstFragmentMs
+            << "，完整回复(ms): " << result.totalMs
+            << "，片段数: " << result.fragments << Qt::endl;
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,76 @@
+/*
+ * @Author: Furdow wang22338014@gmail.com
+ * @Date: 2025-06-12 10:00:00
+ * @LastEditors: Furdow wang22338014@gmail.com
+ * @LastEditTime: 2025-06-12 10:00:00
+ * @FilePath: \IntelliMedia_Notes\src\streamingbenchmark.h
+ * @Description: 用本地回放服务器测量流式回复的首个片段耗时
+ *
+ * Copyright (c) 2025 by Furdow, All Rights Reserved.
+ */
+#ifndef STREAMINGBENCHMARK_H
+#define STREAMINGBENCHMARK_H
+
+#include <QTcpServer>
+#include <QStringList>
+
+class QTcpSocket;
+
+/**
+ * @brief 模拟聊天补全接口的本地服务器
+ *
+ * 请求体中带"stream": true时按固定间隔逐段发送server-sent events，
+ * 否则等到全部片段"生成"完毕后一次返回完整的JSON，两种方式的总耗时相同。
+ */
+class SseReplayServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param fragments 依次返回的文本片段
+     * @param intervalMs 相邻两个片段之间的间隔(毫秒)
+     * @param parent 父对象
+     */
+    SseReplayServer(const QStringList &fragments, int intervalMs, QObject *parent = nullptr);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QStringList m_fragments;
+    int m_intervalMs;
+
+    void handleRequest(QTcpSocket *socket, bool stream);
+    void sendNextEvent(QTcpSocket *socket, int index);
+};
+
+/**
+ * @brief 流式回复基准测试，通过--bench-streaming启动
+ *
+ * 同一段回复分别以流式和非流式方式经DeepSeekService请求本地回放服务器，
+ * 输出收到首个片段和收到完整回复的耗时，不访问真实接口，也不读写回复缓存。
+ */
+class StreamingBenchmark
+{
+public:
+    struct Result {
+        bool success = false;
+        qint64 firstFragmentMs = -1; // 首个片段到达的耗时，非流式时等于完整回复耗时
+        qint64 totalMs = -1;         // 完整回复到达的耗时
+        int fragments = 0;           // 收到的片段数
+        QString text;                // 完整回复
+        QString error;               // 失败原因
+    };
+
+    /**
+     * @brief 运行基准测试并把结果输出到标准输出
+     * @return int 进程退出码，0表示两种方式都成功且流式回复的内容与完整回复一致
+     */
+    static int run();
+
+private:
+    static Result measure(const QString &endpoint, bool streaming);
+};
+
+#endif // STREAMINGBENCHMARK_H
@@ -78,8 +78,19 @@
 #include <QKeyEvent>
 #include <QSvgRenderer>
 #include <QSettings>
+#include <climits>
+#include <QThread>
+#include <QSet>
+#include <QProgressBar>
+#include <QElapsedTimer>
+#include <QTextDocumentFragment>
 #include "databasemanager.h"
 #include "settingsdialog.h"
+#include "autosavewriter.h"
+#include "mediastore.h"
+#include "imagerenditioncache.h"
+#include "notedocumentcodec.h"
+#include "noteloader.h"
 
 // 新增常量定义
 const int HANDLE_SIZE = 8; // 手柄大小
@@ -123,6 +134,9 @@ NoteTextEdit::NoteTextEdit(QWidget *parent)
     setMouseTracking(true);
     installEventFilter(this);
     
+    // 图片解码只占用部分核心，避免影响界面线程和自动保存
+    m_imageDecodePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+    
     // 设置文档边距
     document()->setDocumentMargin(20);
     
@@ -156,6 +170,12 @@ NoteTextEdit::NoteTextEdit(QWidget *parent)
     connect(this, &QTextEdit::textChanged, this, &NoteTextEdit::handleTextChangedForAutoPair);
 }
 
+NoteTextEdit::~NoteTextEdit()
+{
+    // 丢弃尚未开始的解码任务，线程池析构时只需等待正在执行的任务
+    m_imageDecodePool.clear();
+}
+
 void NoteTextEdit::mousePressEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton) {
@@ -645,6 +665,7 @@ void NoteTextEdit::mouseMoveEvent(QMouseEvent *event)
 void NoteTextEdit::paintEvent(QPaintEvent *event)
 {
     QTextEdit::paintEvent(event); // 先调用基类绘制文本和图片
+    scheduleImageScan(); // 视口大小或内容变化后检查需要解码的图片
     // 滚动或内容移动时更新选中框位置，确保手柄与图片同步 (调用时机可能需要斟酌)
     // updateSelectionIndicator(); // 暂时注释掉，避免在paintEvent中意外修改状态
 
@@ -1066,22 +1087,21 @@ bool NoteTextEdit::insertImageFromFile(const QString &filePath, int maxWidth)
 {
     qDebug() << "insertImageFromFile - 开始处理图片:" << filePath << "最大宽度:" << maxWidth;
     
-    QImageReader reader(filePath);
-    QImage image = reader.read();
+    // 只读取文件头获取尺寸，像素在生成副本时才解码
+    QSize originalSize = ImageRenditionCache::originalSize(filePath);
     
-    if (image.isNull()) {
-        qDebug() << "insertImageFromFile - 无法加载图片:" << filePath << reader.errorString();
+    if (!originalSize.isValid()) {
+        qDebug() << "insertImageFromFile - 无法加载图片:" << filePath;
         return false;
     }
     
-    qDebug() << "insertImageFromFile - 成功加载图片，原始尺寸:" << image.width() << "x" << image.height();
+    qDebug() << "insertImageFromFile - 成功读取图片，原始尺寸:" << originalSize;
     
     // 调整图片大小，如果超过最大宽度
-    QSize originalSize = image.size();
-    if (maxWidth > 0 && image.width() > maxWidth) {
-        qDebug() << "insertImageFromFile - 调整图片尺寸从" << originalSize << "到最大宽度" << maxWidth;
-        image = image.scaledToWidth(maxWidth, Qt::SmoothTransformation);
-        qDebug() << "insertImageFromFile - 调整后尺寸:" << image.size();
+    QSize displaySize = originalSize;
+    if (maxWidth > 0 && originalSize.width() > maxWidth) {
+        displaySize = originalSize.scaled(maxWidth, INT_MAX, Qt::KeepAspectRatio);
+        qDebug() << "insertImageFromFile - 调整图片尺寸从" << originalSize << "到" << displaySize;
     }
     
     // 保存图片到媒体文件夹
@@ -1094,16 +1114,19 @@ bool NoteTextEdit::insertImageFromFile(const QString &filePath, int maxWidth)
     
     qDebug() << "insertImageFromFile - 图片已保存到:" << savedImagePath;
     
+    // 导入时生成显示副本，之后打开笔记不再解码原图
+    ImageRenditionCache::generate(savedImagePath);
+    
     // 插入图片到文档
     QTextCursor cursor = textCursor();
     QTextDocument *doc = document();
     
     QTextImageFormat imageFormat;
     imageFormat.setName(savedImagePath);
-    imageFormat.setWidth(image.width());
-    imageFormat.setHeight(image.height());
+    imageFormat.setWidth(displaySize.width());
+    imageFormat.setHeight(displaySize.height());
     
-    qDebug() << "insertImageFromFile - 将图片插入文档，尺寸:" << image.width() << "x" << image.height();
+    qDebug() << "insertImageFromFile - 将图片插入文档，尺寸:" << displaySize.width() << "x" << displaySize.height();
     
     cursor.insertImage(imageFormat);
     setTextCursor(cursor); // 更新编辑器光标
@@ -1118,40 +1141,160 @@ bool NoteTextEdit::insertImageFromFile(const QString &filePath, int maxWidth)
 
 QString NoteTextEdit::saveImageToMediaFolder(const QString &sourceFilePath)
 {
-    // 使用应用程序数据位置而不是文档位置，与数据库管理器保持一致
-    QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString mediaFolderPath = appDataPath + "/notes_media";
+    // 与数据库管理器使用同一个媒体文件夹，引用计数和清理才能覆盖编辑器插入的图片
+    QString mediaFolderPath = SettingsDialog::getNotebookPath() + "/notes_media";
     
     // 添加调试日志
     qDebug() << "保存图片 - 源文件路径:" << sourceFilePath;
     qDebug() << "保存图片 - 媒体文件夹路径:" << mediaFolderPath;
     
-    QDir mediaDir(mediaFolderPath);
+    // 按内容哈希存放，同一张图片多次插入只保存一份，引用计数在笔记保存时更新
+    QString relativePath = MediaStore::store(mediaFolderPath, sourceFilePath);
+    if (relativePath.isEmpty()) {
+        qDebug() << "无法保存图片到媒体文件夹:" << mediaFolderPath;
+        return QString();
+    }
     
-    if (!mediaDir.exists()) {
-        if (!mediaDir.mkpath(".")) {
-            qDebug() << "无法创建媒体文件夹:" << mediaFolderPath;
-            return QString();
+    QString targetFilePath = mediaFolderPath + "/" + relativePath;
+    qDebug() << "保存图片 - 成功保存图片到:" << targetFilePath;
+    return targetFilePath;
+}
+
+QVariant NoteTextEdit::loadResource(int type, const QUrl &name)
+{
+    if (type == QTextDocument::ImageResource) {
+        QString path = ImageRenditionCache::resolveImagePath(name.isLocalFile() ? name.toLocalFile() : name.toString());
+        if (!path.isEmpty()) {
+            // 只读取文件头确定尺寸，像素在图片接近视口时由后台线程解码
+            QSize size = ImageRenditionCache::originalSize(path);
+            if (size.isValid()) {
+                if (size.width() > ImageRenditionCache::DISPLAY_WIDTH) {
+                    size = size.scaled(ImageRenditionCache::DISPLAY_WIDTH, INT_MAX, Qt::KeepAspectRatio);
+                }
+                // 文档重新请求资源，说明之前替换的图片已随旧内容失效
+                m_images.remove(name);
+                scheduleImageScan();
+                return imagePlaceholder(size);
+            }
         }
     }
     
-    // 为图片创建唯一的文件名
-    QFileInfo fileInfo(sourceFilePath);
-    QString extension = fileInfo.suffix().toLower();
-    QString uniqueFileName = QUuid::createUuid().toString(QUuid::WithoutBraces) + "." + extension;
-    QString targetFilePath = mediaFolderPath + "/" + uniqueFileName;
+    return QTextEdit::loadResource(type, name);
+}
+
+QImage NoteTextEdit::imagePlaceholder(const QSize &size)
+{
+    // 单色图每像素只占1位，与解码后的副本尺寸相同，排版不会在解码后跳动
+    QImage placeholder(size, QImage::Format_Mono);
+    placeholder.setColorCount(2);
+    placeholder.setColor(0, qRgba(128, 128, 128, 40));
+    placeholder.setColor(1, qRgba(128, 128, 128, 40));
+    placeholder.fill(0);
+    return placeholder;
+}
+
+void NoteTextEdit::scheduleImageScan()
+{
+    if (m_imageScanScheduled) {
+        return;
+    }
+    m_imageScanScheduled = true;
+    QTimer::singleShot(0, this, &NoteTextEdit::updateVisibleImages);
+}
+
+void NoteTextEdit::switchDocument(QTextDocument *document)
+{
+    // 缓存中的文档只保留占位图，切换回来后再按视口重新解码
+    for (auto it = m_images.constBegin(); it != m_images.constEnd(); ++it) {
+        if (it.value().decoded) {
+            this->document()->addResource(QTextDocument::ImageResource, it.key(), QVariant());
+        }
+    }
+    // 正在解码的图片完成时找不到记录，结果直接丢弃
+    m_images.clear();
+    m_selectedImageCursor = QTextCursor();
+    m_selectedImageRect = QRect();
     
-    // 添加调试日志
-    qDebug() << "保存图片 - 目标文件路径:" << targetFilePath;
+    setDocument(document);
+    scheduleImageScan();
+}
+
+void NoteTextEdit::updateVisibleImages()
+{
+    m_imageScanScheduled = false;
+    
+    // 视口上下各一屏内的图片需要解码，三屏以外已解码的图片释放
+    const int height = viewport()->height();
+    const int width = viewport()->width();
+    const int decodeStart = cursorForPosition(QPoint(0, -height)).position();
+    const int decodeEnd = cursorForPosition(QPoint(width, 2 * height)).position();
+    const int keepStart = cursorForPosition(QPoint(0, -3 * height)).position();
+    const int keepEnd = cursorForPosition(QPoint(width, 4 * height)).position();
+    
+    QSet<QUrl> nearbyImages;
+    for (QTextBlock block = document()->findBlock(keepStart); block.isValid() && block.position() <= keepEnd; block = block.next()) {
+        for (QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it) {
+            QTextFragment fragment = it.fragment();
+            if (!fragment.isValid() || !fragment.charFormat().isImageFormat()) {
+                continue;
+            }
+            
+            const QUrl url(fragment.charFormat().toImageFormat().name());
+            nearbyImages.insert(url);
+            
+            const int position = fragment.position();
+            if (position < decodeStart || position > decodeEnd || m_images.contains(url)) {
+                continue;
+            }
+            
+            QString path = ImageRenditionCache::resolveImagePath(url.isLocalFile() ? url.toLocalFile() : url.toString());
+            if (!path.isEmpty()) {
+                decodeImage(url, path);
+            }
+        }
+    }
     
-    // 复制原始图片到媒体文件夹
-    if (!QFile::copy(sourceFilePath, targetFilePath)) {
-        qDebug() << "无法复制图片到:" << targetFilePath;
-        return QString();
+    // 远离视口的图片清除替换的资源，文档重新使用已缓存的占位图
+    for (auto it = m_images.begin(); it != m_images.end();) {
+        if (nearbyImages.contains(it.key()) || it.value().pending) {
+            ++it;
+            continue;
+        }
+        if (it.value().decoded) {
+            document()->addResource(QTextDocument::ImageResource, it.key(), QVariant());
+        }
+        it = m_images.erase(it);
     }
+}
+
+void NoteTextEdit::decodeImage(const QUrl &url, const QString &path)
+{
+    ImageEntry &entry = m_images[url];
+    entry.path = path;
+    entry.pending = true;
     
-    qDebug() << "保存图片 - 成功保存图片到:" << targetFilePath;
-    return targetFilePath;
+    m_imageDecodePool.start([this, url, path]() {
+        QImage image = ImageRenditionCache::load(path, ImageRenditionCache::DISPLAY_WIDTH);
+        
+        // 回到界面线程替换文档资源
+        QMetaObject::invokeMethod(this, [this, url, image]() {
+            auto it = m_images.find(url);
+            if (it == m_images.end() || !it.value().pending) {
+                return; // 解码期间文档已重新加载
+            }
+            it.value().pending = false;
+            if (image.isNull()) {
+                return;
+            }
+            
+            document()->addResource(QTextDocument::ImageResource, url, image);
+            it.value().decoded = true;
+            viewport()->update();
+            
+            // 解码期间可能已经滚动到别处
+            scheduleImageScan();
+        }, Qt::QueuedConnection);
+    });
 }
 
 QString NoteTextEdit::getImageAtCursor()
@@ -1417,6 +1560,7 @@ void NoteTextEdit::scrollContentsBy(int dx, int dy)
     QTextEdit::scrollContentsBy(dx, dy);
     updateSelectionIndicator();
     viewport()->update();
+    scheduleImageScan();
 }
 
 //=======================================================================================
@@ -1887,6 +2031,23 @@ TextEditorManager::TextEditorManager(QWidget *parent)
     // 创建文本编辑器
     m_textEdit = new NoteTextEdit(m_editorContainer);
     
+    // 后台保存：防抖合并连续修改，快照交给写入线程
+    m_autosaveWriter = new AutosaveWriter(this);
+    connect(m_autosaveWriter, &AutosaveWriter::noteSaved, this, &TextEditorManager::onAutosaveFinished);
+    m_autosaveTimer = new QTimer(this);
+    m_autosaveTimer->setSingleShot(true);
+    m_autosaveTimer->setInterval(AUTOSAVE_DEBOUNCE_MS);
+    connect(m_autosaveTimer, &QTimer::timeout, this, [this]() {
+        if (m_hasUnsavedChanges) {
+            saveNote();
+        }
+    });
+    
+    // 在后台线程中加载笔记，并预读侧边栏和搜索结果中可能打开的笔记
+    m_noteLoader = new NoteLoader(this);
+    connect(m_noteLoader, &NoteLoader::noteLoaded, this, &TextEditorManager::onNoteLoaded);
+    connect(m_noteLoader, &NoteLoader::documentPrefetched, this, &TextEditorManager::onNotePrefetched);
+    
     // 创建浮动工具栏
     m_floatingToolBar = new FloatingToolBar(m_textEdit->viewport());
     m_floatingToolBar->hide();
@@ -1895,8 +2056,19 @@ TextEditorManager::TextEditorManager(QWidget *parent)
     m_topToolBar = new QToolBar(m_editorContainer);
     setupTopToolBar();
     
+    // 分批加载大笔记时显示的进度条
+    m_loadProgressBar = new QProgressBar(m_editorContainer);
+    m_loadProgressBar->setTextVisible(false);
+    m_loadProgressBar->setFixedHeight(3);
+    m_loadProgressBar->hide();
+    
+    m_streamingLoadTimer = new QTimer(this);
+    m_streamingLoadTimer->setInterval(0);
+    connect(m_streamingLoadTimer, &QTimer::timeout, this, &TextEditorManager::loadNextStreamingSlice);
+    
     // 添加组件到容器
     containerLayout->addWidget(m_topToolBar);
+    containerLayout->addWidget(m_loadProgressBar);
     containerLayout->addWidget(m_textEdit);
     
     // 初始化更新工具栏计时器
@@ -2073,6 +2245,11 @@ void TextEditorManager::setupTopToolBar()
     m_showAiAssistantAction->setToolTip(tr("使用AI助手处理选中文本"));
     connect(m_showAiAssistantAction, &QAction::triggered, this, &TextEditorManager::onShowAiAssistantActionTriggered);
     
+    // 查看AI批量处理的结果，纠错结果需要在这里确认后才会写入笔记
+    m_showAiResultsAction = m_topToolBar->addAction(QIcon(":/icons/editor/grammar-check.svg"), tr("AI结果"));
+    m_showAiResultsAction->setToolTip(tr("查看AI批量处理保存的总结和纠错结果"));
+    connect(m_showAiResultsAction, &QAction::triggered, this, &TextEditorManager::onShowAiResultsTriggered);
+    
     // 设置工具提示
     m_saveAction->setToolTip(tr("保存笔记 (Ctrl+S)"));
     m_undoAction->setToolTip(tr("撤销上一步操作 (Ctrl+Z)"));
@@ -2621,8 +2798,188 @@ void TextEditorManager::setReadOnly(bool readOnly)
 
 void TextEditorManager::loadNote(const QString &notePath)
 {
+    // 当前文档放入缓存前先记下光标和滚动位置；重新打开同一笔记时按原来的方式重新读取
+    int previousNoteId = currentNoteId();
+    NoteDocumentCache::Entry previous = currentDocumentEntry();
+    
+    // 切换笔记时放弃上一个笔记未完成的加载
+    cancelNoteLoad();
+    
+    // 离开无法读取的笔记时恢复加载前的只读状态
+    if (m_unreadableNoteId >= 0) {
+        m_unreadableNoteId = -1;
+        m_textEdit->setReadOnly(m_readOnlyBeforeLoad);
+    }
+    
     m_currentNotePath = notePath;
     
+    int noteId = currentNoteId();
+    if (noteId == previousNoteId) {
+        previous = NoteDocumentCache::Entry();
+    }
+    
+    // 最近打开过的笔记直接换回原文档，撤销记录随文档保留；否则在新文档中加载
+    NoteDocumentCache::Entry cached = m_documentCache.take(noteId);
+    QTextDocument *document = cached.document ? cached.document.data() : new QTextDocument(m_textEdit);
+    applyDocumentDefaults(document, m_textEdit->document());
+    switchDocument(document, previous.document != nullptr);
+    
+    if (previous.document) {
+        m_documentCache.insert(previousNoteId, previous);
+    }
+    
+    if (cached.document) {
+        m_textEdit->setTextCursor(cached.cursor);
+        m_textEdit->verticalScrollBar()->setValue(cached.scrollValue);
+        // 视口宽度变化时文档会重新排版，排版完成后再恢复一次滚动位置
+        QTimer::singleShot(0, m_textEdit, [this, document, cached]() {
+            if (m_textEdit->document() == document) {
+                m_textEdit->verticalScrollBar()->setValue(cached.scrollValue);
+            }
+        });
+        qDebug() << "从缓存切换笔记:" << notePath;
+    } else {
+        loadNoteContent(notePath);
+    }
+    
+    // 重置修改状态并禁用保存按钮
+    m_textEdit->document()->setModified(false);
+    m_hasUnsavedChanges = false;
+    if (m_saveAction) { // 确保 m_saveAction 已被创建
+        m_saveAction->setEnabled(false);
+    }
+}
+
+NoteDocumentCache::Entry TextEditorManager::currentDocumentEntry() const
+{
+    NoteDocumentCache::Entry entry;
+    QTextDocument *document = m_textEdit->document();
+    
+    // 编辑器自带的初始文档归QTextEdit所有，不放入缓存
+    if (currentNoteId() < 0 || isNoteLoading() || document->parent() != m_textEdit) {
+        return entry;
+    }
+    
+    // 读取失败时显示的提示不是笔记内容，不能缓存
+    if (currentNoteId() == m_unreadableNoteId) {
+        return entry;
+    }
+    
+    // 未保存的修改只有已提交给写入线程时才随文档保留，否则与原来一样在切换时丢弃
+    if (m_hasUnsavedChanges && m_submittedGeneration != m_editGeneration) {
+        return entry;
+    }
+    
+    entry.document = document;
+    entry.cursor = m_textEdit->textCursor();
+    entry.scrollValue = m_textEdit->verticalScrollBar()->value();
+    return entry;
+}
+
+void TextEditorManager::applyDocumentDefaults(QTextDocument *document, const QTextDocument *source) const
+{
+    if (document == source) {
+        return;
+    }
+    
+    // 设置相同的值也会引起重新排版，只在不同时设置，取回缓存的文档时无需重排
+    if (document->defaultFont() != source->defaultFont()) {
+        document->setDefaultFont(source->defaultFont());
+    }
+    if (document->defaultTextOption().tabStopDistance() != source->defaultTextOption().tabStopDistance()) {
+        document->setDefaultTextOption(source->defaultTextOption());
+    }
+    if (document->defaultStyleSheet() != source->defaultStyleSheet()) {
+        document->setDefaultStyleSheet(source->defaultStyleSheet());
+    }
+    document->setDocumentMargin(source->documentMargin());
+}
+
+void TextEditorManager::switchDocument(QTextDocument *document, bool keepPrevious)
+{
+    QTextDocument *previous = m_textEdit->document();
+    if (previous == document) {
+        return;
+    }
+    
+    disconnect(previous, &QTextDocument::undoAvailable, m_undoAction, &QAction::setEnabled);
+    disconnect(previous, &QTextDocument::redoAvailable, m_redoAction, &QAction::setEnabled);
+    
+    // 初始文档归QTextEdit所有，更换时由QTextEdit释放
+    bool ownsPrevious = previous->parent() == m_textEdit;
+    m_textEdit->switchDocument(document);
+    if (ownsPrevious && !keepPrevious) {
+        delete previous;
+    }
+    
+    connect(document, &QTextDocument::undoAvailable, m_undoAction, &QAction::setEnabled);
+    connect(document, &QTextDocument::redoAvailable, m_redoAction, &QAction::setEnabled);
+    m_undoAction->setEnabled(document->isUndoAvailable());
+    m_redoAction->setEnabled(document->isRedoAvailable());
+}
+
+void TextEditorManager::setDatabaseManager(DatabaseManager *dbManager)
+{
+    if (m_dbManager) {
+        disconnect(m_dbManager, nullptr, this, nullptr);
+    }
+    m_dbManager = dbManager;
+    m_documentCache.clear();
+    
+    if (m_dbManager) {
+        connect(m_dbManager, &DatabaseManager::noteRemoved, this, [this](int note_id, int) {
+            invalidateCachedNote(note_id);
+        });
+        // 删除文件夹时不逐个通知其中的笔记，直接清空缓存
+        connect(m_dbManager, &DatabaseManager::folderRemoved, this, [this]() {
+            m_documentCache.clear();
+        });
+    }
+}
+
+void TextEditorManager::invalidateCachedNote(int noteId)
+{
+    m_documentCache.remove(noteId);
+}
+
+void TextEditorManager::prefetchNotes(const QList<int> &noteIds)
+{
+    // 当前笔记和已缓存的笔记无需预读，正在保存的笔记读到的可能是旧内容
+    QList<int> candidates;
+    const int current = currentNoteId();
+    for (int noteId : noteIds) {
+        if (candidates.size() >= NoteLoader::MAX_PREFETCH_NOTES) {
+            break;
+        }
+        if (noteId == current || m_documentCache.contains(noteId) || m_savesInFlight.contains(noteId)) {
+            continue;
+        }
+        candidates.append(noteId);
+    }
+    
+    if (!candidates.isEmpty()) {
+        m_noteLoader->prefetch(candidates);
+    }
+}
+
+void TextEditorManager::onNotePrefetched(int requestId, int noteId, QTextDocument *document)
+{
+    // 预读期间笔记已被打开、放入缓存，或在请求之后提交过保存时，读到的内容不能使用
+    if (noteId == currentNoteId() || m_documentCache.contains(noteId) || m_savesInFlight.contains(noteId)
+        || m_saveRequestMark.value(noteId, -1) >= requestId) {
+        delete document;
+        return;
+    }
+    
+    document->setParent(m_textEdit);
+    NoteDocumentCache::Entry entry;
+    entry.document = document;
+    entry.cursor = QTextCursor(document);
+    m_documentCache.insert(noteId, entry);
+}
+
+void TextEditorManager::loadNoteContent(const QString &notePath)
+{
     // 如果路径为空，加载默认内容
     if (notePath.isEmpty()) {
         // 获取全局字体设置
@@ -2656,38 +3013,8 @@ void TextEditorManager::loadNote(const QString &notePath)
         
         // 检查是否设置了数据库管理器
         if (m_dbManager) {
-            // 获取笔记信息
-            NoteInfo noteInfo = m_dbManager->getNoteById(noteId);
-            
-            // 获取笔记内容块
-            QList<ContentBlock> blocks = m_dbManager->getNoteContent(noteId);
-            
-            // 如果有内容，则加载
-            if (!blocks.isEmpty()) {
-                // 根据内容块构建HTML
-                QString htmlContent = "<html><body>";
-                
-                for (const ContentBlock &block : blocks) {
-                    if (block.block_type == "text") {
-                        // 文本块直接添加
-                        htmlContent += block.content_text;
-                    } else if (block.block_type == "image") {
-                        // 图片块添加图片标签
-                        QString imgPath = m_dbManager->getMediaAbsolutePath(block.media_path);
-                        htmlContent += QString("<img src=\"%1\" width=\"%2\" height=\"%3\">")
-                                      .arg(imgPath)
-                                      .arg(block.properties.contains("width") ? block.properties.split("width=").at(1).split(",").at(0) : "auto")
-                                      .arg(block.properties.contains("height") ? block.properties.split("height=").at(1).split(",").at(0) : "auto");
-                    }
-                    // 可以添加其他类型的内容块处理
-                }
-                
-                htmlContent += "</body></html>";
-                m_textEdit->setHtml(htmlContent);
-            } else {
-                // 如果笔记没有内容，显示标题和空白内容
-                m_textEdit->setHtml("<html><body><h1>" + noteInfo.title + "</h1></body></html>");
-            }
+            // 读取内容块、拼接和解析HTML都在加载线程中完成，完成后在onNoteLoaded中换入文档
+            startNoteLoad(noteId);
         } else {
             // 无法获取数据库管理器，显示错误信息
             m_textEdit->setHtml("<html><body><h1>" + tr("无法加载笔记") + "</h1><p>" + tr("数据库管理器未设置") + "</p></body></html>");
@@ -2697,15 +3024,91 @@ void TextEditorManager::loadNote(const QString &notePath)
         // 路径格式不正确，加载默认内容
         m_textEdit->setHtml("<html><body><h1>" + tr("笔记：") + notePath + "</h1><p>" + tr("无法识别的笔记路径格式") + "</p></body></html>");
     }
+
+}
+
+void TextEditorManager::startNoteLoad(int noteId)
+{
+    // 加载线程使用独立连接，先等待这篇笔记已提交的保存写入完成，避免读到旧内容
+    if (m_savesInFlight.contains(noteId)) {
+        m_autosaveWriter->flush();
+    }
     
-    // 重置修改状态并禁用保存按钮
+    // 加载完成前只显示空白文档，不允许编辑
+    m_readOnlyBeforeLoad = m_textEdit->isReadOnly();
+    m_textEdit->setReadOnly(true);
+    
+    int loadId = m_noteLoader->load(noteId);
+    m_pendingLoadId = loadId;
+    
+    // 大多数笔记很快加载完成，只有超过一定时间才显示忙碌进度条，避免闪烁
+    QTimer::singleShot(LOAD_INDICATOR_DELAY_MS, this, [this, loadId]() {
+        if (m_pendingLoadId == loadId) {
+            m_loadProgressBar->setRange(0, 0);
+            m_loadProgressBar->show();
+        }
+    });
+}
+
+void TextEditorManager::onNoteLoaded(int loadId, int noteId, QTextDocument *document, const QList<ContentBlock> &blocks)
+{
+    // 加载期间已切换到别的笔记
+    if (loadId != m_pendingLoadId || noteId != currentNoteId()) {
+        delete document;
+        return;
+    }
+    
+    m_pendingLoadId = 0;
+    m_loadProgressBar->hide();
+    m_textEdit->setReadOnly(m_readOnlyBeforeLoad);
+    
+    if (document) {
+        // 界面线程只需换入已构建好的文档
+        document->setParent(m_textEdit);
+        applyDocumentDefaults(document, m_textEdit->document());
+        switchDocument(document, false);
+    } else if (!blocks.isEmpty()) {
+        // 大笔记分批加载，内容不适合分批时一次性加载
+        if (!startStreamingLoad(blocks) && !NoteLoader::fillDocument(m_textEdit->document(), blocks, m_dbManager)) {
+            qWarning() << "解码笔记内容失败:" << noteId;
+        }
+    } else {
+        // 内容块损坏或数据库不可用：保持只读且不保存，否则提示文字会覆盖数据库中的原有内容
+        m_unreadableNoteId = noteId;
+        m_textEdit->setReadOnly(true);
+        m_textEdit->setHtml("<html><body><h1>" + tr("无法加载笔记") + "</h1><p>"
+                            + tr("笔记内容已损坏或无法读取，为保护原有数据，此笔记以只读方式显示。") + "</p></body></html>");
+        qWarning() << "读取笔记内容失败，以只读方式显示:" << noteId;
+    }
+    
+    // 重置修改状态，加载的内容不算未保存的修改
     m_textEdit->document()->setModified(false);
     m_hasUnsavedChanges = false;
-    if (m_saveAction) { // 确保 m_saveAction 已被创建
+    if (m_saveAction) {
         m_saveAction->setEnabled(false);
     }
 }
 
+void TextEditorManager::cancelNoteLoad()
+{
+    cancelStreamingLoad();
+    
+    if (m_pendingLoadId == 0) {
+        return;
+    }
+    
+    // 加载线程的结果到达时因请求ID不一致被丢弃
+    qDebug() << "取消加载笔记:" << m_currentNotePath;
+    m_pendingLoadId = 0;
+    m_loadProgressBar->hide();
+    m_textEdit->setReadOnly(m_readOnlyBeforeLoad);
+}
+
+bool TextEditorManager::isNoteLoading() const
+{
+    return m_pendingLoadId != 0 || isStreamingLoad();
+}
+
 void TextEditorManager::saveNote()
 {
     if (m_currentNotePath.isEmpty()) {
@@ -2713,76 +3116,345 @@ void TextEditorManager::saveNote()
         return;
     }
     
+    // 加载完成前文档只有部分内容且编辑器只读，不能保存
+    if (isNoteLoading()) {
+        qDebug() << "笔记仍在加载，跳过保存:" << m_currentNotePath;
+        return;
+    }    
+    // 无法读取的笔记编辑器中只有提示文字，保存会覆盖原有内容
+    if (currentNoteId() >= 0 && currentNoteId() == m_unreadableNoteId) {
+        qWarning() << "笔记内容无法读取，跳过保存:" << m_currentNotePath;
+        return;
+    }
+    
     // 添加调试日志 - 当前笔记路径
     qDebug() << "保存笔记 - 当前笔记路径:" << m_currentNotePath;
     
     // 从路径中提取笔记ID
-    QRegularExpression noteIdPattern("note_(\\d+)$");
-    QRegularExpressionMatch match = noteIdPattern.match(m_currentNotePath);
-    
-    if (!match.hasMatch()) {
+    int noteId = currentNoteId();
+    if (noteId < 0) {
         qWarning() << "无法保存笔记：无法从路径中提取笔记ID" << m_currentNotePath;
         return;
     }
     
-    int noteId = match.captured(1).toInt();
-    QString content = m_textEdit->toHtml(); // 获取当前编辑器内容
+    // 本次快照已包含所有修改，取消等待中的防抖保存
+    m_autosaveTimer->stop();
+    
+    // 界面线程只复制文档，toHtml、拆分内容块和数据库事务都在写入线程中完成；
+    // 未保存状态在onAutosaveFinished中根据编辑版本号清除
+    m_submittedGeneration = m_editGeneration;
+    m_savesInFlight[noteId] = m_editGeneration;
+    m_saveRequestMark[noteId] = m_noteLoader->latestPrefetchId();
+    m_autosaveWriter->submit(noteId, m_editGeneration, m_textEdit->document()->clone());
+}
+
+void TextEditorManager::scheduleAutosave()
+{
+    if (m_currentNotePath.isEmpty()) {
+        return;
+    }
     
-    // 添加调试日志 - 提取的笔记ID
-    qDebug() << "保存笔记 - 笔记ID:" << noteId;
+    // 重新计时，连续输入只会在停顿后保存一次
+    m_autosaveTimer->start();
+}
+
+void TextEditorManager::flushAutosave()
+{
+    if (m_autosaveTimer->isActive() && m_hasUnsavedChanges) {
+        saveNote();
+    }
+    m_autosaveTimer->stop();
+    m_autosaveWriter->flush();
+}
+
+void TextEditorManager::releaseDatabase()
+{
+    flushAutosave();
+    m_autosaveWriter->releaseDatabase();
+    m_noteLoader->releaseDatabase();
+}
+
+void TextEditorManager::onAutosaveFinished(int noteId, int generation, bool success)
+{
+    // 写入器只写同一笔记的最新快照，版本号一致说明已提交的保存全部完成
+    if (m_savesInFlight.value(noteId, -1) == generation) {
+        m_savesInFlight.remove(noteId);
+    }
     
-    // 检查是否设置了数据库管理器
-    if (!m_dbManager) {
-        qWarning() << "无法保存笔记：数据库管理器未设置";
+    if (!success) {
+        qWarning() << "保存笔记失败，ID:" << noteId;
         return;
     }
     
-    // 获取笔记存储的物理路径
-    QString notebookPath = SettingsDialog::getNotebookPath();
-    QString dbFilePath = notebookPath + "/notes.db";
-    QString mediaFolderPath = notebookPath + "/notes_media";
+    qDebug() << "笔记保存成功，ID:" << noteId;
     
-    // 添加调试日志 - 笔记库路径
-    qDebug() << "保存笔记 - 笔记库路径:" << notebookPath;
-    qDebug() << "保存笔记 - 数据库文件路径:" << dbFilePath;
-    qDebug() << "保存笔记 - 媒体文件夹路径:" << mediaFolderPath;
+    // 写入线程使用独立连接，通知侧边栏的连接刷新修改时间
+    if (m_dbManager) {
+        m_dbManager->refreshNoteHeader(noteId);
+    }
     
-    // 创建一个内容块保存HTML内容
-    QList<ContentBlock> blocks;
-    ContentBlock block;
-    block.note_id = noteId;
-    block.block_type = "text";
-    block.position = 0;
-    block.content_text = content;
-    blocks.append(block);
+    // 保存期间又有新的修改时保持未保存状态，等待下一次保存
+    if (noteId != currentNoteId() || generation != m_editGeneration) {
+        return;
+    }
     
-    // 检查内容中是否包含图片
-    int imageCount = content.count("<img ");
-    if (imageCount > 0) {
-        qDebug() << "保存笔记 - 笔记中包含" << imageCount << "个图片";
+    // 重置未保存状态
+    m_hasUnsavedChanges = false;
+    
+    // 禁用保存按钮
+    if (m_saveAction) {
+        m_saveAction->setEnabled(false);
     }
     
-    // 保存内容块到数据库
-    bool success = m_dbManager->saveNoteContent(noteId, blocks);
+    // 重置编辑器的修改状态
+    if (m_textEdit && m_textEdit->document()) {
+        m_textEdit->document()->setModified(false);
+    }
+}
+
+QString TextEditorManager::contentBlockToHtml(const ContentBlock &block, DatabaseManager *dbManager)
+{
+    if (block.block_type == "text") {
+        // 文本块直接添加
+        return block.content_text;
+    } else if (block.block_type == "image") {
+        // 图片块添加图片标签
+        QString imgPath = dbManager->getMediaAbsolutePath(block.media_path);
+        return QString("<img src=\"%1\" width=\"%2\" height=\"%3\">")
+               .arg(imgPath)
+               .arg(block.properties.contains("width") ? block.properties.split("width=").at(1).split(",").at(0) : "auto")
+               .arg(block.properties.contains("height") ? block.properties.split("height=").at(1).split(",").at(0) : "auto");
+    }
+    // 可以添加其他类型的内容块处理
+    return QString();
+}
+
+bool TextEditorManager::isStreamingLoad() const
+{
+    return m_streamingLoadTimer && m_streamingLoadTimer->isActive();
+}
+
+bool TextEditorManager::startStreamingLoad(const QList<ContentBlock> &blocks)
+{
+    qint64 totalLength = 0;
+    for (const ContentBlock &block : blocks) {
+        totalLength += block.content_text.length() + block.content_data.size();
+    }
+    if (totalLength < STREAMING_LOAD_THRESHOLD) {
+        return false;
+    }
     
-    if (success) {
-        qDebug() << "笔记保存成功，ID:" << noteId << "，物理路径:" << dbFilePath;
-        
-        // 重置未保存状态
-        m_hasUnsavedChanges = false;
-        
-        // 禁用保存按钮
-        if (m_saveAction) {
-            m_saveAction->setEnabled(false);
+    m_readOnlyBeforeStreaming = m_textEdit->isReadOnly();
+    
+    if (NoteDocumentCodec::isEncoded(blocks)) {
+        // 二进制格式逐段解码，先启动定时器使解码触发的修改信号被忽略
+        m_streamingLoadTimer->start();
+        m_streamingCodec = new NoteDocumentCodec(m_textEdit->document());
+        if (!m_streamingCodec->begin(blocks.first())) {
+            m_streamingLoadTimer->stop();
+            delete m_streamingCodec;
+            m_streamingCodec = nullptr;
+            return false;
         }
         
-        // 重置编辑器的修改状态
-        if (m_textEdit && m_textEdit->document()) {
-            m_textEdit->document()->setModified(false);
+        m_streamingBlocks = blocks;
+        int firstEnd = nextStreamingBatchEnd(1, STREAMING_FIRST_BATCH_LINES);
+        for (int i = 1; i < firstEnd; ++i) {
+            m_streamingCodec->append(m_streamingBlocks.at(i));
         }
+        m_streamingIndex = firstEnd;
     } else {
-        qWarning() << "保存笔记失败，ID:" << noteId;
+        if (!startStreamingHtml(blocks)) {
+            return false;
+        }
+    }
+    
+    // 加载完成前只允许浏览，追加过程不进入撤销栈
+    m_textEdit->document()->setUndoRedoEnabled(false);
+    m_textEdit->setReadOnly(true);
+    
+    m_loadProgressBar->setRange(0, m_streamingBlocks.size());
+    m_loadProgressBar->setValue(m_streamingIndex);
+    m_loadProgressBar->show();
+    
+    qDebug() << "分批加载笔记:" << m_currentNotePath << "内容块:" << m_streamingBlocks.size() << "大小:" << totalLength;
+    
+    return true;
+}
+
+bool TextEditorManager::startStreamingHtml(const QList<ContentBlock> &blocks)
+{
+    // 内容块是toHtml逐行拆分的结果，<body>之前的行是样式表等文档头，每批解析时都要带上
+    int bodyLine = -1;
+    for (int i = 0; i < blocks.size() && i < 32; ++i) {
+        if (blocks.at(i).block_type == "text" && blocks.at(i).content_text.contains("<body")) {
+            bodyLine = i;
+            break;
+        }
+    }
+    if (bodyLine < 0) {
+        return false;
+    }
+    
+    m_streamingHtmlHead.clear();
+    for (int i = 0; i <= bodyLine; ++i) {
+        m_streamingHtmlHead += blocks.at(i).content_text;
+    }
+    m_streamingBlocks = blocks;
+    
+    // 首屏内容直接setHtml，立即可见
+    int firstEnd = nextStreamingBatchEnd(bodyLine + 1, STREAMING_FIRST_BATCH_LINES);
+    QString firstHtml = m_streamingHtmlHead;
+    for (int i = bodyLine + 1; i < firstEnd; ++i) {
+        firstHtml += contentBlockToHtml(m_streamingBlocks.at(i), m_dbManager);
+    }
+    firstHtml += "</body></html>";
+    
+    m_streamingIndex = firstEnd;
+    
+    // 先启动定时器，使setHtml触发的修改信号被忽略
+    m_streamingLoadTimer->start();
+    m_textEdit->setHtml(firstHtml);
+    
+    return true;
+}
+
+int TextEditorManager::nextStreamingBatchEnd(int start, int lines) const
+{
+    // 二进制格式的段落彼此独立，可在任意位置断开
+    if (m_streamingCodec) {
+        return qMin(start + lines, int(m_streamingBlocks.size()));
+    }
+    
+    // 统计列表和表格的嵌套深度，只在深度为0的段落或标题之前断开
+    static const QRegularExpression openTag("<(ul|ol|table)[\\s>]");
+    static const QRegularExpression closeTag("</(ul|ol|table)>");
+    
+    int depth = 0;
+    int end = start;
+    while (end < m_streamingBlocks.size()) {
+        const ContentBlock &block = m_streamingBlocks.at(end);
+        if (end - start >= lines && depth == 0 && block.block_type == "text"
+            && (block.content_text.startsWith("<p") || block.content_text.startsWith("<h"))) {
+            break;
+        }
+        if (block.block_type == "text") {
+            depth += block.content_text.count(openTag) - block.content_text.count(closeTag);
+        }
+        ++end;
+    }
+    return end;
+}
+
+void TextEditorManager::appendStreamingBatch(const QString &html)
+{
+    QTextDocument *document = m_textEdit->document();
+    
+    // 在临时文档中解析，保持与setHtml相同的样式继承
+    QTextDocument batchDocument;
+    batchDocument.setDefaultFont(document->defaultFont());
+    batchDocument.setHtml(m_streamingHtmlHead + html + "</body></html>");
+    
+    // 插入片段时第一段会并入光标所在段落，因此先新建一个与之格式相同的段落
+    QTextBlock firstBlock = batchDocument.begin();
+    QTextCursor cursor(document);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertBlock(firstBlock.blockFormat(), firstBlock.charFormat());
+    cursor.insertFragment(QTextDocumentFragment(&batchDocument));
+}
+
+void TextEditorManager::loadNextStreamingSlice()
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    while (m_streamingIndex < m_streamingBlocks.size() && timer.elapsed() < STREAMING_SLICE_MS) {
+        int end = nextStreamingBatchEnd(m_streamingIndex, STREAMING_BATCH_LINES);
+        if (m_streamingCodec) {
+            for (int i = m_streamingIndex; i < end; ++i) {
+                m_streamingCodec->append(m_streamingBlocks.at(i));
+            }
+            m_streamingIndex = end;
+            continue;
+        }
+        
+        QString html;
+        for (int i = m_streamingIndex; i < end; ++i) {
+            html += contentBlockToHtml(m_streamingBlocks.at(i), m_dbManager);
+        }
+        appendStreamingBatch(html);
+        m_streamingIndex = end;
+    }
+    
+    m_loadProgressBar->setValue(m_streamingIndex);
+    
+    if (m_streamingIndex >= m_streamingBlocks.size()) {
+        finishStreamingLoad();
+    }
+}
+
+void TextEditorManager::finishStreamingLoad()
+{
+    m_streamingLoadTimer->stop();
+    if (m_streamingCodec) {
+        m_streamingCodec->end();
+        delete m_streamingCodec;
+        m_streamingCodec = nullptr;
+    }
+    m_streamingBlocks.clear();
+    m_streamingHtmlHead.clear();
+    m_streamingIndex = 0;
+    
+    m_loadProgressBar->hide();
+    m_textEdit->document()->setUndoRedoEnabled(true);
+    m_textEdit->setReadOnly(m_readOnlyBeforeStreaming);
+    
+    // 重置修改状态，追加内容不算未保存的修改
+    m_textEdit->document()->setModified(false);
+    m_hasUnsavedChanges = false;
+    if (m_saveAction) {
+        m_saveAction->setEnabled(false);
+    }
+}
+
+void TextEditorManager::cancelStreamingLoad()
+{
+    if (!isStreamingLoad()) {
+        return;
+    }
+    
+    qDebug() << "取消分批加载:" << m_currentNotePath << "已加载" << m_streamingIndex << "/" << m_streamingBlocks.size();
+    finishStreamingLoad();
+}
+
+int TextEditorManager::currentNoteId() const
+{
+    QRegularExpression noteIdPattern("note_(\\d+)$");
+    QRegularExpressionMatch match = noteIdPattern.match(m_currentNotePath);
+    return match.hasMatch() ? match.captured(1).toInt() : -1;
+}
+
+QList<ContentBlock> TextEditorManager::splitHtmlIntoBlocks(int noteId, const QString &html)
+{
+    QList<ContentBlock> blocks;
+    int start = 0;
+    
+    while (start < html.length()) {
+        int end = html.indexOf('\n', start);
+        end = (end < 0) ? html.length() : end + 1;
+        
+        ContentBlock block;
+        block.id = -1;
+        block.note_id = noteId;
+        block.block_type = "text";
+        block.position = blocks.size();
+        block.content_text = html.mid(start, end - start);
+        blocks.append(block);
+        
+        start = end;
     }
+    
+    return blocks;
 }
 
 void TextEditorManager::insertImageFromButton()
@@ -2804,6 +3476,11 @@ void TextEditorManager::handleEditorClicked(const QPoint &pos)
 
 void TextEditorManager::documentModified()
 {
+    // 加载和分批追加内容不是用户修改，无法读取的笔记不允许修改
+    if (isNoteLoading() || (currentNoteId() >= 0 && currentNoteId() == m_unreadableNoteId)) {
+        return;
+    }
+    
     // 标记有未保存的更改
     m_hasUnsavedChanges = true;
     m_saveAction->setEnabled(true); // 内容修改时启用保存按钮
@@ -3105,6 +3782,103 @@ void TextEditorManager::insertAiContent(const QString &content)
     }
 }
 
+// 查看AI批量处理为当前笔记保存的结果
+void TextEditorManager::onShowAiResultsTriggered()
+{
+    int noteId = currentNoteId();
+    if (!m_dbManager || noteId < 0) {
+        QMessageBox::information(m_editorContainer, tr("AI结果"), tr("请先打开一篇笔记。"));
+        return;
+    }
+    
+    QString summary = m_dbManager->getNoteAiResult(noteId, "summarize");
+    QString fixedText = m_dbManager->getNoteAiResult(noteId, "fix");
+    if (summary.isEmpty() && fixedText.isEmpty()) {
+        QMessageBox::information(m_editorContainer, tr("AI结果"),
+                                 tr("这篇笔记还没有AI批量总结或纠错的结果。\n可以在侧边栏文件夹或搜索结果的菜单中发起批量处理。"));
+        return;
+    }
+    
+    QDialog dialog(m_editorContainer);
+    dialog.setWindowTitle(tr("AI结果 - %1").arg(m_dbManager->getNoteById(noteId).title));
+    dialog.resize(560, 480);
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    
+    // 总结和纠错结果都只读显示，笔记正文不会被自动修改
+    auto addSection = [&dialog, layout](const QString &title, const QString &text) {
+        layout->addWidget(new QLabel(title, &dialog));
+        QTextEdit *view = new QTextEdit(&dialog);
+        view->setReadOnly(true);
+        view->setPlainText(text);
+        layout->addWidget(view);
+    };
+    if (!summary.isEmpty()) {
+        addSection(tr("总结"), summary);
+    }
+    if (!fixedText.isEmpty()) {
+        addSection(tr("纠错后的正文"), fixedText);
+    }
+    
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    buttonLayout->addStretch();
+    QPushButton *insertSummaryButton = nullptr;
+    if (!summary.isEmpty()) {
+        insertSummaryButton = new QPushButton(tr("插入总结"), &dialog);
+        buttonLayout->addWidget(insertSummaryButton);
+    }
+    QPushButton *applyFixButton = nullptr;
+    if (!fixedText.isEmpty()) {
+        applyFixButton = new QPushButton(tr("应用纠错"), &dialog);
+        buttonLayout->addWidget(applyFixButton);
+    }
+    QPushButton *closeButton = new QPushButton(tr("关闭"), &dialog);
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+    
+    // 笔记仍在加载、内容无法读取或处于只读状态时不能修改正文
+    bool editable = !isNoteLoading() && noteId != m_unreadableNoteId && !m_textEdit->isReadOnly();
+    if (insertSummaryButton) {
+        insertSummaryButton->setEnabled(editable);
+        connect(insertSummaryButton, &QPushButton::clicked, &dialog, [this, &dialog, summary]() {
+            insertText(summary);
+            dialog.accept();
+        });
+    }
+    if (applyFixButton) {
+        applyFixButton->setEnabled(editable);
+        connect(applyFixButton, &QPushButton::clicked, &dialog, [this, &dialog, fixedText]() {
+            QMessageBox::StandardButton answer = QMessageBox::question(&dialog, tr("应用纠错"),
+                tr("纠错结果由笔记的纯文本生成，应用后正文将被替换为纠错后的纯文本，原有格式和图片不会保留。\n"
+                   "之后可以用撤销恢复原文。是否继续？"));
+            if (answer != QMessageBox::Yes) {
+                return;
+            }
+            applyAiFix(fixedText);
+            dialog.accept();
+        });
+    }
+    connect(closeButton, &QPushButton::clicked, &dialog, &QDialog::reject);
+    
+    dialog.exec();
+}
+
+void TextEditorManager::applyAiFix(const QString &fixedText)
+{
+    // 打开对话框期间可能已切换笔记或开始加载
+    if (fixedText.isEmpty() || isNoteLoading() || m_textEdit->isReadOnly()) {
+        return;
+    }
+    
+    // 整体替换作为一步编辑，撤销一次即可恢复原文；textChanged会标记修改并触发自动保存
+    QTextCursor cursor(m_textEdit->document());
+    cursor.beginEditBlock();
+    cursor.select(QTextCursor::Document);
+    cursor.removeSelectedText();
+    cursor.insertText(fixedText);
+    cursor.endEditBlock();
+    qDebug() << "已应用AI纠错结果，笔记:" << m_currentNotePath;
+}
+
 // TextEditorManager应用设置方法
 void TextEditorManager::applyEditorSettings()
 {
@@ -55,13 +55,21 @@
 #include <QPainter>
 #include <QPaintEvent>
 #include <QDrag>
+#include <QHash>
+#include <QThreadPool>
 #include "fixedwidthfontcombo.h"
 #include "aiassistantdialog.h"
+#include "notedocumentcache.h"
 
 class NoteTextEdit;
 class FloatingToolBar;
 class AiAssistantDialog; // 前向声明，因为 TextEditorManager 不再拥有它
 class DatabaseManager;
+struct ContentBlock;
+class AutosaveWriter;
+class QProgressBar;
+class NoteDocumentCodec;
+class NoteLoader;
 
 // 自定义文本编辑器，用于扩展QTextEdit功能
 class NoteTextEdit : public QTextEdit 
@@ -70,6 +78,7 @@ class NoteTextEdit : public QTextEdit
 
 public:
     explicit NoteTextEdit(QWidget *parent = nullptr);
+    ~NoteTextEdit() override;
     
     // 重写鼠标事件，用于处理自定义上下文菜单和工具栏定位
     void mousePressEvent(QMouseEvent *event) override;
@@ -92,6 +101,12 @@ public:
     // 调整图片大小和位置
     bool resizeImage(const QString &imagePath, int width, int height, Qt::Alignment alignment = Qt::AlignCenter);
     
+    // 图片资源先返回同尺寸的占位图，视口附近的图片再由后台线程解码
+    QVariant loadResource(int type, const QUrl &name) override;
+    
+    // 更换显示的文档，旧文档中已解码的图片恢复为占位图；文档所有权不变
+    void switchDocument(QTextDocument *document);
+    
 protected:
     // 重写上下文菜单事件
     void contextMenuEvent(QContextMenuEvent *event) override;
@@ -129,12 +144,26 @@ private:
     QLabel *m_dragPreviewLabel = nullptr;  // 拖拽预览标签
     bool m_justDeletedClosingPair = false; // 新增：标记是否刚刚删除了一个配对的右括号
 
+    // 图片按需解码相关成员
+    struct ImageEntry {
+        QString path;          // 原图本地路径
+        bool decoded = false;  // 文档资源是否已替换为解码后的图片
+        bool pending = false;  // 是否正在后台解码
+    };
+    QHash<QUrl, ImageEntry> m_images;    // 已解码或正在解码的图片
+    QThreadPool m_imageDecodePool;       // 图片解码线程池
+    bool m_imageScanScheduled = false;   // 是否已安排可见图片检查
+
     // 辅助函数
     void updateSelectionIndicator(); // 更新选中图片状态和矩形
     void drawSelectionIndicator(QPainter *painter); // 绘制选中框和手柄
     int getHandleAtPos(const QPoint &pos) const; // 获取鼠标位置处的手柄索引，-1表示没有
     void updateImageSize(const QPoint &mousePos); // 根据鼠标位置更新图片大小
     void setCursorForHandle(int handleIndex); // 根据手柄设置鼠标光标
+    void scheduleImageScan(); // 安排一次可见图片检查，同一轮事件循环内只执行一次
+    void updateVisibleImages(); // 解码视口附近的图片，释放远离视口的图片
+    void decodeImage(const QUrl &url, const QString &path); // 在线程池中解码图片
+    static QImage imagePlaceholder(const QSize &size); // 生成指定尺寸的占位图
 
     // 新增：静态配对表及其初始化函数
     static QMap<QString, QString> initPairMap();
@@ -231,8 +260,33 @@ public:
     QString currentNotePath() const { return m_currentNotePath; }
     bool hasUnsavedChanges() const { return m_hasUnsavedChanges; }
     
-    // 标记内容已修改（用于外部调用）
-    void markContentModified() { m_hasUnsavedChanges = true; m_saveAction->setEnabled(true); }
+    // 标记内容已修改（用于外部调用），同时递增编辑版本号
+    void markContentModified() { m_hasUnsavedChanges = true; m_editGeneration++; m_saveAction->setEnabled(true); }
+    
+    // 自动保存：在防抖时间窗口内合并连续修改，到期后提交快照给写入线程
+    void scheduleAutosave();
+    // 立即提交待保存的修改并等待写入线程完成（退出或重启前调用）
+    void flushAutosave();
+    // 写完待保存的修改后关闭写入线程和加载线程的数据库连接（恢复备份或迁移笔记本前调用）
+    void releaseDatabase();
+    
+    // 将编辑器HTML按行拆分为内容块（toHtml为每个顶层段落单独输出一行），
+    // 每块保留行尾换行符，按位置拼接即可无损还原，供数据库做增量保存
+    static QList<ContentBlock> splitHtmlIntoBlocks(int noteId, const QString &html);
+    
+    // 将HTML格式的内容块转换为HTML片段，图片路径由dbManager解析(可在工作线程中使用该线程的连接)
+    static QString contentBlockToHtml(const ContentBlock &block, DatabaseManager *dbManager);
+    
+    static const int AUTOSAVE_DEBOUNCE_MS = 1000; // 自动保存的防抖时间窗口
+    
+    // 大笔记分批加载：首屏内容立即显示，其余内容在事件循环空闲时按时间片追加
+    static const int STREAMING_LOAD_THRESHOLD = 1024 * 1024; // 超过该字符数的笔记分批加载
+    static const int STREAMING_FIRST_BATCH_LINES = 200;      // 首批加载的行数
+    static const int STREAMING_BATCH_LINES = 100;            // 后续每批解析的行数
+    static const int STREAMING_SLICE_MS = 12;                // 每个时间片的最长处理时间
+    bool isStreamingLoad() const; // 是否正在分批加载笔记
+    static const int LOAD_INDICATOR_DELAY_MS = 150; // 后台加载超过该时间才显示忙碌进度条
+    bool isNoteLoading() const;   // 笔记是否仍在后台加载或分批加载
     
     // 图片处理
     void showImageAnnotationDialog(const QString &imagePath);
@@ -267,7 +321,7 @@ public:
     void triggerAiAssistant(); // 主动触发AI助手对话框
     
     // 设置数据库管理器
-    void setDatabaseManager(DatabaseManager *dbManager) { m_dbManager = dbManager; }
+    void setDatabaseManager(DatabaseManager *dbManager);
     DatabaseManager* getDatabaseManager() const { return m_dbManager; }
     
     // 应用编辑器设置
@@ -275,6 +329,9 @@ public:
     void updateFont(const QString &family, int size);
     void updateTabWidth(int spaces);
     void updateAutoPairEnabled(bool enabled);
+    
+    // 丢弃缓存的笔记文档，笔记在编辑器以外被修改或删除时调用
+    void invalidateCachedNote(int noteId);
 
 signals:
     void contentModified();  // 内容被修改信号（字符级别的修改）
@@ -284,6 +341,9 @@ signals:
 public slots:
     void insertImageFromButton(); // 添加从按钮插入图片的槽函数
     
+    // 在后台预读接下来可能打开的笔记，noteIds按可能性从高到低排列
+    void prefetchNotes(const QList<int> &noteIds);
+    
     // 设置相关槽函数 - 接收从设置对话框传来的设置变更
     void onEditorFontSettingChanged(const QString &fontFamily, int fontSize);
     void onTabWidthSettingChanged(int tabWidth);
@@ -295,6 +355,10 @@ private slots:
     void handleTextEditClicked(const QPoint &pos);
     void handleCursorPositionChanged(); // 新增：处理光标位置变化的槽函数
     void documentModified();
+    void onAutosaveFinished(int noteId, int generation, bool success); // 写入线程保存完成
+    void onNotePrefetched(int requestId, int noteId, QTextDocument *document); // 预读线程解码完成
+    void onNoteLoaded(int loadId, int noteId, QTextDocument *document, const QList<ContentBlock> &blocks); // 加载线程构建完成
+    void loadNextStreamingSlice(); // 追加下一个时间片的内容
     void updateToolBarForCurrentFormat();
     void setupFontComboBoxes();
     
@@ -326,6 +390,7 @@ private slots:
     // AI助手槽函数
     void onShowAiAssistantActionTriggered();
     void insertAiContent(const QString &content);
+    void onShowAiResultsTriggered(); // 查看AI批量处理为当前笔记保存的总结和纠错结果
     
 private:
     // UI组件
@@ -360,10 +425,13 @@ private:
     
     // AI助手相关成员
     QAction *m_showAiAssistantAction; // 显示AI助手的动作
+    QAction *m_showAiResultsAction = nullptr; // 查看AI批量处理结果的动作
     
     // 帮助函数
     void setupUI();
     void setupTopToolBar();
+    // 用纠错结果替换当前笔记正文，作为一步可撤销的编辑，随后按普通修改自动保存
+    void applyAiFix(const QString &fixedText);
     void connectSignals();
     void updateToolBarPosition(const QPoint &pos);
     void updateActionIcons();
@@ -374,6 +442,63 @@ private:
 
     // 数据库管理器指针
     DatabaseManager *m_dbManager = nullptr;
+    
+    // 后台保存
+    AutosaveWriter *m_autosaveWriter = nullptr; // 写入线程，拥有独立的数据库连接
+    QTimer *m_autosaveTimer = nullptr; // 防抖定时器
+    int m_editGeneration = 0; // 编辑版本号，用于判断保存完成时是否已有新的修改
+    
+    // 从当前笔记路径中提取笔记ID，失败返回-1
+    int currentNoteId() const;
+    
+    // 最近打开笔记的文档缓存，切换回已缓存的笔记时直接换回文档
+    NoteDocumentCache m_documentCache;
+    int m_submittedGeneration = -1; // 最近一次提交保存时的编辑版本号
+    
+    // 后台加载和预读：数据库中的内容只有在读取前已保存完成时才可用
+    NoteLoader *m_noteLoader = nullptr;
+    QHash<int, int> m_savesInFlight;   // 笔记ID -> 已提交但尚未写入完成的最新快照的编辑版本号
+    QHash<int, int> m_saveRequestMark; // 笔记ID -> 最近一次提交保存时的最新预读请求ID
+    
+    // 记下当前笔记的文档、光标和滚动位置，文档有未提交保存的修改或未加载完成时document为空
+    NoteDocumentCache::Entry currentDocumentEntry() const;
+    // 读取笔记内容并加载到当前文档，数据库中的笔记交给加载线程构建
+    void loadNoteContent(const QString &notePath);
+    
+    // 后台加载
+    int m_pendingLoadId = 0;            // 等待中的加载请求ID，没有时为0
+    bool m_readOnlyBeforeLoad = false;  // 加载前编辑器的只读状态
+    int m_unreadableNoteId = -1;        // 内容损坏、以只读方式显示的笔记ID，没有时为-1
+    // 请求加载线程读取并构建笔记文档，完成前编辑器只读
+    void startNoteLoad(int noteId);
+    // 切换笔记时取消未完成的后台加载和分批加载
+    void cancelNoteLoad();
+    // 新建或取回的文档使用与当前文档一致的默认字体、边距和制表符宽度
+    void applyDocumentDefaults(QTextDocument *document, const QTextDocument *source) const;
+    // 更换编辑器文档，重新绑定撤销/重做按钮；不在缓存中的旧文档被释放
+    void switchDocument(QTextDocument *document, bool keepPrevious);
+    
+    // 分批加载
+    QTimer *m_streamingLoadTimer = nullptr;     // 时间片定时器
+    QProgressBar *m_loadProgressBar = nullptr;  // 加载进度条，仅在分批加载时显示
+    QList<ContentBlock> m_streamingBlocks;      // 待追加的内容块
+    int m_streamingIndex = 0;                   // 下一个待追加的内容块位置
+    QString m_streamingHtmlHead;                // 原文档的<head>和<body>开始标签，每批解析时复用
+    NoteDocumentCodec *m_streamingCodec = nullptr; // 二进制格式笔记的解码器，HTML格式时为空
+    bool m_readOnlyBeforeStreaming = false;     // 加载前编辑器的只读状态
+    
+    // 尝试分批加载，内容不适合分批时返回false由调用方一次性加载
+    bool startStreamingLoad(const QList<ContentBlock> &blocks);
+    // HTML格式笔记：加载文档头和首屏内容
+    bool startStreamingHtml(const QList<ContentBlock> &blocks);
+    // 取下一批内容的结束位置，只在顶层段落或标题之前断开，避免拆开列表和表格
+    int nextStreamingBatchEnd(int start, int lines) const;
+    // 解析一批HTML并追加到文档末尾
+    void appendStreamingBatch(const QString &html);
+    // 加载完成后恢复编辑状态
+    void finishStreamingLoad();
+    // 切换笔记时取消未完成的加载
+    void cancelStreamingLoad();
 };
 
 #endif // TEXTEDITORMANAGER_H 
\ No newline at end of file